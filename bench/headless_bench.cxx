@@ -0,0 +1,270 @@
+#include "backends/headless/backend.h"
+#include "ui/data_grid.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Count every heap allocation made by the process so App allocations show up next
+// to ImGui's own (which the headless backend already counts through its allocator).
+void*
+operator new (std::size_t size) {
+	ambidb::CountHeadlessAllocation (size);
+	if (void* ptr = std::malloc (size ? size : 1)) return ptr;
+	throw std::bad_alloc ();
+}
+
+void
+operator delete (void* ptr) noexcept {
+	std::free (ptr);
+}
+
+void
+operator delete (void* ptr, std::size_t /*size*/) noexcept {
+	std::free (ptr);
+}
+
+namespace {
+
+	constexpr std::array kPages{
+		ambidb::Page::Dashboard,
+		ambidb::Page::Connections,
+		ambidb::Page::QueryEditor,
+		ambidb::Page::SchemaBrowser,
+		ambidb::Page::DataGrid,
+		ambidb::Page::QueryHistory,
+		ambidb::Page::Settings,
+	};
+
+	struct Options {
+		ambidb::HeadlessConfig config;
+		std::string page{"all"};
+		std::string csvPath;
+		std::vector<size_t> gridRows;  ///< Row counts for the synthetic Data Grid runs.
+	};
+
+	/**
+	 * @brief Cells are made up on demand, so a 100M-row grid costs no memory.
+	 */
+	class SyntheticGridSource final : public ambidb::ui::DataGridSource {
+	public:
+		static constexpr size_t kColumns = 20;
+
+		MAKE_NONCOPYABLE (SyntheticGridSource);
+		MAKE_NONMOVABLE (SyntheticGridSource);
+		explicit SyntheticGridSource (size_t rows) : m_rows (rows) {
+			for (size_t column = 0; column < kColumns; ++column) {
+				m_names.push_back ("column_" + std::to_string (column));
+			}
+		}
+		~SyntheticGridSource () override = default;
+
+		size_t
+		RowCount () const override {
+			return m_rows;
+		}
+
+		size_t
+		ColumnCount () const override {
+			return kColumns;
+		}
+
+		const char*
+		ColumnName (size_t column) const override {
+			return m_names [column].c_str ();
+		}
+
+		const char*
+		CellText (size_t row, size_t column, char* scratch, size_t scratchSize) const override {
+			std::snprintf (scratch, scratchSize, "r%zu c%zu", row, column);
+			return scratch;
+		}
+
+	private:
+		size_t m_rows;
+		std::vector<std::string> m_names;
+	};
+
+	void
+	PrintUsage () {
+		std::println ("Usage: ambidb_bench [--page <title>|all] [--frames N] [--size WxH]\n"
+					  "                    [--raster] [--script <file>] [--csv <file>]\n"
+					  "                    [--grid-rows N]...");
+	}
+
+	bool
+	ParseInt (std::string_view text, int& out) {
+		const auto [end, ec] = std::from_chars (text.data (), text.data () + text.size (), out);
+		return ec == std::errc () && end == text.data () + text.size ();
+	}
+
+	bool
+	ParseArgs (int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view arg = argv [i];
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--page" && hasValue) {
+				options.page = argv [++i];
+			}
+			else if (arg == "--frames" && hasValue) {
+				if (!ParseInt (argv [++i], options.config.frames) || options.config.frames <= 0) return false;
+			}
+			else if (arg == "--size" && hasValue) {
+				const std::string_view size = argv [++i];
+				const size_t x = size.find ('x');
+				int width = 0;
+				int height = 0;
+				if (x == std::string_view::npos || !ParseInt (size.substr (0, x), width) ||
+					!ParseInt (size.substr (x + 1), height)) {
+					return false;
+				}
+				options.config.displaySize = ImVec2 (static_cast<float> (width), static_cast<float> (height));
+			}
+			else if (arg == "--raster") {
+				options.config.rasterizeText = true;
+			}
+			else if (arg == "--script" && hasValue) {
+				auto script = ambidb::LoadHeadlessInputScript (argv [++i]);
+				if (!script) return false;
+				options.config.script = std::move (*script);
+			}
+			else if (arg == "--csv" && hasValue) {
+				options.csvPath = argv [++i];
+			}
+			else if (arg == "--grid-rows" && hasValue) {
+				const std::string_view text = argv [++i];
+				size_t rows = 0;
+				const auto [end, ec] = std::from_chars (text.data (), text.data () + text.size (), rows);
+				if (ec != std::errc () || end != text.data () + text.size ()) return false;
+				options.gridRows.push_back (rows);
+			}
+			else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	double
+	Percentile (std::vector<double> values, double p) {
+		if (values.empty ()) return 0.0;
+		const size_t index = static_cast<size_t> (p * static_cast<double> (values.size () - 1) + 0.5);
+		std::nth_element (values.begin (), values.begin () + index, values.end ());
+		return values [index];
+	}
+
+	void
+	PrintSummary (const char* title, const std::vector<ambidb::HeadlessFrameStats>& stats) {
+		std::vector<double> cpu;
+		double allocations = 0.0;
+		double vertices = 0.0;
+		double commands = 0.0;
+		size_t elided = 0;
+		for (const ambidb::HeadlessFrameStats& frame: stats) {
+			if (!frame.presented) ++elided;
+			cpu.push_back (frame.cpuMs);
+			allocations += static_cast<double> (frame.allocations);
+			vertices += frame.vertices;
+			commands += frame.drawCommands;
+		}
+		const double n = std::max<double> (1.0, static_cast<double> (stats.size ()));
+		std::println ("{:<16} {:>6} {:>9.3f} {:>9.3f} {:>9.3f} {:>10.1f} {:>10.0f} {:>8.0f} {:>7}",
+					  title,
+					  stats.size (),
+					  Percentile (cpu, 0.50),
+					  Percentile (cpu, 0.99),
+					  cpu.empty () ? 0.0 : *std::max_element (cpu.begin (), cpu.end ()),
+					  allocations / n,
+					  vertices / n,
+					  commands / n,
+					  elided);
+	}
+
+}  // namespace
+
+int
+main (int argc, char** argv) {
+	Options options;
+	if (!ParseArgs (argc, argv, options)) {
+		PrintUsage ();
+		return 2;
+	}
+
+	std::vector<ambidb::Page> pages;
+	for (ambidb::Page page: kPages) {
+		if (options.page == "all" || options.page == ambidb::PageTitle (page)) {
+			pages.push_back (page);
+		}
+	}
+	if (pages.empty ()) {
+		std::println (stderr, "Unknown page '{}'", options.page);
+		return 2;
+	}
+
+	ambidb::HeadlessBackend backend (options.config);
+	if (!backend.Initialize ()) {
+		return 1;
+	}
+
+	std::ofstream csv;
+	if (!options.csvPath.empty ()) {
+		csv.open (options.csvPath);
+		std::println (csv, "page,frame,cpu_ms,wall_ms,allocations,allocated_bytes,draw_lists,draw_cmds,vertices,indices,presented");
+	}
+
+	std::println ("{:<16} {:>6} {:>9} {:>9} {:>9} {:>10} {:>10} {:>8} {:>7}",
+				  "page", "frames", "cpu p50", "cpu p99", "cpu max", "allocs/f", "vtx/f", "cmds/f", "elided");
+	for (ambidb::Page page: pages) {
+		backend.GetApp ().SetActivePage (page);
+		backend.ClearFrameStats ();
+		backend.Run ();
+
+		const auto& stats = backend.FrameStats ();
+		PrintSummary (ambidb::PageTitle (page), stats);
+		if (csv) {
+			for (size_t i = 0; i < stats.size (); ++i) {
+				const ambidb::HeadlessFrameStats& f = stats [i];
+				std::println (csv, "{},{},{:.4f},{:.4f},{},{},{},{},{},{},{}",
+							  ambidb::PageTitle (page), i, f.cpuMs, f.wallMs, f.allocations,
+							  f.allocatedBytes, f.drawLists, f.drawCommands, f.vertices, f.indices,
+							  f.presented ? 1 : 0);
+			}
+		}
+	}
+
+	// Frame cost should not depend on the row count; the grid jumps around every 30 frames.
+	for (size_t rows: options.gridRows) {
+		const SyntheticGridSource source (rows);
+		ambidb::ui::DataGrid grid;
+		int frame = 0;
+		backend.SetFrameCallback ([&] {
+			const ImGuiViewport* viewport = ImGui::GetMainViewport ();
+			ImGui::SetNextWindowPos (viewport->WorkPos);
+			ImGui::SetNextWindowSize (viewport->WorkSize);
+			ImGui::Begin ("##GridBench", nullptr, ImGuiWindowFlags_NoDecoration);
+			if (rows > 0 && ++frame % 30 == 0) {
+				grid.JumpToRow ((static_cast<size_t> (frame) * 7919u * 7919u) % rows);
+			}
+			grid.Draw ("##Grid", source);
+			ImGui::End ();
+			return false;
+		});
+		backend.ClearFrameStats ();
+		backend.Run ();
+
+		const std::string title = "Grid " + std::to_string (rows);
+		PrintSummary (title.c_str (), backend.FrameStats ());
+	}
+	backend.SetFrameCallback ({});
+
+	backend.Shutdown ();
+	return 0;
+}
@@ -1,40 +1,277 @@
 #include "app.h"
 
+#include "db/result_sort.h"
+#include "startup_trace.h"
 #include "ui/ui.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <span>
 #include <string>
+#include <string_view>
 
 namespace ambidb {
 
 	namespace {
 
+		constexpr std::string_view kDefaultQuery = "SELECT sqlite_version() AS version;";
+
+		constexpr std::array kPages = {
+			Page::Dashboard,
+			Page::Connections,
+			Page::QueryEditor,
+			Page::SchemaBrowser,
+			Page::DataGrid,
+			Page::QueryHistory,
+			Page::Settings,
+		};
+
 		const char*
-		PageTitle (Page page) {
-			switch (page) {
-				case Page::Dashboard: return "Dashboard";
-				case Page::Connections: return "Connections";
-				case Page::QueryEditor: return "Query Editor";
-				case Page::SchemaBrowser: return "Schema Browser";
-				case Page::DataGrid: return "Data Grid";
-				case Page::QueryHistory: return "Query History";
-				case Page::Settings: return "Settings";
+		ConnectionStateLabel (ConnectionState state) {
+			switch (state) {
+				case ConnectionState::Disconnected: return "disconnected";
+				case ConnectionState::Connecting: return "connecting...";
+				case ConnectionState::Connected: return "connected";
+				case ConnectionState::Failed: return "failed";
 			}
 			UNREACHABLE ();
 		}
 
-	}  // namespace
+		template <size_t N>
+		void
+		CopyToBuffer (std::array<char, N>& buffer, std::string_view text) {
+			const size_t length = std::min (text.size (), N - 1);
+			std::copy_n (text.data (), length, buffer.data ());
+			buffer [length] = '\0';
+		}
+
+		constexpr const char* kCompletionPopup = "##Completions";
+
+		/// Lines either side of the cursor the completer reads; a statement rarely spans more.
+		constexpr u32 kCompletionLines = 200;
+
+		const char*
+		QueryStatusLabel (db::QueryStatus status) {
+			switch (status) {
+				case db::QueryStatus::Ok: return "ok";
+				case db::QueryStatus::Failed: return "failed";
+				case db::QueryStatus::Cancelled: return "cancelled";
+			}
+			UNREACHABLE ();
+		}
+
+		/// Numeric stat @p value as the column stores it.
+		void
+		FormatStat (const db::ColumnStats& stats, f64 value, char* out, size_t size) {
+			std::snprintf (out, size, stats.type == db::ColumnType::Integer ? "%.0f" : "%g", value);
+		}
+
+		/// "min .. max" of @p stats, or "-" when it has no ordered values.
+		void
+		FormatRange (const db::ColumnStats& stats, char* out, size_t size) {
+			char low [32], high [32];
+			switch (stats.HasValues () ? stats.type : db::ColumnType::Null) {
+				case db::ColumnType::Integer:
+				case db::ColumnType::Real:
+					FormatStat (stats, stats.min, low, sizeof (low));
+					FormatStat (stats, stats.max, high, sizeof (high));
+					std::snprintf (out, size, "%s .. %s", low, high);
+					break;
+				case db::ColumnType::Text:
+					std::snprintf (out,
+								   size,
+								   "'%.*s' .. '%.*s'",
+								   static_cast<int> (std::min<size_t> (stats.minText.size (), 24)),
+								   stats.minText.data (),
+								   static_cast<int> (std::min<size_t> (stats.maxText.size (), 24)),
+								   stats.maxText.data ());
+					break;
+				case db::ColumnType::Null:
+				case db::ColumnType::Blob: std::snprintf (out, size, "-"); break;
+			}
+		}
+
+		/// Tooltip body describing one column of the result.
+		void
+		ColumnStatsDetails (const char* name, const db::ColumnStats& stats) {
+			ImGui::Text ("%s (%s)", name, db::ColumnTypeName (stats.type));
+			ImGui::Text ("%llu rows, %llu NULL (%.1f%%)",
+						 static_cast<unsigned long long> (stats.rows),
+						 static_cast<unsigned long long> (stats.nulls),
+						 stats.rows ? 100.0 * static_cast<double> (stats.nulls) / static_cast<double> (stats.rows) : 0.0);
+			if (!stats.HasValues ()) return;
+			char range [128];
+			FormatRange (stats, range, sizeof (range));
+			ImGui::Text ("~%.0f distinct, range %s", stats.distinct, range);
+			if (stats.type != db::ColumnType::Integer && stats.type != db::ColumnType::Real) return;
+
+			char quantiles [256];
+			size_t length = 0;
+			for (size_t i = 0; i < stats.quantiles.size () && length < sizeof (quantiles); ++i) {
+				char value [32];
+				FormatStat (stats, stats.quantiles [i], value, sizeof (value));
+				const int written = std::snprintf (quantiles + length,
+												   sizeof (quantiles) - length,
+												   "%sp%.0f %s",
+												   i ? "  " : "",
+												   db::ColumnStats::kQuantiles [i] * 100.0,
+												   value);
+				length += static_cast<size_t> (std::max (written, 0));
+			}
+			ImGui::TextUnformatted (quantiles);
+			const float peak = *std::ranges::max_element (stats.histogram);
+			ImGui::PlotHistogram ("##histogram",
+								  stats.histogram.data (),
+								  static_cast<int> (stats.histogram.size ()),
+								  0,
+								  nullptr,
+								  0.0f,
+								  peak,
+								  ImVec2 (ImGui::GetFontSize () * 16.0f, ImGui::GetTextLineHeight () * 3.0f));
+		}
+
+		class ResultSetGridSource final : public ui::DataGridSource {
+		public:
+			MAKE_NONCOPYABLE (ResultSetGridSource);
+			MAKE_NONMOVABLE (ResultSetGridSource);
+			/**
+			 * @p order maps display rows to result rows. When @p filtered it holds every row
+			 * shown; otherwise empty means all rows in result order. @p stats describe the
+			 * columns in header tooltips; there may be none yet.
+			 */
+			ResultSetGridSource (const db::ResultSet& results,
+								 std::span<const u32> order,
+								 bool filtered,
+								 bool sortable,
+								 std::span<const db::ColumnStats> stats)
+				: m_results (results), m_order (order), m_filtered (filtered), m_sortable (sortable), m_stats (stats) {}
+			~ResultSetGridSource () override = default;
+
+			size_t
+			RowCount () const override {
+				return m_filtered ? m_order.size () : m_results.RowCount ();
+			}
+
+			size_t
+			ColumnCount () const override {
+				return m_results.ColumnCount ();
+			}
 
-	App::App () {
-		m_connections = {
-			{"Production DB", "postgresql", true},
-			{"Local MySQL", "mysql", true},
-			{"Test SQLite", "sqlite", false},
+			const char*
+			ColumnName (size_t column) const override {
+				return m_results.Column (column).name.c_str ();
+			}
+
+			const char*
+			CellText (size_t row, size_t column, char* scratch, size_t scratchSize) const override {
+				if (row < m_order.size ()) row = m_order [row];
+				return m_results.FormatCell (row, column, scratch, scratchSize);
+			}
+
+			bool
+			Sortable () const override {
+				return m_sortable;
+			}
+
+			bool
+			HasColumnTooltip (size_t column) const override {
+				return column < m_stats.size ();
+			}
+
+			void
+			ColumnTooltip (size_t column) const override {
+				ColumnStatsDetails (ColumnName (column), m_stats [column]);
+			}
+
+		private:
+			const db::ResultSet& m_results;
+			std::span<const u32> m_order;
+			bool m_filtered;
+			bool m_sortable;
+			std::span<const db::ColumnStats> m_stats;
 		};
+
+		class WindowedGridSource final : public ui::DataGridSource {
+		public:
+			MAKE_NONCOPYABLE (WindowedGridSource);
+			MAKE_NONMOVABLE (WindowedGridSource);
+			explicit WindowedGridSource (const db::WindowedResult& window) : m_window (window) {}
+			~WindowedGridSource () override = default;
+
+			size_t
+			RowCount () const override {
+				return m_window.RowCount ();
+			}
+
+			size_t
+			ColumnCount () const override {
+				return m_window.ColumnCount ();
+			}
+
+			const char*
+			ColumnName (size_t column) const override {
+				return m_window.Column (column).name.c_str ();
+			}
+
+			const char*
+			CellText (size_t row, size_t column, char* scratch, size_t scratchSize) const override {
+				return m_window.FormatCell (row, column, scratch, scratchSize);
+			}
+
+		private:
+			const db::WindowedResult& m_window;
+		};
+
+	}  // namespace
+
+	const char*
+	PageTitle (Page page) {
+		switch (page) {
+			case Page::Dashboard: return "Dashboard";
+			case Page::Connections: return "Connections";
+			case Page::QueryEditor: return "Query Editor";
+			case Page::SchemaBrowser: return "Schema Browser";
+			case Page::DataGrid: return "Data Grid";
+			case Page::QueryHistory: return "Query History";
+			case Page::Settings: return "Settings";
+		}
+		UNREACHABLE ();
+	}
+
+	App::App (FrameServices services) : m_services (services) {
+		CopyToBuffer (m_exportPath, "export.csv");
+		ConnectionInfo scratch;
+		scratch.name = "Scratch (in-memory)";
+		scratch.params = {"sqlite", ":memory:"};
+		m_connections.push_back (std::move (scratch));
+		m_queryEditor.SetColors (&m_queryColors);
+		m_queryEditor.Load (std::string (kDefaultQuery));
 	}
 
 	void
 	App::Update () {
-		ui::ApplyTheme ();
+		{
+			// Only the first frame's call is traced; see StartupTrace.
+			StartupTrace::Scope scope ("ApplyTheme");
+#if defined(AMBIDB_TUI)
+			// A terminal has few colors; the syntax colors would otherwise blur together.
+			static const ui::ThemeConfig theme = ui::SnapThemeForTUI (ui::DarkTheme ());
+			ui::ApplyTheme (theme);
+#else
+			ui::ApplyTheme ();
+#endif
+		}
+
+		PollDatabase ();
+
+		// Only pay for phase timing while someone is looking at it.
+		if (m_services.timings) {
+			m_services.timings->SetEnabled (m_showFrameOverlay || m_activePage == Page::Dashboard);
+		}
 
 		ui::BeginAppShell ();
 
@@ -50,17 +287,23 @@ namespace ambidb {
 		ui::EndContent ();
 
 		ui::EndAppShell ();
+
+		RenderSearchPalette ();
+
+		if (m_showFrameOverlay) {
+			RenderFrameTimingOverlay ();
+		}
 	}
 
 	void
 	App::ConnectionEntry (const ConnectionInfo& conn) {
 		ImGui::PushID (conn.name.c_str ());
 
-		ui::StatusDot (conn.connected);
+		ui::StatusDot (conn.state == ConnectionState::Connected);
 		ImGui::SameLine (0.0f, ui::kMetrics.styleItemSpacing.x);
 		ImGui::TextUnformatted (conn.name.c_str ());
 		ImGui::SameLine ();
-		ui::TypeBadge (conn.type);
+		ui::TypeBadge (conn.params.driver);
 
 		ImGui::PopID ();
 	}
@@ -82,7 +325,7 @@ namespace ambidb {
 		ImGui::PushStyleVar (ImGuiStyleVar_FrameRounding, ui::kMetrics.frameRounding);
 		ImGui::PushStyleVar (ImGuiStyleVar_FramePadding, ImVec2 (0.0f, ui::kMetrics.primaryButtonPadY));
 		if (ImGui::Button ("+ New Connection", ImVec2 (buttonWidth, 0.0f))) {
-			// Placeholder action for a future connection dialog.
+			m_openNewConnection = true;
 		}
 		ImGui::PopStyleVar (2);
 		ImGui::PopStyleColor (3);
@@ -112,6 +355,9 @@ namespace ambidb {
 		if (ui::NavItem ("[*]", "Settings", m_activePage == Page::Settings)) {
 			m_activePage = Page::Settings;
 		}
+		if (ui::NavItem ("[/]", "Search (Ctrl+P)", false)) {
+			m_openSearch = true;
+		}
 
 		ui::Gap (ui::kMetrics.sectionGapY);
 		ImGui::Separator ();
@@ -141,6 +387,34 @@ namespace ambidb {
 		ui::TextMuted ("System Ready");
 
 		ImGui::PopStyleVar ();
+
+		RenderNewConnectionDialog ();
+	}
+
+	void
+	App::RenderNewConnectionDialog () {
+		constexpr const char* kPopupId = "New Connection";
+		if (m_openNewConnection) {
+			m_openNewConnection = false;
+			CopyToBuffer (m_newConnectionName, "SQLite database");
+			CopyToBuffer (m_newConnectionTarget, "");
+			ui::OpenPopup (kPopupId);
+		}
+		if (!ui::BeginCenteredModal (kPopupId)) return;
+
+		ui::InputTextField ("Name", m_newConnectionName.data (), m_newConnectionName.size ());
+		ui::InputTextWithHintField ("File", ":memory:", m_newConnectionTarget.data (), m_newConnectionTarget.size ());
+		ui::TextMuted ("SQLite is the only driver in this build; the file is created if missing.");
+
+		if (ui::ModalButtonRow ("Add", "Cancel") == ui::ModalResult::Confirmed) {
+			ConnectionInfo conn;
+			conn.name = m_newConnectionName.data ();
+			conn.params.driver = "sqlite";
+			conn.params.target = m_newConnectionTarget [0] ? m_newConnectionTarget.data () : ":memory:";
+			m_connections.push_back (std::move (conn));
+			IndexConnection (m_connections.size () - 1);
+		}
+		ui::EndModal ();
 	}
 
 	void
@@ -160,11 +434,23 @@ namespace ambidb {
 		ImGui::Separator ();
 		ui::Gap (ui::kMetrics.sectionGapY);
 
-		std::string contentHint = "(Content for \"";
-		contentHint += title;
-		contentHint += "\" goes here)";
-		ui::AlignContentStart ();
-		ui::TextMuted (contentHint.c_str ());
+		switch (m_activePage) {
+			case Page::Dashboard: RenderDashboard (); break;
+			case Page::Connections: RenderConnections (); break;
+			case Page::QueryEditor: RenderQueryEditor (); break;
+			case Page::SchemaBrowser: RenderSchemaBrowser (); break;
+			case Page::DataGrid: RenderDataGrid (); break;
+			case Page::QueryHistory: RenderQueryHistory (); break;
+			case Page::Settings: RenderSettings (); break;
+			default: {
+				std::string contentHint = "(Content for \"";
+				contentHint += title;
+				contentHint += "\" goes here)";
+				ui::AlignContentStart ();
+				ui::TextMuted (contentHint.c_str ());
+				break;
+			}
+		}
 
 		ui::PinToBottom (ui::kMetrics.quitReserveY);
 		ui::AlignContentStart ();
@@ -175,4 +461,1363 @@ namespace ambidb {
 		ImGui::PopStyleVar ();
 	}
 
+	void
+	App::RenderDashboard () {
+		ui::AlignContentStart ();
+		ImGui::TextUnformatted ("Frame timing");
+		if (!m_services.timings) {
+			ui::AlignContentStart ();
+			ui::TextMuted ("(not available without a backend)");
+		}
+		else {
+			FrameTimingTable (m_services.timings->Summarize ());
+		}
+
+		ui::Gap (ui::kMetrics.rowGapY);
+		ui::AlignContentStart ();
+		ImGui::TextUnformatted ("Result columns");
+		ColumnStatsTable ();
+	}
+
+	void
+	App::ColumnStatsTable () {
+		if (m_columnStats.empty ()) {
+			ui::AlignContentStart ();
+			ui::TextMuted (m_query.windowed ? "(not kept for results fetched on scroll)" : "(run a query to profile its columns)");
+			return;
+		}
+
+		const db::ResultSet& results = m_query.results;
+		ui::AlignContentStart ();
+		ui::TextMuted ("column           type         nulls   distinct  range");
+		for (size_t column = 0; column < m_columnStats.size () && column < results.ColumnCount (); ++column) {
+			const db::ColumnStats& stats = m_columnStats [column];
+			const char* name = results.Column (column).name.c_str ();
+			char range [128];
+			FormatRange (stats, range, sizeof (range));
+			ui::AlignContentStart ();
+			ImGui::Text ("%-16.16s %-8s %10llu %10.0f  %s",
+						 name,
+						 db::ColumnTypeName (stats.type),
+						 static_cast<unsigned long long> (stats.nulls),
+						 stats.distinct,
+						 range);
+			if (ImGui::IsItemHovered ()) {
+				ImGui::BeginTooltip ();
+				ColumnStatsDetails (name, stats);
+				ImGui::EndTooltip ();
+			}
+		}
+		// Stats trail the rows by up to a row group while the query runs.
+		if (m_columnStats.front ().rows < results.RowCount ()) {
+			ui::AlignContentStart ();
+			ImGui::TextDisabled ("first %llu of %zu rows", static_cast<unsigned long long> (m_columnStats.front ().rows), results.RowCount ());
+		}
+	}
+
+	void
+	App::RenderConnections () {
+		for (size_t i = 0; i < m_connections.size (); ++i) {
+			ConnectionInfo& conn = m_connections [i];
+			ImGui::PushID (static_cast<int> (i));
+
+			ui::AlignContentStart ();
+			ConnectionEntry (conn);
+			ImGui::SameLine ();
+			ui::TextMuted (conn.params.target.c_str ());
+			ImGui::SameLine ();
+			ui::TextMuted (ConnectionStateLabel (conn.state));
+
+			ImGui::SameLine ();
+			switch (conn.state) {
+				case ConnectionState::Disconnected:
+				case ConnectionState::Failed:
+					if (ImGui::SmallButton ("Connect")) Connect (conn);
+					break;
+				case ConnectionState::Connected:
+					if (ImGui::SmallButton ("Disconnect")) Disconnect (conn);
+					break;
+				case ConnectionState::Connecting: break;
+			}
+
+			if (conn.state == ConnectionState::Failed && !conn.error.empty ()) {
+				ui::AlignContentStart ();
+				ImGui::TextWrapped ("  %s", conn.error.c_str ());
+			}
+			ImGui::PopID ();
+		}
+	}
+
+	void
+	SqlEditorColors::Colors (const TextBuffer& text, u32 line, u32 from, u32 to, std::vector<ui::TextColor>& out) {
+		const ui::ThemeConfig& theme = ui::ActiveTheme ();
+		const ImVec4 palette [kSqlTokenCount] = {
+			theme.text,
+			theme.syntaxKeyword,
+			theme.syntaxType,
+			theme.syntaxFunction,
+			theme.syntaxString,
+			theme.syntaxNumber,
+			theme.syntaxComment,
+			theme.syntaxName,
+			theme.syntaxOperator,
+			theme.syntaxParameter,
+		};
+		const SqlHighlighter::LineSource source = [&] (u32 at) { return text.Line (at, m_scratch); };
+		const std::vector<SqlSpan>& spans = m_highlighter.Spans (line, source);
+		// Spans are in order, so only those on screen are walked, however long the line.
+		auto it = std::ranges::partition_point (spans, [from] (const SqlSpan& span) { return span.begin + span.length <= from; });
+		for (; it != spans.end () && it->begin < to; ++it) {
+			if (it->token == SqlToken::Plain) continue;
+			out.push_back ({it->begin, it->length, ImGui::ColorConvertFloat4ToU32 (palette [static_cast<size_t> (it->token)])});
+		}
+	}
+
+	void
+	App::RenderQueryEditor () {
+		if (m_connections.empty ()) {
+			ui::AlignContentStart ();
+			ui::TextMuted ("Add a connection first.");
+			return;
+		}
+		m_queryConnection = std::min (m_queryConnection, m_connections.size () - 1);
+		ConnectionInfo& conn = m_connections [m_queryConnection];
+
+		ui::AlignContentStart ();
+		if (ImGui::BeginCombo ("Connection", conn.name.c_str ())) {
+			for (size_t i = 0; i < m_connections.size (); ++i) {
+				ImGui::PushID (static_cast<int> (i));
+				if (ImGui::Selectable (m_connections [i].name.c_str (), i == m_queryConnection)) {
+					m_queryConnection = i;
+				}
+				ImGui::PopID ();
+			}
+			ImGui::EndCombo ();
+		}
+		ImGui::SameLine ();
+		if (conn.state == ConnectionState::Disconnected || conn.state == ConnectionState::Failed) {
+			if (ImGui::SmallButton ("Connect")) Connect (conn);
+		}
+		else {
+			ui::TextMuted (ConnectionStateLabel (conn.state));
+		}
+
+		ui::AlignContentStart ();
+		m_queryColors.SetDialect (SqlDialectFor (conn.params.driver));
+		m_queryEditor.Draw ("##QueryText", ImVec2 (-1.0f, ImGui::GetTextLineHeight () * 8.0f + ImGui::GetStyle ().FramePadding.y * 2.0f));
+		// Typing a name or a '.' asks for completions, and so does Ctrl+Space.
+		const char typed = m_queryEditor.Typed ();
+		if (std::isalnum (static_cast<unsigned char> (typed)) || typed == '_' || typed == '.' ||
+			(m_queryEditor.Focused () && ImGui::GetIO ().KeyCtrl && ImGui::IsKeyPressed (ImGuiKey_Space, false))) {
+			m_completeRequested = true;
+		}
+		else if (m_queryEditor.Cursor () != m_editorCursor) {
+			m_completionWaiting = false;
+		}
+		m_editorCursor = m_queryEditor.Cursor ();
+		// When asked, and again once the catalog levels the word needed have loaded and are indexed.
+		if (m_completionWaiting) UpdateCompleter (conn);
+		if (m_completeRequested || (m_completionWaiting && m_completer.Generation () != m_completionGeneration)) {
+			m_completeRequested = false;
+			CompleteQuery (conn);
+			if (!m_completions.empty ()) ui::OpenPopup (kCompletionPopup);
+		}
+		RenderCompletions (conn);
+
+		ui::AlignContentStart ();
+		if (m_query.running) {
+			if (ImGui::Button ("Cancel")) {
+				Database ().Cancel (m_query.id);
+			}
+			ImGui::SameLine ();
+			// Frames keep coming while the query runs (BeginAnimation), so the spinner turns.
+			constexpr char kSpinner [] = "|/-\\";
+			const int step = static_cast<int> (ImGui::GetTime () * 8.0) % 4;
+			ImGui::Text ("%c running, %zu rows so far", kSpinner [step], m_query.KnownRows ());
+		}
+		else {
+			if (ImGui::Button ("Run") && conn.state == ConnectionState::Connected) {
+				RunQuery ();
+			}
+			ImGui::SameLine ();
+			ImGui::Checkbox ("Fetch on scroll", &m_fetchOnScroll);
+			ImGui::SameLine ();
+			if (conn.state != ConnectionState::Connected) {
+				ui::TextMuted ("(not connected)");
+			}
+			else if (m_query.id == 0) {
+				ui::TextMuted ("Ready");
+			}
+			else if (m_query.status == db::QueryStatus::Failed) {
+				ImGui::TextWrapped ("Error: %s", m_query.error.c_str ());
+			}
+			else {
+				ImGui::Text ("%s: %zu%s rows, %lld affected, %.1f ms",
+							 m_query.status == db::QueryStatus::Cancelled ? "Cancelled" : "Done",
+							 m_query.KnownRows (),
+							 m_query.MoreRows () ? "+" : "",
+							 static_cast<long long> (m_query.rowsAffected),
+							 m_query.elapsedMs);
+			}
+		}
+
+		RenderExport ();
+		RenderImport ();
+
+		ui::Gap (ui::kMetrics.rowGapY);
+		ResultGrid ();
+	}
+
+	void
+	App::UpdateCompleter (ConnectionInfo& conn) {
+		FrameScheduler* scheduler = m_services.scheduler;
+		// The index is built off the UI thread; the next frame takes it in.
+		m_completer.Update (SchemaOf (conn), [scheduler] {
+			if (scheduler) scheduler->RequestRedraw ();
+		});
+	}
+
+	void
+	App::CompleteQuery (ConnectionInfo& conn) {
+		const std::shared_ptr<db::SchemaCache>& cache = SchemaOf (conn);
+		UpdateCompleter (conn);
+		m_completionGeneration = m_completer.Generation ();
+		// The completer reads the statement around the cursor; lines around it are plenty, and
+		// keep a long script from being copied for every keystroke.
+		const TextBuffer& text = m_queryEditor.Text ();
+		const size_t cursor = m_queryEditor.Cursor ();
+		const u32 line = text.LineOf (cursor);
+		const size_t from = text.LineStart (line > kCompletionLines ? line - kCompletionLines : 0);
+		const size_t to = text.LineEnd (std::min (line + kCompletionLines, text.LineCount () - 1));
+		std::string scratch;
+		m_completer.Complete (text.Text (from, to, scratch), cursor - from, m_completions, m_completionContext);
+		m_completionContext.wordStart += from;
+		m_completionSelection = 0;
+		// Fetch what the statement names but the cache lacks; the list fills in once it lands.
+		m_completionWaiting = false;
+		if (conn.state != ConnectionState::Connected) return;
+		for (const db::CatalogPath& path : m_completionContext.missing) {
+			if (std::optional<db::CatalogPath> load = cache->Require (path.schema, path.table)) {
+				Database ().LoadCatalog (conn.id, cache, std::move (*load));
+			}
+			m_completionWaiting = true;
+		}
+	}
+
+	void
+	App::RenderCompletions (ConnectionInfo& conn) {
+		constexpr float kVisibleRows = 10.0f;
+
+		ImGui::SetNextWindowPos (m_queryEditor.CursorScreenPos ());
+		ImGui::SetNextWindowSizeConstraints (ImVec2 (0.0f, 0.0f), ImVec2 (FLT_MAX, ImGui::GetTextLineHeightWithSpacing () * kVisibleRows));
+		if (!ui::BeginPopup (kCompletionPopup, ImGuiWindowFlags_NoMove)) return;
+
+		// The list has the keyboard while it is open, so typing carries on into the text. The
+		// keystroke that opened it already reached the editor.
+		const bool keys = !ImGui::IsWindowAppearing ();
+		bool close = false;
+		bool edited = false;
+		std::string typed;
+		if (keys) ui::AppendTyped (typed, ImGui::GetIO ().InputQueueCharacters);
+		const size_t cursor = m_queryEditor.Cursor ();
+		if (!typed.empty ()) {
+			m_queryEditor.Replace (cursor, cursor, typed);
+			edited = true;
+			// Anything but a name ends the word.
+			const char last = typed.back ();
+			close = !(std::isalnum (static_cast<unsigned char> (last)) || last == '_' || last == '.');
+		}
+		if (keys && ImGui::IsKeyPressed (ImGuiKey_Backspace) && cursor > 0) {
+			size_t from = cursor - 1;
+			while (from > 0 && (static_cast<unsigned char> (m_queryEditor.Text ().At (from)) & 0xC0) == 0x80) --from;
+			m_queryEditor.Replace (from, cursor, {});
+			edited = true;
+		}
+		if (edited && !close) CompleteQuery (conn);
+
+		bool scroll = false;
+		if (keys && ImGui::IsKeyPressed (ImGuiKey_DownArrow) && m_completionSelection + 1 < m_completions.size ()) {
+			++m_completionSelection;
+			scroll = true;
+		}
+		if (keys && ImGui::IsKeyPressed (ImGuiKey_UpArrow) && m_completionSelection > 0) {
+			--m_completionSelection;
+			scroll = true;
+		}
+		const Completion* chosen = nullptr;
+		for (size_t i = 0; i < m_completions.size (); ++i) {
+			const Completion& completion = m_completions [i];
+			ImGui::PushID (static_cast<int> (i));
+			if (ImGui::Selectable (completion.text.c_str (), i == m_completionSelection)) chosen = &completion;
+			if (scroll && i == m_completionSelection) ImGui::SetScrollHereY ();
+			ImGui::SameLine ();
+			ImGui::TextDisabled ("%s", completion.detail.empty () ? CompletionKindName (completion.kind) : completion.detail.c_str ());
+			ImGui::PopID ();
+		}
+		if (keys && (ImGui::IsKeyPressed (ImGuiKey_Enter) || ImGui::IsKeyPressed (ImGuiKey_Tab)) && m_completionSelection < m_completions.size ()) {
+			chosen = &m_completions [m_completionSelection];
+		}
+
+		if (chosen) {
+			m_queryEditor.Replace (m_completionContext.wordStart, m_queryEditor.Cursor (), chosen->text);
+			close = true;
+		}
+		close = close || m_completions.empty () ||
+				(keys && (ImGui::IsKeyPressed (ImGuiKey_Escape) || ImGui::IsKeyPressed (ImGuiKey_LeftArrow) || ImGui::IsKeyPressed (ImGuiKey_RightArrow)));
+		if (close) {
+			m_queryEditor.Focus ();
+			ImGui::CloseCurrentPopup ();
+		}
+		ui::EndPopup ();
+	}
+
+	void
+	App::RenderExport () {
+		const bool exporting = m_export && !m_export->Done ();
+		if (m_export && !exporting && m_exportSeconds == 0.0) {
+			if (m_exportThread.joinable ()) m_exportThread.join ();
+			m_exportSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - m_exportStart).count ();
+		}
+
+		ui::AlignContentStart ();
+		if (exporting) {
+			const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - m_exportStart).count ();
+			const double mib = static_cast<double> (m_export->Bytes ()) / (1024.0 * 1024.0);
+			char overlay [128];
+			std::snprintf (overlay,
+						   sizeof (overlay),
+						   "%llu rows, %.1f MiB, %.0f MiB/s",
+						   static_cast<unsigned long long> (m_export->Rows ()),
+						   mib,
+						   seconds > 0.0 ? mib / seconds : 0.0);
+			float fraction;
+			if (m_exportTotal > 0) {
+				fraction = static_cast<float> (static_cast<double> (m_export->Rows ()) / static_cast<double> (m_exportTotal));
+			}
+			else {
+				// A cursor does not say how many rows are coming.
+#if IMGUI_VERSION_NUM >= 19100
+				fraction = -1.0f * static_cast<float> (ImGui::GetTime ());
+#else
+				fraction = 0.0f;
+#endif
+			}
+			ui::ProgressBarLabeled (fraction, overlay, ImGui::GetFontSize () * 24.0f);
+			ImGui::SameLine ();
+			if (ImGui::SmallButton ("Cancel export")) CancelExport ();
+			return;
+		}
+
+		ImGui::PushItemWidth (ImGui::GetFontSize () * 10.0f);
+		if (ImGui::BeginCombo ("##ExportFormat", db::ExportFormatName (m_exportFormat))) {
+			for (const db::ExportFormat format :
+				 {db::ExportFormat::Csv, db::ExportFormat::Tsv, db::ExportFormat::JsonLines, db::ExportFormat::Columnar}) {
+				if (!ImGui::Selectable (db::ExportFormatName (format), format == m_exportFormat)) continue;
+				// Follow the format with the extension, unless the user picked another one.
+				std::string path (m_exportPath.data ());
+				const std::string old = std::string (".") + db::ExportFormatExtension (m_exportFormat);
+				if (path.ends_with (old)) {
+					path.replace (path.size () - old.size (), old.size (), std::string (".") + db::ExportFormatExtension (format));
+					CopyToBuffer (m_exportPath, path);
+				}
+				m_exportFormat = format;
+			}
+			ImGui::EndCombo ();
+		}
+		ImGui::PopItemWidth ();
+		ImGui::SameLine ();
+		ui::InputTextField ("##ExportPath", m_exportPath.data (), m_exportPath.size (), ImGuiInputTextFlags_None, ImGui::GetFontSize () * 16.0f);
+		ImGui::SameLine ();
+		const ConnectionInfo& conn = m_connections [m_queryConnection];
+		if (ImGui::SmallButton ("Export query") && conn.state == ConnectionState::Connected && !m_query.running) {
+			StartExport (false);
+		}
+		ImGui::SameLine ();
+		const bool stored = !m_query.windowed && !m_query.running && m_query.status == db::QueryStatus::Ok && m_query.ColumnCount () > 0;
+		if (ImGui::SmallButton ("Export result") && stored) {
+			StartExport (true);
+		}
+
+		if (!m_exportError.empty ()) {
+			ImGui::SameLine ();
+			ImGui::TextWrapped ("Export: %s", m_exportError.c_str ());
+		}
+		else if (m_export) {
+			ImGui::SameLine ();
+			if (!m_export->Error ().empty ()) {
+				ImGui::TextWrapped ("Export: %s", m_export->Error ().c_str ());
+			}
+			else {
+				ImGui::TextDisabled ("Exported %llu rows, %.1f MiB in %.1f s",
+									 static_cast<unsigned long long> (m_export->Rows ()),
+									 static_cast<double> (m_export->Bytes ()) / (1024.0 * 1024.0),
+									 m_exportSeconds);
+			}
+		}
+	}
+
+	void
+	App::StartExport (bool storedResult) {
+		FrameScheduler* scheduler = m_services.scheduler;
+		// Each written block wakes the loop so the progress bar moves.
+		db::DbResult<std::unique_ptr<db::Exporter>> created =
+			db::Exporter::Create (m_exportFormat, m_exportPath.data (), [scheduler] {
+				if (scheduler) scheduler->RequestRedraw ();
+			});
+		m_export.reset ();
+		if (!created) {
+			m_exportError = std::move (created.error ().message);
+			return;
+		}
+		m_exportError.clear ();
+		m_export = std::move (*created);
+		m_exportStart = std::chrono::steady_clock::now ();
+		m_exportSeconds = 0.0;
+
+		if (!storedResult) {
+			m_exportTotal = 0;
+			const ConnectionInfo& conn = m_connections [m_queryConnection];
+			m_exportQuery = Database ().Export (conn.id, m_queryEditor.Text ().Text (), m_export);
+			return;
+		}
+
+		// Rows stay put until the next RunQuery (), which stops this thread first.
+		const db::ResultSet& results = m_query.results;
+		m_exportQuery = 0;
+		m_exportTotal = results.RowCount ();
+		m_exportThread = std::jthread ([exporter = m_export, &results] (std::stop_token stop) {
+			const std::stop_callback cancel (stop, [&] { exporter->Cancel (); });
+			std::vector<db::ColumnInfo> columns;
+			for (size_t column = 0; column < results.ColumnCount (); ++column) columns.push_back (results.Column (column));
+			exporter->Begin (columns);
+			for (size_t group = 0; group < results.GroupCount (); ++group) {
+				if (!exporter->Write (results, group)) break;
+			}
+			exporter->Finish ();
+		});
+	}
+
+	void
+	App::CancelExport () {
+		if (!m_export) return;
+		m_export->Cancel ();
+		if (m_exportQuery != 0) Database ().Cancel (m_exportQuery);
+	}
+
+	void
+	App::RenderImport () {
+		const bool importing = m_import && !m_import->Done ();
+		if (m_import && !importing && m_importSeconds == 0.0) {
+			m_importSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - m_importStart).count ();
+		}
+
+		ui::AlignContentStart ();
+		if (importing) {
+			const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - m_importStart).count ();
+			const u64 rows = m_import->Rows ();
+			char overlay [128];
+			std::snprintf (overlay,
+						   sizeof (overlay),
+						   "%llu rows, %.0f rows/s",
+						   static_cast<unsigned long long> (rows),
+						   seconds > 0.0 ? static_cast<double> (rows) / seconds : 0.0);
+			const u64 total = std::max<u64> (m_import->TotalBytes (), 1);
+			ui::ProgressBarLabeled (static_cast<float> (static_cast<double> (m_import->Bytes ()) / static_cast<double> (total)),
+									overlay,
+									ImGui::GetFontSize () * 24.0f);
+			ImGui::SameLine ();
+			if (ImGui::SmallButton ("Cancel import")) {
+				m_import->Cancel ();
+				Database ().Cancel (m_importQuery);
+			}
+			return;
+		}
+
+		ui::InputTextWithHintField ("##ImportPath", "file.csv", m_importPath.data (), m_importPath.size (), ImGuiInputTextFlags_None, ImGui::GetFontSize () * 16.0f);
+		ImGui::SameLine ();
+		ui::InputTextWithHintField ("##ImportTable", "table", m_importTable.data (), m_importTable.size (), ImGuiInputTextFlags_None, ImGui::GetFontSize () * 8.0f);
+		ImGui::SameLine ();
+		ImGui::Checkbox ("Header", &m_importHeader);
+		ImGui::SameLine ();
+		if (ui::InputIntField ("Rows/s", &m_importRowLimit, 1000, 100000, ImGuiInputTextFlags_None, ImGui::GetFontSize () * 6.0f)) {
+			m_importRowLimit = std::max (m_importRowLimit, 0);
+		}
+		ImGui::SameLine ();
+		const ConnectionInfo& conn = m_connections [m_queryConnection];
+		if (ImGui::SmallButton ("Import CSV") && conn.state == ConnectionState::Connected && m_importPath [0] && m_importTable [0]) {
+			StartImport ();
+		}
+
+		if (!m_importError.empty ()) {
+			ImGui::SameLine ();
+			ImGui::TextWrapped ("Import: %s", m_importError.c_str ());
+		}
+		else if (m_import) {
+			ImGui::SameLine ();
+			if (!m_import->Error ().empty ()) {
+				ImGui::TextWrapped ("Import: %s", m_import->Error ().c_str ());
+			}
+			else {
+				ImGui::TextDisabled ("Imported %llu rows in %.1f s",
+									 static_cast<unsigned long long> (m_import->Rows ()),
+									 m_importSeconds);
+			}
+		}
+	}
+
+	void
+	App::StartImport () {
+		db::ImportOptions options;
+		options.table = m_importTable.data ();
+		options.header = m_importHeader;
+		options.maxRowsPerSecond = static_cast<u64> (m_importRowLimit);
+		FrameScheduler* scheduler = m_services.scheduler;
+		// Each batch handed to the connection wakes the loop so the readout moves.
+		db::DbResult<std::unique_ptr<db::Importer>> created =
+			db::Importer::Create (m_importPath.data (), std::move (options), [scheduler] {
+				if (scheduler) scheduler->RequestRedraw ();
+			});
+		m_import.reset ();
+		if (!created) {
+			m_importError = std::move (created.error ().message);
+			return;
+		}
+		m_importError.clear ();
+		m_import = std::move (*created);
+		m_importStart = std::chrono::steady_clock::now ();
+		m_importSeconds = 0.0;
+		m_importQuery = Database ().Import (m_connections [m_queryConnection].id, m_import);
+	}
+
+	void
+	App::ResultGrid () {
+		if (m_query.ColumnCount () == 0) return;
+
+		ui::AlignContentStart ();
+		const ImVec2 size (0.0f, -ui::kMetrics.quitReserveY);
+		bool settle;
+		if (m_query.windowed) {
+			settle = m_grid.Draw ("##QueryResults", WindowedGridSource (m_query.window), size);
+			RequestPages ();
+		}
+		else {
+			// A new order invalidates the selection, which lists rows in display order.
+			if (m_sorter.TakeResult (m_sortOrder)) FilterResults (false);
+			if (m_filterer.TakeResult (m_filterRows)) {
+				m_filtered = true;
+				m_shownFilter = std::move (m_pendingFilter);
+			}
+
+			// Rows must stay put while a sort or filter reads them, so both wait for the query to end.
+			const bool sortable = !m_query.running && m_query.status == db::QueryStatus::Ok;
+			const ImGuiInputTextFlags filterFlags = sortable ? ImGuiInputTextFlags_None : ImGuiInputTextFlags_ReadOnly;
+			if (ui::InputTextWithHintField ("##ResultFilter", "Filter (inc,-exc)", m_filterText.data (), m_filterText.size (), filterFlags)) {
+				FilterResults (true);
+			}
+
+			const std::span<const u32> order = m_filtered ? std::span<const u32> (m_filterRows) : std::span<const u32> (m_sortOrder);
+			settle = m_grid.Draw ("##QueryResults", ResultSetGridSource (m_query.results, order, m_filtered, sortable, m_columnStats), size);
+			std::vector<ui::SortSpec> specs;
+			if (m_grid.TakeSortSpecs (specs)) {
+				SortResults (specs);
+			}
+		}
+		if (settle && m_services.scheduler) {
+			m_services.scheduler->RequestAnimationFrame ();
+		}
+	}
+
+	void
+	App::SortResults (const std::vector<ui::SortSpec>& specs) {
+		m_sorter.Cancel ();
+		if (specs.empty ()) {
+			m_sortOrder.clear ();
+			return;
+		}
+
+		std::vector<db::SortKey> keys;
+		keys.reserve (specs.size ());
+		for (const ui::SortSpec& spec : specs) {
+			keys.push_back ({spec.column, spec.descending});
+		}
+		// The previous order stays on screen until the new one is ready.
+		FrameScheduler* scheduler = m_services.scheduler;
+		m_sorter.Start ([&results = m_query.results, keys = std::move (keys)] (std::stop_token stop) { return db::SortRows (results, keys, stop); },
+						[scheduler] {
+							if (scheduler) scheduler->RequestRedraw ();
+						});
+	}
+
+	void
+	App::FilterResults (bool refine) {
+		m_filterer.Cancel ();
+		db::RowFilter filter (m_filterText.data ());
+		if (filter.Empty ()) {
+			m_filterRows.clear ();
+			m_filtered = false;
+			return;
+		}
+
+		// A narrower filter only re-tests the rows the previous filter kept; anything else scans every row.
+		refine = refine && m_filtered && filter.Refines (m_shownFilter);
+		if (refine && m_filterRows.empty ()) {
+			m_shownFilter = std::move (filter);
+			return;
+		}
+
+		// As with sorting, the previous selection stays on screen until the new one is ready.
+		m_pendingFilter = filter;
+		FrameScheduler* scheduler = m_services.scheduler;
+		m_filterer.Start (
+			[&results = m_query.results, filter = std::move (filter), rows = refine ? m_filterRows : m_sortOrder] (std::stop_token stop) {
+				return db::FilterRows (results, filter, rows, stop);
+			},
+			[scheduler] {
+				if (scheduler) scheduler->RequestRedraw ();
+			});
+	}
+
+	void
+	App::RequestPages () {
+		// The initial page comes with the query; after a failure the cursor may be gone.
+		if (m_query.running || m_query.fetchFailed || m_query.status != db::QueryStatus::Ok) return;
+
+		m_pageRequests.clear ();
+		m_query.window.Plan (m_grid.FirstVisibleRow (), m_grid.VisibleRowCount (), m_pageRequests);
+		for (size_t firstRow : m_pageRequests) {
+			Database ().FetchRows (m_query.id, firstRow, db::WindowedResult::kPageRows);
+		}
+	}
+
+	void
+	App::RenderSchemaBrowser () {
+		if (m_connections.empty ()) {
+			ui::AlignContentStart ();
+			ui::TextMuted ("Add a connection first.");
+			return;
+		}
+		m_schemaConnection = std::min (m_schemaConnection, m_connections.size () - 1);
+		ConnectionInfo& conn = m_connections [m_schemaConnection];
+		db::SchemaCache& cache = *SchemaOf (conn);
+		const bool connected = conn.state == ConnectionState::Connected;
+
+		ui::AlignContentStart ();
+		if (ImGui::BeginCombo ("Connection##Schema", conn.name.c_str ())) {
+			for (size_t i = 0; i < m_connections.size (); ++i) {
+				ImGui::PushID (static_cast<int> (i));
+				if (ImGui::Selectable (m_connections [i].name.c_str (), i == m_schemaConnection)) {
+					m_schemaConnection = i;
+					m_schemaFocus.reset ();
+				}
+				ImGui::PopID ();
+			}
+			ImGui::EndCombo ();
+		}
+		ImGui::SameLine ();
+		if (!connected) {
+			if ((conn.state == ConnectionState::Disconnected || conn.state == ConnectionState::Failed) && ImGui::SmallButton ("Connect")) {
+				Connect (conn);
+			}
+		}
+		else if (!cache.Busy () && ImGui::SmallButton ("Refresh")) {
+			Database ().RefreshCatalog (conn.id, conn.schema);
+		}
+		ImGui::SameLine ();
+		if (cache.Busy ()) {
+			ui::TextMuted ("Loading...");
+		}
+		else if (const std::string error = cache.Error (); !error.empty ()) {
+			ImGui::TextWrapped ("Error: %s", error.c_str ());
+		}
+		else if (!cache.Loaded ()) {
+			ui::TextMuted (connected ? "Loading..." : "Connect to load the schema.");
+		}
+
+		// The tree is copied out only when it changed, and only the visible rows are drawn.
+		if (m_schemaShown != &cache || cache.Generation () != m_schemaGeneration) {
+			m_schemaShown = &cache;
+			m_schemaGeneration = cache.Generation ();
+			cache.Rows (m_schemaRows);
+			// Rows carry only their own name, so the node opened from the palette is found by path.
+			m_schemaFocusRow = ~size_t{0};
+			if (m_schemaFocus) {
+				const SchemaNode& focus = *m_schemaFocus;
+				const u32 depth = focus.table.empty () ? 0 : focus.column.empty () ? 1 : 2;
+				std::string_view schema;
+				std::string_view table;
+				for (size_t i = 0; i < m_schemaRows.size (); ++i) {
+					const db::SchemaCache::Row& row = m_schemaRows [i];
+					if (row.depth == 0) schema = row.name;
+					if (row.depth == 1) table = row.name;
+					if (row.depth == depth && schema == focus.schema && (depth == 0 || table == focus.table) && (depth < 2 || row.name == focus.column)) {
+						m_schemaFocusRow = i;
+						break;
+					}
+				}
+			}
+		}
+
+		ui::AlignContentStart ();
+		if (ImGui::BeginChild ("##SchemaTree", ImVec2 (0.0f, -ui::kMetrics.quitReserveY), false)) {
+			const float indent = ImGui::GetFontSize ();
+			if (m_schemaScroll && m_schemaFocusRow < m_schemaRows.size ()) {
+				ImGui::SetScrollY (static_cast<float> (m_schemaFocusRow) * ImGui::GetTextLineHeightWithSpacing () - ImGui::GetWindowHeight () * 0.5f);
+			}
+			m_schemaScroll = false;
+			std::optional<std::pair<u32, u32>> toggled;
+			ImGuiListClipper clipper;
+			clipper.Begin (static_cast<int> (m_schemaRows.size ()));
+			while (clipper.Step ()) {
+				for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+					const db::SchemaCache::Row& row = m_schemaRows [static_cast<size_t> (i)];
+					ImGui::PushID (i);
+					ImGui::SetCursorPosX (ImGui::GetCursorPosX () + indent * static_cast<float> (row.depth));
+					const char* marker = !row.expandable ? "  " : row.expanded ? "v " : "> ";
+					std::string label = marker + row.name;
+					if (!row.detail.empty ()) label += "  " + row.detail;
+					if (row.loading) label += "  (loading)";
+					if (ImGui::Selectable (label.c_str (), static_cast<size_t> (i) == m_schemaFocusRow) && row.expandable) {
+						toggled.emplace (row.schema, row.table);
+					}
+					ImGui::PopID ();
+				}
+			}
+			if (toggled) {
+				m_schemaFocus.reset ();
+				if (std::optional<db::CatalogPath> load = cache.Toggle (toggled->first, toggled->second, connected)) {
+					Database ().LoadCatalog (conn.id, conn.schema, std::move (*load));
+				}
+			}
+		}
+		ImGui::EndChild ();
+	}
+
+	void
+	App::RenderDataGrid () {
+		ui::AlignContentStart ();
+		if (m_query.ColumnCount () == 0) {
+			ui::TextMuted ("Run a query to browse its result here.");
+			return;
+		}
+
+		if (m_query.windowed) {
+			const db::WindowedResult& window = m_query.window;
+			ImGui::Text ("%zu%s rows x %zu columns, %zu pages cached, %.1f MiB",
+						 window.KnownRows (),
+						 window.Complete () ? "" : "+",
+						 window.ColumnCount (),
+						 window.CachedPages (),
+						 static_cast<double> (window.MemoryBytes ()) / (1024.0 * 1024.0));
+			ui::AlignContentStart ();
+			for (size_t column = 0; column < window.ColumnCount (); ++column) {
+				if (column > 0) ImGui::SameLine ();
+				const db::ColumnInfo& info = window.Column (column);
+				ImGui::TextDisabled ("%s:%s", info.name.c_str (), info.declaredType.empty () ? "?" : info.declaredType.c_str ());
+			}
+		}
+		else {
+			const db::ResultSet& results = m_query.results;
+			ImGui::Text ("%zu rows x %zu columns, %.1f MiB in memory, %.1f MiB spilled to disk",
+						 results.RowCount (),
+						 results.ColumnCount (),
+						 static_cast<double> (results.MemoryBytes ()) / (1024.0 * 1024.0),
+						 static_cast<double> (results.SpilledBytes ()) / (1024.0 * 1024.0));
+			ui::AlignContentStart ();
+			for (size_t column = 0; column < results.ColumnCount (); ++column) {
+				if (column > 0) ImGui::SameLine ();
+				ImGui::TextDisabled ("%s:%s", results.Column (column).name.c_str (), db::ColumnTypeName (results.Type (column)));
+			}
+		}
+
+		ui::AlignContentStart ();
+		const size_t rows = m_filtered ? m_filterRows.size () : m_query.KnownRows ();
+		ImGui::Text ("rows %zu-%zu of %zu%s%s%s%s",
+					 rows ? m_grid.FirstVisibleRow () + 1 : 0,
+					 std::min (m_grid.FirstVisibleRow () + m_grid.VisibleRowCount (), rows),
+					 rows,
+					 m_query.MoreRows () ? "+" : "",
+					 m_filtered ? " matching" : "",
+					 m_sorter.Running () ? ", sorting..." : "",
+					 m_filterer.Running () ? ", filtering..." : "");
+		ImGui::SameLine ();
+		ImGui::PushItemWidth (ImGui::CalcTextSize ("0000000000000").x);
+		if (ImGui::InputScalar ("Go to row", ImGuiDataType_U64, &m_gotoRow, nullptr, nullptr, "%llu", ImGuiInputTextFlags_EnterReturnsTrue)) {
+			const size_t row = m_gotoRow > 0 ? static_cast<size_t> (m_gotoRow - 1) : 0;
+			// Windowed results may not know that far yet; the grid shows placeholders until the page arrives.
+			if (m_query.MoreRows ()) m_query.window.Extend (row);
+			m_grid.JumpToRow (row);
+		}
+		ImGui::PopItemWidth ();
+
+		ui::Gap (ui::kMetrics.rowGapY);
+		ResultGrid ();
+	}
+
+	void
+	App::RenderQueryHistory () {
+		constexpr size_t kSearchHits = 1000;
+		constexpr i64 kDayMs = 24 * 60 * 60 * 1000;
+		constexpr std::array<std::pair<const char*, i64>, 4> kSince = {{
+			{"All time", 0},
+			{"Last 24 hours", kDayMs},
+			{"Last 7 days", 7 * kDayMs},
+			{"Last 30 days", 30 * kDayMs},
+		}};
+
+		ui::AlignContentStart ();
+		HistoryStore* history = History ();
+		if (!history) {
+			ui::TextMuted (m_historyError.c_str ());
+			return;
+		}
+
+		const float width = ImGui::GetFontSize () * 12.0f;
+		if (ui::InputTextWithHintField ("##HistorySearch", "Search queries...", m_historyText.data (), m_historyText.size (), 0, width * 2.0f)) {
+			m_historyStale = true;
+		}
+		ImGui::SameLine ();
+		ImGui::PushItemWidth (width);
+		const std::string connectionLabel (m_historyConnection < 0 ? "All connections" : history->ConnectionName (static_cast<u32> (m_historyConnection)));
+		if (ImGui::BeginCombo ("##HistoryConnection", connectionLabel.c_str ())) {
+			if (ImGui::Selectable ("All connections", m_historyConnection < 0)) {
+				m_historyConnection = -1;
+				m_historyStale = true;
+			}
+			for (u32 i = 0; i < history->ConnectionCount (); ++i) {
+				ImGui::PushID (static_cast<int> (i));
+				const std::string name (history->ConnectionName (i));
+				if (ImGui::Selectable (name.c_str (), static_cast<int> (i) == m_historyConnection)) {
+					m_historyConnection = static_cast<int> (i);
+					m_historyStale = true;
+				}
+				ImGui::PopID ();
+			}
+			ImGui::EndCombo ();
+		}
+		ImGui::SameLine ();
+		if (ImGui::BeginCombo ("##HistorySince", kSince [m_historySince].first)) {
+			for (int i = 0; i < static_cast<int> (kSince.size ()); ++i) {
+				if (ImGui::Selectable (kSince [i].first, i == m_historySince)) {
+					m_historySince = i;
+					m_historyStale = true;
+				}
+			}
+			ImGui::EndCombo ();
+		}
+		ImGui::PopItemWidth ();
+
+		const i64 window = kSince [m_historySince].second;
+		const i64 since =
+			window > 0 ? std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::system_clock::now ().time_since_epoch ()).count () - window : 0;
+		HistoryFilter filter;
+		filter.since = since;
+		if (m_historyConnection >= 0) filter.connection = static_cast<u32> (m_historyConnection);
+
+		// Without search text the list reads the store's index files in place, whatever
+		// their size: rows are a range of all entries or of one connection's entries.
+		const bool searching = m_historyText [0] != '\0';
+		std::span<const u32> entries;
+		u32 first = 0;
+		size_t rows = 0;
+		if (searching) {
+			if (m_historyStale || history->Generation () != m_historyGeneration) {
+				history->Search (m_historyText.data (), kSearchHits, m_historyRows, filter);
+			}
+			rows = m_historyRows.size ();
+		}
+		else if (m_historyConnection >= 0) {
+			entries = history->EntriesOf (static_cast<u32> (m_historyConnection));
+			entries = entries.subspan (static_cast<size_t> (
+				std::ranges::partition_point (entries, [&] (u32 entry) { return history->At (entry).time < since; }) - entries.begin ()));
+			rows = entries.size ();
+		}
+		else {
+			first = history->FirstAtOrAfter (since);
+			rows = history->Size () - first;
+		}
+		m_historyStale = false;
+		m_historyGeneration = history->Generation ();
+		// Newest first.
+		const auto entryAt = [&] (size_t row) -> u32 {
+			if (searching) return m_historyRows [row];
+			if (!entries.empty ()) return entries [entries.size () - 1 - row];
+			return static_cast<u32> (first + rows - 1 - row);
+		};
+
+		ui::AlignContentStart ();
+		ImGui::Text ("%zu%s queries", rows, searching && rows == kSearchHits ? "+" : "");
+
+		ui::AlignContentStart ();
+		if (ImGui::BeginChild ("##HistoryList", ImVec2 (0.0f, -ui::kMetrics.quitReserveY), false)) {
+			ImGuiListClipper clipper;
+			clipper.Begin (static_cast<int> (rows));
+			while (clipper.Step ()) {
+				for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+					const HistoryEntry item = history->At (entryAt (static_cast<size_t> (row)));
+					const std::time_t seconds = static_cast<std::time_t> (item.time / 1000);
+					std::tm local{};
+					localtime_r (&seconds, &local);
+					char when [32];
+					std::strftime (when, sizeof (when), "%Y-%m-%d %H:%M:%S", &local);
+					// One line per entry: the SQL up to its first line break.
+					const std::string_view sql = item.sql.substr (0, std::min<size_t> (item.sql.find_first_of ("\r\n"), 200));
+					const std::string connection (history->ConnectionName (item.connection));
+					char label [512];
+					std::snprintf (label,
+								   sizeof (label),
+								   "%s  %-20.20s %-9s %10.1f ms  %.*s",
+								   when,
+								   connection.c_str (),
+								   QueryStatusLabel (item.status),
+								   item.elapsedMs,
+								   static_cast<int> (sql.size ()),
+								   sql.data ());
+					ImGui::PushID (row);
+					if (ImGui::Selectable (label)) OpenHistoryEntry (entryAt (static_cast<size_t> (row)));
+					ImGui::PopID ();
+				}
+			}
+		}
+		ImGui::EndChild ();
+	}
+
+	void
+	App::OpenHistoryEntry (u32 entry) {
+		const HistoryEntry item = m_history->At (entry);
+		m_queryEditor.SetText (item.sql);
+		const std::string connection (m_history->ConnectionName (item.connection));
+		const auto conn = std::ranges::find (m_connections, connection, &ConnectionInfo::name);
+		if (conn != m_connections.end ()) m_queryConnection = static_cast<size_t> (conn - m_connections.begin ());
+		m_activePage = Page::QueryEditor;
+	}
+
+	db::QueryExecutor&
+	App::Database () {
+		if (!m_database) {
+			FrameScheduler* scheduler = m_services.scheduler;
+			// Workers only ever wake the loop; all App state changes happen in PollDatabase().
+			m_database = std::make_unique<db::QueryExecutor> (0, [scheduler] {
+				if (scheduler) scheduler->RequestRedraw ();
+			});
+		}
+		return *m_database;
+	}
+
+	void
+	App::PollDatabase () {
+		if (!m_database) return;
+
+		m_dbEvents.clear ();
+		m_database->DrainEvents (m_dbEvents);
+		for (db::DbEvent& event : m_dbEvents) {
+			ConnectionInfo* conn = FindConnection (event.connection);
+			const bool current = event.query != 0 && event.query == m_query.id;
+			switch (event.kind) {
+				case db::DbEvent::Kind::Connected:
+					if (conn) {
+						conn->state = ConnectionState::Connected;
+						conn->error.clear ();
+						// The tree shows from the snapshot at once; bring it up to date behind it.
+						Database ().RefreshCatalog (conn->id, SchemaOf (*conn));
+					}
+					break;
+				case db::DbEvent::Kind::ConnectFailed:
+					if (conn) {
+						conn->state = ConnectionState::Failed;
+						conn->error = std::move (event.error);
+						conn->id = 0;
+					}
+					// Release the executor's slot; its Closed event no longer matches anything.
+					m_database->Close (event.connection);
+					break;
+				case db::DbEvent::Kind::Closed:
+					if (conn) {
+						conn->state = ConnectionState::Disconnected;
+						conn->id = 0;
+					}
+					break;
+				case db::DbEvent::Kind::QueryColumns:
+					if (!current) break;
+					// Statements that change data come back in full even when paging was asked for.
+					m_query.windowed = event.windowed;
+					if (m_query.windowed) {
+						m_query.window.Reset (std::move (event.columns));
+					}
+					else {
+						m_query.results.Reset (std::move (event.columns));
+					}
+					break;
+				case db::DbEvent::Kind::QueryRows:
+					if (current) m_query.results.Append (event.rows);
+					break;
+				case db::DbEvent::Kind::QueryPage:
+					if (!current) break;
+					if (!event.error.empty ()) {
+						m_query.window.PageFailed (event.firstRow);
+						m_query.fetchFailed = true;
+						m_query.error = std::move (event.error);
+					}
+					else {
+						m_query.window.AddPage (event.firstRow, event.rows, event.endOfData);
+					}
+					break;
+				case db::DbEvent::Kind::QueryFinished:
+					if (!current) break;
+					m_query.running = false;
+					m_query.status = event.status;
+					m_query.rowsAffected = event.rowsAffected;
+					m_query.elapsedMs = std::chrono::duration<double, std::milli> (event.elapsed).count ();
+					m_query.error = std::move (event.error);
+					if (HistoryStore* history = History ()) {
+						history->Append ({m_query.connection,
+										  m_query.sql,
+										  m_query.status,
+										  m_query.elapsedMs,
+										  m_query.ColumnCount () > 0 ? static_cast<i64> (m_query.KnownRows ()) : m_query.rowsAffected});
+					}
+					// A filter kept from the previous result applies once the rows are complete.
+					if (!m_query.windowed && m_query.status == db::QueryStatus::Ok) FilterResults (false);
+					if (m_services.scheduler) m_services.scheduler->EndAnimation ();
+					break;
+			}
+		}
+
+		// Windowed results never hold every row, so only full results get stats. Feeding
+		// every frame hands over groups the engine held back while it was busy.
+		if (!m_query.windowed && m_query.ColumnCount () > 0) Statistics ().Feed (m_query.results, !m_query.running);
+		if (m_stats && m_stats->Generation () != m_statsGeneration) {
+			m_statsGeneration = m_stats->Generation ();
+			m_stats->Snapshot (m_columnStats);
+		}
+	}
+
+	void
+	App::Connect (ConnectionInfo& conn) {
+		conn.state = ConnectionState::Connecting;
+		conn.error.clear ();
+		conn.id = Database ().Open (conn.params);
+	}
+
+	void
+	App::Disconnect (ConnectionInfo& conn) {
+		if (conn.id == 0) return;
+		Database ().Close (conn.id);
+	}
+
+	void
+	App::RunQuery () {
+		const ConnectionInfo& conn = m_connections [m_queryConnection];
+		if (m_query.running || conn.state != ConnectionState::Connected) return;
+
+		if (m_query.windowed && m_query.id != 0) {
+			Database ().Release (m_query.id);
+		}
+		m_sorter.Cancel ();
+		m_filterer.Cancel ();
+		m_exportThread = {};  // Cancels and joins an export of the rows about to go.
+		m_sortOrder.clear ();
+		m_filterRows.clear ();
+		m_filtered = false;
+		if (m_stats) m_stats->Reset ();
+		m_columnStats.clear ();
+		m_query = QueryRun{};
+		m_query.running = true;
+		m_query.windowed = m_fetchOnScroll;
+		m_grid.Reset ();
+		std::string sql = m_queryEditor.Text ().Text ();
+		m_query.sql = sql;
+		m_query.connection = conn.name;
+		m_query.id = m_fetchOnScroll
+						 ? Database ().ExecuteWindowed (conn.id, std::move (sql), db::WindowedResult::kPageRows)
+						 : Database ().Execute (conn.id, std::move (sql));
+		if (m_services.scheduler) m_services.scheduler->BeginAnimation ();
+	}
+
+	ConnectionInfo*
+	App::FindConnection (db::ConnectionId id) {
+		if (id == 0) return nullptr;
+		const auto it = std::ranges::find (m_connections, id, &ConnectionInfo::id);
+		return it != m_connections.end () ? &*it : nullptr;
+	}
+
+	db::StatsEngine&
+	App::Statistics () {
+		if (!m_stats) {
+			FrameScheduler* scheduler = m_services.scheduler;
+			// Fresh stats wake the loop; PollDatabase () picks them up.
+			m_stats = std::make_unique<db::StatsEngine> ([scheduler] {
+				if (scheduler) scheduler->RequestRedraw ();
+			});
+		}
+		return *m_stats;
+	}
+
+	HistoryStore*
+	App::History () {
+		if (!m_historyOpened) {
+			m_historyOpened = true;
+			const std::optional<std::filesystem::path> directory = HistoryStore::DefaultDirectory ();
+			if (!directory) {
+				m_historyError = "No data directory: set AMBIDB_DATA_DIR or HOME.";
+				return nullptr;
+			}
+			FrameScheduler* scheduler = m_services.scheduler;
+			// Commits wake the loop so an open history page shows the new entry.
+			auto opened = HistoryStore::Open (*directory, [scheduler] {
+				if (scheduler) scheduler->RequestRedraw ();
+			});
+			if (opened) {
+				m_history = std::move (*opened);
+			}
+			else {
+				m_historyError = std::move (opened.error ());
+			}
+		}
+		return m_history.get ();
+	}
+
+	const std::shared_ptr<db::SchemaCache>&
+	App::SchemaOf (ConnectionInfo& conn) {
+		if (!conn.schema) {
+			// Without a data directory the cache still works, in memory only.
+			const std::optional<std::filesystem::path> directory = HistoryStore::DefaultDirectory ();
+			FrameScheduler* scheduler = m_services.scheduler;
+			conn.schema = db::SchemaCache::Open (directory ? *directory / "schema" / db::SchemaCache::SnapshotName (conn.params) : std::filesystem::path (),
+												 [scheduler] {
+													 if (scheduler) scheduler->RequestRedraw ();
+												 });
+		}
+		return conn.schema;
+	}
+
+	SearchIndex&
+	App::Search () {
+		if (!m_search) {
+			FrameScheduler* scheduler = m_services.scheduler;
+			// Batches land on the index thread; an open palette searches again next frame.
+			m_search = std::make_unique<SearchIndex> ([scheduler] {
+				if (scheduler) scheduler->RequestRedraw ();
+			});
+			for (const Page page : kPages) {
+				m_search->Add (SearchKind::Page, PageTitle (page), static_cast<u64> (page));
+			}
+			for (size_t i = 0; i < m_connections.size (); ++i) IndexConnection (i);
+		}
+		return *m_search;
+	}
+
+	void
+	App::IndexConnection (size_t index) {
+		if (!m_search) return;
+		m_search->Add (SearchKind::Connection, m_connections [index].name, index);
+	}
+
+	void
+	App::IndexSchemas () {
+		if (!m_search) return;
+		m_schemaSearch.resize (m_connections.size ());
+		for (size_t i = 0; i < m_connections.size (); ++i) {
+			const db::SchemaCache& cache = *SchemaOf (m_connections [i]);
+			SchemaSearch& indexed = m_schemaSearch [i];
+			const u64 content = cache.ContentGeneration ();
+			if (indexed.content == content) continue;
+			indexed.content = content;
+			for (const u32 entry : indexed.entries) m_search->Remove (entry);
+			indexed.entries.clear ();
+			indexed.nodes.clear ();
+
+			// Names are indexed qualified, so a table found in two schemas tells them apart.
+			// The target holds the connection in its high half and the node in its low half.
+			SchemaNode node;
+			cache.Visit ([&] (u32 depth, const db::CatalogEntry& entry, bool) {
+				SearchKind kind = SearchKind::Column;
+				std::string text;
+				if (depth == 0) {
+					node = {entry.name, {}, {}};
+					kind = SearchKind::Schema;
+					text = node.schema;
+				}
+				else if (depth == 1) {
+					node.table = entry.name;
+					node.column.clear ();
+					kind = SearchKind::Table;
+					text = node.schema + "." + node.table;
+				}
+				else {
+					node.column = entry.name;
+					text = node.schema + "." + node.table + "." + node.column;
+				}
+				const u64 target = static_cast<u64> (i) << 32 | indexed.nodes.size ();
+				indexed.entries.push_back (m_search->Add (kind, std::move (text), target));
+				indexed.nodes.push_back (node);
+			});
+		}
+	}
+
+	void
+	App::RenderSearchPalette () {
+		constexpr const char* kPopupId = "Search";
+		constexpr size_t kResults = 12;
+		constexpr size_t kHistoryResults = 4;  // Of the kResults rows.
+		constexpr size_t kHistoryText = 200;
+
+		if (ImGui::GetIO ().KeyCtrl && ImGui::IsKeyPressed (ImGuiKey_P, false)) {
+			m_openSearch = true;
+		}
+		if (m_openSearch) {
+			m_openSearch = false;
+			m_searchText [0] = '\0';
+			m_searchHits.clear ();
+			m_searchSelection = 0;
+			ui::OpenPopup (kPopupId);
+		}
+		if (!ui::BeginCenteredModal (kPopupId)) return;
+
+		SearchIndex& index = Search ();
+		IndexSchemas ();
+		HistoryStore* history = History ();
+		if (ImGui::IsWindowAppearing ()) ImGui::SetKeyboardFocusHere ();
+		const float width = ImGui::GetMainViewport ()->WorkSize.x * 0.5f;
+		const bool edited = ui::InputTextWithHintField ("##SearchText", "Pages, connections, tables, queries...", m_searchText.data (), m_searchText.size (), 0, width);
+		// Rank again when the text changes, the index has taken in more names or queries were stored.
+		const u64 historyGeneration = history ? history->Generation () : 0;
+		if (edited || index.Generation () != m_searchGeneration || historyGeneration != m_searchHistoryGeneration) {
+			m_searchGeneration = index.Generation ();
+			m_searchHistoryGeneration = historyGeneration;
+			index.Search (m_searchText.data (), kResults, m_searchHits);
+			// Stored queries come from the history's own word index, listed after the names.
+			if (history) {
+				history->Search (m_searchText.data (), kHistoryResults, m_searchHistory);
+				m_searchHits.resize (std::min (m_searchHits.size (), kResults - m_searchHistory.size ()));
+				for (const u32 entry : m_searchHistory) {
+					const std::string_view sql = history->At (entry).sql;
+					SearchHit hit;
+					hit.kind = SearchKind::History;
+					hit.target = entry;
+					// Shown on one line in the palette.
+					hit.text.assign (sql.substr (0, kHistoryText));
+					std::ranges::replace_if (hit.text, [] (char c) { return c == '\n' || c == '\r' || c == '\t'; }, ' ');
+					m_searchHits.push_back (std::move (hit));
+				}
+			}
+			if (edited) m_searchSelection = 0;
+		}
+
+		if (ImGui::IsKeyPressed (ImGuiKey_DownArrow)) ++m_searchSelection;
+		if (ImGui::IsKeyPressed (ImGuiKey_UpArrow) && m_searchSelection > 0) --m_searchSelection;
+		m_searchSelection = std::min (m_searchSelection, m_searchHits.empty () ? 0 : m_searchHits.size () - 1);
+
+		const SearchHit* chosen = nullptr;
+		for (size_t i = 0; i < m_searchHits.size (); ++i) {
+			const SearchHit& hit = m_searchHits [i];
+			ImGui::PushID (static_cast<int> (i));
+			ImGui::TextDisabled ("%-10s", SearchKindName (hit.kind));
+			ImGui::SameLine ();
+			if (ImGui::Selectable (hit.text.c_str (), i == m_searchSelection)) chosen = &hit;
+			ImGui::PopID ();
+		}
+		if (m_searchHits.empty () && m_searchText [0] != '\0') {
+			ui::TextMuted ("No matches");
+		}
+		if (ImGui::IsKeyPressed (ImGuiKey_Enter) && !m_searchHits.empty ()) {
+			chosen = &m_searchHits [m_searchSelection];
+		}
+
+		if (chosen) {
+			OpenSearchHit (*chosen);
+			ImGui::CloseCurrentPopup ();
+		}
+		else if (ImGui::IsKeyPressed (ImGuiKey_Escape)) {
+			ImGui::CloseCurrentPopup ();
+		}
+		ui::EndModal ();
+	}
+
+	void
+	App::OpenSearchHit (const SearchHit& hit) {
+		switch (hit.kind) {
+			case SearchKind::Page: m_activePage = static_cast<Page> (hit.target); break;
+			case SearchKind::Connection:
+				if (hit.target < m_connections.size ()) {
+					m_queryConnection = hit.target;
+					m_activePage = Page::QueryEditor;
+				}
+				break;
+			case SearchKind::History:
+				if (const HistoryStore* history = m_history.get (); history && hit.target < history->Size ()) {
+					OpenHistoryEntry (static_cast<u32> (hit.target));
+				}
+				break;
+			case SearchKind::Schema:
+			case SearchKind::Table:
+			case SearchKind::Column: {
+				const size_t connection = static_cast<size_t> (hit.target >> 32);
+				const size_t node = static_cast<size_t> (hit.target & 0xFFFFFFFF);
+				if (connection >= m_schemaSearch.size () || node >= m_schemaSearch [connection].nodes.size ()) break;
+				const SchemaNode& found = m_schemaSearch [connection].nodes [node];
+				// Its parents are loaded, or it would not have been indexed; open the path down to it.
+				SchemaOf (m_connections [connection])->Reveal (found.schema, found.table);
+				m_schemaConnection = connection;
+				m_schemaFocus = found;
+				m_schemaShown = nullptr;
+				m_schemaScroll = true;
+				m_activePage = Page::SchemaBrowser;
+				break;
+			}
+		}
+	}
+
+	void
+	App::RenderSettings () {
+		ui::AlignContentStart ();
+		ImGui::Checkbox ("Show frame timing overlay", &m_showFrameOverlay);
+	}
+
+	void
+	App::RenderFrameTimingOverlay () {
+		if (!m_services.timings) return;
+
+		const ImGuiViewport* viewport = ImGui::GetMainViewport ();
+		ImGui::SetNextWindowPos (ImVec2 (viewport->WorkPos.x + viewport->WorkSize.x, viewport->WorkPos.y),
+								 ImGuiCond_Always,
+								 ImVec2 (1.0f, 0.0f));
+		ImGui::SetNextWindowBgAlpha (0.85f);
+		constexpr ImGuiWindowFlags kOverlayFlags = ImGuiWindowFlags_NoDecoration |
+												   ImGuiWindowFlags_AlwaysAutoResize |
+												   ImGuiWindowFlags_NoSavedSettings |
+												   ImGuiWindowFlags_NoFocusOnAppearing |
+												   ImGuiWindowFlags_NoNav |
+												   ImGuiWindowFlags_NoInputs;
+		if (ImGui::Begin ("##FrameTimingOverlay", nullptr, kOverlayFlags)) {
+			FrameTimingTable (m_services.timings->Summarize ());
+		}
+		ImGui::End ();
+	}
+
+	void
+	App::FrameTimingTable (const FrameTimingStats& stats) {
+		ui::AlignContentStart ();
+		ui::TextMuted ("phase        p50 ms   p99 ms   max ms");
+		const auto row = [] (const char* name, const PhaseStats& phase) {
+			ui::AlignContentStart ();
+			ImGui::Text ("%-10s %8.3f %8.3f %8.3f", name, phase.p50Ms, phase.p99Ms, phase.maxMs);
+		};
+		for (size_t i = 0; i < kFramePhaseCount; ++i) {
+			row (FramePhaseName (static_cast<FramePhase> (i)), stats.phases [i]);
+		}
+		row ("total", stats.total);
+		if (stats.output.maxBytes > 0) {
+			ui::AlignContentStart ();
+			ImGui::Text ("%-10s %7u B %7u B %7u B", "output", stats.output.p50Bytes, stats.output.p99Bytes, stats.output.maxBytes);
+		}
+		ui::AlignContentStart ();
+		ImGui::Text ("%zu frames sampled", stats.samples);
+		if (m_services.presentGate) {
+			ui::AlignContentStart ();
+			ImGui::Text ("%llu presented, %llu unchanged (skipped)",
+						 static_cast<unsigned long long> (m_services.presentGate->PresentedFrames ()),
+						 static_cast<unsigned long long> (m_services.presentGate->ElidedFrames ()));
+		}
+	}
+
 }  // namespace ambidb
@@ -1,8 +1,32 @@
 #pragma once
 #include <macro.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "db/column_stats.h"
+#include "db/exporter.h"
+#include "db/importer.h"
+#include "db/query_executor.h"
+#include "db/result_filter.h"
+#include "db/result_set.h"
+#include "db/row_task.h"
+#include "db/schema_cache.h"
+#include "db/windowed_result.h"
+#include "frame_scheduler.h"
+#include "frame_timing.h"
+#include "history_store.h"
+#include "present_gate.h"
+#include "search_index.h"
+#include "sql_completion.h"
+#include "sql_lexer.h"
+#include "ui/data_grid.h"
+#include "ui/text_editor.h"
+
 namespace ambidb {
 
 	enum class Page {
@@ -15,17 +39,98 @@ namespace ambidb {
 		Settings,
 	};
 
+	const char*
+	PageTitle (Page page);
+
+	enum class ConnectionState {
+		Disconnected,
+		Connecting,
+		Connected,
+		Failed,
+	};
+
 	struct ConnectionInfo {
 		std::string name;
-		std::string type;  // "postgresql", "mysql", "sqlite"
-		bool connected{false};
+		db::ConnectionParams params;  // params.driver: "postgresql", "mysql", "sqlite"
+		ConnectionState state{ConnectionState::Disconnected};
+		db::ConnectionId id{0};	 ///< Executor handle while Connecting or Connected.
+		std::string error;		 ///< Why the last connect attempt failed.
+		std::shared_ptr<db::SchemaCache> schema;  ///< Opened on first use, from its snapshot.
+	};
+
+	/**
+	 * @brief The query last run from the Query Editor, filled in as its events arrive.
+	 */
+	struct QueryRun {
+		db::QueryId id{0};	// 0 until the first query runs.
+		std::string sql;
+		std::string connection;	 ///< Name of the connection it runs on, for the history.
+		bool running{false};
+		bool windowed{false};	  ///< Rows are fetched as the grid scrolls, into window.
+		bool fetchFailed{false};  ///< A windowed page failed; stop asking for more.
+		db::ResultSet results;	  ///< Every row, when not windowed.
+		db::WindowedResult window;
+		db::QueryStatus status{db::QueryStatus::Ok};
+		i64 rowsAffected{0};
+		double elapsedMs{0.0};
+		std::string error;
+
+		size_t
+		ColumnCount () const {
+			return windowed ? window.ColumnCount () : results.ColumnCount ();
+		}
+
+		/// Rows received so far; for windowed queries, how far the result is known to go.
+		size_t
+		KnownRows () const {
+			return windowed ? window.KnownRows () : results.RowCount ();
+		}
+
+		bool
+		MoreRows () const {
+			return windowed && !window.Complete ();
+		}
+	};
+
+	/**
+	 * @brief Colors the Query Editor by SQL token. Edits reach the highlighter as line
+	 * ranges, so it re-lexes only what they changed.
+	 */
+	class SqlEditorColors final : public ui::TextEditorColors {
+	public:
+		void
+		SetDialect (SqlDialect dialect) {
+			m_highlighter.SetDialect (dialect);
+		}
+
+		void
+		Edited (u32 line, u32 removed, u32 inserted) override {
+			m_highlighter.Edited (line, removed, inserted);
+		}
+
+		void
+		Colors (const TextBuffer& text, u32 line, u32 from, u32 to, std::vector<ui::TextColor>& out) override;
+
+	private:
+		SqlHighlighter m_highlighter;
+		std::string m_scratch;
+	};
+
+	/**
+	 * @brief Frame-loop services owned by the backend and lent to App.
+	 * All pointers are null when App runs without a backend (e.g. unit tests).
+	 */
+	struct FrameServices {
+		FrameScheduler* scheduler{nullptr};
+		FrameTimings* timings{nullptr};
+		const PresentGate* presentGate{nullptr};
 	};
 
 	class App {
 	public:
 		MAKE_NONCOPYABLE (App);
 		MAKE_NONMOVABLE (App);
-		App ();
+		explicit App (FrameServices services = {});
 		~App () = default;
 
 		void
@@ -35,20 +140,214 @@ namespace ambidb {
 			return m_shouldClose;
 		}
 
+		Page
+		ActivePage () const {
+			return m_activePage;
+		}
+
+		void
+		SetActivePage (Page page) {
+			m_activePage = page;
+		}
+
 	private:
+		/// A schema, table or column the palette can open in the Schema Browser.
+		struct SchemaNode {
+			std::string schema;
+			std::string table;	 ///< Empty for a schema.
+			std::string column;	 ///< Empty for a schema or table.
+		};
+
+		/// What the palette has indexed of one connection's schema cache.
+		struct SchemaSearch {
+			std::optional<u64> content;	 ///< ContentGeneration () indexed; none before the first pass.
+			std::vector<u32> entries;	 ///< Search index ids, to remove when the cache changes.
+			std::vector<SchemaNode> nodes;
+		};
+
 		void
 		RenderSidebar ();
 		void
 		RenderContent ();
 		void
+		RenderDashboard ();
+		void
+		RenderSettings ();
+		void
+		RenderFrameTimingOverlay ();
+		void
+		RenderSearchPalette ();
+		void
+		OpenSearchHit (const SearchHit& hit);
+		void
+		FrameTimingTable (const FrameTimingStats& stats);
+		void
+		ColumnStatsTable ();
+		void
 		ConnectionEntry (const ConnectionInfo& conn);
+		void
+		RenderConnections ();
+		void
+		RenderNewConnectionDialog ();
+		void
+		RenderQueryEditor ();
+		/// Hand the connection's schema cache to the completer, which reindexes it if it changed.
+		void
+		UpdateCompleter (ConnectionInfo& conn);
+		void
+		CompleteQuery (ConnectionInfo& conn);
+		void
+		RenderCompletions (ConnectionInfo& conn);
+		void
+		RenderExport ();
+		void
+		StartExport (bool storedResult);
+		void
+		CancelExport ();
+		void
+		RenderImport ();
+		void
+		StartImport ();
+		void
+		ResultGrid ();
+		void
+		SortResults (const std::vector<ui::SortSpec>& specs);
+		void
+		FilterResults (bool refine);
+		void
+		RequestPages ();
+		void
+		RenderDataGrid ();
+		void
+		RenderQueryHistory ();
+		/// Load a stored query into the Query Editor, on the connection it ran on.
+		void
+		OpenHistoryEntry (u32 entry);
+		void
+		RenderSchemaBrowser ();
+
+		db::QueryExecutor&
+		Database ();
+		void
+		PollDatabase ();
+		void
+		Connect (ConnectionInfo& conn);
+		void
+		Disconnect (ConnectionInfo& conn);
+		void
+		RunQuery ();
+		ConnectionInfo*
+		FindConnection (db::ConnectionId id);
 
+		db::StatsEngine&
+		Statistics ();
+
+		SearchIndex&
+		Search ();
+		void
+		IndexConnection (size_t index);
+		/// Index the entries of every connection's schema cache whose content moved.
+		void
+		IndexSchemas ();
+
+		HistoryStore*
+		History ();
+		const std::shared_ptr<db::SchemaCache>&
+		SchemaOf (ConnectionInfo& conn);
+
+		FrameServices m_services;
 		bool m_shouldClose{false};
+		bool m_showFrameOverlay{false};
 
 		Page m_activePage{Page::Dashboard};
 		bool m_connectionsExpanded{true};
 
 		std::vector<ConnectionInfo> m_connections;
+		bool m_openNewConnection{false};
+		std::array<char, 128> m_newConnectionName{};
+		std::array<char, 512> m_newConnectionTarget{};
+
+		size_t m_schemaConnection{0};
+		std::vector<db::SchemaCache::Row> m_schemaRows;	 ///< Tree of m_schemaShown as last read.
+		const db::SchemaCache* m_schemaShown{nullptr};
+		u64 m_schemaGeneration{0};
+		std::optional<SchemaNode> m_schemaFocus;  ///< Opened from the palette; highlighted.
+		size_t m_schemaFocusRow{~size_t{0}};	  ///< Row of m_schemaFocus in m_schemaRows, if shown.
+		bool m_schemaScroll{false};				  ///< Scroll m_schemaFocusRow into view.
+
+		// Created on first use, like m_database; fed as connections are added and schema caches load.
+		std::unique_ptr<SearchIndex> m_search;
+		bool m_openSearch{false};
+		std::array<char, 256> m_searchText{};
+		std::vector<SearchHit> m_searchHits;
+		size_t m_searchSelection{0};
+		u64 m_searchGeneration{0};	///< Index generation m_searchHits were found in.
+		u64 m_searchHistoryGeneration{0};	 ///< History store generation they were found in.
+		std::vector<u32> m_searchHistory;	 ///< Scratch for the history entries matched.
+		std::vector<SchemaSearch> m_schemaSearch;  ///< Per connection, in m_connections order.
+
+		// Created on first use so App stays cheap to construct (tests, startup).
+		std::unique_ptr<db::QueryExecutor> m_database;
+		std::vector<db::DbEvent> m_dbEvents;
+
+		size_t m_queryConnection{0};
+		SqlEditorColors m_queryColors;
+		ui::TextEditor m_queryEditor;
+		size_t m_editorCursor{0};  ///< Editor cursor as of the last frame; moving it drops a pending completion.
+		bool m_completeRequested{false};  ///< A name was typed or Ctrl+Space pressed.
+		bool m_completionWaiting{false};  ///< Catalog levels are loading for the word at the cursor.
+		u64 m_completionGeneration{0};	  ///< Completer index generation m_completions came from.
+		SqlCompleter m_completer;
+		std::vector<Completion> m_completions;
+		CompletionContext m_completionContext;
+		size_t m_completionSelection{0};
+		// Opened on first use; null if there is no data directory or it cannot be opened.
+		std::unique_ptr<HistoryStore> m_history;
+		bool m_historyOpened{false};
+		std::string m_historyError;
+		std::array<char, 256> m_historyText{};
+		int m_historyConnection{-1};  ///< Connection filter; -1 shows all.
+		int m_historySince{0};		  ///< Index into the page's time filters.
+		std::vector<u32> m_historyRows;	 ///< Entries the list shows, newest first.
+		u64 m_historyGeneration{0};		 ///< Store generation m_historyRows was built in.
+		bool m_historyStale{true};		 ///< A filter changed; rebuild m_historyRows.
+		bool m_fetchOnScroll{true};
+		QueryRun m_query;
+		std::vector<size_t> m_pageRequests;
+		ui::DataGrid m_grid;
+		u64 m_gotoRow{0};
+		std::vector<u32> m_sortOrder;  ///< Display order of m_query.results; empty = as received.
+		std::array<char, 256> m_filterText{};
+		std::vector<u32> m_filterRows;	///< Rows passing m_shownFilter, in m_sortOrder order.
+		bool m_filtered{false};			///< m_filterRows is what the grid shows.
+		db::RowFilter m_shownFilter;	///< Filter m_filterRows was computed with.
+		db::RowFilter m_pendingFilter;	///< Filter the running m_filterer job applies.
+		// Created on first use; follows m_query.results while it is not windowed.
+		std::unique_ptr<db::StatsEngine> m_stats;
+		std::vector<db::ColumnStats> m_columnStats;	 ///< Latest from m_stats, one per result column.
+		u64 m_statsGeneration{0};
+		// Exports run straight from a cursor (m_exportQuery) or from m_query.results.
+		std::shared_ptr<db::Exporter> m_export;	 ///< The running or last finished export.
+		db::QueryId m_exportQuery{0};
+		u64 m_exportTotal{0};  ///< Rows known up front; 0 while streaming from a cursor.
+		std::chrono::steady_clock::time_point m_exportStart;
+		double m_exportSeconds{0.0};  ///< Set once the export is done.
+		std::string m_exportError;	///< Create () failed, e.g. the path cannot be opened.
+		db::ExportFormat m_exportFormat{db::ExportFormat::Csv};
+		std::array<char, 512> m_exportPath{};
+		std::shared_ptr<db::Importer> m_import;	 ///< The running or last finished CSV import.
+		db::QueryId m_importQuery{0};
+		std::chrono::steady_clock::time_point m_importStart;
+		double m_importSeconds{0.0};  ///< Set once the import is done.
+		std::string m_importError;	  ///< Create () failed: unreadable file or header.
+		std::array<char, 512> m_importPath{};
+		std::array<char, 128> m_importTable{};
+		bool m_importHeader{true};
+		int m_importRowLimit{0};  ///< Rows per second; 0 loads at full speed.
+		// Declared last: they stop before the rows they read go away.
+		db::RowTask m_sorter;
+		db::RowTask m_filterer;
+		std::jthread m_exportThread;  ///< Feeds m_export from m_query.results; stopping it cancels.
 	};
 
 }  // namespace ambidb
@@ -2,6 +2,10 @@
 
 #include "backend_concept.h"
 #include <app.h>
+#include <frame_scheduler.h>
+#include <frame_timing.h>
+#include <present_gate.h>
+#include <startup_trace.h>
 #include <functional>
 #include <memory>
 #include <print>
@@ -31,7 +35,7 @@ namespace ambidb {
 	template <typename Derived>
 	class BackendBase {
 	public:
-		BackendBase () : m_app (std::make_unique<App> ()) {}
+		BackendBase () : m_app (std::make_unique<App> (FrameServices{&m_scheduler, &m_frameTimings, &m_presentGate})) {}
 		~BackendBase () = default;
 
 		// Non-copyable, non-movable
@@ -49,12 +53,21 @@ namespace ambidb {
 
 			std::println ("[{}] Initializing backend...", derived ().GetName ());
 
-			if (!derived ().InitializeBackend ()) {
+			bool ok;
+			{
+				StartupTrace::Scope scope ("InitializeBackend");
+				ok = derived ().InitializeBackend ();
+			}
+			if (!ok) {
 				std::println (stderr, "[{}] Backend initialization failed!", derived ().GetName ());
 				return false;
 			}
 
-			if (!derived ().InitializeImGui ()) {
+			{
+				StartupTrace::Scope scope ("InitializeImGui");
+				ok = derived ().InitializeImGui ();
+			}
+			if (!ok) {
 				std::println (stderr, "[{}] ImGui initialization failed!", derived ().GetName ());
 				// Clean up backend resources since InitializeBackend() succeeded
 				derived ().ShutdownBackend ();
@@ -75,6 +88,7 @@ namespace ambidb {
 			derived ().ShutdownImGui ();
 			derived ().ShutdownBackend ();
 			std::println ("[{}] Shutdown complete.", derived ().GetName ());
+			StartupTrace::Instance ().PrintSummary ();
 		}
 
 		/**
@@ -86,6 +100,57 @@ namespace ambidb {
 			derived ().Run ();
 		}
 
+		/**
+		 * @brief Thread-safe: wake the event loop and render one more frame.
+		 * Use from worker threads when new data (query rows, progress) is ready.
+		 */
+		void
+		RequestRedraw () {
+			m_scheduler.RequestRedraw ();
+		}
+
+		/**
+		 * @brief Thread-safe: make sure a frame is rendered no later than @p when.
+		 */
+		void
+		ScheduleFrameAt (FrameScheduler::Clock::time_point when) {
+			m_scheduler.ScheduleFrameAt (when);
+		}
+
+		/**
+		 * @brief Thread-safe: keep rendering at the animation rate until EndAnimation().
+		 */
+		void
+		BeginAnimation () {
+			m_scheduler.BeginAnimation ();
+		}
+
+		void
+		EndAnimation () {
+			m_scheduler.EndAnimation ();
+		}
+
+		FrameScheduler&
+		Scheduler () {
+			return m_scheduler;
+		}
+
+		/**
+		 * @brief Per-phase frame timings; the Run() loops only record while enabled.
+		 */
+		FrameTimings&
+		Timings () {
+			return m_frameTimings;
+		}
+
+		/**
+		 * @brief Presented vs. elided frame counters (see PresentGate).
+		 */
+		const PresentGate&
+		Presents () const {
+			return m_presentGate;
+		}
+
 		/**
 		 * @brief Set an optional per-frame callback. If set, Run() uses it instead of App.
 		 * Callback returns true when the app should close.
@@ -96,6 +161,19 @@ namespace ambidb {
 		}
 
 	protected:
+		/**
+		 * @brief Call from Run() after a frame reached the screen; the first call ends
+		 * the startup trace. A single branch afterwards.
+		 */
+		void
+		FramePresented () {
+			StartupTrace& trace = StartupTrace::Instance ();
+			if (trace.Recording ()) {
+				trace.Record ("first frame", m_lastFrameStart, FrameScheduler::Clock::now (), {});
+				trace.MarkFirstFrame ();
+			}
+		}
+
 		/**
 		 * @brief Run one frame: either the custom callback or App::Update().
 		 * @return true if the main loop should exit.
@@ -109,6 +187,11 @@ namespace ambidb {
 			return m_app->ShouldClose ();
 		}
 
+		// Declared before m_app so it outlives any worker the App owns.
+		FrameScheduler m_scheduler;
+		FrameScheduler::Clock::time_point m_lastFrameStart{};
+		FrameTimings m_frameTimings;
+		PresentGate m_presentGate;
 		std::unique_ptr<App> m_app;
 		std::function<bool ()> m_frameCallback;
 
@@ -13,6 +13,29 @@ namespace ambidb {
 		constexpr int OPENGL_MAJOR_VERSION = 3;
 		constexpr int OPENGL_MINOR_VERSION = 0;
 
+		// Startup target: process start to the first presented frame (TUI over SSH).
+		// Checked by the AMBIDB_STARTUP_TRACE summary.
+		constexpr int STARTUP_BUDGET_MS = 50;
+
+		// Frame pacing while something animates (spinners, progress). Idle frames block.
+		constexpr int GUI_ANIMATION_FPS = 60;
+		constexpr int TUI_ANIMATION_FPS = 20;
+
+		// TUI output: diff cells against the previous frame and write only changed runs
+		// (false falls back to ImTui_ImplNcurses_DrawScreen).
+		constexpr bool TUI_DAMAGE_TRACKING = true;
+
+		// Headless backend: synthetic display in the units of the linked renderer
+		// (character cells for ImTui builds, pixels otherwise).
+#if defined(AMBIDB_TUI)
+		constexpr float HEADLESS_DISPLAY_WIDTH = 200.0f;
+		constexpr float HEADLESS_DISPLAY_HEIGHT = 60.0f;
+#else
+		constexpr float HEADLESS_DISPLAY_WIDTH = static_cast<float> (DEFAULT_WINDOW_WIDTH);
+		constexpr float HEADLESS_DISPLAY_HEIGHT = static_cast<float> (DEFAULT_WINDOW_HEIGHT);
+#endif
+		constexpr int HEADLESS_DEFAULT_FRAMES = 120;
+
 		// Visual configuration
 		constexpr float CLEAR_COLOR_R = 0.45f;
 		constexpr float CLEAR_COLOR_G = 0.55f;
@@ -0,0 +1,117 @@
+#include "backend_select.h"
+
+#include <startup_trace.h>
+
+#include <cstdlib>
+#include <dlfcn.h>
+#include <filesystem>
+#include <print>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+#ifndef AMBIDB_GUI_MODULE_FILE
+#  define AMBIDB_GUI_MODULE_FILE "ambidb_gui.so"
+#endif
+
+namespace ambidb {
+
+	namespace {
+
+		bool
+		HasEnv (const char* name) {
+			const char* value = std::getenv (name);
+			return value && *value;
+		}
+
+		std::optional<BackendKind>
+		ParseKind (std::string_view name) {
+			if (name == "gui" || name == "GUI") return BackendKind::Gui;
+			if (name == "tui" || name == "TUI") return BackendKind::Tui;
+			return std::nullopt;
+		}
+
+		std::string
+		ModulePath () {
+			if (const char* path = std::getenv ("AMBIDB_GUI_MODULE"); path && *path) {
+				return path;
+			}
+			std::error_code ec;
+			const std::filesystem::path exe = std::filesystem::read_symlink ("/proc/self/exe", ec);
+			if (!ec) {
+				return (exe.parent_path () / AMBIDB_GUI_MODULE_FILE).string ();
+			}
+			// Let the dynamic linker search its default paths.
+			return AMBIDB_GUI_MODULE_FILE;
+		}
+
+	}  // namespace
+
+	BackendEnvironment
+	BackendEnvironment::Current () {
+		BackendEnvironment env;
+		env.hasDisplay = HasEnv ("WAYLAND_DISPLAY") || HasEnv ("DISPLAY");
+		env.remoteSession = HasEnv ("SSH_CONNECTION") || HasEnv ("SSH_TTY");
+		env.interactiveTerminal = isatty (STDIN_FILENO) && isatty (STDOUT_FILENO);
+		return env;
+	}
+
+	BackendKind
+	DetectBackend (const BackendEnvironment& env) {
+		if (!env.hasDisplay) return BackendKind::Tui;
+		if (env.remoteSession && env.interactiveTerminal) return BackendKind::Tui;
+		return BackendKind::Gui;
+	}
+
+	std::optional<BackendKind>
+	SelectBackend (int argc, char** argv) {
+		std::optional<BackendKind> chosen;
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view arg = argv [i];
+			if (arg == "--gui") {
+				chosen = BackendKind::Gui;
+			}
+			else if (arg == "--tui") {
+				chosen = BackendKind::Tui;
+			}
+			else {
+				std::println (stderr, "Unknown argument '{}'\nUsage: {} [--gui|--tui]", arg, argv [0]);
+				return std::nullopt;
+			}
+		}
+		if (chosen) return chosen;
+
+		if (const char* env = std::getenv ("AMBIDB_BACKEND"); env && *env) {
+			if (const std::optional<BackendKind> kind = ParseKind (env)) return kind;
+			std::println (stderr, "Ignoring AMBIDB_BACKEND='{}' (expected gui or tui)", env);
+		}
+		StartupTrace::Scope scope ("DetectBackend");
+		return DetectBackend (BackendEnvironment::Current ());
+	}
+
+	int
+	RunGuiModule () {
+		const std::string path = ModulePath ();
+		void* handle;
+		{
+			StartupTrace::Scope scope ("dlopen GUI module");
+			// RTLD_LOCAL: the module carries its own ImGui and App; keep them out of the global scope.
+			handle = dlopen (path.c_str (), RTLD_NOW | RTLD_LOCAL);
+		}
+		if (!handle) {
+			std::println (stderr, "[GUI] Cannot load {}: {}", path, dlerror ());
+			return kGuiUnavailable;
+		}
+
+		auto entry = reinterpret_cast<GuiModuleMain> (dlsym (handle, kGuiModuleEntry));
+		if (!entry) {
+			std::println (stderr, "[GUI] {} has no {} entry point", path, kGuiModuleEntry);
+			dlclose (handle);
+			return kGuiUnavailable;
+		}
+
+		// The module stays mapped: GL drivers may leave threads and atexit handlers behind.
+		return entry (&StartupTrace::Instance ());
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <optional>
+
+namespace ambidb {
+
+	class StartupTrace;
+
+	enum class BackendKind {
+		Gui,
+		Tui,
+	};
+
+	/**
+	 * @brief What the process can see of its surroundings at startup.
+	 */
+	struct BackendEnvironment {
+		bool hasDisplay{false};			  ///< WAYLAND_DISPLAY or DISPLAY is set.
+		bool remoteSession{false};		  ///< SSH_CONNECTION or SSH_TTY is set.
+		bool interactiveTerminal{false};  ///< stdin and stdout are TTYs.
+
+		static BackendEnvironment
+		Current ();
+	};
+
+	/**
+	 * @brief GUI when a display is available, unless this is an interactive SSH session
+	 * (a forwarded display is rarely what the user wants there); TUI otherwise.
+	 */
+	BackendKind
+	DetectBackend (const BackendEnvironment& env);
+
+	/**
+	 * @brief Pick the backend from --gui / --tui, then AMBIDB_BACKEND=gui|tui, then DetectBackend().
+	 * @return std::nullopt (after printing usage) on unknown arguments.
+	 */
+	std::optional<BackendKind>
+	SelectBackend (int argc, char** argv);
+
+	/// Name of the entry point exported by the GUI module. It receives the executable's
+	/// startup trace so the module's trace covers the whole startup.
+	inline constexpr const char* kGuiModuleEntry = "ambidb_gui_main";
+	using GuiModuleMain = int (*) (const StartupTrace* hostTrace);
+
+	/// Returned by the GUI module (or the loader) when the GUI could not start at all,
+	/// so the caller can fall back to the TUI.
+	inline constexpr int kGuiUnavailable = 125;
+
+	/**
+	 * @brief dlopen() the GUI module and run it. GLFW, OpenGL and the display client
+	 * libraries are only resolved here, so TUI sessions never load them.
+	 *
+	 * The module is looked up in $AMBIDB_GUI_MODULE, then next to the executable.
+	 * @return the module's exit code, or kGuiUnavailable.
+	 */
+	int
+	RunGuiModule ();
+
+}  // namespace ambidb
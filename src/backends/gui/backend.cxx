@@ -4,6 +4,7 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <print>
 #include <string>
 
@@ -11,7 +12,12 @@ namespace ambidb {
 
 	bool
 	GuiBackend::InitializeBackend () {
-		if (!glfwInit ()) {
+		bool glfwReady;
+		{
+			StartupTrace::Scope scope ("glfwInit");
+			glfwReady = glfwInit ();
+		}
+		if (!glfwReady) {
 			std::println (stderr, "Failed to initialize GLFW");
 			return false;
 		}
@@ -20,11 +26,14 @@ namespace ambidb {
 		glfwWindowHint (GLFW_CONTEXT_VERSION_MINOR, config::OPENGL_MINOR_VERSION);
 
 		std::string title = std::string (config::WINDOW_TITLE) + " (GUI)";
-		m_window = glfwCreateWindow (config::DEFAULT_WINDOW_WIDTH,
-									 config::DEFAULT_WINDOW_HEIGHT,
-									 title.c_str (),
-									 nullptr,
-									 nullptr);
+		{
+			StartupTrace::Scope scope ("glfwCreateWindow");
+			m_window = glfwCreateWindow (config::DEFAULT_WINDOW_WIDTH,
+										 config::DEFAULT_WINDOW_HEIGHT,
+										 title.c_str (),
+										 nullptr,
+										 nullptr);
+		}
 
 		if (!m_window) {
 			std::println (stderr, "Failed to create GLFW window");
@@ -44,8 +53,21 @@ namespace ambidb {
 			glfwSetWindowPos (m_window, x, y);
 		}
 
-		glfwMakeContextCurrent (m_window);
-		glfwSwapInterval (1);  // Enable vsync
+		// Window contents were damaged (uncovered, restored); the next frame must be presented.
+		glfwSetWindowUserPointer (m_window, this);
+		glfwSetWindowRefreshCallback (m_window, [] (GLFWwindow* window) {
+			static_cast<GuiBackend*> (glfwGetWindowUserPointer (window))->m_presentGate.Invalidate ();
+		});
+
+		{
+			StartupTrace::Scope scope ("GL context");
+			glfwMakeContextCurrent (m_window);
+			glfwSwapInterval (1);  // Enable vsync
+		}
+
+		// glfwPostEmptyEvent is thread-safe and interrupts glfwWaitEvents.
+		m_scheduler.SetWakeHook ([] { glfwPostEmptyEvent (); });
+		m_scheduler.SetAnimationInterval (std::chrono::microseconds (1'000'000 / config::GUI_ANIMATION_FPS));
 
 		return true;
 	}
@@ -53,52 +75,113 @@ namespace ambidb {
 	bool
 	GuiBackend::InitializeImGui () {
 		IMGUI_CHECKVERSION ();
-		ImGui::CreateContext ();
+		{
+			StartupTrace::Scope scope ("ImGui::CreateContext");
+			ImGui::CreateContext ();
+		}
 
 		ImGuiIO& io = ImGui::GetIO ();
 		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 
 		ImGui::StyleColorsDark ();
 
-		if (!ImGui_ImplGlfw_InitForOpenGL (m_window, true)) {
+		bool ok;
+		{
+			StartupTrace::Scope scope ("ImGui_ImplGlfw_InitForOpenGL");
+			ok = ImGui_ImplGlfw_InitForOpenGL (m_window, true);
+		}
+		if (!ok) {
 			std::println (stderr, "Failed to initialize ImGui GLFW implementation");
 			ImGui::DestroyContext ();
 			return false;
 		}
 
-		if (!ImGui_ImplOpenGL3_Init (config::GLSL_VERSION)) {
+		{
+			StartupTrace::Scope scope ("ImGui_ImplOpenGL3_Init");
+			ok = ImGui_ImplOpenGL3_Init (config::GLSL_VERSION);
+		}
+		if (!ok) {
 			std::println (stderr, "Failed to initialize ImGui OpenGL3 implementation");
 			ImGui_ImplGlfw_Shutdown ();
 			ImGui::DestroyContext ();
 			return false;
 		}
 
+		{
+			// Rasterize the atlas here so the trace shows it; the first NewFrame only uploads it.
+			StartupTrace::Scope scope ("font atlas build");
+			unsigned char* pixels = nullptr;
+			int width = 0;
+			int height = 0;
+			io.Fonts->GetTexDataAsRGBA32 (&pixels, &width, &height);
+		}
+
 		return true;
 	}
 
+	void
+	GuiBackend::WaitForEvents () {
+		const WaitPlan plan = m_scheduler.PlanWait (FrameScheduler::Clock::now (), m_lastFrameStart);
+
+		switch (plan.mode) {
+			case WaitMode::Idle:
+				// Nothing animating and no timers: sleep until input or a cross-thread wakeup.
+				glfwWaitEvents ();
+				break;
+			case WaitMode::Deadline:
+			case WaitMode::Continuous:
+				if (plan.timeout > FrameScheduler::Clock::duration::zero ()) {
+					glfwWaitEventsTimeout (std::chrono::duration<double> (plan.timeout).count ());
+				}
+				else {
+					glfwPollEvents ();
+				}
+				break;
+		}
+
+		m_scheduler.ConsumeRedraw ();
+		m_scheduler.ConsumeDeadline (FrameScheduler::Clock::now ());
+	}
+
 	void
 	GuiBackend::Run () {
+		bool firstFrame = true;
 		while (!glfwWindowShouldClose (m_window)) {
-			// glfwPollEvents ();
-			glfwWaitEvents ();
+			if (!firstFrame) {
+				WaitForEvents ();
+			}
+			firstFrame = false;
+			m_lastFrameStart = FrameScheduler::Clock::now ();
+			m_frameTimings.BeginFrame ();
 
 			ImGui_ImplOpenGL3_NewFrame ();
 			ImGui_ImplGlfw_NewFrame ();
 			ImGui::NewFrame ();
+			m_frameTimings.Mark (FramePhase::NewFrame);
 
 			if (RunFrame ()) {
 				break;
 			}
+			m_frameTimings.Mark (FramePhase::Update);
 
 			ImGui::Render ();
-			int display_w, display_h;
-			glfwGetFramebufferSize (m_window, &display_w, &display_h);
-			glViewport (0, 0, display_w, display_h);
-			glClearColor (config::CLEAR_COLOR_R, config::CLEAR_COLOR_G, config::CLEAR_COLOR_B, config::CLEAR_COLOR_A);
-			glClear (GL_COLOR_BUFFER_BIT);
-			ImGui_ImplOpenGL3_RenderDrawData (ImGui::GetDrawData ());
-
-			glfwSwapBuffers (m_window);
+			m_frameTimings.Mark (FramePhase::Render);
+
+			// Identical draw data (e.g. the mouse moved over inert space): the front
+			// buffer already shows this frame, so skip the upload and swap.
+			if (m_presentGate.ShouldPresent (ImGui::GetDrawData ())) {
+				int display_w, display_h;
+				glfwGetFramebufferSize (m_window, &display_w, &display_h);
+				glViewport (0, 0, display_w, display_h);
+				glClearColor (config::CLEAR_COLOR_R, config::CLEAR_COLOR_G, config::CLEAR_COLOR_B, config::CLEAR_COLOR_A);
+				glClear (GL_COLOR_BUFFER_BIT);
+				ImGui_ImplOpenGL3_RenderDrawData (ImGui::GetDrawData ());
+
+				glfwSwapBuffers (m_window);
+				FramePresented ();
+			}
+			m_frameTimings.Mark (FramePhase::Present);
+			m_frameTimings.EndFrame ();
 		}
 	}
 
@@ -111,6 +194,7 @@ namespace ambidb {
 
 	void
 	GuiBackend::ShutdownBackend () {
+		m_scheduler.SetWakeHook ({});
 		if (m_window) {
 			glfwDestroyWindow (m_window);
 			m_window = nullptr;
@@ -38,6 +38,13 @@ namespace ambidb {
 		ShutdownBackend ();
 
 	private:
+		/**
+		 * @brief Wait according to the FrameScheduler: block when idle, wait with a
+		 * timeout for deadlines and animation ticks, never longer than needed.
+		 */
+		void
+		WaitForEvents ();
+
 		GLFWwindow* m_window = nullptr;
 	};
 
@@ -0,0 +1,25 @@
+// Entry point of the GUI module in single-binary (AMBIDB_BACKEND=ALL) builds.
+// The executable dlopen()s this module only when the GUI is selected; see RunGuiModule().
+
+#include "backend.h"
+
+#include <backends/backend_select.h>
+#include <startup_trace.h>
+
+extern "C" __attribute__ ((visibility ("default"))) int
+ambidb_gui_main (const ambidb::StartupTrace* hostTrace) {
+	if (hostTrace) {
+		ambidb::StartupTrace::Instance ().Absorb (*hostTrace);
+	}
+
+	ambidb::GuiBackend backend;
+
+	if (!backend.Initialize ()) {
+		return ambidb::kGuiUnavailable;
+	}
+
+	backend.Run ();
+	backend.Shutdown ();
+
+	return 0;
+}
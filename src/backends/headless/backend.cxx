@@ -0,0 +1,251 @@
+#include "backend.h"
+
+#if defined(AMBIDB_TUI)
+#  include "imtui/imtui.h"
+#  include "imtui/imtui-impl-text.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <print>
+#include <sstream>
+
+namespace ambidb {
+
+	namespace {
+
+		std::atomic<size_t> g_allocations{0};
+		std::atomic<size_t> g_allocatedBytes{0};
+
+		void*
+		CountingAlloc (size_t size, void* /*userData*/) {
+			CountHeadlessAllocation (size);
+			return std::malloc (size);
+		}
+
+		void
+		CountingFree (void* ptr, void* /*userData*/) {
+			std::free (ptr);
+		}
+
+		double
+		ThreadCpuMs () {
+			timespec ts{};
+			clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+			return static_cast<double> (ts.tv_sec) * 1e3 + static_cast<double> (ts.tv_nsec) / 1e6;
+		}
+
+		void
+		ApplyEvent (const HeadlessInputEvent& event) {
+			ImGuiIO& io = ImGui::GetIO ();
+			switch (event.kind) {
+#if IMGUI_VERSION_NUM >= 18700
+				case HeadlessInputEvent::Kind::MouseMove: io.AddMousePosEvent (event.pos.x, event.pos.y); break;
+				case HeadlessInputEvent::Kind::MouseButton: io.AddMouseButtonEvent (event.button, event.down); break;
+				case HeadlessInputEvent::Kind::MouseWheel: io.AddMouseWheelEvent (0.0f, event.pos.y); break;
+				case HeadlessInputEvent::Kind::Key: io.AddKeyEvent (static_cast<ImGuiKey> (event.key), event.down); break;
+#else
+				// Pre-1.87 ImGui has no input queue; write the legacy IO state directly.
+				case HeadlessInputEvent::Kind::MouseMove: io.MousePos = event.pos; break;
+				case HeadlessInputEvent::Kind::MouseButton:
+					if (event.button >= 0 && event.button < IM_ARRAYSIZE (io.MouseDown)) {
+						io.MouseDown [event.button] = event.down;
+					}
+					break;
+				case HeadlessInputEvent::Kind::MouseWheel: io.MouseWheel += event.pos.y; break;
+				case HeadlessInputEvent::Kind::Key:
+					if (event.key >= 0 && event.key < IM_ARRAYSIZE (io.KeysDown)) {
+						io.KeysDown [event.key] = event.down;
+					}
+					break;
+#endif
+				case HeadlessInputEvent::Kind::Char: io.AddInputCharacter (event.ch); break;
+			}
+		}
+
+	}  // namespace
+
+	void
+	CountHeadlessAllocation (size_t bytes) {
+		g_allocations.fetch_add (1, std::memory_order_relaxed);
+		g_allocatedBytes.fetch_add (bytes, std::memory_order_relaxed);
+	}
+
+	std::optional<std::vector<HeadlessInputEvent>>
+	LoadHeadlessInputScript (const std::string& path) {
+		std::ifstream in (path);
+		if (!in) {
+			std::println (stderr, "[Headless] Cannot open input script '{}'", path);
+			return std::nullopt;
+		}
+
+		std::vector<HeadlessInputEvent> events;
+		std::string line;
+		int lineNo = 0;
+		while (std::getline (in, line)) {
+			++lineNo;
+			if (line.empty () || line [0] == '#') continue;
+
+			std::istringstream fields (line);
+			HeadlessInputEvent event;
+			std::string kind;
+			std::string state;
+			fields >> event.frame >> kind;
+
+			bool ok = !fields.fail ();
+			if (kind == "move") {
+				event.kind = HeadlessInputEvent::Kind::MouseMove;
+				fields >> event.pos.x >> event.pos.y;
+			}
+			else if (kind == "button") {
+				event.kind = HeadlessInputEvent::Kind::MouseButton;
+				fields >> event.button >> state;
+				event.down = state == "down";
+			}
+			else if (kind == "wheel") {
+				event.kind = HeadlessInputEvent::Kind::MouseWheel;
+				fields >> event.pos.y;
+			}
+			else if (kind == "key") {
+				event.kind = HeadlessInputEvent::Kind::Key;
+				fields >> event.key >> state;
+				event.down = state == "down";
+			}
+			else if (kind == "char") {
+				event.kind = HeadlessInputEvent::Kind::Char;
+				fields >> event.ch;
+			}
+			else {
+				ok = false;
+			}
+
+			if (!ok || fields.fail ()) {
+				std::println (stderr, "[Headless] {}:{}: cannot parse '{}'", path, lineNo, line);
+				return std::nullopt;
+			}
+			events.push_back (event);
+		}
+		return events;
+	}
+
+	bool
+	HeadlessBackend::InitializeBackend () {
+		// Replay order must not depend on how the script was written.
+		std::stable_sort (m_config.script.begin (),
+						  m_config.script.end (),
+						  [] (const HeadlessInputEvent& a, const HeadlessInputEvent& b) {
+							  return a.frame < b.frame;
+						  });
+		return true;
+	}
+
+	bool
+	HeadlessBackend::InitializeImGui () {
+		IMGUI_CHECKVERSION ();
+		// Must precede CreateContext so the context itself is counted.
+		ImGui::SetAllocatorFunctions (CountingAlloc, CountingFree);
+		ImGui::CreateContext ();
+
+		ImGuiIO& io = ImGui::GetIO ();
+		io.IniFilename = nullptr;
+		io.DisplaySize = m_config.displaySize;
+
+#if defined(AMBIDB_TUI)
+		// Always use the text font metrics so layout matches the real TUI;
+		// rasterizeText only decides whether the draw data is rasterized.
+		ImTui_ImplText_Init ();
+		if (m_config.rasterizeText) {
+			m_screen = new ImTui::TScreen ();
+		}
+#else
+		if (m_config.rasterizeText) {
+			std::println ("[Headless] Text rasterization needs an ImTui build; ignoring.");
+		}
+		unsigned char* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+		io.Fonts->GetTexDataAsRGBA32 (&pixels, &width, &height);
+#endif
+
+		return true;
+	}
+
+	void
+	HeadlessBackend::Run () {
+		ImGuiIO& io = ImGui::GetIO ();
+		m_nextEvent = 0;
+
+		for (int frame = 0; frame < m_config.frames; ++frame) {
+			io.DisplaySize = m_config.displaySize;
+			io.DeltaTime = m_config.deltaTime;
+			ApplyInput (frame);
+
+			const size_t allocationsBefore = g_allocations.load (std::memory_order_relaxed);
+			const size_t bytesBefore = g_allocatedBytes.load (std::memory_order_relaxed);
+			const auto wallStart = std::chrono::steady_clock::now ();
+			const double cpuStart = ThreadCpuMs ();
+
+#if defined(AMBIDB_TUI)
+			ImTui_ImplText_NewFrame ();
+#endif
+			ImGui::NewFrame ();
+			const bool quit = RunFrame ();
+			ImGui::Render ();
+
+			HeadlessFrameStats stats;
+			stats.presented = m_presentGate.ShouldPresent (ImGui::GetDrawData ());
+#if defined(AMBIDB_TUI)
+			if (m_screen && stats.presented) {
+				ImTui_ImplText_RenderDrawData (ImGui::GetDrawData (), static_cast<ImTui::TScreen*> (m_screen));
+			}
+#endif
+
+			stats.cpuMs = ThreadCpuMs () - cpuStart;
+			stats.wallMs = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - wallStart).count ();
+			stats.allocations = g_allocations.load (std::memory_order_relaxed) - allocationsBefore;
+			stats.allocatedBytes = g_allocatedBytes.load (std::memory_order_relaxed) - bytesBefore;
+
+			if (const ImDrawData* drawData = ImGui::GetDrawData ()) {
+				stats.drawLists = drawData->CmdListsCount;
+				stats.vertices = drawData->TotalVtxCount;
+				stats.indices = drawData->TotalIdxCount;
+				for (int i = 0; i < drawData->CmdListsCount; ++i) {
+					stats.drawCommands += drawData->CmdLists [i]->CmdBuffer.Size;
+				}
+			}
+			m_stats.push_back (stats);
+
+			if (quit) {
+				break;
+			}
+		}
+	}
+
+	void
+	HeadlessBackend::ApplyInput (int frame) {
+		// The script is sorted by frame in InitializeBackend(), so one cursor suffices.
+		while (m_nextEvent < m_config.script.size () && m_config.script [m_nextEvent].frame <= frame) {
+			ApplyEvent (m_config.script [m_nextEvent++]);
+		}
+	}
+
+	void
+	HeadlessBackend::ShutdownImGui () {
+#if defined(AMBIDB_TUI)
+		delete static_cast<ImTui::TScreen*> (m_screen);
+		ImTui_ImplText_Shutdown ();
+#endif
+		m_screen = nullptr;
+		ImGui::DestroyContext ();
+	}
+
+	void
+	HeadlessBackend::ShutdownBackend () {
+		// Nothing was acquired beyond the ImGui context.
+	}
+
+}  // namespace ambidb
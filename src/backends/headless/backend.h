@@ -0,0 +1,140 @@
+#pragma once
+
+#include <backends/backend_base.h>
+#include <backends/backend_config.h>
+
+#include "imgui.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ambidb {
+
+	/**
+	 * @brief One synthetic input event, applied before the frame with the same index.
+	 */
+	struct HeadlessInputEvent {
+		enum class Kind {
+			MouseMove,
+			MouseButton,
+			MouseWheel,
+			Key,
+			Char,
+		};
+
+		int frame{0};
+		Kind kind{Kind::MouseMove};
+		ImVec2 pos{0.0f, 0.0f};	 ///< MouseMove position; MouseWheel uses pos.y as the wheel delta.
+		int button{0};
+		bool down{false};
+		int key{0};	 ///< ImGuiKey value.
+		unsigned int ch{0};
+	};
+
+	struct HeadlessConfig {
+		ImVec2 displaySize{config::HEADLESS_DISPLAY_WIDTH, config::HEADLESS_DISPLAY_HEIGHT};
+		int frames{config::HEADLESS_DEFAULT_FRAMES};
+		float deltaTime{1.0f / 60.0f};
+		/// Rasterize each frame through the ImTui text renderer into an in-memory screen.
+		/// Only available in builds that contain ImTui; ignored otherwise.
+		bool rasterizeText{false};
+		std::vector<HeadlessInputEvent> script;
+	};
+
+	struct HeadlessFrameStats {
+		double cpuMs{0.0};
+		double wallMs{0.0};
+		size_t allocations{0};
+		size_t allocatedBytes{0};
+		int drawLists{0};
+		int drawCommands{0};
+		int vertices{0};
+		int indices{0};
+		bool presented{true};  ///< false if PresentGate found the draw data unchanged.
+	};
+
+	/**
+	 * @brief Record one heap allocation in the headless allocation counters.
+	 *
+	 * ImGui's allocator is routed through this automatically. Harnesses that replace
+	 * global operator new can call it too, so App allocations show up in the stats.
+	 */
+	void
+	CountHeadlessAllocation (size_t bytes);
+
+	/**
+	 * @brief Parse a plain-text input script, one event per line:
+	 *
+	 *   <frame> move <x> <y>
+	 *   <frame> button <index> <down|up>
+	 *   <frame> wheel <delta>
+	 *   <frame> key <imgui-key-number> <down|up>
+	 *   <frame> char <codepoint>
+	 *
+	 * Blank lines and lines starting with '#' are ignored.
+	 */
+	std::optional<std::vector<HeadlessInputEvent>>
+	LoadHeadlessInputScript (const std::string& path);
+
+	/**
+	 * @brief Backend without a window or terminal, for benchmarking App::Update().
+	 *
+	 * Run() drives a fixed number of frames against a synthetic display size,
+	 * replays the input script, calls ImGui::Render(), runs the PresentGate like the
+	 * interactive backends and optionally rasterizes changed frames through ImTui. Per-frame CPU time, allocation counts and
+	 * draw-list sizes are recorded in FrameStats().
+	 *
+	 * Uses CRTP pattern via BackendBase<HeadlessBackend> for compile-time polymorphism.
+	 */
+	class HeadlessBackend : public BackendBase<HeadlessBackend> {
+	public:
+		MAKE_NONCOPYABLE (HeadlessBackend);
+		MAKE_NONMOVABLE (HeadlessBackend);
+		explicit HeadlessBackend (HeadlessConfig config = {}) : m_config (std::move (config)) {}
+		~HeadlessBackend () = default;
+
+		// Backend interface implementation
+		void
+		Run ();
+		const char*
+		GetName () const {
+			return "Headless";
+		}
+		bool
+		InitializeBackend ();
+		bool
+		InitializeImGui ();
+		void
+		ShutdownImGui ();
+		void
+		ShutdownBackend ();
+
+		App&
+		GetApp () {
+			return *m_app;
+		}
+
+		const std::vector<HeadlessFrameStats>&
+		FrameStats () const {
+			return m_stats;
+		}
+
+		void
+		ClearFrameStats () {
+			m_stats.clear ();
+		}
+
+	private:
+		/// Feed every script event scheduled at or before @p frame to ImGui.
+		void
+		ApplyInput (int frame);
+
+		HeadlessConfig m_config;
+		size_t m_nextEvent = 0;
+		std::vector<HeadlessFrameStats> m_stats;
+		void* m_screen = nullptr;
+	};
+
+}  // namespace ambidb
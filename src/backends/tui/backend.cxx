@@ -2,6 +2,7 @@
 #include "imtui/imtui.h"
 #include "imtui/imtui-impl-ncurses.h"
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <ncurses.h>
 #include <poll.h>
@@ -14,15 +15,28 @@ namespace ambidb {
 	TuiBackend::InitializeBackend () {
 		// For TUI, backend initialization is minimal
 		// Most work is done in InitializeImGui
+		if (!m_wakeup.Open ()) {
+			std::println (stderr, "Failed to create wakeup channel: {} (errno={})",
+						  std::strerror (errno), errno);
+			return false;
+		}
+		m_scheduler.SetWakeHook ([this] { m_wakeup.Notify (); });
+		m_scheduler.SetAnimationInterval (std::chrono::microseconds (1'000'000 / config::TUI_ANIMATION_FPS));
 		return true;
 	}
 
 	bool
 	TuiBackend::InitializeImGui () {
 		IMGUI_CHECKVERSION ();
-		ImGui::CreateContext ();
+		{
+			StartupTrace::Scope scope ("ImGui::CreateContext");
+			ImGui::CreateContext ();
+		}
 
-		m_screen = ImTui_ImplNcurses_Init (true);
+		{
+			StartupTrace::Scope scope ("ImTui_ImplNcurses_Init");
+			m_screen = ImTui_ImplNcurses_Init (true);
+		}
 		if (!m_screen) {
 			std::println (stderr, "Failed to initialize ImTui ncurses implementation");
 			ImGui::DestroyContext ();
@@ -30,7 +44,49 @@ namespace ambidb {
 			return false;
 		}
 
-		ImTui_ImplText_Init ();
+		{
+			// Sets up the text renderer's font atlas.
+			StartupTrace::Scope scope ("ImTui_ImplText_Init");
+			ImTui_ImplText_Init ();
+		}
+
+		if constexpr (config::TUI_DAMAGE_TRACKING) {
+			// Let ncurses flush its initial clear; from here on Present() owns the screen
+			// and ncurses' own screen buffer is never refreshed again.
+			refresh ();
+			m_damageWriter.Invalidate ();
+		}
+		return true;
+	}
+
+	bool
+	TuiBackend::WaitForEvents () {
+		const WaitPlan plan = m_scheduler.PlanWait (FrameScheduler::Clock::now (), m_lastFrameStart);
+
+		int timeoutMs = -1;
+		if (plan.mode != WaitMode::Idle) {
+			timeoutMs = static_cast<int> (
+				std::chrono::ceil<std::chrono::milliseconds> (plan.timeout).count ());
+		}
+
+		struct pollfd fds [2];
+		fds [0].fd = STDIN_FILENO;
+		fds [0].events = POLLIN;
+		fds [1].fd = m_wakeup.ReadFd ();
+		fds [1].events = POLLIN;
+		if (poll (fds, 2, timeoutMs) == -1) {
+			if (errno != EINTR) {
+				std::println (stderr, "Poll error while waiting for events: {} (errno={})",
+							  std::strerror (errno), errno);
+				return false;
+			}
+		}
+
+		if (fds [1].revents & POLLIN) {
+			m_wakeup.Drain ();
+		}
+		m_scheduler.ConsumeRedraw ();
+		m_scheduler.ConsumeDeadline (FrameScheduler::Clock::now ());
 		return true;
 	}
 
@@ -38,36 +94,61 @@ namespace ambidb {
 	TuiBackend::Run () {
 		bool firstFrame = true;
 		while (true) {
-			if (!firstFrame) {
-				struct pollfd fds [1];
-				fds [0].fd = STDIN_FILENO;
-				fds [0].events = POLLIN;
-				if (poll (fds, 1, -1) == -1) {
-					if (errno != EINTR) {
-						std::println (stderr, "Poll error while waiting for stdin: {} (errno={})",
-									  std::strerror (errno), errno);
-						break;
-					}
-				}
+			// Block until stdin input, a cross-thread wakeup or the next scheduled frame.
+			if (!firstFrame && !WaitForEvents ()) {
+				break;
 			}
 			firstFrame = false;
+			m_lastFrameStart = FrameScheduler::Clock::now ();
+			m_frameTimings.BeginFrame ();
 
 			ImTui_ImplNcurses_NewFrame ();
 			ImTui_ImplText_NewFrame ();
 			ImGui::NewFrame ();
+			m_frameTimings.Mark (FramePhase::NewFrame);
 
 			if (RunFrame ()) {
 				break;
 			}
+			m_frameTimings.Mark (FramePhase::Update);
 
 			ImGui::Render ();
-			ImTui_ImplText_RenderDrawData (ImGui::GetDrawData (), (ImTui::TScreen*) m_screen);
+			m_frameTimings.Mark (FramePhase::Render);
+
+			Present ();
+			m_frameTimings.Mark (FramePhase::Present);
+			m_frameTimings.EndFrame ();
+		}
+	}
+
+	void
+	TuiBackend::Present () {
+		// Unchanged draw data rasterizes to the same cells; skip both steps.
+		if (!m_presentGate.ShouldPresent (ImGui::GetDrawData ())) return;
+
+		auto* screen = static_cast<ImTui::TScreen*> (m_screen);
+		ImTui_ImplText_RenderDrawData (ImGui::GetDrawData (), screen);
+
+		if constexpr (!config::TUI_DAMAGE_TRACKING) {
 			ImTui_ImplNcurses_DrawScreen (true);
+			FramePresented ();
+			return;
 		}
+
+		if (!m_damageWriter.Present (screen->data, screen->nx, screen->ny)) {
+			std::println (stderr, "Terminal write failed: {} (errno={})", std::strerror (errno), errno);
+			m_presentGate.Invalidate ();
+			return;
+		}
+		m_frameTimings.RecordOutputBytes (m_damageWriter.LastStats ().bytes);
+		FramePresented ();
 	}
 
 	void
 	TuiBackend::ShutdownImGui () {
+		if constexpr (config::TUI_DAMAGE_TRACKING) {
+			m_damageWriter.ResetAttributes ();
+		}
 		ImTui_ImplText_Shutdown ();
 		ImTui_ImplNcurses_Shutdown ();
 		ImGui::DestroyContext ();
@@ -75,7 +156,8 @@ namespace ambidb {
 
 	void
 	TuiBackend::ShutdownBackend () {
-		// No additional backend-specific cleanup needed
+		m_scheduler.SetWakeHook ({});
+		m_wakeup.Close ();
 		m_screen = nullptr;
 	}
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <backends/backend_base.h>
+#include <backends/backend_config.h>
+#include <backends/tui/damage_writer.h>
+#include <backends/wakeup_channel.h>
 
 namespace ambidb {
 
@@ -36,7 +39,25 @@ namespace ambidb {
 		ShutdownBackend ();
 
 	private:
+		static constexpr int kStdoutFd = 1;
+
+		/**
+		 * @brief Block until stdin is readable, another thread requested a frame,
+		 * or the FrameScheduler's next deadline or animation tick is due.
+		 * @return false on an unrecoverable poll() error.
+		 */
+		bool
+		WaitForEvents ();
+
+		/**
+		 * @brief Write the rasterized screen to the terminal.
+		 */
+		void
+		Present ();
+
 		void* m_screen = nullptr;
+		WakeupChannel m_wakeup;
+		TerminalDamageWriter m_damageWriter{kStdoutFd};
 	};
 
 }  // namespace ambidb
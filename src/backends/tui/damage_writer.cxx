@@ -0,0 +1,200 @@
+#include "damage_writer.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+
+namespace ambidb {
+
+	namespace {
+
+		// Reprinting up to this many unchanged cells is cheaper than an escape sequence.
+		constexpr int kMaxReprintGap = 4;
+
+		constexpr uint32_t
+		CellChar (uint32_t cell) {
+			return cell & 0xFFFFu;
+		}
+
+		constexpr int
+		CellFg (uint32_t cell) {
+			return static_cast<int> ((cell >> 16) & 0xFFu);
+		}
+
+		constexpr int
+		CellBg (uint32_t cell) {
+			return static_cast<int> ((cell >> 24) & 0xFFu);
+		}
+
+	}  // namespace
+
+	TerminalDamageWriter::TerminalDamageWriter (int fd) : m_fd (fd) {}
+
+	bool
+	TerminalDamageWriter::Present (const uint32_t* cells, int width, int height) {
+		m_out.clear ();
+		m_stats = {};
+
+		const size_t count = static_cast<size_t> (width) * static_cast<size_t> (height);
+		if (width != m_width || height != m_height || m_previous.size () != count) {
+			m_fullRepaint = true;
+		}
+		m_width = width;
+		m_height = height;
+
+		if (m_fullRepaint) {
+			// Reset attributes and home the cursor; every cell below is rewritten.
+			m_out += "\x1b[0m\x1b[H";
+			m_cursorX = 0;
+			m_cursorY = 0;
+			m_fg = -1;
+			m_bg = -1;
+			m_stats.fullRepaint = true;
+		}
+
+		for (int y = 0; y < height; ++y) {
+			const uint32_t* row = cells + static_cast<size_t> (y) * width;
+			const uint32_t* prevRow = m_fullRepaint ? nullptr : m_previous.data () + static_cast<size_t> (y) * width;
+			if (prevRow && std::memcmp (row, prevRow, sizeof (uint32_t) * width) == 0) continue;
+
+			for (int x = 0; x < width; ++x) {
+				if (prevRow && row [x] == prevRow [x]) continue;
+				MoveTo (x, y, row);
+				PutCell (row [x]);
+				++m_stats.changedCells;
+			}
+		}
+
+		m_previous.assign (cells, cells + count);
+		m_fullRepaint = false;
+		return Flush ();
+	}
+
+	void
+	TerminalDamageWriter::ResetAttributes () {
+		m_out.assign ("\x1b[0m");
+		m_fg = -1;
+		m_bg = -1;
+		Flush ();
+		m_fullRepaint = true;
+	}
+
+	void
+	TerminalDamageWriter::MoveTo (int x, int y, const uint32_t* row) {
+		if (m_cursorY == y && m_cursorX == x) return;
+
+		if (m_cursorY == y && m_cursorX >= 0 && x > m_cursorX) {
+			const int gap = x - m_cursorX;
+			// Reprint the unchanged gap when it is short and needs no color change.
+			bool reprint = gap <= kMaxReprintGap;
+			for (int i = m_cursorX; reprint && i < x; ++i) {
+				reprint = CellFg (row [i]) == m_fg && CellBg (row [i]) == m_bg;
+			}
+			if (reprint) {
+				for (int i = m_cursorX; i < x; ++i) PutCell (row [i]);
+				return;
+			}
+			m_out += "\x1b[";
+			if (gap > 1) AppendNumber (gap);
+			m_out += 'C';
+			m_cursorX = x;
+			return;
+		}
+
+		if (x == 0 && m_cursorY >= 0 && y == m_cursorY + 1) {
+			m_out += "\r\n";
+		}
+		else {
+			m_out += "\x1b[";
+			AppendNumber (y + 1);
+			m_out += ';';
+			AppendNumber (x + 1);
+			m_out += 'H';
+		}
+		m_cursorX = x;
+		m_cursorY = y;
+	}
+
+	void
+	TerminalDamageWriter::SetColors (uint32_t cell) {
+		const int fg = CellFg (cell);
+		const int bg = CellBg (cell);
+		if (fg == m_fg && bg == m_bg) return;
+
+		m_out += "\x1b[";
+		if (fg != m_fg) {
+			m_out += "38;5;";
+			AppendNumber (fg);
+		}
+		if (bg != m_bg) {
+			if (fg != m_fg) m_out += ';';
+			m_out += "48;5;";
+			AppendNumber (bg);
+		}
+		m_out += 'm';
+		m_fg = fg;
+		m_bg = bg;
+	}
+
+	void
+	TerminalDamageWriter::PutCell (uint32_t cell) {
+		SetColors (cell);
+
+		uint32_t ch = CellChar (cell);
+		if (ch == 0) ch = ' ';
+		if (ch < 0x80) {
+			m_out += static_cast<char> (ch);
+		}
+		else if (ch < 0x800) {
+			m_out += static_cast<char> (0xC0 | (ch >> 6));
+			m_out += static_cast<char> (0x80 | (ch & 0x3F));
+		}
+		else {
+			m_out += static_cast<char> (0xE0 | (ch >> 12));
+			m_out += static_cast<char> (0x80 | ((ch >> 6) & 0x3F));
+			m_out += static_cast<char> (0x80 | (ch & 0x3F));
+		}
+
+		++m_cursorX;
+		if (m_cursorX >= m_width) {
+			// Terminals differ in how they handle the pending wrap after the last column.
+			m_cursorX = -1;
+			m_cursorY = -1;
+		}
+	}
+
+	void
+	TerminalDamageWriter::AppendNumber (int value) {
+		char buffer [12];
+		const auto [end, ec] = std::to_chars (buffer, buffer + sizeof (buffer), value);
+		(void) ec;
+		m_out.append (buffer, end);
+	}
+
+	bool
+	TerminalDamageWriter::Flush () {
+		m_stats.bytes = m_out.size ();
+		const char* data = m_out.data ();
+		size_t remaining = m_out.size ();
+		while (remaining > 0) {
+			const ssize_t written = write (m_fd, data, remaining);
+			if (written < 0) {
+				if (errno == EINTR) continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					// Non-blocking tty with a full buffer (slow link): sleep until it drains.
+					pollfd pfd{m_fd, POLLOUT, 0};
+					if (poll (&pfd, 1, -1) >= 0 || errno == EINTR) continue;
+				}
+				// The terminal state is unknown after a failed write.
+				m_fullRepaint = true;
+				return false;
+			}
+			data += written;
+			remaining -= static_cast<size_t> (written);
+		}
+		return true;
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <macro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ambidb {
+
+	/**
+	 * @brief Writes only the terminal cells that changed since the previous frame.
+	 *
+	 * Cells use ImTui's packed layout: bits 0-15 character, 16-23 foreground and
+	 * 24-31 background (ANSI-256 indices). Present() diffs the new frame against the
+	 * last one it wrote, emits changed runs with the cheapest cursor motion
+	 * (reprint short gaps, CUF, CR/LF or CUP), tracks the current SGR colors to
+	 * avoid redundant escapes, and hands the whole frame to a single write().
+	 */
+	class TerminalDamageWriter {
+	public:
+		struct Stats {
+			size_t bytes{0};
+			size_t changedCells{0};
+			bool fullRepaint{false};
+		};
+
+		MAKE_NONCOPYABLE (TerminalDamageWriter);
+		MAKE_NONMOVABLE (TerminalDamageWriter);
+		explicit TerminalDamageWriter (int fd);
+		~TerminalDamageWriter () = default;
+
+		/**
+		 * @brief Forget what the terminal shows; the next Present() repaints every cell.
+		 */
+		void
+		Invalidate () {
+			m_fullRepaint = true;
+		}
+
+		/**
+		 * @brief Diff and write one frame.
+		 * @return false if writing to the terminal failed.
+		 */
+		bool
+		Present (const uint32_t* cells, int width, int height);
+
+		/**
+		 * @brief Restore default colors before the terminal is handed back (endwin).
+		 */
+		void
+		ResetAttributes ();
+
+		const Stats&
+		LastStats () const {
+			return m_stats;
+		}
+
+	private:
+		void
+		MoveTo (int x, int y, const uint32_t* row);
+		void
+		SetColors (uint32_t cell);
+		void
+		PutCell (uint32_t cell);
+		void
+		AppendNumber (int value);
+		bool
+		Flush ();
+
+		int m_fd;
+		std::vector<uint32_t> m_previous;
+		int m_width = 0;
+		int m_height = 0;
+		bool m_fullRepaint = true;
+
+		// What the terminal currently has; -1 means unknown.
+		int m_cursorX = -1;
+		int m_cursorY = -1;
+		int m_fg = -1;
+		int m_bg = -1;
+
+		std::string m_out;
+		Stats m_stats;
+	};
+
+}  // namespace ambidb
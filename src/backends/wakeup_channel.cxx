@@ -0,0 +1,92 @@
+#include "wakeup_channel.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#  include <sys/eventfd.h>
+#endif
+
+namespace ambidb {
+
+	namespace {
+
+		bool
+		MakeNonBlocking (int fd) {
+			const int flags = fcntl (fd, F_GETFL, 0);
+			if (flags == -1) return false;
+			if (fcntl (fd, F_SETFL, flags | O_NONBLOCK) == -1) return false;
+			return fcntl (fd, F_SETFD, FD_CLOEXEC) != -1;
+		}
+
+	}  // namespace
+
+	WakeupChannel::~WakeupChannel () {
+		Close ();
+	}
+
+	bool
+	WakeupChannel::Open () {
+		if (m_readFd != -1) return true;
+
+#if defined(__linux__)
+		const int fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (fd != -1) {
+			m_readFd = fd;
+			m_writeFd = fd;
+			return true;
+		}
+#endif
+
+		int fds [2];
+		if (pipe (fds) == -1) return false;
+		if (!MakeNonBlocking (fds [0]) || !MakeNonBlocking (fds [1])) {
+			close (fds [0]);
+			close (fds [1]);
+			return false;
+		}
+		m_readFd = fds [0];
+		m_writeFd = fds [1];
+		return true;
+	}
+
+	void
+	WakeupChannel::Close () {
+		if (m_writeFd != -1 && m_writeFd != m_readFd) {
+			close (m_writeFd);
+		}
+		if (m_readFd != -1) {
+			close (m_readFd);
+		}
+		m_readFd = -1;
+		m_writeFd = -1;
+	}
+
+	void
+	WakeupChannel::Notify () {
+		if (m_writeFd == -1) return;
+		// An eventfd needs exactly 8 bytes; a pipe accepts any payload. EAGAIN means the
+		// channel is already readable, which is all a wakeup needs.
+		const uint64_t one = 1;
+		ssize_t written;
+		do {
+			written = write (m_writeFd, &one, sizeof (one));
+		}
+		while (written == -1 && errno == EINTR);
+	}
+
+	void
+	WakeupChannel::Drain () {
+		if (m_readFd == -1) return;
+		uint64_t sink [16];
+		while (true) {
+			const ssize_t got = read (m_readFd, sink, sizeof (sink));
+			if (got > 0) continue;
+			if (got == -1 && errno == EINTR) continue;
+			break;
+		}
+	}
+
+}  // namespace ambidb
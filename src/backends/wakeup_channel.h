@@ -0,0 +1,45 @@
+#pragma once
+
+#include <macro.h>
+
+namespace ambidb {
+
+	/**
+	 * @brief Pollable file descriptor that other threads can use to interrupt poll().
+	 *
+	 * Backed by an eventfd on Linux and a non-blocking self-pipe elsewhere.
+	 * Notify() is async-signal-safe and may be called from any thread.
+	 */
+	class WakeupChannel {
+	public:
+		MAKE_NONCOPYABLE (WakeupChannel);
+		MAKE_NONMOVABLE (WakeupChannel);
+		WakeupChannel () = default;
+		~WakeupChannel ();
+
+		bool
+		Open ();
+
+		void
+		Close ();
+
+		void
+		Notify ();
+
+		/**
+		 * @brief Consume all pending notifications so the fd stops polling readable.
+		 */
+		void
+		Drain ();
+
+		int
+		ReadFd () const {
+			return m_readFd;
+		}
+
+	private:
+		int m_readFd = -1;
+		int m_writeFd = -1;
+	};
+
+}  // namespace ambidb
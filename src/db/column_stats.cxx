@@ -0,0 +1,383 @@
+#include "column_stats.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace ambidb::db {
+
+	namespace {
+
+		/// Bits of a null-bitmap word that belong to @p count rows.
+		u64
+		RowMask (size_t count) {
+			return count >= 64 ? ~u64{0} : (u64{1} << count) - 1;
+		}
+
+		/// splitmix64 finalizer: spreads every input bit over the whole hash.
+		u64
+		Mix (u64 x) {
+			x ^= x >> 30;
+			x *= 0xBF58476D1CE4E5B9;
+			x ^= x >> 27;
+			x *= 0x94D049BB133111EB;
+			return x ^ (x >> 31);
+		}
+
+		u64
+		HashNumber (i64 value) {
+			return Mix (static_cast<u64> (value));
+		}
+
+		u64
+		HashNumber (f64 value) {
+			// -0.0 == 0.0, so both must count as one value.
+			return Mix (std::bit_cast<u64> (value == 0.0 ? 0.0 : value));
+		}
+
+		u64
+		HashBytes (std::string_view bytes) {
+			u64 hash = bytes.size ();
+			size_t at = 0;
+			for (; at + 8 <= bytes.size (); at += 8) {
+				u64 word;
+				std::memcpy (&word, bytes.data () + at, 8);
+				hash = Mix (hash ^ word);
+			}
+			u64 tail = 0;
+			std::memcpy (&tail, bytes.data () + at, bytes.size () - at);
+			return Mix (hash ^ tail ^ 0x9E3779B97F4A7C15);
+		}
+
+	}  // namespace
+
+	double
+	HyperLogLog::Estimate () const {
+		double sum = 0.0;
+		size_t zeros = 0;
+		for (const u8 rank : m_registers) {
+			sum += std::ldexp (1.0, -static_cast<int> (rank));
+			zeros += rank == 0;
+		}
+		const double m = static_cast<double> (m_registers.size ());
+		const double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+		// The raw estimate is biased for small counts, where empty registers still say a lot.
+		if (estimate <= 2.5 * m && zeros > 0) return m * std::log (m / static_cast<double> (zeros));
+		return estimate;
+	}
+
+	size_t
+	QuantileSketch::Capacity (size_t level) const {
+		const size_t depth = m_levels.size () - 1 - level;
+		return std::max<size_t> (2, static_cast<size_t> (std::ceil (static_cast<double> (kK) * std::pow (2.0 / 3.0, static_cast<double> (depth)))));
+	}
+
+	void
+	QuantileSketch::Add (f64 value) {
+		if (std::isnan (value)) return;
+		if (m_levels.empty ()) {
+			m_levels.emplace_back ();
+			m_capacity = Capacity (0);
+		}
+		m_levels [0].push_back (value);
+		++m_size;
+		++m_count;
+		if (m_size >= m_capacity) Compress ();
+	}
+
+	void
+	QuantileSketch::Compress () {
+		for (size_t level = 0; level < m_levels.size (); ++level) {
+			if (m_levels [level].size () < Capacity (level)) continue;
+			if (level + 1 == m_levels.size ()) {
+				m_levels.emplace_back ();
+				m_capacity = 0;
+				for (size_t h = 0; h < m_levels.size (); ++h) m_capacity += Capacity (h);
+			}
+
+			// Keep the even or the odd ranks, at random, so the error has no bias; an odd
+			// item out stays behind.
+			std::vector<f64>& items = m_levels [level];
+			std::vector<f64>& above = m_levels [level + 1];
+			std::ranges::sort (items);
+			m_coin = m_coin * 6364136223846793005 + 1442695040888963407;
+			const size_t offset = m_coin >> 63;
+			const size_t pairs = items.size () / 2;
+			for (size_t i = 0; i < pairs; ++i) above.push_back (items [2 * i + offset]);
+			if (items.size () % 2) {
+				items.front () = items.back ();
+				items.resize (1);
+			}
+			else {
+				items.clear ();
+			}
+			m_size -= pairs;
+			return;
+		}
+	}
+
+	std::vector<QuantileSketch::Weighted>
+	QuantileSketch::Sorted () const {
+		std::vector<Weighted> items;
+		items.reserve (m_size);
+		for (size_t level = 0; level < m_levels.size (); ++level) {
+			for (const f64 value : m_levels [level]) items.push_back ({value, u64{1} << level});
+		}
+		std::ranges::sort (items, {}, &Weighted::value);
+		return items;
+	}
+
+	void
+	QuantileSketch::Quantiles (std::span<const double> ranks, std::span<f64> values) const {
+		const std::vector<Weighted> items = Sorted ();
+		u64 total = 0;
+		for (const Weighted& item : items) total += item.weight;
+
+		size_t at = 0;
+		u64 seen = items.front ().weight;
+		for (size_t i = 0; i < ranks.size (); ++i) {
+			const double target = ranks [i] * static_cast<double> (total);
+			while (at + 1 < items.size () && static_cast<double> (seen) < target) seen += items [++at].weight;
+			values [i] = items [at].value;
+		}
+	}
+
+	void
+	QuantileSketch::Histogram (f64 min, f64 max, std::span<float> bins) const {
+		std::ranges::fill (bins, 0.0f);
+		if (bins.empty () || m_count == 0) return;
+		const f64 width = max > min ? (max - min) / static_cast<f64> (bins.size ()) : 1.0;
+		u64 total = 0;
+		for (size_t level = 0; level < m_levels.size (); ++level) {
+			const u64 weight = u64{1} << level;
+			for (const f64 value : m_levels [level]) {
+				const f64 slot = std::floor ((value - min) / width);
+				const size_t bin = slot <= 0.0 ? 0 : std::min (static_cast<size_t> (slot), bins.size () - 1);
+				bins [bin] += static_cast<float> (weight);
+				total += weight;
+			}
+		}
+		for (float& bin : bins) bin /= static_cast<float> (total);
+	}
+
+	template <typename T>
+	void
+	ColumnSketch::AddNumbers (const T* values, const u64* nulls, size_t rows) {
+		T low = std::numeric_limits<T>::max ();
+		T high = std::numeric_limits<T>::lowest ();
+		bool any = false;
+		for (size_t base = 0; base < rows; base += 64) {
+			const size_t count = std::min<size_t> (64, rows - base);
+			const u64 mask = RowMask (count);
+			const u64 word = nulls [base >> 6] & mask;
+			const T* block = values + base;
+			if (word == 0) {
+				// No NULLs: keep min/max apart from the hashing so this loop stays branch-free.
+				for (size_t i = 0; i < count; ++i) {
+					low = std::min (low, block [i]);
+					high = std::max (high, block [i]);
+				}
+				for (size_t i = 0; i < count; ++i) {
+					m_distinct.Add (HashNumber (block [i]));
+					m_quantiles.Add (static_cast<f64> (block [i]));
+				}
+				any = true;
+			}
+			else if (word != mask) {
+				for (size_t i = 0; i < count; ++i) {
+					if ((word >> i) & 1) continue;
+					low = std::min (low, block [i]);
+					high = std::max (high, block [i]);
+					m_distinct.Add (HashNumber (block [i]));
+					m_quantiles.Add (static_cast<f64> (block [i]));
+					any = true;
+				}
+			}
+		}
+		if (!any) return;
+		m_stats.min = m_seen ? std::min (m_stats.min, static_cast<f64> (low)) : static_cast<f64> (low);
+		m_stats.max = m_seen ? std::max (m_stats.max, static_cast<f64> (high)) : static_cast<f64> (high);
+		m_seen = true;
+	}
+
+	void
+	ColumnSketch::AddText (const ColumnChunkView& chunk) {
+		const bool ordered = chunk.type == ColumnType::Text;
+		for (size_t row = 0; row < chunk.rows; ++row) {
+			if (chunk.IsNull (row)) continue;
+			const std::string_view text = chunk.Text (row);
+			m_distinct.Add (HashBytes (text));
+			if (!ordered) continue;
+			if (!m_seen) {
+				m_stats.minText = text;
+				m_stats.maxText = text;
+				m_seen = true;
+			}
+			else if (text < m_stats.minText) {
+				m_stats.minText = text;
+			}
+			else if (text > m_stats.maxText) {
+				m_stats.maxText = text;
+			}
+		}
+	}
+
+	void
+	ColumnSketch::Add (const ColumnChunkView& chunk) {
+		m_stats.rows += chunk.rows;
+		for (size_t base = 0; base < chunk.rows; base += 64) {
+			m_stats.nulls += std::popcount (chunk.nulls [base >> 6] & RowMask (chunk.rows - base));
+		}
+		switch (chunk.type) {
+			case ColumnType::Null: break;
+			case ColumnType::Integer: AddNumbers (chunk.integers.data (), chunk.nulls, chunk.rows); break;
+			case ColumnType::Real: AddNumbers (chunk.reals.data (), chunk.nulls, chunk.rows); break;
+			case ColumnType::Text:
+			case ColumnType::Blob: AddText (chunk); break;
+		}
+	}
+
+	ColumnStats
+	ColumnSketch::Summarize () const {
+		ColumnStats stats = m_stats;
+		stats.distinct = std::min (m_distinct.Estimate (), static_cast<double> (stats.rows - stats.nulls));
+		if (m_quantiles.Count () > 0) {
+			m_quantiles.Quantiles (ColumnStats::kQuantiles, stats.quantiles);
+			m_quantiles.Histogram (stats.min, stats.max, stats.histogram);
+		}
+		return stats;
+	}
+
+	ColumnChunkView
+	StatsEngine::ChunkCopy::View () const {
+		ColumnChunkView view;
+		view.rows = rows;
+		view.type = type;
+		view.nulls = nulls.data ();
+		view.integers = integers;
+		view.reals = reals;
+		view.offsets = offsets;
+		view.bytes = bytes.data ();
+		return view;
+	}
+
+	StatsEngine::StatsEngine (std::function<void ()> notify)
+		: m_notify (std::move (notify)), m_thread ([this] (std::stop_token stop) { Run (stop); }) {}
+
+	StatsEngine::~StatsEngine () = default;
+
+	void
+	StatsEngine::Reset () {
+		m_types.clear ();
+		m_fedGroups = 0;
+		m_fedComplete = false;
+		std::lock_guard lock (m_queueMutex);
+		m_queue.clear ();
+		++m_epoch;
+		std::lock_guard stats (m_statsMutex);
+		m_stats.clear ();
+		m_generation.fetch_add (1, std::memory_order_release);
+	}
+
+	void
+	StatsEngine::Feed (const ResultSet& results, bool complete) {
+		// A widened column was converted in place, so what the worker saw of it is stale.
+		bool widened = m_types.size () != results.ColumnCount ();
+		for (size_t column = 0; !widened && column < m_types.size (); ++column) widened = m_types [column] != results.Type (column);
+		if (widened) {
+			if (m_fedGroups > 0 || m_fedComplete) Reset ();
+			m_types.resize (results.ColumnCount ());
+			for (size_t column = 0; column < m_types.size (); ++column) m_types [column] = results.Type (column);
+		}
+		if (m_fedComplete) return;
+
+		const size_t groups = results.GroupCount ();
+		const size_t ready = complete ? groups : std::max<size_t> (groups, 1) - 1;
+		if (m_fedGroups == ready && !complete) return;
+
+		size_t room;
+		{
+			std::lock_guard lock (m_queueMutex);
+			room = kMaxQueued - std::min (m_queue.size (), kMaxQueued);
+		}
+		std::vector<Work> batch;
+		for (; m_fedGroups < ready && batch.size () < room; ++m_fedGroups) {
+			Work& work = batch.emplace_back ();
+			work.columns.resize (m_types.size ());
+			for (size_t column = 0; column < m_types.size (); ++column) {
+				const ColumnChunkView chunk = results.Chunk (m_fedGroups, column);
+				ChunkCopy& copy = work.columns [column];
+				copy.type = chunk.type;
+				copy.rows = chunk.rows;
+				copy.nulls.assign (chunk.nulls, chunk.nulls + (chunk.rows + 63) / 64);
+				copy.integers.assign (chunk.integers.begin (), chunk.integers.end ());
+				copy.reals.assign (chunk.reals.begin (), chunk.reals.end ());
+				copy.offsets.assign (chunk.offsets.begin (), chunk.offsets.end ());
+				if (!chunk.offsets.empty ()) copy.bytes.assign (chunk.bytes, chunk.bytes + chunk.offsets.back ());
+			}
+		}
+		if (complete && m_fedGroups == ready) {
+			// An empty result still sends one empty group so its columns show up.
+			if (groups == 0) batch.emplace_back ();
+			m_fedComplete = true;
+		}
+		if (batch.empty ()) return;
+
+		std::lock_guard lock (m_queueMutex);
+		for (Work& work : batch) {
+			work.epoch = m_epoch;
+			work.types = m_types;
+			m_queue.push_back (std::move (work));
+		}
+		m_wake.notify_one ();
+	}
+
+	void
+	StatsEngine::Flush () {
+		std::unique_lock lock (m_queueMutex);
+		m_idle.wait (lock, [this] { return m_queue.empty () && !m_working; });
+	}
+
+	void
+	StatsEngine::Snapshot (std::vector<ColumnStats>& stats) const {
+		std::lock_guard lock (m_statsMutex);
+		stats = m_stats;
+	}
+
+	void
+	StatsEngine::Run (std::stop_token stop) {
+		std::vector<ColumnStats> stats;
+		while (true) {
+			Work work;
+			{
+				std::unique_lock lock (m_queueMutex);
+				m_working = false;
+				m_idle.notify_all ();
+				if (!m_wake.wait (lock, stop, [this] { return !m_queue.empty (); })) return;
+				work = std::move (m_queue.front ());
+				m_queue.pop_front ();
+				m_working = true;
+			}
+
+			if (work.epoch != m_workerEpoch || m_sketches.size () != work.types.size ()) {
+				m_workerEpoch = work.epoch;
+				m_sketches.clear ();
+				for (const ColumnType type : work.types) m_sketches.emplace_back (type);
+			}
+			for (size_t column = 0; column < work.columns.size (); ++column) m_sketches [column].Add (work.columns [column].View ());
+			stats.clear ();
+			for (const ColumnSketch& sketch : m_sketches) stats.push_back (sketch.Summarize ());
+
+			{
+				// Reset () may have dropped this result meanwhile; its stats must not come back.
+				std::lock_guard lock (m_queueMutex);
+				if (work.epoch != m_epoch) continue;
+				std::lock_guard published (m_statsMutex);
+				m_stats.swap (stats);
+				m_generation.fetch_add (1, std::memory_order_release);
+			}
+			if (m_notify) m_notify ();
+		}
+	}
+
+}  // namespace ambidb::db
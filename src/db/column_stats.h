@@ -0,0 +1,243 @@
+#pragma once
+
+#include "result_set.h"
+
+#include <macro.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ambidb::db {
+
+	/**
+	 * @brief Approximate distinct count in a fixed 4 KiB: 2^12 registers holding the longest
+	 * run of leading zeros seen among the hashes routed to them. Standard error is about
+	 * 1.6%; small counts use linear counting and are close to exact.
+	 */
+	class HyperLogLog {
+	public:
+		static constexpr unsigned kBits = 12;
+
+		void
+		Add (u64 hash) {
+			const size_t index = hash >> (64 - kBits);
+			const u8 rank = static_cast<u8> (std::countl_zero ((hash << kBits) | (u64{1} << (kBits - 1))) + 1);
+			m_registers [index] = std::max (m_registers [index], rank);
+		}
+
+		double
+		Estimate () const;
+
+	private:
+		std::array<u8, size_t{1} << kBits> m_registers{};
+	};
+
+	/**
+	 * @brief Streaming quantile sketch (KLL): a stack of compactors whose capacities shrink
+	 * by 2/3 per level below the top. A full compactor sorts its items and passes every
+	 * other one, at twice the weight, to the level above. It keeps about 3 * kK items no
+	 * matter how many were added; rank error is around 1%.
+	 */
+	class QuantileSketch {
+	public:
+		static constexpr size_t kK = 200;
+
+		void
+		Add (f64 value);
+
+		u64
+		Count () const {
+			return m_count;
+		}
+
+		/// Approximate value at each rank in @p ranks (ascending, in [0, 1]). Count () must be non-zero.
+		void
+		Quantiles (std::span<const double> ranks, std::span<f64> values) const;
+
+		/// Approximate share of values in each of @p bins equal-width bins over [min, max].
+		void
+		Histogram (f64 min, f64 max, std::span<float> bins) const;
+
+	private:
+		struct Weighted {
+			f64 value;
+			u64 weight;
+		};
+
+		size_t
+		Capacity (size_t level) const;
+		void
+		Compress ();
+		std::vector<Weighted>
+		Sorted () const;
+
+		std::vector<std::vector<f64>> m_levels;	 ///< Level h holds items of weight 2^h.
+		size_t m_size{0};		 ///< Items over all levels.
+		size_t m_capacity{0};	 ///< Sum of Capacity () over all levels.
+		u64 m_count{0};
+		u64 m_coin{0x9E3779B97F4A7C15};	 ///< Picks which half a compaction keeps.
+	};
+
+	/// Summary of one result column as of the rows processed so far.
+	struct ColumnStats {
+		static constexpr std::array<double, 5> kQuantiles = {0.05, 0.25, 0.5, 0.75, 0.95};
+		static constexpr size_t kHistogramBins = 16;
+
+		ColumnType type{ColumnType::Null};
+		u64 rows{0};
+		u64 nulls{0};
+		double distinct{0.0};  ///< HyperLogLog estimate over non-null values.
+		/// Integer and Real columns; set when there is a non-null value.
+		f64 min{0.0};
+		f64 max{0.0};
+		std::array<f64, kQuantiles.size ()> quantiles{};
+		std::array<float, kHistogramBins> histogram{};	///< Share of values per bin over [min, max].
+		/// Text columns: byte-wise smallest and largest value.
+		std::string minText;
+		std::string maxText;
+
+		bool
+		HasValues () const {
+			return rows > nulls;
+		}
+	};
+
+	/**
+	 * @brief Accumulates ColumnStats for one column, chunk by chunk, in constant memory.
+	 *
+	 * Every chunk must have the same type. Null counts come from popcounts of the null
+	 * bitmap and min/max from tight loops over 64-row blocks without NULLs, which the
+	 * compiler can vectorize. Numbers and text are hashed into a HyperLogLog; numbers also
+	 * feed a QuantileSketch, which supplies quantiles and the histogram.
+	 */
+	class ColumnSketch {
+	public:
+		explicit ColumnSketch (ColumnType type = ColumnType::Null) {
+			m_stats.type = type;
+		}
+
+		void
+		Add (const ColumnChunkView& chunk);
+
+		ColumnStats
+		Summarize () const;
+
+	private:
+		template <typename T>
+		void
+		AddNumbers (const T* values, const u64* nulls, size_t rows);
+		void
+		AddText (const ColumnChunkView& chunk);
+
+		ColumnStats m_stats;
+		bool m_seen{false};	 ///< A non-null value set min/max.
+		HyperLogLog m_distinct;
+		QuantileSketch m_quantiles;
+	};
+
+	/**
+	 * @brief Keeps ColumnStats for a streaming ResultSet on a background thread.
+	 *
+	 * The ResultSet changes on the UI thread as rows arrive and groups spill, so the worker
+	 * never reads it. Feed () copies each row group to the worker once the group is full
+	 * (full groups never change again) and the last one once the result is complete; the
+	 * worker folds the copies into one ColumnSketch per column and publishes fresh stats
+	 * after each group. Only a few groups are ever in flight, and the sketches are a fixed
+	 * size, so memory is O(columns). If a column's type widens after groups were fed, its
+	 * earlier values were converted in place, so Feed () starts over from the first group.
+	 */
+	class StatsEngine {
+	public:
+		/// Copied groups waiting for the worker; Feed () holds back the rest until they are done.
+		static constexpr size_t kMaxQueued = 2;
+
+		MAKE_NONCOPYABLE (StatsEngine);
+		MAKE_NONMOVABLE (StatsEngine);
+		/// @p notify is called from the worker after each published update.
+		explicit StatsEngine (std::function<void ()> notify = {});
+		~StatsEngine ();
+
+		/// UI thread: forget the current result and any queued groups.
+		void
+		Reset ();
+
+		/**
+		 * @brief UI thread: hand groups of @p results not seen yet to the worker. The last,
+		 * still growing group goes only once @p complete. Cheap when there is nothing new,
+		 * so call it every frame: groups held back by kMaxQueued go out on a later call.
+		 */
+		void
+		Feed (const ResultSet& results, bool complete);
+
+		/// Block until every fed group is in the published stats.
+		void
+		Flush ();
+
+		/// Bumped whenever the published stats change.
+		u64
+		Generation () const {
+			return m_generation.load (std::memory_order_acquire);
+		}
+
+		/// Copy the published stats, one per column, into @p stats.
+		void
+		Snapshot (std::vector<ColumnStats>& stats) const;
+
+	private:
+		struct ChunkCopy {
+			ColumnType type{ColumnType::Null};
+			size_t rows{0};
+			std::vector<u64> nulls;
+			std::vector<i64> integers;
+			std::vector<f64> reals;
+			std::vector<u32> offsets;
+			std::vector<char> bytes;
+
+			ColumnChunkView
+			View () const;
+		};
+
+		struct Work {
+			u64 epoch{0};
+			std::vector<ColumnType> types;	///< Set on the first group of an epoch.
+			std::vector<ChunkCopy> columns;
+		};
+
+		void
+		Run (std::stop_token stop);
+
+		// UI thread.
+		std::vector<ColumnType> m_types;
+		size_t m_fedGroups{0};
+		bool m_fedComplete{false};
+
+		std::mutex m_queueMutex;
+		std::condition_variable_any m_wake;
+		std::condition_variable_any m_idle;
+		std::deque<Work> m_queue;
+		u64 m_epoch{0};
+		bool m_working{false};
+
+		// Worker thread.
+		u64 m_workerEpoch{0};
+		std::vector<ColumnSketch> m_sketches;
+
+		mutable std::mutex m_statsMutex;
+		std::vector<ColumnStats> m_stats;
+		std::atomic<u64> m_generation{0};
+
+		std::function<void ()> m_notify;
+		std::jthread m_thread;	///< Last member: stops before the rest is destroyed.
+	};
+
+}  // namespace ambidb::db
@@ -0,0 +1,205 @@
+#include "driver.h"
+
+#include "sqlite_driver.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+namespace ambidb::db {
+
+	namespace {
+
+		template <typename... Ts>
+		struct Overloaded : Ts... {
+			using Ts::operator()...;
+		};
+
+		/// Rows per statement of the generic InsertRows (); keeps statements to a few hundred KiB.
+		constexpr size_t kLiteralInsertRows = 500;
+
+		/// @p value as an SQL literal.
+		void
+		AppendLiteral (std::string& sql, const Value& value) {
+			char scratch [32];
+			std::visit (Overloaded{
+							[&] (std::monostate) { sql += "NULL"; },
+							[&] (i64 v) {
+								std::snprintf (scratch, sizeof (scratch), "%" PRId64, v);
+								sql += scratch;
+							},
+							[&] (f64 v) {
+								if (!std::isfinite (v)) {
+									sql += "NULL";
+									return;
+								}
+								std::snprintf (scratch, sizeof (scratch), "%.17g", v);
+								sql += scratch;
+							},
+							[&] (const std::string& v) {
+								sql += '\'';
+								for (const char c : v) {
+									if (c == '\'') sql += '\'';
+									sql += c;
+								}
+								sql += '\'';
+							},
+							[&] (const Blob& v) {
+								constexpr char kHex [] = "0123456789abcdef";
+								sql += "X'";
+								for (const u8 byte : v.bytes) {
+									sql += kHex [byte >> 4];
+									sql += kHex [byte & 0xf];
+								}
+								sql += '\'';
+							},
+						},
+						value);
+		}
+
+	}  // namespace
+
+	const char*
+	FormatValue (const Value& value, char* scratch, size_t scratchSize) {
+		return std::visit (Overloaded{
+							   [] (std::monostate) -> const char* { return "NULL"; },
+							   [&] (i64 v) -> const char* {
+								   std::snprintf (scratch, scratchSize, "%" PRId64, v);
+								   return scratch;
+							   },
+							   [&] (f64 v) -> const char* {
+								   std::snprintf (scratch, scratchSize, "%.15g", v);
+								   return scratch;
+							   },
+							   [] (const std::string& v) -> const char* { return v.c_str (); },
+							   [&] (const Blob& v) -> const char* {
+								   std::snprintf (scratch, scratchSize, "<blob %zu bytes>", v.bytes.size ());
+								   return scratch;
+							   },
+						   },
+						   value);
+	}
+
+	DbResult<void>
+	Connection::InsertRows (std::string_view table, std::span<const std::string> columns, const RowBatch& rows) {
+		const std::string head = InsertHead (table, columns);
+		const size_t count = rows.RowCount ();
+		std::string sql;
+		for (size_t first = 0; first < count; first += kLiteralInsertRows) {
+			sql = head;
+			const size_t last = std::min (first + kLiteralInsertRows, count);
+			for (size_t row = first; row < last; ++row) {
+				sql += row == first ? "(" : ", (";
+				for (size_t column = 0; column < rows.columnCount; ++column) {
+					if (column > 0) sql += ", ";
+					AppendLiteral (sql, rows.At (row, column));
+				}
+				sql += ')';
+			}
+			if (DbResult<i64> done = RunStatement (*this, sql); !done) return std::unexpected (std::move (done.error ()));
+		}
+		return {};
+	}
+
+	DbResult<std::vector<CatalogEntry>>
+	Connection::ListSchemas () {
+		return ReadCatalog (*this, "SELECT schema_name FROM information_schema.schemata ORDER BY schema_name");
+	}
+
+	DbResult<std::vector<CatalogEntry>>
+	Connection::ListTables (std::string_view schema) {
+		return ReadCatalog (*this,
+							"SELECT table_name, CASE table_type WHEN 'VIEW' THEN 'view' ELSE 'table' END FROM information_schema.tables "
+							"WHERE table_schema = " +
+								SqlLiteral (schema) + " ORDER BY table_name");
+	}
+
+	DbResult<std::vector<CatalogEntry>>
+	Connection::ListColumns (std::string_view schema, std::string_view table) {
+		return ReadCatalog (*this,
+							"SELECT column_name, data_type FROM information_schema.columns WHERE table_schema = " + SqlLiteral (schema) +
+								" AND table_name = " + SqlLiteral (table) + " ORDER BY ordinal_position");
+	}
+
+	DbResult<i64>
+	RunStatement (Connection& connection, std::string_view sql) {
+		DbResult<std::unique_ptr<Cursor>> cursor = connection.Execute (sql);
+		if (!cursor) return std::unexpected (std::move (cursor.error ()));
+		RowBatch discard;
+		while (true) {
+			const DbResult<bool> more = (*cursor)->FetchBatch (discard, 256);
+			if (!more) return std::unexpected (more.error ());
+			if (!*more) break;
+			discard.values.clear ();
+		}
+		return (*cursor)->RowsAffected ();
+	}
+
+	DbResult<std::vector<CatalogEntry>>
+	ReadCatalog (Connection& connection, std::string_view sql) {
+		DbResult<std::unique_ptr<Cursor>> cursor = connection.Execute (sql);
+		if (!cursor) return std::unexpected (std::move (cursor.error ()));
+		std::vector<CatalogEntry> entries;
+		RowBatch batch;
+		char scratch [64];
+		while (true) {
+			const DbResult<bool> more = (*cursor)->FetchBatch (batch, 256);
+			if (!more) return std::unexpected (more.error ());
+			for (size_t row = 0; row < batch.RowCount (); ++row) {
+				CatalogEntry& entry = entries.emplace_back ();
+				entry.name = FormatValue (batch.At (row, 0), scratch, sizeof (scratch));
+				if (batch.columnCount > 1 && !std::holds_alternative<std::monostate> (batch.At (row, 1))) {
+					entry.detail = FormatValue (batch.At (row, 1), scratch, sizeof (scratch));
+				}
+				if (batch.columnCount > 2) {
+					const Value& marker = batch.At (row, 2);
+					if (const i64* number = std::get_if<i64> (&marker)) {
+						entry.marker = static_cast<u64> (*number);
+					}
+					else if (const std::string* text = std::get_if<std::string> (&marker)) {
+						// FNV-1a; 0 stays free for "unknown".
+						u64 hash = 14695981039346656037ull;
+						for (const char c : *text) hash = (hash ^ static_cast<u8> (c)) * 1099511628211ull;
+						entry.marker = hash | 1;
+					}
+				}
+			}
+			batch.values.clear ();
+			if (!*more) break;
+		}
+		return entries;
+	}
+
+	std::string
+	SqlLiteral (std::string_view text) {
+		std::string sql;
+		AppendLiteral (sql, Value{std::string (text)});
+		return sql;
+	}
+
+	std::string
+	InsertHead (std::string_view table, std::span<const std::string> columns) {
+		std::string sql = "INSERT INTO ";
+		sql += table;
+		for (size_t column = 0; column < columns.size (); ++column) {
+			sql += column == 0 ? " (\"" : ", \"";
+			for (const char c : columns [column]) {
+				if (c == '"') sql += '"';
+				sql += c;
+			}
+			sql += '"';
+		}
+		if (!columns.empty ()) sql += ')';
+		sql += " VALUES ";
+		return sql;
+	}
+
+	Driver*
+	FindDriver (std::string_view name) {
+		static SqliteDriver sqlite;
+		if (name == sqlite.Name ()) return &sqlite;
+		return nullptr;
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <macro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace ambidb::db {
+
+	struct DbError {
+		std::string message;
+	};
+
+	template <typename T>
+	using DbResult = result<T, DbError>;
+
+	struct Blob {
+		std::vector<u8> bytes;
+
+		bool
+		operator== (const Blob&) const = default;
+	};
+
+	/**
+	 * @brief One cell. The alternatives mirror the storage classes every driver can map to.
+	 */
+	using Value = std::variant<std::monostate, i64, f64, std::string, Blob>;
+
+	/**
+	 * @brief Render @p value for display. Text is returned as-is (no copy); other
+	 * values are formatted into @p scratch, which must outlive the returned pointer.
+	 */
+	const char*
+	FormatValue (const Value& value, char* scratch, size_t scratchSize);
+
+	struct ColumnInfo {
+		std::string name;
+		std::string declaredType;  ///< As reported by the driver; may be empty.
+	};
+
+	/**
+	 * @brief A block of rows in row-major order, the unit in which results travel
+	 * from a worker to the UI thread.
+	 */
+	struct RowBatch {
+		size_t columnCount{0};
+		std::vector<Value> values;
+
+		size_t
+		RowCount () const {
+			return columnCount ? values.size () / columnCount : 0;
+		}
+
+		const Value&
+		At (size_t row, size_t column) const {
+			return values [row * columnCount + column];
+		}
+	};
+
+	/// One object of a catalog: a schema, a table or view, or a column.
+	struct CatalogEntry {
+		std::string name;
+		std::string detail;	 ///< Tables: "table" or "view"; columns: the declared type.
+		u64 marker{0};		 ///< Changes whenever the object or anything in it does; 0 if unknown.
+
+		bool
+		operator== (const CatalogEntry&) const = default;
+	};
+
+	struct ConnectionParams {
+		std::string driver;	 ///< Driver name, e.g. "sqlite".
+		std::string target;	 ///< Driver-specific: a file path for SQLite, a host for servers.
+	};
+
+	/**
+	 * @brief The rows of one executed statement. Used by one worker thread at a time.
+	 */
+	class Cursor {
+	public:
+		MAKE_NONCOPYABLE (Cursor);
+		MAKE_NONMOVABLE (Cursor);
+		Cursor () = default;
+		virtual ~Cursor () = default;
+
+		virtual const std::vector<ColumnInfo>&
+		Columns () const = 0;
+
+		/**
+		 * @brief Append up to @p maxRows rows to @p batch.
+		 * @return true while more rows may follow, false once the result is exhausted.
+		 */
+		virtual DbResult<bool>
+		FetchBatch (RowBatch& batch, size_t maxRows) = 0;
+
+		/**
+		 * @brief Whether the statement leaves the database unchanged. Only such statements
+		 * are kept open for windowed fetching; others are read to the end at once.
+		 */
+		virtual bool
+		ReadOnly () const = 0;
+
+		/**
+		 * @brief Rows changed by a data-modifying statement; 0 for queries.
+		 */
+		virtual i64
+		RowsAffected () const = 0;
+	};
+
+	/**
+	 * @brief An open session. All calls except Interrupt() happen on worker threads,
+	 * one at a time; drivers may block freely.
+	 */
+	class Connection {
+	public:
+		MAKE_NONCOPYABLE (Connection);
+		MAKE_NONMOVABLE (Connection);
+		Connection () = default;
+		virtual ~Connection () = default;
+
+		/**
+		 * @brief Run @p sql. With several statements, all but the last run to completion
+		 * and the cursor belongs to the last one.
+		 */
+		virtual DbResult<std::unique_ptr<Cursor>>
+		Execute (std::string_view sql) = 0;
+
+		/**
+		 * @brief Append @p rows to @p table, naming @p columns in order (none: every
+		 * column of the table). @p table is spliced in as written, so it may be qualified
+		 * or quoted. Bulk loads call this with large batches inside their own transaction.
+		 *
+		 * The default runs multi-row INSERT statements with literal values. Drivers override
+		 * it with their fastest path: bound multi-row INSERTs, or COPY FROM STDIN on servers
+		 * that have it.
+		 */
+		virtual DbResult<void>
+		InsertRows (std::string_view table, std::span<const std::string> columns, const RowBatch& rows);
+
+		/**
+		 * @brief Catalog introspection, one level at a time so a browser loads only what it
+		 * shows. The defaults query information_schema and report no markers; drivers
+		 * override them with their own catalog and change markers, so a refresh can skip
+		 * whatever has not changed.
+		 */
+		virtual DbResult<std::vector<CatalogEntry>>
+		ListSchemas ();
+		virtual DbResult<std::vector<CatalogEntry>>
+		ListTables (std::string_view schema);
+		virtual DbResult<std::vector<CatalogEntry>>
+		ListColumns (std::string_view schema, std::string_view table);
+
+		/**
+		 * @brief Thread-safe: make the statement running on the worker fail promptly.
+		 */
+		virtual void
+		Interrupt () = 0;
+
+		virtual void
+		Close () = 0;
+	};
+
+	/**
+	 * @brief Run @p sql on @p connection, discarding any rows.
+	 * @return Rows changed, as Cursor::RowsAffected ().
+	 */
+	DbResult<i64>
+	RunStatement (Connection& connection, std::string_view sql);
+
+	/**
+	 * @brief Run @p sql and read each row as a catalog entry: the first column is the
+	 * name, the second (if any) the detail and the third (if any) the marker, taken as is
+	 * when it is an integer and hashed otherwise.
+	 */
+	DbResult<std::vector<CatalogEntry>>
+	ReadCatalog (Connection& connection, std::string_view sql);
+
+	/// @p text as a quoted SQL string literal.
+	std::string
+	SqlLiteral (std::string_view text);
+
+	/// "INSERT INTO table ("a", "b") VALUES ", with each column name quoted.
+	std::string
+	InsertHead (std::string_view table, std::span<const std::string> columns);
+
+	/**
+	 * @brief Factory for connections of one database type.
+	 *
+	 * Drivers use virtual dispatch: the type is only known at runtime and the calls
+	 * happen on worker threads, never in the per-frame path.
+	 */
+	class Driver {
+	public:
+		MAKE_NONCOPYABLE (Driver);
+		MAKE_NONMOVABLE (Driver);
+		Driver () = default;
+		virtual ~Driver () = default;
+
+		virtual const char*
+		Name () const = 0;
+
+		virtual DbResult<std::unique_ptr<Connection>>
+		Connect (const ConnectionParams& params) = 0;
+	};
+
+	/**
+	 * @brief Built-in driver by name ("sqlite"), or nullptr if this build has none.
+	 */
+	Driver*
+	FindDriver (std::string_view name);
+
+}  // namespace ambidb::db
@@ -0,0 +1,564 @@
+#include "exporter.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ambidb::db {
+
+	namespace {
+
+		constexpr std::string_view kColumnarMagic = "AMBICOL1";
+		constexpr char kHexDigits [] = "0123456789abcdef";
+
+		/// One cell, whichever storage it came from. type is Null for NULL.
+		struct Cell {
+			ColumnType type{ColumnType::Null};
+			i64 integer{0};
+			f64 real{0.0};
+			std::string_view bytes;	 ///< Text or Blob.
+		};
+
+		Cell
+		BatchCell (const Value& value) {
+			if (const i64* integer = std::get_if<i64> (&value)) return {ColumnType::Integer, *integer, 0.0, {}};
+			if (const f64* real = std::get_if<f64> (&value)) return {ColumnType::Real, 0, *real, {}};
+			if (const std::string* text = std::get_if<std::string> (&value)) return {ColumnType::Text, 0, 0.0, *text};
+			if (const Blob* blob = std::get_if<Blob> (&value)) {
+				return {ColumnType::Blob, 0, 0.0, {reinterpret_cast<const char*> (blob->bytes.data ()), blob->bytes.size ()}};
+			}
+			return {};
+		}
+
+		Cell
+		ChunkCell (const ColumnChunkView& chunk, size_t row) {
+			if (chunk.IsNull (row)) return {};
+			switch (chunk.type) {
+				case ColumnType::Null: return {};
+				case ColumnType::Integer: return {ColumnType::Integer, chunk.integers [row], 0.0, {}};
+				case ColumnType::Real: return {ColumnType::Real, 0, chunk.reals [row], {}};
+				case ColumnType::Text:
+				case ColumnType::Blob: return {chunk.type, 0, 0.0, chunk.Text (row)};
+			}
+			UNREACHABLE ();
+		}
+
+		template <typename T>
+		void
+		AppendNumber (std::string& out, T value) {
+			char buffer [32];
+			const std::to_chars_result end = std::to_chars (buffer, buffer + sizeof (buffer), value);
+			out.append (buffer, end.ptr);
+		}
+
+		void
+		AppendHex (std::string& out, std::string_view bytes) {
+			const size_t at = out.size ();
+			out.resize (at + bytes.size () * 2);
+			char* hex = out.data () + at;
+			for (const char c : bytes) {
+				const auto byte = static_cast<unsigned char> (c);
+				*hex++ = kHexDigits [byte >> 4];
+				*hex++ = kHexDigits [byte & 15];
+			}
+		}
+
+		template <typename T>
+		void
+		AppendRaw (std::string& out, const T* data, size_t count) {
+			out.append (reinterpret_cast<const char*> (data), count * sizeof (T));
+		}
+
+		template <typename T>
+		void
+		AppendRaw (std::string& out, T value) {
+			AppendRaw (out, &value, 1);
+		}
+
+		using ByteSet = std::array<bool, 256>;
+
+		template <typename Predicate>
+		constexpr ByteSet
+		MakeByteSet (Predicate predicate) {
+			ByteSet set{};
+			for (size_t c = 0; c < set.size (); ++c) set [c] = predicate (static_cast<unsigned char> (c));
+			return set;
+		}
+
+		constexpr ByteSet kCsvQuote = MakeByteSet ([] (unsigned char c) { return c == '"'; });
+		constexpr ByteSet kCsvQuoted = MakeByteSet ([] (unsigned char c) { return c == ',' || c == '"' || c == '\n' || c == '\r'; });
+		constexpr ByteSet kTsvEscaped = MakeByteSet ([] (unsigned char c) { return c == '\t' || c == '\n' || c == '\r' || c == '\\'; });
+		constexpr ByteSet kJsonEscaped = MakeByteSet ([] (unsigned char c) { return c < 0x20 || c == '"' || c == '\\'; });
+
+		/**
+		 * @brief Append @p text with each byte in @p special replaced by escape (byte); the
+		 * runs between them are copied in one go.
+		 */
+		template <typename Escape>
+		void
+		AppendEscaped (std::string& out, std::string_view text, const ByteSet& special, Escape escape) {
+			size_t run = 0;
+			for (size_t i = 0; i < text.size (); ++i) {
+				const auto c = static_cast<unsigned char> (text [i]);
+				if (!special [c]) continue;
+				out.append (text.data () + run, i - run);
+				escape (out, c);
+				run = i + 1;
+			}
+			out.append (text.data () + run, text.size () - run);
+		}
+
+		bool
+		NeedsAny (std::string_view text, const ByteSet& special) {
+			return std::ranges::any_of (text, [&] (char c) { return special [static_cast<unsigned char> (c)]; });
+		}
+
+		void
+		AppendCsv (std::string& out, const Cell& cell) {
+			switch (cell.type) {
+				case ColumnType::Null: break;
+				case ColumnType::Integer: AppendNumber (out, cell.integer); break;
+				case ColumnType::Real: AppendNumber (out, cell.real); break;
+				case ColumnType::Text:
+					if (!NeedsAny (cell.bytes, kCsvQuoted)) {
+						out += cell.bytes;
+						break;
+					}
+					out += '"';
+					AppendEscaped (out, cell.bytes, kCsvQuote, [] (std::string& to, unsigned char) { to += "\"\""; });
+					out += '"';
+					break;
+				case ColumnType::Blob:
+					out += "\\x";
+					AppendHex (out, cell.bytes);
+					break;
+			}
+		}
+
+		void
+		AppendTsv (std::string& out, const Cell& cell) {
+			switch (cell.type) {
+				case ColumnType::Null: out += "\\N"; break;
+				case ColumnType::Integer: AppendNumber (out, cell.integer); break;
+				case ColumnType::Real: AppendNumber (out, cell.real); break;
+				case ColumnType::Text:
+					AppendEscaped (out, cell.bytes, kTsvEscaped, [] (std::string& to, unsigned char c) {
+						to += '\\';
+						to += c == '\t' ? 't' : c == '\n' ? 'n' : c == '\r' ? 'r' : '\\';
+					});
+					break;
+				case ColumnType::Blob:
+					out += "\\\\x";
+					AppendHex (out, cell.bytes);
+					break;
+			}
+		}
+
+		void
+		AppendJsonString (std::string& out, std::string_view text) {
+			out += '"';
+			AppendEscaped (out, text, kJsonEscaped, [] (std::string& to, unsigned char c) {
+				switch (c) {
+					case '"': to += "\\\""; break;
+					case '\\': to += "\\\\"; break;
+					case '\n': to += "\\n"; break;
+					case '\r': to += "\\r"; break;
+					case '\t': to += "\\t"; break;
+					default:
+						to += "\\u00";
+						to += kHexDigits [c >> 4];
+						to += kHexDigits [c & 15];
+						break;
+				}
+			});
+			out += '"';
+		}
+
+		void
+		AppendJson (std::string& out, const Cell& cell) {
+			switch (cell.type) {
+				case ColumnType::Null: out += "null"; break;
+				case ColumnType::Integer: AppendNumber (out, cell.integer); break;
+				case ColumnType::Real:
+					// JSON has no NaN or infinity.
+					if (std::isfinite (cell.real)) {
+						AppendNumber (out, cell.real);
+					}
+					else {
+						out += "null";
+					}
+					break;
+				case ColumnType::Text: AppendJsonString (out, cell.bytes); break;
+				case ColumnType::Blob:
+					out += "\"\\\\x";
+					AppendHex (out, cell.bytes);
+					out += '"';
+					break;
+			}
+		}
+
+		/// Text formats, row by row; @p at (row, column) yields each Cell.
+		template <typename CellAt>
+		void
+		FormatText (ExportFormat format, std::span<const std::string> keys, size_t rows, size_t columns, CellAt at, std::string& out) {
+			for (size_t row = 0; row < rows; ++row) {
+				switch (format) {
+					case ExportFormat::Csv:
+					case ExportFormat::Tsv: {
+						const char separator = format == ExportFormat::Csv ? ',' : '\t';
+						for (size_t column = 0; column < columns; ++column) {
+							if (column > 0) out += separator;
+							if (format == ExportFormat::Csv) {
+								AppendCsv (out, at (row, column));
+							}
+							else {
+								AppendTsv (out, at (row, column));
+							}
+						}
+						out += '\n';
+						break;
+					}
+					case ExportFormat::JsonLines:
+						if (columns == 0) out += '{';
+						for (size_t column = 0; column < columns; ++column) {
+							out += keys [column];
+							AppendJson (out, at (row, column));
+						}
+						out += "}\n";
+						break;
+					case ExportFormat::Columnar: UNREACHABLE ();
+				}
+			}
+		}
+
+		/// Columnar block for one column of a RowBatch, which has no column types of its own.
+		void
+		AppendBatchColumn (std::string& out, const RowBatch& batch, size_t column) {
+			const size_t rows = batch.RowCount ();
+			ColumnType type = ColumnType::Null;
+			std::vector<u64> nulls ((rows + 63) / 64, 0);
+			for (size_t row = 0; row < rows; ++row) {
+				const ColumnType cell = ColumnTypeOf (batch.At (row, column));
+				if (cell == ColumnType::Null) nulls [row >> 6] |= u64{1} << (row & 63);
+				type = WidenColumnType (type, cell);
+			}
+			AppendRaw (out, static_cast<u8> (type));
+			AppendRaw (out, nulls.data (), nulls.size ());
+
+			switch (type) {
+				case ColumnType::Null: break;
+				case ColumnType::Integer:
+					for (size_t row = 0; row < rows; ++row) AppendRaw (out, BatchCell (batch.At (row, column)).integer);
+					break;
+				case ColumnType::Real:
+					for (size_t row = 0; row < rows; ++row) {
+						const Cell cell = BatchCell (batch.At (row, column));
+						AppendRaw (out, cell.type == ColumnType::Integer ? static_cast<f64> (cell.integer) : cell.real);
+					}
+					break;
+				case ColumnType::Text:
+				case ColumnType::Blob: {
+					// Offsets go first, so values are formatted into a side buffer.
+					std::string bytes;
+					std::vector<u32> offsets;
+					offsets.reserve (rows + 1);
+					for (size_t row = 0; row < rows; ++row) {
+						offsets.push_back (static_cast<u32> (bytes.size ()));
+						const Cell cell = BatchCell (batch.At (row, column));
+						switch (cell.type) {
+							case ColumnType::Null: break;
+							case ColumnType::Integer: AppendNumber (bytes, cell.integer); break;
+							case ColumnType::Real: AppendNumber (bytes, cell.real); break;
+							case ColumnType::Text:
+							case ColumnType::Blob: bytes += cell.bytes; break;
+						}
+						bytes += '\0';
+					}
+					offsets.push_back (static_cast<u32> (bytes.size ()));
+					AppendRaw (out, offsets.data (), offsets.size ());
+					out += bytes;
+					break;
+				}
+			}
+		}
+
+		/// Columnar block for one ResultSet chunk: the arrays as they are.
+		void
+		AppendChunkColumn (std::string& out, const ColumnChunkView& chunk) {
+			AppendRaw (out, static_cast<u8> (chunk.type));
+			AppendRaw (out, chunk.nulls, (chunk.rows + 63) / 64);
+			AppendRaw (out, chunk.integers.data (), chunk.integers.size ());
+			AppendRaw (out, chunk.reals.data (), chunk.reals.size ());
+			AppendRaw (out, chunk.offsets.data (), chunk.offsets.size ());
+			if (!chunk.offsets.empty ()) out.append (chunk.bytes, chunk.offsets.back ());
+		}
+
+		bool
+		WriteAll (int fd, const char* data, size_t size) {
+			while (size > 0) {
+				const ssize_t written = write (fd, data, size);
+				if (written < 0 && errno == EINTR) continue;
+				if (written <= 0) return false;
+				data += written;
+				size -= static_cast<size_t> (written);
+			}
+			return true;
+		}
+
+	}  // namespace
+
+	const char*
+	ExportFormatName (ExportFormat format) {
+		switch (format) {
+			case ExportFormat::Csv: return "CSV";
+			case ExportFormat::Tsv: return "TSV";
+			case ExportFormat::JsonLines: return "JSON Lines";
+			case ExportFormat::Columnar: return "Columnar (binary)";
+		}
+		UNREACHABLE ();
+	}
+
+	const char*
+	ExportFormatExtension (ExportFormat format) {
+		switch (format) {
+			case ExportFormat::Csv: return "csv";
+			case ExportFormat::Tsv: return "tsv";
+			case ExportFormat::JsonLines: return "jsonl";
+			case ExportFormat::Columnar: return "ambicol";
+		}
+		UNREACHABLE ();
+	}
+
+	DbResult<std::unique_ptr<Exporter>>
+	Exporter::Create (ExportFormat format, const std::string& path, std::function<void ()> notify, size_t threads) {
+		const bool stdOut = path == "-";
+		const int fd = stdOut ? STDOUT_FILENO : open (path.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) return std::unexpected (DbError{"Cannot open " + path + ": " + std::strerror (errno)});
+
+		std::unique_ptr<Exporter> exporter (new Exporter (format, fd, !stdOut, std::move (notify)));
+		const size_t count = ThreadCount (threads);
+		exporter->m_formatters.reserve (count);
+		for (size_t i = 0; i < count; ++i) {
+			exporter->m_formatters.emplace_back ([raw = exporter.get ()] (std::stop_token stop) { raw->FormatLoop (stop); });
+		}
+		exporter->m_writer = std::jthread ([raw = exporter.get ()] (std::stop_token stop) { raw->WriteLoop (stop); });
+		return exporter;
+	}
+
+	Exporter::Exporter (ExportFormat format, int fd, bool ownsFd, std::function<void ()> notify)
+		: m_format (format), m_fd (fd), m_ownsFd (ownsFd), m_notify (std::move (notify)) {}
+
+	Exporter::~Exporter () {
+		if (!Done ()) Finish ("Cancelled");
+	}
+
+	void
+	Exporter::Begin (const std::vector<ColumnInfo>& columns) {
+		m_columns = columns;
+		m_keys.clear ();
+		for (size_t column = 0; column < columns.size (); ++column) {
+			std::string key (column == 0 ? "{" : ",");
+			AppendJsonString (key, columns [column].name);
+			key += ':';
+			m_keys.push_back (std::move (key));
+		}
+		auto header = std::make_unique<Block> ();
+		header->header = true;
+		Push (std::move (header));
+	}
+
+	bool
+	Exporter::Write (RowBatch batch) {
+		auto block = std::make_unique<Block> ();
+		block->batch = std::move (batch);
+		return Push (std::move (block));
+	}
+
+	bool
+	Exporter::Write (const ResultSet& results, size_t group) {
+		auto block = std::make_unique<Block> ();
+		block->results = &results;
+		block->group = group;
+		return Push (std::move (block));
+	}
+
+	bool
+	Exporter::Push (std::unique_ptr<Block> block) {
+		std::unique_lock lock (m_mutex);
+		m_space.wait (lock, [this] { return m_blocks.size () < kMaxPending || m_failed || m_cancelled.load (); });
+		if (m_failed || m_cancelled.load ()) return false;
+		m_blocks.push_back (std::move (block));
+		m_formatWake.notify_one ();
+		return true;
+	}
+
+	void
+	Exporter::Finish (std::string error) {
+		if (!error.empty ()) {
+			Fail (std::move (error));
+		}
+		else if (m_cancelled.load ()) {
+			Fail ("Cancelled");
+		}
+
+		bool failed;
+		{
+			// Blocks left after a failure are skipped, not written, so this does not take long.
+			std::unique_lock lock (m_mutex);
+			m_space.wait (lock, [this] { return m_blocks.empty (); });
+			failed = m_failed;
+		}
+		if (!failed && m_format == ExportFormat::Columnar) {
+			const u32 end = 0;
+			if (!WriteAll (m_fd, reinterpret_cast<const char*> (&end), sizeof (end))) Fail (std::string ("Write failed: ") + std::strerror (errno));
+		}
+		if (m_ownsFd && close (m_fd) != 0 && !failed) Fail (std::string ("Close failed: ") + std::strerror (errno));
+		m_ownsFd = false;
+
+		m_done.store (true, std::memory_order_release);
+		if (m_notify) m_notify ();
+	}
+
+	void
+	Exporter::Cancel () {
+		m_cancelled.store (true);
+		// Under the lock, so a Write () about to wait cannot miss the wakeup.
+		std::lock_guard lock (m_mutex);
+		m_space.notify_all ();
+	}
+
+	void
+	Exporter::Fail (std::string error) {
+		std::lock_guard lock (m_mutex);
+		if (m_failed) return;
+		m_failed = true;
+		m_error = std::move (error);
+		m_space.notify_all ();
+	}
+
+	void
+	Exporter::Format (Block& block) const {
+		std::string& out = block.out;
+		out.clear ();
+		const size_t columns = m_columns.size ();
+
+		if (block.header) {
+			switch (m_format) {
+				case ExportFormat::Csv:
+				case ExportFormat::Tsv:
+					for (size_t column = 0; column < columns; ++column) {
+						if (column > 0) out += m_format == ExportFormat::Csv ? ',' : '\t';
+						const Cell name{ColumnType::Text, 0, 0.0, m_columns [column].name};
+						if (m_format == ExportFormat::Csv) {
+							AppendCsv (out, name);
+						}
+						else {
+							AppendTsv (out, name);
+						}
+					}
+					out += '\n';
+					break;
+				case ExportFormat::JsonLines: break;
+				case ExportFormat::Columnar:
+					out += kColumnarMagic;
+					AppendRaw (out, static_cast<u32> (columns));
+					for (const ColumnInfo& column : m_columns) {
+						AppendRaw (out, static_cast<u32> (column.name.size ()));
+						out += column.name;
+					}
+					break;
+			}
+			return;
+		}
+
+		if (block.results) {
+			std::vector<ColumnChunkView> chunks (columns);
+			for (size_t column = 0; column < columns; ++column) chunks [column] = block.results->Chunk (block.group, column);
+			block.rows = columns ? chunks.front ().rows : 0;
+			if (m_format == ExportFormat::Columnar) {
+				AppendRaw (out, static_cast<u32> (block.rows));
+				for (const ColumnChunkView& chunk : chunks) AppendChunkColumn (out, chunk);
+				return;
+			}
+			out.reserve (block.rows * columns * 8);
+			FormatText (m_format, m_keys, block.rows, columns, [&] (size_t row, size_t column) { return ChunkCell (chunks [column], row); }, out);
+			return;
+		}
+
+		const RowBatch& batch = block.batch;
+		block.rows = batch.RowCount ();
+		if (m_format == ExportFormat::Columnar) {
+			AppendRaw (out, static_cast<u32> (block.rows));
+			for (size_t column = 0; column < columns; ++column) AppendBatchColumn (out, batch, column);
+			return;
+		}
+		out.reserve (block.rows * columns * 8);
+		FormatText (m_format, m_keys, block.rows, columns, [&] (size_t row, size_t column) { return BatchCell (batch.At (row, column)); }, out);
+	}
+
+	void
+	Exporter::FormatLoop (std::stop_token stop) {
+		while (true) {
+			Block* block;
+			bool skip;
+			{
+				std::unique_lock lock (m_mutex);
+				if (!m_formatWake.wait (lock, stop, [this] { return m_claimed < m_blocks.size (); })) return;
+				block = m_blocks [m_claimed++].get ();
+				skip = m_failed;
+				if (!m_spare.empty ()) {
+					block->out = std::move (m_spare.back ());
+					m_spare.pop_back ();
+				}
+			}
+			if (!skip) Format (*block);
+			{
+				std::lock_guard lock (m_mutex);
+				block->formatted = true;
+				m_writeWake.notify_one ();
+			}
+		}
+	}
+
+	void
+	Exporter::WriteLoop (std::stop_token stop) {
+		while (true) {
+			Block* block;
+			bool skip;
+			{
+				std::unique_lock lock (m_mutex);
+				if (!m_writeWake.wait (lock, stop, [this] { return !m_blocks.empty () && m_blocks.front ()->formatted; })) return;
+				block = m_blocks.front ().get ();
+				skip = m_failed;
+			}
+			// The block stays queued while it is written, so Finish () waits for it.
+			if (!skip) {
+				if (WriteAll (m_fd, block->out.data (), block->out.size ())) {
+					m_bytes.fetch_add (block->out.size (), std::memory_order_relaxed);
+					m_rows.fetch_add (block->rows, std::memory_order_relaxed);
+				}
+				else {
+					Fail (std::string ("Write failed: ") + std::strerror (errno));
+				}
+			}
+			{
+				std::lock_guard lock (m_mutex);
+				std::string out = std::move (block->out);
+				m_blocks.pop_front ();
+				--m_claimed;
+				if (m_spare.size () < kMaxPending) m_spare.push_back (std::move (out));
+				m_space.notify_all ();
+			}
+			if (m_notify) m_notify ();
+		}
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "driver.h"
+#include "result_set.h"
+
+#include <macro.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ambidb::db {
+
+	enum class ExportFormat : u8 {
+		Csv,		///< RFC 4180; NULL is an empty field, blobs are \x-prefixed hex.
+		Tsv,		///< PostgreSQL text format: backslash escapes, NULL is \N.
+		JsonLines,	///< One object per row keyed by column name.
+		Columnar,	///< Binary row groups laid out like ResultSet chunks; see Exporter.
+	};
+
+	const char*
+	ExportFormatName (ExportFormat format);
+
+	/// File name extension for @p format, without the dot.
+	const char*
+	ExportFormatExtension (ExportFormat format);
+
+	/**
+	 * @brief Streams rows to a file in constant memory, as fast as the disk takes them.
+	 *
+	 * A producer calls Begin () once, then Write () for each block of rows: a RowBatch
+	 * fetched from a driver cursor, or a row group of a stored ResultSet, which is read in
+	 * place. A pool of threads formats queued blocks in parallel, each into its own buffer,
+	 * and a writer thread writes the buffers in order with one large write(2) each, so
+	 * formatting overlaps the I/O. At most kMaxPending blocks are queued or in flight;
+	 * Write () blocks beyond that, which bounds memory whatever the row count. Numbers are
+	 * formatted with std::to_chars, and strings are copied in runs up to the next byte
+	 * that needs escaping.
+	 *
+	 * Columnar files start with "AMBICOL1", a u32 column count and each name as a u32
+	 * length plus bytes. Each block follows as a u32 row count and, per column, a u8
+	 * ColumnType, the null bitmap as (rows + 63) / 64 u64 words and the values: rows i64
+	 * or f64, or for Text and Blob rows + 1 u32 offsets and the bytes, value i being
+	 * [offsets [i], offsets [i + 1] - 1) followed by a NUL. A zero row count ends the file.
+	 * Integers are in host byte order.
+	 *
+	 * Every call but Cancel () comes from the one producer thread.
+	 */
+	class Exporter {
+	public:
+		/// Rows per RowBatch the executor fetches for an export.
+		static constexpr size_t kBatchRows = 8192;
+		static constexpr size_t kMaxPending = 16;
+
+		MAKE_NONCOPYABLE (Exporter);
+		MAKE_NONMOVABLE (Exporter);
+		/// Cancels an unfinished export and joins the threads.
+		~Exporter ();
+
+		/**
+		 * @brief Create or truncate @p path ("-" writes to stdout). @p notify is called from
+		 * the writer thread after each written block and once the export is done.
+		 * @param threads Formatting threads; 0 picks one per core.
+		 */
+		static DbResult<std::unique_ptr<Exporter>>
+		Create (ExportFormat format, const std::string& path, std::function<void ()> notify = {}, size_t threads = 0);
+
+		void
+		Begin (const std::vector<ColumnInfo>& columns);
+
+		/**
+		 * @brief Queue @p batch, waiting while kMaxPending blocks are. False once the
+		 * export failed or was cancelled; the producer should stop and call Finish ().
+		 */
+		bool
+		Write (RowBatch batch);
+
+		/**
+		 * @brief Queue row group @p group of @p results. The rows are read in place, so they
+		 * must not change until Finish () returns.
+		 */
+		bool
+		Write (const ResultSet& results, size_t group);
+
+		/**
+		 * @brief Write everything queued and close the file; with @p error, drop whatever is
+		 * still queued and fail with it instead.
+		 */
+		void
+		Finish (std::string error = {});
+
+		/// Any thread: make Write () return false; Finish () then reports "Cancelled".
+		void
+		Cancel ();
+
+		/// Finish () has returned; Error () is valid from then on.
+		bool
+		Done () const {
+			return m_done.load (std::memory_order_acquire);
+		}
+
+		/// Empty if every row was written.
+		const std::string&
+		Error () const {
+			return m_error;
+		}
+
+		/// Rows written so far.
+		u64
+		Rows () const {
+			return m_rows.load (std::memory_order_relaxed);
+		}
+
+		/// Bytes written so far.
+		u64
+		Bytes () const {
+			return m_bytes.load (std::memory_order_relaxed);
+		}
+
+	private:
+		struct Block {
+			RowBatch batch;
+			const ResultSet* results{nullptr};	///< With group: read the rows from here instead.
+			size_t group{0};
+			bool header{false};	 ///< Column names or the file header instead of rows.
+			bool formatted{false};
+			u64 rows{0};
+			std::string out;
+		};
+
+		Exporter (ExportFormat format, int fd, bool ownsFd, std::function<void ()> notify);
+
+		bool
+		Push (std::unique_ptr<Block> block);
+		void
+		Format (Block& block) const;
+		void
+		FormatLoop (std::stop_token stop);
+		void
+		WriteLoop (std::stop_token stop);
+		void
+		Fail (std::string error);
+
+		ExportFormat m_format;
+		int m_fd;
+		bool m_ownsFd;
+		std::function<void ()> m_notify;
+		std::vector<ColumnInfo> m_columns;
+		std::vector<std::string> m_keys;  ///< JsonLines: `{"name":` / `,"name":`, escaped once.
+
+		std::mutex m_mutex;
+		std::condition_variable_any m_formatWake;  ///< A block waits to be formatted.
+		std::condition_variable_any m_writeWake;   ///< The front block may be formatted.
+		std::condition_variable_any m_space;	   ///< A block was written, or the export failed.
+		std::deque<std::unique_ptr<Block>> m_blocks;  ///< In file order.
+		size_t m_claimed{0};						  ///< Leading blocks a formatter has taken.
+		std::vector<std::string> m_spare;			  ///< Written buffers, reused for capacity.
+		bool m_failed{false};
+		std::string m_error;  ///< Set with m_failed; read by others once m_done.
+
+		std::atomic<bool> m_cancelled{false};
+		std::atomic<bool> m_done{false};
+		std::atomic<u64> m_rows{0};
+		std::atomic<u64> m_bytes{0};
+
+		std::vector<std::jthread> m_formatters;
+		std::jthread m_writer;	///< Last member: stops before the rest is destroyed.
+	};
+
+}  // namespace ambidb::db
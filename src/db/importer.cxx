@@ -0,0 +1,384 @@
+#include "importer.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define AMBIDB_IMPORT_SSE2 1
+#endif
+
+namespace ambidb::db {
+
+	namespace {
+
+		constexpr size_t kNoRecord = static_cast<size_t> (-1);
+
+		size_t
+		CountQuotes (const char* p, const char* end) {
+			size_t count = 0;
+#ifdef AMBIDB_IMPORT_SSE2
+			const __m128i quote = _mm_set1_epi8 ('"');
+			for (; end - p >= 16; p += 16) {
+				const __m128i bytes = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (p));
+				count += static_cast<size_t> (std::popcount (static_cast<u32> (_mm_movemask_epi8 (_mm_cmpeq_epi8 (bytes, quote)))));
+			}
+#endif
+			for (; p < end; ++p) count += *p == '"';
+			return count;
+		}
+
+		/// First delimiter, quote, CR or LF in [p, end), or end.
+		const char*
+		FindSpecial (const char* p, const char* end, char delimiter) {
+#ifdef AMBIDB_IMPORT_SSE2
+			const __m128i delim = _mm_set1_epi8 (delimiter);
+			const __m128i quote = _mm_set1_epi8 ('"');
+			const __m128i cr = _mm_set1_epi8 ('\r');
+			const __m128i lf = _mm_set1_epi8 ('\n');
+			for (; end - p >= 16; p += 16) {
+				const __m128i bytes = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (p));
+				const __m128i hits = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (bytes, delim), _mm_cmpeq_epi8 (bytes, quote)),
+												   _mm_or_si128 (_mm_cmpeq_epi8 (bytes, cr), _mm_cmpeq_epi8 (bytes, lf)));
+				if (const u32 mask = static_cast<u32> (_mm_movemask_epi8 (hits))) return p + std::countr_zero (mask);
+			}
+#endif
+			for (; p < end; ++p) {
+				if (*p == delimiter || *p == '"' || *p == '\r' || *p == '\n') return p;
+			}
+			return end;
+		}
+
+		/// An empty line, LF or CRLF, starts at @p at.
+		size_t
+		BlankLine (std::string_view file, size_t at) {
+			if (file [at] == '\n') return 1;
+			if (file [at] == '\r' && at + 1 < file.size () && file [at + 1] == '\n') return 2;
+			return 0;
+		}
+
+		/**
+		 * Reads the record starting at @p at, calling field (text, quoted) for each field.
+		 * @return Where the next record starts, or kNoRecord with @p error set.
+		 */
+		template <typename F>
+		size_t
+		ReadRecord (std::string_view file, size_t at, char delimiter, std::string& scratch, std::string& error, F&& field) {
+			const char* const begin = file.data ();
+			const char* const end = begin + file.size ();
+			const char* p = begin + at;
+			while (true) {
+				if (p < end && *p == '"') {
+					const char* text = ++p;
+					const char* textEnd;
+					bool escaped = false;
+					while (true) {
+						const auto* quote = static_cast<const char*> (std::memchr (p, '"', static_cast<size_t> (end - p)));
+						if (!quote) {
+							error = "Unterminated quoted field";
+							return kNoRecord;
+						}
+						if (quote + 1 < end && quote [1] == '"') {
+							if (!escaped) scratch.clear ();
+							scratch.append (p, quote + 1);
+							escaped = true;
+							p = quote + 2;
+							continue;
+						}
+						if (escaped) scratch.append (p, quote);
+						textEnd = quote;
+						p = quote + 1;
+						break;
+					}
+					field (escaped ? std::string_view (scratch) : std::string_view (text, textEnd), true);
+				}
+				else {
+					const char* stop = FindSpecial (p, end, delimiter);
+					if (stop < end && *stop == '"') {
+						error = "Quote inside an unquoted field";
+						return kNoRecord;
+					}
+					field (std::string_view (p, stop), false);
+					p = stop;
+				}
+
+				if (p == end) return file.size ();
+				if (*p == delimiter) {
+					++p;
+					continue;
+				}
+				if (*p == '\r' && p + 1 < end && p [1] == '\n') ++p;
+				if (*p == '\n') return static_cast<size_t> (p + 1 - begin);
+				error = "Unexpected character after a field";
+				return kNoRecord;
+			}
+		}
+
+		/// NULL when empty; a number when the whole field is one, unless it has leading zeros.
+		Value
+		ToValue (std::string_view text) {
+			if (text.empty ()) return std::monostate{};
+			const char c = text [0];
+			if ((c >= '0' && c <= '9') || c == '-' || c == '.') {
+				const std::string_view digits = c == '-' ? text.substr (1) : text;
+				const bool leadingZero = digits.size () > 1 && digits [0] == '0' && digits [1] >= '0' && digits [1] <= '9';
+				const char* const last = text.data () + text.size ();
+				if (!leadingZero) {
+					i64 integer = 0;
+					if (const std::from_chars_result parsed = std::from_chars (text.data (), last, integer); parsed.ec == std::errc{} && parsed.ptr == last) {
+						return integer;
+					}
+					f64 real = 0.0;
+					if (const std::from_chars_result parsed = std::from_chars (text.data (), last, real);
+						parsed.ec == std::errc{} && parsed.ptr == last && std::isfinite (real)) {
+						return real;
+					}
+				}
+			}
+			return std::string (text);
+		}
+
+	}  // namespace
+
+	DbResult<std::unique_ptr<Importer>>
+	Importer::Create (const std::string& path, ImportOptions options, std::function<void ()> notify, size_t threads) {
+		const int fd = open (path.c_str (), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return std::unexpected (DbError{"Cannot open " + path + ": " + std::strerror (errno)});
+		struct stat info{};
+		if (fstat (fd, &info) != 0) {
+			DbError error{"Cannot read " + path + ": " + std::strerror (errno)};
+			close (fd);
+			return std::unexpected (std::move (error));
+		}
+		const size_t size = static_cast<size_t> (info.st_size);
+		const char* data = nullptr;
+		if (size > 0) {
+			void* mapped = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped == MAP_FAILED) {
+				DbError error{"Cannot map " + path + ": " + std::strerror (errno)};
+				close (fd);
+				return std::unexpected (std::move (error));
+			}
+			madvise (mapped, size, MADV_SEQUENTIAL);
+			data = static_cast<const char*> (mapped);
+		}
+		close (fd);
+
+		const char delimiter = options.delimiter;
+		std::unique_ptr<Importer> importer (new Importer (std::move (options), data, size, std::move (notify)));
+		const std::string_view file (data, size);
+
+		// The first record fixes the column count, and names the columns with a header.
+		size_t at = 0;
+		while (at < size && BlankLine (file, at)) at += BlankLine (file, at);
+		if (at < size) {
+			std::string scratch;
+			std::string error;
+			const bool header = importer->m_options.header;
+			std::vector<std::string>& columns = importer->m_columns;
+			const size_t next = ReadRecord (file, at, delimiter, scratch, error, [&] (std::string_view text, bool) {
+				if (header) columns.emplace_back (text);
+				++importer->m_columnCount;
+			});
+			if (next == kNoRecord) return std::unexpected (DbError{path + ": " + error});
+			if (header) at = next;
+		}
+		importer->m_dataStart = at;
+		importer->m_bytes.store (at, std::memory_order_relaxed);
+		importer->m_chunkCount = (size - at + kChunkBytes - 1) / kChunkBytes;
+		importer->m_parity.assign (importer->m_chunkCount, -1);
+		importer->m_startsQuoted.assign (importer->m_chunkCount + 1, 0);
+
+		const size_t count = std::min (ThreadCount (threads), importer->m_chunkCount);
+		importer->m_parsers.reserve (count);
+		for (size_t i = 0; i < count; ++i) {
+			importer->m_parsers.emplace_back ([raw = importer.get ()] (std::stop_token stop) { raw->ParseLoop (stop); });
+		}
+		return importer;
+	}
+
+	Importer::Importer (ImportOptions options, const char* data, size_t size, std::function<void ()> notify)
+		: m_options (std::move (options)), m_data (data), m_size (size), m_notify (std::move (notify)) {}
+
+	Importer::~Importer () {
+		if (!Done ()) Finish ("Cancelled");
+	}
+
+	bool
+	Importer::Next (RowBatch& batch) {
+		std::unique_lock lock (m_mutex);
+		if (m_start == std::chrono::steady_clock::time_point{}) m_start = std::chrono::steady_clock::now ();
+		while (true) {
+			m_readyWake.wait (lock, [this] {
+				return m_failed || m_cancelled.load () || (!m_chunks.empty () && m_chunks.front ()->parsed) ||
+					   (m_chunks.empty () && m_nextChunk >= m_chunkCount);
+			});
+			if (m_failed || m_cancelled.load ()) return false;
+			if (m_chunks.empty ()) {
+				m_atEnd = true;
+				return false;
+			}
+			std::unique_ptr<Chunk> chunk = std::move (m_chunks.front ());
+			m_chunks.pop_front ();
+			m_parseWake.notify_all ();
+			if (!chunk->error.empty ()) {
+				m_failed = true;
+				m_error = std::move (chunk->error);
+				return false;
+			}
+			// A chunk inside one long quoted field has no record of its own.
+			if (chunk->rows.RowCount () == 0) continue;
+
+			if (m_options.maxRowsPerSecond > 0) {
+				const std::chrono::duration<double> due (static_cast<double> (Rows ()) / static_cast<double> (m_options.maxRowsPerSecond));
+				const auto until = m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration> (due);
+				if (m_readyWake.wait_until (lock, until, [this] { return m_cancelled.load (); })) return false;
+			}
+			batch = std::move (chunk->rows);
+			m_rows.fetch_add (batch.RowCount (), std::memory_order_relaxed);
+			m_bytes.fetch_add (chunk->bytes, std::memory_order_relaxed);
+			break;
+		}
+		lock.unlock ();
+		if (m_notify) m_notify ();
+		return true;
+	}
+
+	void
+	Importer::Finish (std::string error) {
+		if (!error.empty ()) {
+			Fail (std::move (error));
+		}
+		else if (m_cancelled.load ()) {
+			Fail ("Cancelled");
+		}
+		m_parsers.clear ();	 // Stops and joins them; nothing reads the mapping after this.
+		m_chunks.clear ();
+		if (m_data) munmap (const_cast<char*> (m_data), m_size);
+		m_data = nullptr;
+
+		m_done.store (true, std::memory_order_release);
+		if (m_notify) m_notify ();
+	}
+
+	void
+	Importer::Cancel () {
+		m_cancelled.store (true);
+		// Under the lock, so a Next () about to wait cannot miss the wakeup.
+		std::lock_guard lock (m_mutex);
+		m_readyWake.notify_all ();
+		m_parseWake.notify_all ();
+	}
+
+	void
+	Importer::Fail (std::string error) {
+		std::lock_guard lock (m_mutex);
+		if (m_failed) return;
+		m_failed = true;
+		m_error = std::move (error);
+		m_readyWake.notify_all ();
+		m_parseWake.notify_all ();
+	}
+
+	void
+	Importer::ParseLoop (std::stop_token stop) {
+		while (true) {
+			Chunk* chunk;
+			{
+				std::unique_lock lock (m_mutex);
+				const bool claim = m_parseWake.wait (lock, stop, [this] {
+					return m_failed || m_cancelled.load () || m_nextChunk >= m_chunkCount || m_chunks.size () < kMaxPending;
+				});
+				if (!claim || stop.stop_requested () || m_failed || m_cancelled.load () || m_nextChunk >= m_chunkCount) return;
+				m_chunks.push_back (std::make_unique<Chunk> ());
+				chunk = m_chunks.back ().get ();
+				chunk->index = m_nextChunk++;
+			}
+
+			const size_t begin = m_dataStart + chunk->index * kChunkBytes;
+			const size_t end = std::min (begin + kChunkBytes, m_size);
+			const bool odd = CountQuotes (m_data + begin, m_data + end) % 2 != 0;
+			bool quoted;
+			{
+				std::unique_lock lock (m_mutex);
+				m_parity [chunk->index] = odd ? 1 : 0;
+				while (m_known < m_chunkCount && m_parity [m_known] >= 0) {
+					m_startsQuoted [m_known + 1] = m_startsQuoted [m_known] ^ static_cast<u8> (m_parity [m_known]);
+					++m_known;
+				}
+				m_parseWake.notify_all ();
+				// Every earlier chunk was claimed first and counts without waiting, so this is brief.
+				if (!m_parseWake.wait (lock, stop, [&] { return m_known >= chunk->index; })) return;
+				quoted = m_startsQuoted [chunk->index] != 0;
+			}
+
+			Parse (*chunk, quoted);
+			{
+				std::lock_guard lock (m_mutex);
+				chunk->parsed = true;
+				m_readyWake.notify_all ();
+			}
+		}
+	}
+
+	void
+	Importer::Parse (Chunk& chunk, bool quoted) const {
+		const std::string_view file (m_data, m_size);
+		const size_t begin = m_dataStart + chunk.index * kChunkBytes;
+		const size_t end = std::min (begin + kChunkBytes, m_size);
+		chunk.bytes = end - begin;
+
+		// The chunk holds the records that start in [begin, end); the last may run past end.
+		size_t at = begin;
+		if (chunk.index > 0 && !(file [begin - 1] == '\n' && !quoted)) {
+			bool inQuotes = quoted;
+			for (; at < end; ++at) {
+				if (file [at] == '"') {
+					inQuotes = !inQuotes;
+				}
+				else if (file [at] == '\n' && !inQuotes) {
+					break;
+				}
+			}
+			at = std::min (at + 1, end);
+		}
+
+		RowBatch& rows = chunk.rows;
+		rows.columnCount = m_columnCount;
+		rows.values.reserve ((end - begin) / 8);
+		std::string scratch;
+		const char delimiter = m_options.delimiter;
+		while (at < end) {
+			if (const size_t blank = BlankLine (file, at)) {
+				at += blank;
+				continue;
+			}
+			size_t fields = 0;
+			const size_t next = ReadRecord (file, at, delimiter, scratch, chunk.error, [&] (std::string_view text, bool wasQuoted) {
+				if (++fields <= m_columnCount) rows.values.push_back (wasQuoted ? Value{std::string (text)} : ToValue (text));
+			});
+			if (next == kNoRecord) {
+				chunk.error = "At byte " + std::to_string (at) + ": " + chunk.error;
+				return;
+			}
+			if (fields > m_columnCount) {
+				chunk.error = "At byte " + std::to_string (at) + ": " + std::to_string (fields) + " fields, expected " + std::to_string (m_columnCount);
+				return;
+			}
+			rows.values.resize (rows.values.size () + m_columnCount - fields);
+			at = next;
+		}
+	}
+
+}  // namespace ambidb::db
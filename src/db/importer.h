@@ -0,0 +1,178 @@
+#pragma once
+
+#include "driver.h"
+
+#include <macro.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ambidb::db {
+
+	struct ImportOptions {
+		std::string table;	 ///< Target table, spliced into the INSERT as written.
+		bool header{true};	 ///< The first record names the columns.
+		char delimiter{','};
+		u64 maxRowsPerSecond{0};  ///< Throttle; 0 hands rows over as fast as they are taken.
+	};
+
+	/**
+	 * @brief Parses a CSV file into RowBatches on a pool of threads, for a bulk load.
+	 *
+	 * The file is memory-mapped and cut into kChunkBytes pieces. A worker claims the next
+	 * piece, counts its quotes (16 bytes at a time) and, once the parity of every earlier
+	 * piece is known, knows whether the piece starts inside a quoted field, so it can find
+	 * the first record starting in it without reading anything before. Pieces are parsed
+	 * in parallel and handed out by Next () in file order; at most kMaxPending are parsed
+	 * ahead, so memory stays bounded however large the file is.
+	 *
+	 * Fields follow RFC 4180; CRLF line ends and blank lines are accepted. An empty
+	 * unquoted field is NULL, unquoted integers and reals become numbers (except ones with
+	 * leading zeros, such as codes) and everything else, quoted fields included, is text.
+	 *
+	 * The loader (QueryExecutor::Import) calls Next () and Finish () from one thread.
+	 */
+	class Importer {
+	public:
+		static constexpr size_t kChunkBytes = size_t{1} << 20;
+		static constexpr size_t kMaxPending = 16;
+		/// Rows the loader inserts per transaction.
+		static constexpr u64 kTransactionRows = 1'000'000;
+
+		MAKE_NONCOPYABLE (Importer);
+		MAKE_NONMOVABLE (Importer);
+		/// Cancels an unfinished import and joins the threads.
+		~Importer ();
+
+		/**
+		 * @brief Map @p path and read its header. @p notify is called from the loader each
+		 * time it takes a batch, and once the import is done.
+		 * @param threads Parsing threads; 0 picks one per core.
+		 */
+		static DbResult<std::unique_ptr<Importer>>
+		Create (const std::string& path, ImportOptions options, std::function<void ()> notify = {}, size_t threads = 0);
+
+		const ImportOptions&
+		Options () const {
+			return m_options;
+		}
+
+		/// Column names from the header; empty without one.
+		const std::vector<std::string>&
+		Columns () const {
+			return m_columns;
+		}
+
+		/// Fields per record: the header's, or the first record's.
+		size_t
+		ColumnCount () const {
+			return m_columnCount;
+		}
+
+		/**
+		 * @brief Replace @p batch with the next parsed rows, waiting for them and for the
+		 * throttle. False at the end of the file, on malformed input or once cancelled.
+		 */
+		bool
+		Next (RowBatch& batch);
+
+		/// Loader: Next () returned false because every row was handed over.
+		bool
+		AtEnd () const {
+			return m_atEnd;
+		}
+
+		/// Stop parsing and unmap the file; with @p error, fail with it unless already failed.
+		void
+		Finish (std::string error = {});
+
+		/// Any thread: make Next () return false; Finish () then reports "Cancelled".
+		void
+		Cancel ();
+
+		/// Finish () has returned; Error () is valid from then on.
+		bool
+		Done () const {
+			return m_done.load (std::memory_order_acquire);
+		}
+
+		/// Empty if every row was handed over.
+		const std::string&
+		Error () const {
+			return m_error;
+		}
+
+		/// Rows handed to the loader so far.
+		u64
+		Rows () const {
+			return m_rows.load (std::memory_order_relaxed);
+		}
+
+		/// Input bytes behind Rows ().
+		u64
+		Bytes () const {
+			return m_bytes.load (std::memory_order_relaxed);
+		}
+
+		u64
+		TotalBytes () const {
+			return m_size;
+		}
+
+	private:
+		struct Chunk {
+			size_t index{0};
+			bool parsed{false};
+			RowBatch rows;
+			std::string error;
+			u64 bytes{0};  ///< Input consumed by rows.
+		};
+
+		Importer (ImportOptions options, const char* data, size_t size, std::function<void ()> notify);
+
+		void
+		ParseLoop (std::stop_token stop);
+		void
+		Parse (Chunk& chunk, bool quoted) const;
+		void
+		Fail (std::string error);
+
+		ImportOptions m_options;
+		const char* m_data;
+		size_t m_size;
+		size_t m_dataStart{0};	///< After the header.
+		size_t m_chunkCount{0};
+		std::function<void ()> m_notify;
+		std::vector<std::string> m_columns;
+		size_t m_columnCount{0};
+		std::chrono::steady_clock::time_point m_start;  ///< First Next (); the throttle counts from here.
+		bool m_atEnd{false};
+
+		std::mutex m_mutex;
+		std::condition_variable_any m_parseWake;   ///< Room for another chunk, or a parity is known.
+		std::condition_variable_any m_readyWake;   ///< The front chunk may be parsed.
+		std::deque<std::unique_ptr<Chunk>> m_chunks;  ///< Claimed, in file order.
+		size_t m_nextChunk{0};
+		std::vector<i8> m_parity;		   ///< Per chunk: quote count parity, -1 until counted.
+		std::vector<u8> m_startsQuoted;	   ///< Per chunk: begins inside quotes; valid below m_known + 1.
+		size_t m_known{0};				   ///< Chunks whose parity, and all before, are counted.
+		bool m_failed{false};
+		std::string m_error;
+
+		std::atomic<bool> m_cancelled{false};
+		std::atomic<bool> m_done{false};
+		std::atomic<u64> m_rows{0};
+		std::atomic<u64> m_bytes{0};
+
+		std::vector<std::jthread> m_parsers;  ///< Last member: they stop before the rest goes.
+	};
+
+}  // namespace ambidb::db
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <macro.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ambidb::db {
+
+	/// @p threads, or one per core when 0.
+	inline size_t
+	ThreadCount (size_t threads) {
+		return threads ? threads : std::max (1u, std::thread::hardware_concurrency ());
+	}
+
+	/**
+	 * @brief Call body (t) for t in [0, threads): on threads - 1 new threads plus the calling
+	 * one, returning when all are done.
+	 */
+	template <typename F>
+	void
+	ParallelFor (size_t threads, F&& body) {
+		if (threads <= 1) {
+			body (size_t{0});
+			return;
+		}
+		std::vector<std::jthread> workers;
+		workers.reserve (threads - 1);
+		for (size_t t = 1; t < threads; ++t) {
+			workers.emplace_back ([&body, t] { body (t); });
+		}
+		body (size_t{0});
+	}
+
+	struct Segment {
+		size_t begin;
+		size_t end;
+	};
+
+	/// Part @p t of [0, count) split evenly into @p parts.
+	inline Segment
+	SegmentOf (size_t count, size_t parts, size_t t) {
+		return {count * t / parts, count * (t + 1) / parts};
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,698 @@
+#include "query_executor.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace ambidb::db {
+
+	namespace {
+
+		constexpr const char* kNotConnected = "Not connected";
+
+		/// Cell @p row, @p column of @p rows as the Value a driver would have returned.
+		Value
+		CellValue (const ResultSet& rows, size_t row, size_t column) {
+			if (rows.IsNull (row, column)) return std::monostate{};
+			switch (rows.Type (column)) {
+				case ColumnType::Null: return std::monostate{};
+				case ColumnType::Integer: return rows.Integer (row, column);
+				case ColumnType::Real: return rows.Real (row, column);
+				case ColumnType::Text: return std::string (rows.Text (row, column));
+				case ColumnType::Blob: {
+					const std::string_view bytes = rows.Text (row, column);
+					const auto* data = reinterpret_cast<const u8*> (bytes.data ());
+					return Blob{std::vector<u8> (data, data + bytes.size ())};
+				}
+			}
+			UNREACHABLE ();
+		}
+
+	}  // namespace
+
+	QueryExecutor::QueryExecutor (size_t workers, std::function<void ()> notify) : m_notify (std::move (notify)) {
+		if (workers == 0) {
+			workers = std::clamp<size_t> (std::thread::hardware_concurrency (), 1, 4);
+		}
+		m_workers.reserve (workers);
+		for (size_t i = 0; i < workers; ++i) {
+			m_workers.emplace_back ([this] { WorkerLoop (); });
+		}
+	}
+
+	QueryExecutor::~QueryExecutor () {
+		{
+			std::lock_guard lock (m_mutex);
+			m_stopping = true;
+			for (auto& [id, query] : m_queries) {
+				query->cancelled.store (true, std::memory_order_relaxed);
+			}
+			for (auto& [id, state] : m_connections) {
+				if (state->running != 0 && state->connection) {
+					state->connection->Interrupt ();
+				}
+			}
+		}
+		m_wake.notify_all ();
+		for (std::thread& worker : m_workers) {
+			worker.join ();
+		}
+	}
+
+	ConnectionId
+	QueryExecutor::Open (ConnectionParams params) {
+		ConnectionId id;
+		{
+			std::lock_guard lock (m_mutex);
+			id = m_nextConnection++;
+			auto state = std::make_shared<ConnectionState> ();
+			state->id = id;
+			m_connections.emplace (id, std::move (state));
+		}
+
+		(void) Submit (id, [this, params = std::move (params)] (ConnectionState& state) {
+			DbEvent event;
+			event.connection = state.id;
+			Driver* driver = FindDriver (params.driver);
+			if (!driver) {
+				event.kind = DbEvent::Kind::ConnectFailed;
+				event.error = "No driver for '" + params.driver + "' in this build";
+			}
+			else if (DbResult<std::unique_ptr<Connection>> connection = driver->Connect (params)) {
+				state.connection = std::move (*connection);
+				event.kind = DbEvent::Kind::Connected;
+			}
+			else {
+				event.kind = DbEvent::Kind::ConnectFailed;
+				event.error = std::move (connection.error ().message);
+			}
+			Push (std::move (event));
+		});
+		return id;
+	}
+
+	QueryId
+	QueryExecutor::Execute (ConnectionId connection, std::string sql) {
+		const QueryId id = NewQuery (connection);
+		if (!Submit (connection, [this, id, sql = std::move (sql)] (ConnectionState& state) {
+				RunQuery (state, id, sql, 0);
+			})) {
+			Reject (connection, id);
+		}
+		return id;
+	}
+
+	QueryId
+	QueryExecutor::ExecuteWindowed (ConnectionId connection, std::string sql, size_t firstRows) {
+		const QueryId id = NewQuery (connection);
+		if (!Submit (connection, [this, id, sql = std::move (sql), firstRows] (ConnectionState& state) {
+				RunQuery (state, id, sql, std::max<size_t> (firstRows, 1));
+			})) {
+			Reject (connection, id);
+		}
+		return id;
+	}
+
+	QueryId
+	QueryExecutor::Export (ConnectionId connection, std::string sql, std::shared_ptr<Exporter> exporter) {
+		const QueryId id = NewQuery (connection);
+		if (!Submit (connection, [this, id, sql = std::move (sql), exporter] (ConnectionState& state) {
+				RunExport (state, id, sql, *exporter);
+			})) {
+			// Nothing was written yet, so finishing only closes the file.
+			exporter->Finish (kNotConnected);
+			Reject (connection, id);
+		}
+		return id;
+	}
+
+	QueryId
+	QueryExecutor::Import (ConnectionId connection, std::shared_ptr<Importer> importer) {
+		const QueryId id = NewQuery (connection);
+		if (!Submit (connection, [this, id, importer] (ConnectionState& state) {
+				RunImport (state, id, *importer);
+			})) {
+			// Cancelling first lets the read-ahead parsers stop at once instead of finishing a chunk.
+			importer->Cancel ();
+			importer->Finish (kNotConnected);
+			Reject (connection, id);
+		}
+		return id;
+	}
+
+	QueryId
+	QueryExecutor::LoadCatalog (ConnectionId connection, std::shared_ptr<SchemaCache> cache, CatalogPath path) {
+		const QueryId id = NewQuery (connection);
+		if (!Submit (connection, [this, id, cache, path = std::move (path)] (ConnectionState& state) {
+				RunCatalog (state, id, *cache, path);
+			})) {
+			cache->Fail (kNotConnected);
+			Reject (connection, id);
+		}
+		return id;
+	}
+
+	QueryId
+	QueryExecutor::RefreshCatalog (ConnectionId connection, std::shared_ptr<SchemaCache> cache) {
+		cache->Queued ();
+		const QueryId id = NewQuery (connection);
+		if (!Submit (connection, [this, id, cache] (ConnectionState& state) {
+				RunCatalog (state, id, *cache, std::nullopt);
+			})) {
+			cache->Fail (kNotConnected);
+			Reject (connection, id);
+		}
+		return id;
+	}
+
+	void
+	QueryExecutor::FetchRows (QueryId query, size_t firstRow, size_t count) {
+		ConnectionId connection;
+		{
+			std::lock_guard lock (m_mutex);
+			const auto it = m_queries.find (query);
+			if (it == m_queries.end ()) return;
+			connection = it->second->connection;
+		}
+		if (!Submit (connection, [this, query, firstRow, count] (ConnectionState& state) {
+				FetchPage (state, query, firstRow, count);
+			})) {
+			DbEvent page;
+			page.kind = DbEvent::Kind::QueryPage;
+			page.connection = connection;
+			page.query = query;
+			page.firstRow = firstRow;
+			page.error = "Query is closed";
+			Push (std::move (page));
+		}
+	}
+
+	void
+	QueryExecutor::Release (QueryId query) {
+		ConnectionId connection;
+		{
+			std::lock_guard lock (m_mutex);
+			const auto it = m_queries.find (query);
+			if (it == m_queries.end ()) return;
+			connection = it->second->connection;
+		}
+		if (!Submit (connection, [this, query] (ConnectionState& state) {
+				state.windows.erase (query);
+				std::lock_guard lock (m_mutex);
+				m_queries.erase (query);
+			})) {
+			std::lock_guard lock (m_mutex);
+			m_queries.erase (query);
+		}
+	}
+
+	void
+	QueryExecutor::Cancel (QueryId query) {
+		std::lock_guard lock (m_mutex);
+		const auto it = m_queries.find (query);
+		if (it == m_queries.end ()) return;
+		it->second->cancelled.store (true, std::memory_order_relaxed);
+
+		const auto conn = m_connections.find (it->second->connection);
+		// While running == query the worker does not touch state->connection itself.
+		if (conn != m_connections.end () && conn->second->running == query && conn->second->connection) {
+			conn->second->connection->Interrupt ();
+		}
+	}
+
+	void
+	QueryExecutor::Close (ConnectionId connection) {
+		const bool queued = Submit (connection, [this] (ConnectionState& state) {
+			{
+				std::lock_guard lock (m_mutex);
+				for (const auto& [id, window] : state.windows) {
+					m_queries.erase (id);
+				}
+			}
+			state.windows.clear ();
+			state.connection.reset ();
+			{
+				std::lock_guard lock (m_mutex);
+				m_connections.erase (state.id);
+			}
+			DbEvent event;
+			event.kind = DbEvent::Kind::Closed;
+			event.connection = state.id;
+			Push (std::move (event));
+		});
+		if (!queued) {
+			DbEvent event;
+			event.kind = DbEvent::Kind::Closed;
+			event.connection = connection;
+			Push (std::move (event));
+		}
+	}
+
+	void
+	QueryExecutor::DrainEvents (std::vector<DbEvent>& out) {
+		std::lock_guard lock (m_eventMutex);
+		if (m_events.empty ()) return;
+		if (out.empty ()) {
+			out.swap (m_events);
+			return;
+		}
+		std::move (m_events.begin (), m_events.end (), std::back_inserter (out));
+		m_events.clear ();
+	}
+
+	QueryId
+	QueryExecutor::NewQuery (ConnectionId connection) {
+		std::lock_guard lock (m_mutex);
+		const QueryId id = m_nextQuery++;
+		auto query = std::make_shared<QueryState> ();
+		query->connection = connection;
+		m_queries.emplace (id, std::move (query));
+		return id;
+	}
+
+	bool
+	QueryExecutor::Submit (ConnectionId connection, std::function<void (ConnectionState&)> job) {
+		std::lock_guard lock (m_mutex);
+		const auto it = m_connections.find (connection);
+		if (it == m_connections.end ()) return false;
+
+		ConnectionState& state = *it->second;
+		state.jobs.push_back (std::move (job));
+		if (!state.scheduled) {
+			state.scheduled = true;
+			m_ready.push_back (it->second);
+			m_wake.notify_one ();
+		}
+		return true;
+	}
+
+	void
+	QueryExecutor::Reject (ConnectionId connection, QueryId id) {
+		{
+			std::lock_guard lock (m_mutex);
+			m_queries.erase (id);
+		}
+		DbEvent finished;
+		finished.kind = DbEvent::Kind::QueryFinished;
+		finished.connection = connection;
+		finished.query = id;
+		finished.status = QueryStatus::Failed;
+		finished.error = kNotConnected;
+		Push (std::move (finished));
+	}
+
+	void
+	QueryExecutor::WorkerLoop () {
+		while (true) {
+			std::shared_ptr<ConnectionState> state;
+			std::function<void (ConnectionState&)> job;
+			{
+				std::unique_lock lock (m_mutex);
+				m_wake.wait (lock, [this] { return m_stopping || !m_ready.empty (); });
+				if (m_ready.empty ()) return;  // Stopping and drained.
+				state = std::move (m_ready.front ());
+				m_ready.pop_front ();
+				job = std::move (state->jobs.front ());
+				state->jobs.pop_front ();
+			}
+
+			job (*state);
+
+			std::lock_guard lock (m_mutex);
+			if (state->jobs.empty ()) {
+				state->scheduled = false;
+			}
+			else {
+				// Back of the line so one busy connection cannot starve the others.
+				m_ready.push_back (std::move (state));
+				m_wake.notify_one ();
+			}
+		}
+	}
+
+	std::shared_ptr<QueryExecutor::QueryState>
+	QueryExecutor::BeginJob (ConnectionState& state, QueryId id) {
+		std::lock_guard lock (m_mutex);
+		state.running = id;
+		const auto it = m_queries.find (id);
+		return it != m_queries.end () ? it->second : nullptr;
+	}
+
+	void
+	QueryExecutor::EndJob (ConnectionState& state) {
+		std::lock_guard lock (m_mutex);
+		state.running = 0;
+	}
+
+	void
+	QueryExecutor::RunQuery (ConnectionState& state, QueryId id, const std::string& sql, size_t windowRows) {
+		const auto start = std::chrono::steady_clock::now ();
+		const std::shared_ptr<QueryState> query = BeginJob (state, id);
+
+		DbEvent finished;
+		finished.kind = DbEvent::Kind::QueryFinished;
+		finished.connection = state.id;
+		finished.query = id;
+
+		const auto cancelled = [&] {
+			return query && query->cancelled.load (std::memory_order_relaxed);
+		};
+		const auto fail = [&] (std::string message) {
+			finished.status = cancelled () ? QueryStatus::Cancelled : QueryStatus::Failed;
+			if (finished.status == QueryStatus::Failed) finished.error = std::move (message);
+		};
+
+		bool keepCursor = false;
+		if (cancelled ()) {
+			finished.status = QueryStatus::Cancelled;
+		}
+		else if (!state.connection) {
+			fail (kNotConnected);
+		}
+		else if (DbResult<std::unique_ptr<Cursor>> cursor = state.connection->Execute (sql); !cursor) {
+			fail (std::move (cursor.error ().message));
+		}
+		else {
+			DbEvent columns;
+			columns.kind = DbEvent::Kind::QueryColumns;
+			columns.connection = state.id;
+			columns.query = id;
+			columns.columns = (*cursor)->Columns ();
+			const size_t columnCount = columns.columns.size ();
+			// Paging re-reads nothing, but a statement that writes must not stay open either.
+			if (!(*cursor)->ReadOnly ()) windowRows = 0;
+			columns.windowed = windowRows > 0;
+			Push (std::move (columns));
+
+			if (windowRows > 0) {
+				DbEvent page;
+				page.kind = DbEvent::Kind::QueryPage;
+				page.connection = state.id;
+				page.query = id;
+				page.rows.values.reserve (windowRows * columnCount);
+				if (const DbResult<bool> more = (*cursor)->FetchBatch (page.rows, windowRows); !more) {
+					fail (more.error ().message);
+				}
+				else {
+					page.endOfData = !*more;
+					keepCursor = *more;
+					if (keepCursor) {
+						Window& window = state.windows [id];
+						window.rows.Reset ((*cursor)->Columns ());
+						window.rows.Append (page.rows);
+					}
+					Push (std::move (page));
+				}
+			}
+			else {
+				while (true) {
+					if (cancelled ()) {
+						finished.status = QueryStatus::Cancelled;
+						break;
+					}
+					DbEvent rows;
+					rows.kind = DbEvent::Kind::QueryRows;
+					rows.connection = state.id;
+					rows.query = id;
+					rows.rows.values.reserve (kBatchRows * columnCount);
+					const DbResult<bool> more = (*cursor)->FetchBatch (rows.rows, kBatchRows);
+					if (!more) {
+						fail (more.error ().message);
+						break;
+					}
+					if (rows.rows.RowCount () > 0) {
+						Push (std::move (rows));
+					}
+					if (!*more) break;
+				}
+			}
+			finished.rowsAffected = (*cursor)->RowsAffected ();
+			if (keepCursor) {
+				state.windows [id].cursor = std::move (*cursor);
+			}
+		}
+
+		EndJob (state);
+		if (!keepCursor) {
+			std::lock_guard lock (m_mutex);
+			m_queries.erase (id);
+		}
+		finished.elapsed = std::chrono::steady_clock::now () - start;
+		Push (std::move (finished));
+	}
+
+	void
+	QueryExecutor::RunExport (ConnectionState& state, QueryId id, const std::string& sql, Exporter& exporter) {
+		const auto start = std::chrono::steady_clock::now ();
+		const std::shared_ptr<QueryState> query = BeginJob (state, id);
+
+		DbEvent finished;
+		finished.kind = DbEvent::Kind::QueryFinished;
+		finished.connection = state.id;
+		finished.query = id;
+
+		const auto cancelled = [&] {
+			return query && query->cancelled.load (std::memory_order_relaxed);
+		};
+
+		std::string error;
+		if (cancelled ()) {
+			error = "Cancelled";
+		}
+		else if (!state.connection) {
+			error = kNotConnected;
+		}
+		else if (DbResult<std::unique_ptr<Cursor>> cursor = state.connection->Execute (sql); !cursor) {
+			error = std::move (cursor.error ().message);
+		}
+		else {
+			exporter.Begin ((*cursor)->Columns ());
+			const size_t columnCount = (*cursor)->Columns ().size ();
+			while (true) {
+				if (cancelled ()) {
+					error = "Cancelled";
+					break;
+				}
+				RowBatch batch;
+				batch.values.reserve (Exporter::kBatchRows * columnCount);
+				const DbResult<bool> more = (*cursor)->FetchBatch (batch, Exporter::kBatchRows);
+				if (!more) {
+					error = cancelled () ? "Cancelled" : std::move (more.error ().message);
+					break;
+				}
+				// False once the file failed or the export was cancelled; Finish () says which.
+				if (batch.RowCount () > 0 && !exporter.Write (std::move (batch))) break;
+				if (!*more) break;
+			}
+			finished.rowsAffected = (*cursor)->RowsAffected ();
+		}
+
+		EndJob (state);
+		{
+			std::lock_guard lock (m_mutex);
+			m_queries.erase (id);
+		}
+		exporter.Finish (error);
+		if (!exporter.Error ().empty ()) {
+			finished.status = cancelled () ? QueryStatus::Cancelled : QueryStatus::Failed;
+			if (finished.status == QueryStatus::Failed) finished.error = exporter.Error ();
+		}
+		finished.elapsed = std::chrono::steady_clock::now () - start;
+		Push (std::move (finished));
+	}
+
+	void
+	QueryExecutor::RunImport (ConnectionState& state, QueryId id, Importer& importer) {
+		const auto start = std::chrono::steady_clock::now ();
+		const std::shared_ptr<QueryState> query = BeginJob (state, id);
+
+		DbEvent finished;
+		finished.kind = DbEvent::Kind::QueryFinished;
+		finished.connection = state.id;
+		finished.query = id;
+
+		const auto cancelled = [&] {
+			return query && query->cancelled.load (std::memory_order_relaxed);
+		};
+
+		std::string error;
+		if (cancelled ()) {
+			error = "Cancelled";
+		}
+		else if (!state.connection) {
+			error = kNotConnected;
+		}
+		else if (DbResult<i64> begun = RunStatement (*state.connection, "BEGIN"); !begun) {
+			error = std::move (begun.error ().message);
+		}
+		else {
+			Connection& connection = *state.connection;
+			const std::string& table = importer.Options ().table;
+			u64 pending = 0;  // Rows in the open transaction.
+			RowBatch batch;
+			while (true) {
+				if (cancelled ()) {
+					error = "Cancelled";
+					break;
+				}
+				// False at the end, or once the input failed or was cancelled; Finish () says which.
+				if (!importer.Next (batch)) break;
+				if (DbResult<void> inserted = connection.InsertRows (table, importer.Columns (), batch); !inserted) {
+					error = cancelled () ? "Cancelled" : std::move (inserted.error ().message);
+					break;
+				}
+				pending += batch.RowCount ();
+				if (pending >= Importer::kTransactionRows) {
+					if (DbResult<i64> committed = RunStatement (connection, "COMMIT; BEGIN"); !committed) {
+						error = std::move (committed.error ().message);
+						break;
+					}
+					finished.rowsAffected += static_cast<i64> (pending);
+					pending = 0;
+				}
+			}
+			if (error.empty () && importer.AtEnd ()) {
+				if (DbResult<i64> committed = RunStatement (connection, "COMMIT"); !committed) {
+					error = std::move (committed.error ().message);
+				}
+				else {
+					finished.rowsAffected += static_cast<i64> (pending);
+				}
+			}
+			if (!error.empty () || !importer.AtEnd ()) {
+				(void) RunStatement (connection, "ROLLBACK");
+			}
+		}
+
+		EndJob (state);
+		{
+			std::lock_guard lock (m_mutex);
+			m_queries.erase (id);
+		}
+		importer.Finish (error);
+		if (!importer.Error ().empty ()) {
+			finished.status = cancelled () ? QueryStatus::Cancelled : QueryStatus::Failed;
+			if (finished.status == QueryStatus::Failed) finished.error = importer.Error ();
+		}
+		finished.elapsed = std::chrono::steady_clock::now () - start;
+		Push (std::move (finished));
+	}
+
+	void
+	QueryExecutor::RunCatalog (ConnectionState& state, QueryId id, SchemaCache& cache, const std::optional<CatalogPath>& path) {
+		const auto start = std::chrono::steady_clock::now ();
+		const std::shared_ptr<QueryState> query = BeginJob (state, id);
+
+		DbEvent finished;
+		finished.kind = DbEvent::Kind::QueryFinished;
+		finished.connection = state.id;
+		finished.query = id;
+
+		const auto cancelled = [&] {
+			return query && query->cancelled.load (std::memory_order_relaxed);
+		};
+
+		std::string error;
+		if (cancelled ()) {
+			error = "Cancelled";
+			cache.Fail (error);
+		}
+		else if (!state.connection) {
+			error = kNotConnected;
+			cache.Fail (error);
+		}
+		else {
+			const DbResult<void> done = path ? cache.Load (*state.connection, *path) : cache.Refresh (*state.connection, cancelled);
+			if (!done) error = done.error ().message;
+		}
+
+		EndJob (state);
+		{
+			std::lock_guard lock (m_mutex);
+			m_queries.erase (id);
+		}
+		if (!error.empty ()) {
+			finished.status = cancelled () ? QueryStatus::Cancelled : QueryStatus::Failed;
+			if (finished.status == QueryStatus::Failed) finished.error = std::move (error);
+		}
+		finished.elapsed = std::chrono::steady_clock::now () - start;
+		Push (std::move (finished));
+	}
+
+	void
+	QueryExecutor::FetchPage (ConnectionState& state, QueryId id, size_t firstRow, size_t count) {
+		const std::shared_ptr<QueryState> query = BeginJob (state, id);
+
+		DbEvent page;
+		page.kind = DbEvent::Kind::QueryPage;
+		page.connection = state.id;
+		page.query = id;
+		page.firstRow = firstRow;
+
+		const auto it = state.windows.find (id);
+		const auto cancelled = [&] {
+			return query && query->cancelled.load (std::memory_order_relaxed);
+		};
+		if (it == state.windows.end ()) {
+			page.error = "Query is closed";
+		}
+		else if (cancelled ()) {
+			page.error = "Cancelled";
+		}
+		else {
+			Window& window = it->second;
+			const size_t columnCount = window.rows.ColumnCount ();
+			const size_t end = firstRow + count;
+			// Read on until the stored rows cover the page; each row is stepped over once.
+			while (window.cursor && window.rows.RowCount () < end) {
+				if (cancelled ()) {
+					page.error = "Cancelled";
+					break;
+				}
+				RowBatch batch;
+				const size_t want = std::min (end - window.rows.RowCount (), kBatchRows);
+				batch.values.reserve (want * columnCount);
+				const DbResult<bool> more = window.cursor->FetchBatch (batch, want);
+				if (!more) {
+					page.error = cancelled () ? "Cancelled" : more.error ().message;
+					break;
+				}
+				window.rows.Append (batch);
+				if (!*more) {
+					// Every row is stored: finish the statement and end its read transaction.
+					window.cursor.reset ();
+				}
+			}
+
+			page.rows.columnCount = columnCount;
+			const size_t stored = window.rows.RowCount ();
+			if (page.error.empty () && firstRow >= stored) {
+				// The result ends before firstRow; an empty page there carries the row count.
+				page.firstRow = stored;
+				page.endOfData = true;
+			}
+			else if (page.error.empty ()) {
+				const size_t last = std::min (end, stored);
+				page.rows.values.reserve ((last - firstRow) * columnCount);
+				for (size_t row = firstRow; row < last; ++row) {
+					for (size_t column = 0; column < columnCount; ++column) {
+						page.rows.values.push_back (CellValue (window.rows, row, column));
+					}
+				}
+				page.endOfData = !window.cursor && last == stored;
+			}
+		}
+
+		EndJob (state);
+		Push (std::move (page));
+	}
+
+	void
+	QueryExecutor::Push (DbEvent event) {
+		{
+			std::lock_guard lock (m_eventMutex);
+			m_events.push_back (std::move (event));
+		}
+		if (m_notify) m_notify ();
+	}
+
+}  // namespace ambidb::db
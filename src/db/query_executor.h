@@ -0,0 +1,235 @@
+#pragma once
+
+#include "driver.h"
+#include "exporter.h"
+#include "importer.h"
+#include "result_set.h"
+#include "schema_cache.h"
+
+#include <macro.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ambidb::db {
+
+	using ConnectionId = u32;
+	using QueryId = u64;
+
+	enum class QueryStatus {
+		Ok,
+		Failed,
+		Cancelled,
+	};
+
+	/**
+	 * @brief Something that happened on a worker, delivered to the UI thread in order.
+	 */
+	struct DbEvent {
+		enum class Kind {
+			Connected,
+			ConnectFailed,
+			Closed,
+			QueryColumns,	 ///< columns and windowed are set; sent once before any rows.
+			QueryRows,		 ///< rows holds the next batch.
+			QueryPage,		 ///< Windowed: rows from firstRow on, or error.
+			QueryFinished,	 ///< status, rowsAffected, elapsed and error are set.
+		};
+
+		Kind kind{Kind::Connected};
+		ConnectionId connection{0};
+		QueryId query{0};
+		std::vector<ColumnInfo> columns;
+		bool windowed{false};  ///< QueryColumns: rows follow as QueryPage events, not QueryRows.
+		RowBatch rows;
+		size_t firstRow{0};
+		bool endOfData{false};	///< QueryPage: the result has exactly firstRow + rows.RowCount () rows.
+		QueryStatus status{QueryStatus::Ok};
+		i64 rowsAffected{0};
+		std::chrono::steady_clock::duration elapsed{};
+		std::string error;
+	};
+
+	/**
+	 * @brief Runs all database I/O on a pool of worker threads.
+	 *
+	 * Every call returns immediately. Jobs for one connection run in submission order
+	 * (drivers are not thread-safe per connection), jobs for different connections run
+	 * in parallel. Results stream back as DbEvents: rows arrive in batches of
+	 * kBatchRows while the query is still running, so the UI can show them at once.
+	 * The notify callback fires whenever events become available; the App wires it to
+	 * FrameScheduler::RequestRedraw() and drains with DrainEvents() once per frame.
+	 */
+	class QueryExecutor {
+	public:
+		static constexpr size_t kBatchRows = 512;
+
+		MAKE_NONCOPYABLE (QueryExecutor);
+		MAKE_NONMOVABLE (QueryExecutor);
+		/// @param workers 0 picks min(4, hardware threads).
+		explicit QueryExecutor (size_t workers = 0, std::function<void ()> notify = {});
+		/// Cancels running queries, closes all connections and joins the workers.
+		~QueryExecutor ();
+
+		ConnectionId
+		Open (ConnectionParams params);
+
+		/**
+		 * @brief Run @p sql and stream every row back as QueryRows events.
+		 */
+		QueryId
+		Execute (ConnectionId connection, std::string sql);
+
+		/**
+		 * @brief Run @p sql but only fetch its first @p firstRows rows (one QueryPage); the
+		 * cursor then stays open for FetchRows() until Release(). QueryFinished follows the
+		 * first page, so its elapsed time is the time to the first screen.
+		 *
+		 * Only read-only statements are windowed. Anything else (e.g. DELETE ... RETURNING)
+		 * is read to the end like Execute (), and its QueryColumns event says so, so paging
+		 * can never run a change twice or hold the statement open.
+		 */
+		QueryId
+		ExecuteWindowed (ConnectionId connection, std::string sql, size_t firstRows);
+
+		/**
+		 * @brief Run @p sql and stream its rows straight into @p exporter, in batches of
+		 * Exporter::kBatchRows, instead of sending QueryColumns and QueryRows events. The job
+		 * always ends with Exporter::Finish (), which carries any error; QueryFinished
+		 * follows as for Execute (). Cancel () stops the export.
+		 */
+		QueryId
+		Export (ConnectionId connection, std::string sql, std::shared_ptr<Exporter> exporter);
+
+		/**
+		 * @brief Insert every row @p importer parses into its table, through
+		 * Connection::InsertRows () in transactions of Importer::kTransactionRows. On failure
+		 * or Cancel () the open transaction is rolled back; earlier ones stay committed. The
+		 * job ends with Importer::Finish (), then QueryFinished with the rows committed in
+		 * rowsAffected.
+		 */
+		QueryId
+		Import (ConnectionId connection, std::shared_ptr<Importer> importer);
+
+		/**
+		 * @brief Fetch the catalog level @p path into @p cache (SchemaCache::Load ()), after
+		 * SchemaCache::Toggle () asked for it. QueryFinished follows.
+		 */
+		QueryId
+		LoadCatalog (ConnectionId connection, std::shared_ptr<SchemaCache> cache, CatalogPath path);
+
+		/**
+		 * @brief Bring @p cache up to date with the database, refetching only the levels
+		 * whose change markers moved (SchemaCache::Refresh ()). QueryFinished follows.
+		 */
+		QueryId
+		RefreshCatalog (ConnectionId connection, std::shared_ptr<SchemaCache> cache);
+
+		/**
+		 * @brief Windowed queries: fetch @p count rows from @p firstRow as one QueryPage.
+		 *
+		 * Every row read is kept in a ResultSet (spilled to disk past the memory budget), so
+		 * the statement only ever moves forward and pages behind it are served from there.
+		 */
+		void
+		FetchRows (QueryId query, size_t firstRow, size_t count);
+
+		/**
+		 * @brief Windowed queries: close the cursor. Other queries need no release.
+		 */
+		void
+		Release (QueryId query);
+
+		/**
+		 * @brief Stop a queued or running query. Its QueryFinished event reports Cancelled
+		 * (or Ok/Failed if it completed first).
+		 */
+		void
+		Cancel (QueryId query);
+
+		void
+		Close (ConnectionId connection);
+
+		/**
+		 * @brief UI thread: append all pending events to @p out.
+		 */
+		void
+		DrainEvents (std::vector<DbEvent>& out);
+
+	private:
+		struct QueryState {
+			ConnectionId connection{0};
+			std::atomic<bool> cancelled{false};
+		};
+
+		/// An open windowed query.
+		struct Window {
+			std::unique_ptr<Cursor> cursor;	 ///< Null once every row has been read.
+			ResultSet rows;					 ///< Every row read so far, from row 0.
+		};
+
+		struct ConnectionState {
+			ConnectionId id{0};
+			std::unique_ptr<Connection> connection;	 ///< Touched by the job running for it only.
+			std::unordered_map<QueryId, Window> windows;  ///< Open windowed queries; same.
+			std::deque<std::function<void (ConnectionState&)>> jobs;
+			bool scheduled = false;	 ///< Queued in m_ready or being run by a worker.
+			QueryId running = 0;	 ///< Guarded by m_mutex; lets Cancel() interrupt.
+		};
+
+		QueryId
+		NewQuery (ConnectionId connection);
+		/// Queue @p job behind the connection's earlier jobs; false if the connection is
+		/// closed or unknown, in which case the job is dropped and the caller reports it.
+		[[nodiscard]] bool
+		Submit (ConnectionId connection, std::function<void (ConnectionState&)> job);
+		/// Finish query @p id as Failed ("Not connected") without running anything.
+		void
+		Reject (ConnectionId connection, QueryId id);
+		void
+		WorkerLoop ();
+		void
+		RunQuery (ConnectionState& state, QueryId id, const std::string& sql, size_t windowRows);
+		void
+		RunExport (ConnectionState& state, QueryId id, const std::string& sql, Exporter& exporter);
+		void
+		RunImport (ConnectionState& state, QueryId id, Importer& importer);
+		void
+		RunCatalog (ConnectionState& state, QueryId id, SchemaCache& cache, const std::optional<CatalogPath>& path);
+		void
+		FetchPage (ConnectionState& state, QueryId id, size_t firstRow, size_t count);
+		std::shared_ptr<QueryState>
+		BeginJob (ConnectionState& state, QueryId id);
+		void
+		EndJob (ConnectionState& state);
+		void
+		Push (DbEvent event);
+
+		std::function<void ()> m_notify;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::deque<std::shared_ptr<ConnectionState>> m_ready;
+		std::unordered_map<ConnectionId, std::shared_ptr<ConnectionState>> m_connections;
+		std::unordered_map<QueryId, std::shared_ptr<QueryState>> m_queries;
+		ConnectionId m_nextConnection = 1;
+		QueryId m_nextQuery = 1;
+		bool m_stopping = false;
+
+		std::mutex m_eventMutex;
+		std::vector<DbEvent> m_events;
+
+		std::vector<std::thread> m_workers;
+	};
+
+}  // namespace ambidb::db
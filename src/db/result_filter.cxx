@@ -0,0 +1,382 @@
+#include "result_filter.h"
+
+#include "parallel.h"
+#include "row_task.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AMBIDB_FILTER_X86 1
+#endif
+
+namespace ambidb::db {
+
+	namespace {
+
+		constexpr size_t kWordBits = 64;
+
+		/// Below one candidate in this many rows, a group's cells are searched one by one.
+		constexpr size_t kSparseRatio = 8;
+
+		char
+		Lower (char c) {
+			return (c >= 'A' && c <= 'Z') ? static_cast<char> (c | 0x20) : c;
+		}
+
+		/// @p needle is lower-case; compares its @p count bytes with @p text ignoring ASCII case.
+		bool
+		CaselessEqual (const char* text, const char* needle, size_t count) {
+			for (size_t i = 0; i < count; ++i) {
+				if (Lower (text [i]) != needle [i]) return false;
+			}
+			return true;
+		}
+
+		size_t
+		FindScalar (std::string_view haystack, std::string_view needle, size_t from) {
+			if (haystack.size () < needle.size ()) return std::string_view::npos;
+			const size_t last = haystack.size () - needle.size ();
+			for (size_t i = from; i <= last; ++i) {
+				if (Lower (haystack [i]) == needle [0] && CaselessEqual (haystack.data () + i + 1, needle.data () + 1, needle.size () - 1)) {
+					return i;
+				}
+			}
+			return std::string_view::npos;
+		}
+
+#ifdef AMBIDB_FILTER_X86
+		// Both variants compare the needle's first and last byte with a block of candidate
+		// start positions and verify the middle only where both match.
+
+		/// ASCII upper-case letters get bit 5 set; bytes >= 0x80 compare negative and stay.
+		inline __m128i
+		ToLower (__m128i v) {
+			const __m128i upper = _mm_and_si128 (_mm_cmpgt_epi8 (v, _mm_set1_epi8 ('A' - 1)), _mm_cmplt_epi8 (v, _mm_set1_epi8 ('Z' + 1)));
+			return _mm_or_si128 (v, _mm_and_si128 (upper, _mm_set1_epi8 (0x20)));
+		}
+
+		size_t
+		FindSse2 (std::string_view haystack, std::string_view needle) {
+			constexpr size_t kWidth = 16;
+			const size_t n = needle.size ();
+			const char* data = haystack.data ();
+			const __m128i first = _mm_set1_epi8 (needle [0]);
+			const __m128i last = _mm_set1_epi8 (needle [n - 1]);
+			size_t i = 0;
+			for (; i + n - 1 + kWidth <= haystack.size (); i += kWidth) {
+				const __m128i head = ToLower (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (data + i)));
+				const __m128i tail = ToLower (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (data + i + n - 1)));
+				u32 mask = static_cast<u32> (_mm_movemask_epi8 (_mm_and_si128 (_mm_cmpeq_epi8 (head, first), _mm_cmpeq_epi8 (tail, last))));
+				for (; mask; mask &= mask - 1) {
+					const size_t at = i + std::countr_zero (mask);
+					if (n <= 2 || CaselessEqual (data + at + 1, needle.data () + 1, n - 2)) return at;
+				}
+			}
+			return FindScalar (haystack, needle, i);
+		}
+
+		__attribute__ ((target ("avx2"), always_inline)) inline __m256i
+		ToLower (__m256i v) {
+			const __m256i upper = _mm256_andnot_si256 (_mm256_cmpgt_epi8 (_mm256_set1_epi8 ('A'), v), _mm256_cmpgt_epi8 (_mm256_set1_epi8 ('Z' + 1), v));
+			return _mm256_or_si256 (v, _mm256_and_si256 (upper, _mm256_set1_epi8 (0x20)));
+		}
+
+		__attribute__ ((target ("avx2"))) size_t
+		FindAvx2 (std::string_view haystack, std::string_view needle) {
+			constexpr size_t kWidth = 32;
+			const size_t n = needle.size ();
+			const char* data = haystack.data ();
+			const __m256i first = _mm256_set1_epi8 (needle [0]);
+			const __m256i last = _mm256_set1_epi8 (needle [n - 1]);
+			size_t i = 0;
+			for (; i + n - 1 + kWidth <= haystack.size (); i += kWidth) {
+				const __m256i head = ToLower (_mm256_loadu_si256 (reinterpret_cast<const __m256i*> (data + i)));
+				const __m256i tail = ToLower (_mm256_loadu_si256 (reinterpret_cast<const __m256i*> (data + i + n - 1)));
+				u32 mask = static_cast<u32> (_mm256_movemask_epi8 (_mm256_and_si256 (_mm256_cmpeq_epi8 (head, first), _mm256_cmpeq_epi8 (tail, last))));
+				for (; mask; mask &= mask - 1) {
+					const size_t at = i + std::countr_zero (mask);
+					if (n <= 2 || CaselessEqual (data + at + 1, needle.data () + 1, n - 2)) return at;
+				}
+			}
+			return FindScalar (haystack, needle, i);
+		}
+
+		using FindFn = size_t (*) (std::string_view, std::string_view);
+
+		const FindFn kFind = [] {
+			__builtin_cpu_init ();
+			return __builtin_cpu_supports ("avx2") ? &FindAvx2 : &FindSse2;
+		}();
+#endif
+
+		/// False when @p term cannot occur in a number formatted like FormatValue ().
+		bool
+		CouldBeNumber (std::string_view term, ColumnType type) {
+			const std::string_view chars = type == ColumnType::Integer ? "0123456789-" : "0123456789-+.einfa";
+			return term.find_first_not_of (chars) == std::string_view::npos;
+		}
+
+		/// Same text as FormatValue (): %PRId64 and %.15g, without going through snprintf.
+		std::string_view
+		FormatNumber (const ColumnChunkView& chunk, size_t row, std::span<char> scratch) {
+			const auto result = chunk.type == ColumnType::Integer
+									? std::to_chars (scratch.data (), scratch.data () + scratch.size (), chunk.integers [row])
+									: std::to_chars (scratch.data (), scratch.data () + scratch.size (), chunk.reals [row], std::chars_format::general, 15);
+			return {scratch.data (), result.ptr};
+		}
+
+		void
+		SetBit (std::vector<u64>& bits, size_t row) {
+			bits [row / kWordBits] |= u64{1} << (row % kWordBits);
+		}
+
+		/// Marks rows of a Text chunk containing @p term, scanning the arena as one string.
+		void
+		MatchText (const ColumnChunkView& chunk, std::string_view term, std::vector<u64>& bits) {
+			const std::string_view arena (chunk.bytes, chunk.offsets [chunk.rows]);
+			size_t pos = 0;
+			while (pos < arena.size ()) {
+				const size_t hit = FindCaseless (arena.substr (pos), term);
+				if (hit == std::string_view::npos) break;
+				// Terms hold no NUL, so a hit never spans two cells.
+				const size_t at = pos + hit;
+				const size_t row = static_cast<size_t> (std::upper_bound (chunk.offsets.begin (), chunk.offsets.end (), at) - chunk.offsets.begin ()) - 1;
+				if (!chunk.IsNull (row)) SetBit (bits, row);
+				pos = chunk.offsets [row + 1];
+			}
+		}
+
+		/// Marks the @p candidates rows of a Text chunk containing @p term, one cell at a time.
+		void
+		MatchTextCells (const ColumnChunkView& chunk, std::string_view term, std::span<const u64> candidates, std::vector<u64>& bits) {
+			for (size_t w = 0; w < candidates.size (); ++w) {
+				for (u64 word = candidates [w]; word; word &= word - 1) {
+					const size_t row = w * kWordBits + std::countr_zero (word);
+					if (!chunk.IsNull (row) && FindCaseless (chunk.Text (row), term) != std::string_view::npos) SetBit (bits, row);
+				}
+			}
+		}
+
+		/// Marks rows of an Integer or Real chunk whose text contains one of @p terms.
+		void
+		MatchNumbers (const ColumnChunkView& chunk,
+					  std::span<const RowFilter::Term* const> terms,
+					  std::span<const u64> candidates,
+					  std::vector<u64>& include,
+					  std::vector<u64>& exclude) {
+			std::array<char, 32> scratch;
+			for (size_t row = 0; row < chunk.rows; ++row) {
+				if (!((candidates [row / kWordBits] >> (row % kWordBits)) & 1) || chunk.IsNull (row)) continue;
+				const std::string_view text = FormatNumber (chunk, row, scratch);
+				for (const RowFilter::Term* term : terms) {
+					if (text.find (term->text) != std::string_view::npos) SetBit (term->exclude ? exclude : include, row);
+				}
+			}
+		}
+
+		/// The 64 bits of @p bits from bit @p at on; bits past the end read as 0.
+		u64
+		WordAt (const std::vector<u64>& bits, size_t at) {
+			const size_t word = at / kWordBits;
+			const size_t shift = at % kWordBits;
+			if (word >= bits.size ()) return 0;
+			u64 value = bits [word] >> shift;
+			if (shift && word + 1 < bits.size ()) value |= bits [word + 1] << (kWordBits - shift);
+			return value;
+		}
+
+		/// OR @p value into the 64 bits of @p bits from bit @p at on; bits past the end are dropped.
+		void
+		OrWordAt (std::vector<u64>& bits, size_t at, u64 value) {
+			const size_t word = at / kWordBits;
+			const size_t shift = at % kWordBits;
+			if (word >= bits.size ()) return;
+			bits [word] |= value << shift;
+			if (shift && word + 1 < bits.size ()) bits [word + 1] |= value >> (kWordBits - shift);
+		}
+
+		/**
+		 * @brief Evaluates @p filter on the rows of one row group set in @p candidates (indexed
+		 * by result row), and stores which of them pass in @p pass (indexed by row within the
+		 * group). False if stopped.
+		 */
+		bool
+		FilterGroup (const ResultSet& results,
+					 const RowFilter& filter,
+					 size_t group,
+					 const std::vector<u64>& candidates,
+					 std::vector<u64>& pass,
+					 const std::stop_token& stop) {
+			size_t firstRow = 0, rows = 0;
+			const size_t words = [&] {
+				const ColumnChunkView chunk = results.Chunk (group, 0);
+				firstRow = chunk.firstRow;
+				rows = chunk.rows;
+				return (rows + kWordBits - 1) / kWordBits;
+			}();
+			// A group sealed early (ResultSet::SetArenaLimit ()) starts at any row, so its bits
+			// are shifted to start a word and the result is merged by the caller.
+			std::vector<u64> test (words);
+			for (size_t w = 0; w < words; ++w) test [w] = WordAt (candidates, firstRow + w * kWordBits);
+			if (rows % kWordBits) test.back () &= (u64{1} << (rows % kWordBits)) - 1;
+			size_t tested = 0;
+			for (const u64 word : test) tested += std::popcount (word);
+			if (tested == 0) return true;
+			const bool sparse = tested * kSparseRatio < rows;
+
+			std::vector<u64> include (words, 0), exclude (words, 0);
+			std::vector<const RowFilter::Term*> numberTerms;
+
+			for (size_t column = 0; column < results.ColumnCount (); ++column) {
+				if (stop.stop_requested ()) return false;
+				const ColumnChunkView chunk = results.Chunk (group, column);
+				switch (chunk.type) {
+					case ColumnType::Null:
+					case ColumnType::Blob: break;
+					case ColumnType::Text:
+						for (const RowFilter::Term& term : filter.Terms ()) {
+							std::vector<u64>& bits = term.exclude ? exclude : include;
+							if (sparse) {
+								MatchTextCells (chunk, term.text, test, bits);
+							}
+							else {
+								MatchText (chunk, term.text, bits);
+							}
+						}
+						break;
+					case ColumnType::Integer:
+					case ColumnType::Real:
+						numberTerms.clear ();
+						for (const RowFilter::Term& term : filter.Terms ()) {
+							if (CouldBeNumber (term.text, chunk.type)) numberTerms.push_back (&term);
+						}
+						if (!numberTerms.empty ()) MatchNumbers (chunk, numberTerms, test, include, exclude);
+						break;
+				}
+			}
+
+			pass.resize (words);
+			for (size_t w = 0; w < words; ++w) {
+				pass [w] = (filter.HasIncludes () ? include [w] : test [w]) & test [w] & ~exclude [w];
+			}
+			return true;
+		}
+
+	}  // namespace
+
+	RowFilter::RowFilter (std::string_view pattern) {
+		while (!pattern.empty ()) {
+			const size_t comma = pattern.find (',');
+			std::string_view part = pattern.substr (0, comma);
+			pattern = comma == std::string_view::npos ? std::string_view{} : pattern.substr (comma + 1);
+
+			while (!part.empty () && part.front () == ' ') part.remove_prefix (1);
+			while (!part.empty () && part.back () == ' ') part.remove_suffix (1);
+			Term term;
+			if (part.starts_with ('-')) {
+				term.exclude = true;
+				part.remove_prefix (1);
+			}
+			if (part.empty ()) continue;
+			term.text.resize (part.size ());
+			std::transform (part.begin (), part.end (), term.text.begin (), Lower);
+			m_includes += !term.exclude;
+			m_terms.push_back (std::move (term));
+		}
+	}
+
+	bool
+	RowFilter::Pass (std::string_view text) const {
+		bool included = m_includes == 0;
+		for (const Term& term : m_terms) {
+			if (FindCaseless (text, term.text) == std::string_view::npos) continue;
+			if (term.exclude) return false;
+			included = true;
+		}
+		return included;
+	}
+
+	bool
+	RowFilter::Refines (const RowFilter& base) const {
+		const auto contains = [] (const Term& outer, const Term& inner) { return outer.text.find (inner.text) != std::string::npos; };
+		// A row base excludes contains one of this filter's excludes, so it stays excluded.
+		for (const Term& dropped : base.m_terms) {
+			if (!dropped.exclude) continue;
+			if (std::ranges::none_of (m_terms, [&] (const Term& term) { return term.exclude && contains (dropped, term); })) return false;
+		}
+		if (base.m_includes == 0) return true;
+		// A row matching one of these includes matches an include of base.
+		if (m_includes == 0) return false;
+		for (const Term& term : m_terms) {
+			if (term.exclude) continue;
+			if (std::ranges::none_of (base.m_terms, [&] (const Term& kept) { return !kept.exclude && contains (term, kept); })) return false;
+		}
+		return true;
+	}
+
+	size_t
+	FindCaseless (std::string_view haystack, std::string_view needle) {
+		if (needle.empty ()) return 0;
+#ifdef AMBIDB_FILTER_X86
+		return kFind (haystack, needle);
+#else
+		return FindScalar (haystack, needle, 0);
+#endif
+	}
+
+	std::optional<std::vector<u32>>
+	FilterRows (const ResultSet& results, const RowFilter& filter, std::span<const u32> order, std::stop_token stop, size_t threads) {
+		const size_t rowCount = results.RowCount ();
+		if (rowCount > RowTask::kMaxRows) return std::nullopt;
+
+		const size_t words = (rowCount + kWordBits - 1) / kWordBits;
+		std::vector<u64> candidates (words, order.empty () ? ~u64{0} : 0);
+		if (order.empty ()) {
+			if (rowCount % kWordBits) candidates.back () = (u64{1} << (rowCount % kWordBits)) - 1;
+		}
+		else {
+			for (const u32 row : order) SetBit (candidates, row);
+		}
+		const size_t groups = results.GroupCount ();
+		std::vector<std::vector<u64>> groupPass (groups);
+		threads = std::min (ThreadCount (threads), groups);
+		std::atomic<bool> stopped{false};
+		ParallelFor (threads, [&] (size_t t) {
+			for (size_t group = t; group < groups; group += threads) {
+				if (!FilterGroup (results, filter, group, candidates, groupPass [group], stop)) {
+					stopped.store (true, std::memory_order_relaxed);
+					return;
+				}
+			}
+		});
+		if (stopped.load (std::memory_order_relaxed) || stop.stop_requested ()) return std::nullopt;
+
+		// Merged on this thread: groups that do not start a word share one with the group before.
+		std::vector<u64> pass (words, 0);
+		for (size_t group = 0; group < groups; ++group) {
+			const size_t firstRow = results.Chunk (group, 0).firstRow;
+			for (size_t w = 0; w < groupPass [group].size (); ++w) OrWordAt (pass, firstRow + w * kWordBits, groupPass [group] [w]);
+		}
+
+		std::vector<u32> rows;
+		if (order.empty ()) {
+			for (size_t w = 0; w < pass.size (); ++w) {
+				for (u64 bits = pass [w]; bits; bits &= bits - 1) {
+					rows.push_back (static_cast<u32> (w * kWordBits + std::countr_zero (bits)));
+				}
+			}
+		}
+		else {
+			for (const u32 row : order) {
+				if ((pass [row / kWordBits] >> (row % kWordBits)) & 1) rows.push_back (row);
+			}
+		}
+		return rows;
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "result_set.h"
+
+#include <macro.h>
+
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ambidb::db {
+
+	/**
+	 * @brief A filter in ImGuiTextFilter syntax: comma-separated terms, "-term" excludes.
+	 *
+	 * Terms are trimmed and matched as case-insensitive (ASCII) substrings. Text passes when
+	 * it contains no exclude term and, if there are include terms, at least one of them.
+	 * Unlike ImGuiTextFilter, the result does not depend on the order of the terms.
+	 */
+	class RowFilter {
+	public:
+		struct Term {
+			std::string text;  ///< Lower-cased.
+			bool exclude{false};
+		};
+
+		RowFilter () = default;
+		explicit RowFilter (std::string_view pattern);
+
+		bool
+		Empty () const {
+			return m_terms.empty ();
+		}
+
+		const std::vector<Term>&
+		Terms () const {
+			return m_terms;
+		}
+
+		bool
+		HasIncludes () const {
+			return m_includes > 0;
+		}
+
+		/// Scalar check of one string, e.g. a list entry.
+		bool
+		Pass (std::string_view text) const;
+
+		/**
+		 * @brief True if everything this filter passes, @p base passes too: its excludes
+		 * are kept (or shortened) and each include extends one of base's includes. Typing
+		 * more of a term or adding an exclusion refines the previous filter.
+		 */
+		bool
+		Refines (const RowFilter& base) const;
+
+	private:
+		std::vector<Term> m_terms;
+		size_t m_includes{0};
+	};
+
+	/**
+	 * @brief Offset of the first case-insensitive occurrence of @p needle (lower-cased,
+	 * non-empty) in @p haystack, or std::string_view::npos.
+	 *
+	 * Compares the needle's first and last byte against 32 (AVX2) or 16 (SSE2) haystack
+	 * bytes at a time and verifies only the candidate positions, so long runs without a
+	 * match cost a few instructions per block. Picks the widest variant the CPU supports;
+	 * other architectures use a scalar loop.
+	 */
+	size_t
+	FindCaseless (std::string_view haystack, std::string_view needle);
+
+	/**
+	 * @brief Rows of @p results where @p filter passes for at least one cell, treating each
+	 * row as the set of its cells' display texts. NULL and Blob cells never match.
+	 *
+	 * Text columns are searched a whole row group at a time: the group's string arena is one
+	 * NUL-separated buffer, so FindCaseless runs over it directly and a hit is mapped back to
+	 * its row through the offsets. Numeric cells are formatted only when the term could
+	 * appear in a number. Row groups are spread across @p threads (0 = one per core).
+	 *
+	 * Only the rows in @p order are tested. Passing the rows a broader filter selected
+	 * (see RowFilter::Refines ()) narrows that selection: groups without such rows are
+	 * skipped, and where they are sparse their cells are searched one by one instead of
+	 * the whole arena, so each refining keystroke costs less than the last.
+	 *
+	 * @param order Rows to filter in display order (e.g. from SortRows ()); empty = all
+	 * rows in result order.
+	 * @return The passing rows in that order, or std::nullopt if @p stop is requested first.
+	 */
+	std::optional<std::vector<u32>>
+	FilterRows (const ResultSet& results,
+				const RowFilter& filter,
+				std::span<const u32> order,
+				std::stop_token stop,
+				size_t threads = 0);
+
+}  // namespace ambidb::db
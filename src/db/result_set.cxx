@@ -0,0 +1,435 @@
+#include "result_set.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <print>
+
+namespace ambidb::db {
+
+	namespace {
+
+		size_t
+		PayloadSize (const Value& value) {
+			if (const auto* text = std::get_if<std::string> (&value)) return text->size () + 1;
+			if (const auto* blob = std::get_if<Blob> (&value)) return blob->bytes.size () + 1;
+			return 0;
+		}
+
+		template <typename T>
+		size_t
+		Reserved (const std::vector<T>& v) {
+			return v.capacity () * sizeof (T);
+		}
+
+		template <typename T>
+		void
+		Release (std::vector<T>& v) {
+			std::vector<T> ().swap (v);
+		}
+
+		template <typename T>
+		std::span<const std::byte>
+		AsBytes (const std::vector<T>& v) {
+			return std::as_bytes (std::span (v));
+		}
+
+		template <typename T>
+		std::span<const T>
+		Mapped (const SpillMapping& mapping, size_t offset, size_t count) {
+			return {reinterpret_cast<const T*> (mapping.Data () + offset), count};
+		}
+
+		void
+		PushBytes (std::vector<char>& bytes, std::vector<u32>& offsets, const char* data, size_t size) {
+			bytes.insert (bytes.end (), data, data + size);
+			bytes.push_back ('\0');
+			offsets.push_back (static_cast<u32> (bytes.size ()));
+		}
+
+	}  // namespace
+
+	const char*
+	ColumnTypeName (ColumnType type) {
+		switch (type) {
+			case ColumnType::Null: return "null";
+			case ColumnType::Integer: return "integer";
+			case ColumnType::Real: return "real";
+			case ColumnType::Text: return "text";
+			case ColumnType::Blob: return "blob";
+		}
+		UNREACHABLE ();
+	}
+
+	ColumnType
+	ColumnTypeOf (const Value& value) {
+		switch (value.index ()) {
+			case 1: return ColumnType::Integer;
+			case 2: return ColumnType::Real;
+			case 3: return ColumnType::Text;
+			case 4: return ColumnType::Blob;
+			default: return ColumnType::Null;
+		}
+	}
+
+	ColumnType
+	WidenColumnType (ColumnType current, ColumnType incoming) {
+		if (incoming == ColumnType::Null || incoming == current) return current;
+		if (current == ColumnType::Null) return incoming;
+		if ((current == ColumnType::Integer && incoming == ColumnType::Real) ||
+			(current == ColumnType::Real && incoming == ColumnType::Integer)) {
+			return ColumnType::Real;
+		}
+		return ColumnType::Text;
+	}
+
+	void
+	ResultSet::Reset (std::vector<ColumnInfo> columns) {
+		m_columns.clear ();
+		m_columns.reserve (columns.size ());
+		for (ColumnInfo& info : columns) {
+			m_columns.push_back ({std::move (info), ColumnType::Null});
+		}
+		m_groups.clear ();
+		m_rowCount = 0;
+		m_sealedBytes = 0;
+		m_spilledGroups = 0;
+		m_spillCursor = 0;
+		m_spillFailed = false;
+		m_charge.Set (0);
+		m_spill = SpillFile{};
+	}
+
+	void
+	ResultSet::Append (const RowBatch& batch) {
+		if (batch.columnCount != m_columns.size ()) return;
+
+		const size_t rows = batch.RowCount ();
+		for (size_t row = 0; row < rows; ++row) {
+			RowGroup& group = GroupFor (batch, row);
+			const size_t index = group.rows;
+			for (size_t column = 0; column < m_columns.size (); ++column) {
+				const Value& value = batch.At (row, column);
+				const ColumnType type = WidenColumnType (m_columns [column].type, ColumnTypeOf (value));
+				if (type != m_columns [column].type) {
+					Promote (column, type);
+				}
+				AppendValue (group.columns [column], column, index, value);
+			}
+			++group.rows;
+			++m_rowCount;
+		}
+		Account ();
+	}
+
+	void
+	ResultSet::SetArenaLimit (size_t bytes) {
+		m_arenaLimit = std::min (bytes, kMaxArenaBytes);
+	}
+
+	ResultSet::RowGroup&
+	ResultSet::GroupFor (const RowBatch& batch, size_t row) {
+		if (!m_groups.empty ()) {
+			RowGroup& last = m_groups.back ();
+			bool fits = last.rows < kGroupRows;
+			for (size_t column = 0; fits && column < m_columns.size (); ++column) {
+				const size_t payload = PayloadSize (batch.At (row, column));
+				fits = payload == 0 || last.columns [column].bytes.size () + payload <= m_arenaLimit;
+			}
+			if (fits) return last;
+			SealLastGroup ();
+		}
+
+		RowGroup& group = m_groups.emplace_back ();
+		group.firstRow = m_rowCount;
+		group.columns.resize (m_columns.size ());
+		for (size_t column = 0; column < m_columns.size (); ++column) {
+			const ColumnType type = m_columns [column].type;
+			if (type == ColumnType::Text || type == ColumnType::Blob) {
+				group.columns [column].offsets.push_back (0);
+			}
+		}
+		return group;
+	}
+
+	void
+	ResultSet::SealLastGroup () {
+		for (ColumnChunk& chunk : m_groups.back ().columns) {
+			chunk.nulls.shrink_to_fit ();
+			chunk.integers.shrink_to_fit ();
+			chunk.reals.shrink_to_fit ();
+			chunk.offsets.shrink_to_fit ();
+			chunk.bytes.shrink_to_fit ();
+		}
+		m_sealedBytes += GroupBytes (m_groups.back ());
+	}
+
+	void
+	ResultSet::Account () {
+		m_charge.Set (m_sealedBytes + (m_groups.empty () ? 0 : GroupBytes (m_groups.back ())));
+
+		// Full groups go to disk, oldest first, until the process is back under its budget.
+		while (!m_spillFailed && MemoryBudget::Process ().Exceeded () && m_spillCursor + 1 < m_groups.size ()) {
+			RowGroup& group = m_groups [m_spillCursor++];
+			if (group.Spilled ()) continue;
+			const size_t bytes = GroupBytes (group);
+			if (!Spill (group)) {
+				std::println (stderr, "Cannot spill query results to disk; keeping them in memory");
+				m_spillFailed = true;
+				break;
+			}
+			m_sealedBytes -= bytes;
+			m_charge.Set (m_sealedBytes + GroupBytes (m_groups.back ()));
+		}
+	}
+
+	bool
+	ResultSet::Spill (RowGroup& group) {
+		std::vector<std::span<const std::byte>> parts;
+		parts.reserve (group.columns.size () * 5);
+		for (const ColumnChunk& chunk : group.columns) {
+			parts.push_back (AsBytes (chunk.nulls));
+			parts.push_back (AsBytes (chunk.integers));
+			parts.push_back (AsBytes (chunk.reals));
+			parts.push_back (AsBytes (chunk.offsets));
+			parts.push_back (AsBytes (chunk.bytes));
+		}
+		std::vector<size_t> offsets;
+		std::optional<SpillMapping> mapping = m_spill.Write (parts, offsets);
+		if (!mapping) return false;
+
+		group.mapping = std::move (*mapping);
+		for (size_t column = 0; column < group.columns.size (); ++column) {
+			ColumnChunk& chunk = group.columns [column];
+			const size_t* part = &offsets [column * 5];
+			chunk.spilled.nulls = Mapped<u64> (group.mapping, part [0], chunk.nulls.size ());
+			chunk.spilled.integers = Mapped<i64> (group.mapping, part [1], chunk.integers.size ());
+			chunk.spilled.reals = Mapped<f64> (group.mapping, part [2], chunk.reals.size ());
+			chunk.spilled.offsets = Mapped<u32> (group.mapping, part [3], chunk.offsets.size ());
+			chunk.spilled.bytes = Mapped<char> (group.mapping, part [4], chunk.bytes.size ());
+			Release (chunk.nulls);
+			Release (chunk.integers);
+			Release (chunk.reals);
+			Release (chunk.offsets);
+			Release (chunk.bytes);
+		}
+		++m_spilledGroups;
+		return true;
+	}
+
+	void
+	ResultSet::Unspill (RowGroup& group) {
+		for (ColumnChunk& chunk : group.columns) {
+			chunk.nulls.assign (chunk.spilled.nulls.begin (), chunk.spilled.nulls.end ());
+			chunk.integers.assign (chunk.spilled.integers.begin (), chunk.spilled.integers.end ());
+			chunk.reals.assign (chunk.spilled.reals.begin (), chunk.spilled.reals.end ());
+			chunk.offsets.assign (chunk.spilled.offsets.begin (), chunk.spilled.offsets.end ());
+			chunk.bytes.assign (chunk.spilled.bytes.begin (), chunk.spilled.bytes.end ());
+			chunk.spilled = {};
+		}
+		m_spill.Release (std::move (group.mapping));
+		--m_spilledGroups;
+	}
+
+	ResultSet::ChunkSpans
+	ResultSet::Spans (const RowGroup& group, size_t column) {
+		const ColumnChunk& chunk = group.columns [column];
+		if (group.Spilled ()) return chunk.spilled;
+		return {chunk.nulls, chunk.integers, chunk.reals, chunk.offsets, chunk.bytes};
+	}
+
+	size_t
+	ResultSet::GroupBytes (const RowGroup& group) {
+		size_t bytes = 0;
+		for (const ColumnChunk& chunk : group.columns) {
+			bytes += Reserved (chunk.nulls) + Reserved (chunk.integers) + Reserved (chunk.reals) +
+					 Reserved (chunk.offsets) + Reserved (chunk.bytes);
+		}
+		return bytes;
+	}
+
+	void
+	ResultSet::Promote (size_t column, ColumnType type) {
+		const ColumnType from = m_columns [column].type;
+		m_columns [column].type = type;
+
+		for (RowGroup& group : m_groups) {
+			// A spilled group is converted on the heap and written out again; its old range
+			// is released, so later groups reuse it.
+			const bool spilled = group.Spilled ();
+			if (spilled) Unspill (group);
+			ConvertChunk (group.columns [column], group.rows, from, type);
+			if (spilled && !Spill (group)) m_spillFailed = true;
+		}
+
+		m_sealedBytes = 0;
+		for (size_t group = 0; group + 1 < m_groups.size (); ++group) {
+			m_sealedBytes += GroupBytes (m_groups [group]);
+		}
+		m_spillCursor = 0;
+	}
+
+	void
+	ResultSet::ConvertChunk (ColumnChunk& chunk, size_t rows, ColumnType from, ColumnType type) {
+		char scratch [64];
+		switch (type) {
+			case ColumnType::Null: break;
+			case ColumnType::Integer: chunk.integers.assign (rows, 0); break;
+			case ColumnType::Real:
+				if (from == ColumnType::Integer) {
+					chunk.reals.assign (chunk.integers.begin (), chunk.integers.end ());
+					Release (chunk.integers);
+				}
+				else {
+					chunk.reals.assign (rows, 0.0);
+				}
+				break;
+			case ColumnType::Blob:
+			case ColumnType::Text: {
+				// Blob bytes are already in text layout; keep them as they are.
+				if (from == ColumnType::Blob) break;
+				std::vector<u32> offsets;
+				std::vector<char> bytes;
+				offsets.reserve (rows + 1);
+				offsets.push_back (0);
+				for (size_t i = 0; i < rows; ++i) {
+					const bool null = (chunk.nulls [i >> 6] >> (i & 63)) & 1;
+					const char* text = "";
+					if (!null && from == ColumnType::Integer) {
+						text = FormatValue (Value{chunk.integers [i]}, scratch, sizeof (scratch));
+					}
+					else if (!null && from == ColumnType::Real) {
+						text = FormatValue (Value{chunk.reals [i]}, scratch, sizeof (scratch));
+					}
+					PushBytes (bytes, offsets, text, std::strlen (text));
+				}
+				chunk.offsets = std::move (offsets);
+				chunk.bytes = std::move (bytes);
+				Release (chunk.integers);
+				Release (chunk.reals);
+				break;
+			}
+		}
+	}
+
+	void
+	ResultSet::AppendValue (ColumnChunk& chunk, size_t column, size_t index, const Value& value) {
+		if ((index >> 6) >= chunk.nulls.size ()) {
+			chunk.nulls.push_back (0);
+		}
+		const bool null = std::holds_alternative<std::monostate> (value);
+		if (null) {
+			chunk.nulls [index >> 6] |= u64{1} << (index & 63);
+		}
+
+		char scratch [64];
+		switch (m_columns [column].type) {
+			case ColumnType::Null: break;
+			case ColumnType::Integer:
+				chunk.integers.push_back (null ? 0 : std::get<i64> (value));
+				break;
+			case ColumnType::Real:
+				if (const auto* integer = std::get_if<i64> (&value)) {
+					chunk.reals.push_back (static_cast<f64> (*integer));
+				}
+				else {
+					chunk.reals.push_back (null ? 0.0 : std::get<f64> (value));
+				}
+				break;
+			case ColumnType::Text:
+			case ColumnType::Blob:
+				if (const auto* text = std::get_if<std::string> (&value)) {
+					PushBytes (chunk.bytes, chunk.offsets, text->data (), text->size ());
+				}
+				else if (const auto* blob = std::get_if<Blob> (&value)) {
+					PushBytes (chunk.bytes,
+							   chunk.offsets,
+							   reinterpret_cast<const char*> (blob->bytes.data ()),
+							   blob->bytes.size ());
+				}
+				else {
+					const char* formatted = null ? "" : FormatValue (value, scratch, sizeof (scratch));
+					PushBytes (chunk.bytes, chunk.offsets, formatted, std::strlen (formatted));
+				}
+				break;
+		}
+	}
+
+	const ResultSet::RowGroup&
+	ResultSet::Locate (size_t row, size_t& index) const {
+		// Groups are kGroupRows long unless a string arena filled up early, so guess first.
+		size_t group = std::min (row / kGroupRows, m_groups.size () - 1);
+		if (m_groups [group].firstRow > row || row - m_groups [group].firstRow >= m_groups [group].rows) {
+			const auto it = std::ranges::upper_bound (m_groups, row, {}, &RowGroup::firstRow);
+			group = static_cast<size_t> (it - m_groups.begin ()) - 1;
+		}
+		index = row - m_groups [group].firstRow;
+		return m_groups [group];
+	}
+
+	bool
+	ResultSet::IsNull (size_t row, size_t column) const {
+		size_t index;
+		const ChunkSpans chunk = Spans (Locate (row, index), column);
+		return (chunk.nulls [index >> 6] >> (index & 63)) & 1;
+	}
+
+	i64
+	ResultSet::Integer (size_t row, size_t column) const {
+		size_t index;
+		return Spans (Locate (row, index), column).integers [index];
+	}
+
+	f64
+	ResultSet::Real (size_t row, size_t column) const {
+		size_t index;
+		const ChunkSpans chunk = Spans (Locate (row, index), column);
+		if (m_columns [column].type == ColumnType::Integer) {
+			return static_cast<f64> (chunk.integers [index]);
+		}
+		return chunk.reals [index];
+	}
+
+	std::string_view
+	ResultSet::Text (size_t row, size_t column) const {
+		size_t index;
+		const ChunkSpans chunk = Spans (Locate (row, index), column);
+		return {chunk.bytes.data () + chunk.offsets [index], chunk.offsets [index + 1] - chunk.offsets [index] - 1};
+	}
+
+	const char*
+	ResultSet::FormatCell (size_t row, size_t column, char* scratch, size_t scratchSize) const {
+		size_t index;
+		const ChunkSpans chunk = Spans (Locate (row, index), column);
+		if ((chunk.nulls [index >> 6] >> (index & 63)) & 1) return "NULL";
+
+		switch (m_columns [column].type) {
+			case ColumnType::Null: return "NULL";
+			case ColumnType::Integer: return FormatValue (Value{chunk.integers [index]}, scratch, scratchSize);
+			case ColumnType::Real: return FormatValue (Value{chunk.reals [index]}, scratch, scratchSize);
+			case ColumnType::Text: return chunk.bytes.data () + chunk.offsets [index];
+			case ColumnType::Blob:
+				std::snprintf (scratch, scratchSize, "<blob %u bytes>", chunk.offsets [index + 1] - chunk.offsets [index] - 1);
+				return scratch;
+		}
+		UNREACHABLE ();
+	}
+
+	ColumnChunkView
+	ResultSet::Chunk (size_t group, size_t column) const {
+		const RowGroup& rows = m_groups [group];
+		const ChunkSpans chunk = Spans (rows, column);
+		ColumnChunkView view;
+		view.firstRow = rows.firstRow;
+		view.rows = rows.rows;
+		view.type = m_columns [column].type;
+		view.nulls = chunk.nulls.data ();
+		view.integers = chunk.integers;
+		view.reals = chunk.reals;
+		view.offsets = chunk.offsets;
+		view.bytes = chunk.bytes.data ();
+		return view;
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "driver.h"
+#include "spill_store.h"
+
+#include <macro.h>
+
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ambidb::db {
+
+	/**
+	 * @brief Storage type of a ResultSet column. Ordered so that promotion only moves right:
+	 * Null -> Integer -> Real -> Text. Blob columns become Text if they meet any other type.
+	 */
+	enum class ColumnType : u8 {
+		Null,  ///< No non-null value seen yet; only the null bitmap is stored.
+		Integer,
+		Real,
+		Text,
+		Blob,
+	};
+
+	const char*
+	ColumnTypeName (ColumnType type);
+
+	/// Storage type of @p value on its own.
+	ColumnType
+	ColumnTypeOf (const Value& value);
+
+	/// The narrowest type that holds both; Text when nothing narrower does.
+	ColumnType
+	WidenColumnType (ColumnType current, ColumnType incoming);
+
+	/**
+	 * @brief Read-only view of one column within one row group, for scans.
+	 *
+	 * Exactly one of integers / reals / (offsets, bytes) is populated, matching type.
+	 * Row i of a Text or Blob chunk is bytes [offsets [i], offsets [i + 1] - 1); the byte
+	 * before offsets [i + 1] is a NUL terminator so Text cells can be passed to ImGui as is.
+	 */
+	struct ColumnChunkView {
+		size_t firstRow{0};
+		size_t rows{0};
+		ColumnType type{ColumnType::Null};
+		const u64* nulls{nullptr};	///< Bit i set = row i is NULL.
+		std::span<const i64> integers;
+		std::span<const f64> reals;
+		std::span<const u32> offsets;	 ///< rows + 1 entries.
+		const char* bytes{nullptr};
+
+		bool
+		IsNull (size_t row) const {
+			return (nulls [row >> 6] >> (row & 63)) & 1;
+		}
+
+		std::string_view
+		Text (size_t row) const {
+			return {bytes + offsets [row], offsets [row + 1] - offsets [row] - 1};
+		}
+	};
+
+	/**
+	 * @brief Columnar, append-only storage for a query result.
+	 *
+	 * Rows are grouped into row groups of up to kGroupRows. Within a group each column is one
+	 * contiguous array: i64 / f64 values, or NUL-terminated strings packed into a byte arena
+	 * with a u32 offset array, plus a null bitmap. A cell costs its payload plus one bit
+	 * (and four offset bytes for strings) instead of a std::string or Value each, and a
+	 * column scan walks dense arrays.
+	 *
+	 * Full groups are shrunk to fit and never touched again, so appending costs amortized
+	 * O(1) per cell and row pointers into older groups stay valid. Types come from the data:
+	 * a column takes the type of its first non-null value and widens in place when a later
+	 * value does not fit (see ColumnType).
+	 *
+	 * Resident bytes are charged to MemoryBudget::Process (). While the budget is exceeded,
+	 * full groups are written to a SpillFile, oldest first, and read back through a
+	 * read-only mapping. Every accessor and Chunk () reads spilled groups in place, so the
+	 * kernel pages them in on access and can drop them again under memory pressure.
+	 */
+	class ResultSet {
+	public:
+		static constexpr size_t kGroupRows = 64 * 1024;
+		/// Keeps string offsets within u32, with room for numbers converted by a promotion.
+		static constexpr size_t kMaxArenaBytes = std::numeric_limits<u32>::max () - kGroupRows * 32;
+
+		MAKE_NONCOPYABLE (ResultSet);
+		ResultSet () = default;
+		ResultSet (ResultSet&&) noexcept = default;
+		ResultSet&
+		operator= (ResultSet&&) noexcept = default;
+		~ResultSet () = default;
+
+		/**
+		 * @brief Drop all rows and start over with @p columns.
+		 */
+		void
+		Reset (std::vector<ColumnInfo> columns);
+
+		/**
+		 * @brief Seal a group early once one of its text arenas would pass @p bytes (at most
+		 * the default, which keeps offsets within u32). Groups then start at any row; tests
+		 * use a small limit to get there without gigabytes of text.
+		 */
+		void
+		SetArenaLimit (size_t bytes);
+
+		/**
+		 * @brief Append the rows of @p batch; its column count must match.
+		 */
+		void
+		Append (const RowBatch& batch);
+
+		size_t
+		RowCount () const {
+			return m_rowCount;
+		}
+
+		size_t
+		ColumnCount () const {
+			return m_columns.size ();
+		}
+
+		const ColumnInfo&
+		Column (size_t column) const {
+			return m_columns [column].info;
+		}
+
+		ColumnType
+		Type (size_t column) const {
+			return m_columns [column].type;
+		}
+
+		bool
+		IsNull (size_t row, size_t column) const;
+
+		/// Integer columns only.
+		i64
+		Integer (size_t row, size_t column) const;
+
+		/// Integer or Real columns.
+		f64
+		Real (size_t row, size_t column) const;
+
+		/// Text or Blob columns. The view is NUL-terminated and stable until Reset().
+		std::string_view
+		Text (size_t row, size_t column) const;
+
+		/**
+		 * @brief Cell text for display: text cells point into the arena (no copy), other
+		 * types are formatted into @p scratch like FormatValue().
+		 */
+		const char*
+		FormatCell (size_t row, size_t column, char* scratch, size_t scratchSize) const;
+
+		size_t
+		GroupCount () const {
+			return m_groups.size ();
+		}
+
+		ColumnChunkView
+		Chunk (size_t group, size_t column) const;
+
+		/**
+		 * @brief Heap bytes reserved for cell storage, excluding the fixed per-group overhead
+		 * and spilled groups.
+		 */
+		size_t
+		MemoryBytes () const {
+			return m_charge.Bytes ();
+		}
+
+		/// Bytes of cell storage in the spill file, not counting released old copies.
+		size_t
+		SpilledBytes () const {
+			return m_spill.LiveBytes ();
+		}
+
+		size_t
+		SpilledGroups () const {
+			return m_spilledGroups;
+		}
+
+	private:
+		/// Where a chunk's arrays are, on the heap or in the spill mapping.
+		struct ChunkSpans {
+			std::span<const u64> nulls;
+			std::span<const i64> integers;
+			std::span<const f64> reals;
+			std::span<const u32> offsets;
+			std::span<const char> bytes;
+		};
+
+		struct ColumnChunk {
+			std::vector<u64> nulls;
+			std::vector<i64> integers;
+			std::vector<f64> reals;
+			std::vector<u32> offsets;
+			std::vector<char> bytes;
+			ChunkSpans spilled;	 ///< Set while the group is spilled; the vectors are then empty.
+		};
+
+		struct RowGroup {
+			size_t firstRow{0};
+			size_t rows{0};
+			std::vector<ColumnChunk> columns;
+			SpillMapping mapping;  ///< Non-empty while the group is spilled.
+
+			bool
+			Spilled () const {
+				return mapping.Data () != nullptr;
+			}
+		};
+
+		struct ColumnMeta {
+			ColumnInfo info;
+			ColumnType type{ColumnType::Null};
+		};
+
+		/// Returns the group holding @p row and sets @p index to the row within it.
+		const RowGroup&
+		Locate (size_t row, size_t& index) const;
+
+		static ChunkSpans
+		Spans (const RowGroup& group, size_t column);
+		static size_t
+		GroupBytes (const RowGroup& group);
+
+		RowGroup&
+		GroupFor (const RowBatch& batch, size_t row);
+		void
+		SealLastGroup ();
+		void
+		Account ();
+		bool
+		Spill (RowGroup& group);
+		void
+		Unspill (RowGroup& group);
+		void
+		Promote (size_t column, ColumnType type);
+		static void
+		ConvertChunk (ColumnChunk& chunk, size_t rows, ColumnType from, ColumnType type);
+		void
+		AppendValue (ColumnChunk& chunk, size_t column, size_t index, const Value& value);
+
+		std::vector<ColumnMeta> m_columns;
+		std::vector<RowGroup> m_groups;
+		size_t m_rowCount{0};
+		size_t m_arenaLimit{kMaxArenaBytes};
+		size_t m_sealedBytes{0};  ///< Resident bytes of every group but the last.
+		size_t m_spilledGroups{0};
+		size_t m_spillCursor{0};  ///< Groups before this one are spilled.
+		bool m_spillFailed{false};
+		MemoryCharge m_charge;
+		SpillFile m_spill;
+	};
+
+}  // namespace ambidb::db
@@ -0,0 +1,405 @@
+#include "result_sort.h"
+
+#include "parallel.h"
+#include "row_task.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace ambidb::db {
+
+	namespace {
+
+		constexpr u64 kSignBit = u64{1} << 63;
+		// Below this many rows a single thread is faster than starting workers.
+		constexpr size_t kParallelRows = 64 * 1024;
+		// Tied text runs up to this size are compared in full instead of radix sorted again.
+		constexpr size_t kSmallRun = 64;
+		constexpr size_t kPrefixBytes = sizeof (u64);
+		// 11-bit digits: six passes over a 64-bit key, with counts that still fit in L1.
+		constexpr unsigned kDigitBits = 11;
+		constexpr size_t kBuckets = size_t{1} << kDigitBits;
+
+		/// Big-endian bytes [offset, offset + 8) of @p text, zero padded: compares like memcmp.
+		u64
+		Prefix (std::string_view text, size_t offset) {
+			if (offset >= text.size ()) return 0;
+			std::array<unsigned char, kPrefixBytes> bytes{};
+			std::memcpy (bytes.data (), text.data () + offset, std::min (kPrefixBytes, text.size () - offset));
+			const u64 value = std::bit_cast<u64> (bytes);
+			if constexpr (std::endian::native == std::endian::little) return std::byteswap (value);
+			return value;
+		}
+
+		/// Maps a cell to a u64 whose unsigned order matches the column's order.
+		template <ColumnType T>
+		struct KeyOf;
+
+		template <>
+		struct KeyOf<ColumnType::Integer> {
+			static u64
+			Get (const ColumnChunkView& chunk, size_t i) {
+				return static_cast<u64> (chunk.integers [i]) ^ kSignBit;
+			}
+		};
+
+		template <>
+		struct KeyOf<ColumnType::Real> {
+			static u64
+			Get (const ColumnChunkView& chunk, size_t i) {
+				const u64 bits = std::bit_cast<u64> (chunk.reals [i]);
+				return (bits & kSignBit) ? ~bits : bits | kSignBit;
+			}
+		};
+
+		template <>
+		struct KeyOf<ColumnType::Text> {
+			static u64
+			Get (const ColumnChunkView& chunk, size_t i) {
+				return Prefix (chunk.Text (i), 0);
+			}
+		};
+
+		template <>
+		struct KeyOf<ColumnType::Blob> : KeyOf<ColumnType::Text> {};
+
+		/**
+		 * @brief Scratch arrays shared by the passes of one sort, sized to the row count.
+		 */
+		struct SortBuffers {
+			std::vector<u64> byRow;	 ///< Key of each row; reused as radix scratch.
+			std::vector<u8> nulls;
+			std::vector<u64> keys;
+			std::vector<u32> rows;
+			std::vector<u32> rowScratch;
+		};
+
+		template <ColumnType T>
+		void
+		ExtractKeys (const ResultSet& results, size_t column, u64 flip, SortBuffers& buffers, size_t threads) {
+			const size_t groups = results.GroupCount ();
+			ParallelFor (std::min (threads, groups), [&] (size_t t) {
+				for (size_t group = t; group < groups; group += threads) {
+					const ColumnChunkView chunk = results.Chunk (group, column);
+					u64* keys = buffers.byRow.data () + chunk.firstRow;
+					u8* nulls = buffers.nulls.data () + chunk.firstRow;
+					for (size_t i = 0; i < chunk.rows; ++i) {
+						nulls [i] = chunk.IsNull (i);
+						keys [i] = nulls [i] ? 0 : KeyOf<T>::Get (chunk, i) ^ flip;
+					}
+				}
+			});
+		}
+
+		/**
+		 * @brief Stable ascending LSD radix sort of @p keys, carrying @p rows along.
+		 * Digits on which all keys agree are skipped, so narrow ranges take few passes.
+		 */
+		bool
+		RadixSort (std::span<u64> keys,
+				   std::span<u32> rows,
+				   std::span<u64> keyScratch,
+				   std::span<u32> rowScratch,
+				   size_t threads,
+				   const std::stop_token& stop) {
+			const size_t count = keys.size ();
+			if (count < 2) return true;
+			if (count < kParallelRows) threads = 1;
+
+			std::vector<u64> differs (threads, 0);
+			ParallelFor (threads, [&] (size_t t) {
+				const auto [begin, end] = SegmentOf (count, threads, t);
+				u64 bits = 0;
+				for (size_t i = begin; i < end; ++i) bits |= keys [i] ^ keys [0];
+				differs [t] = bits;
+			});
+			const u64 varying = std::reduce (differs.begin (), differs.end (), u64{0}, std::bit_or<> ());
+
+			std::span<u64> srcKeys = keys, dstKeys = keyScratch.first (count);
+			std::span<u32> srcRows = rows, dstRows = rowScratch.first (count);
+			std::vector<std::array<size_t, kBuckets>> offsets (threads);
+			for (unsigned shift = 0; shift < 64; shift += kDigitBits) {
+				if (((varying >> shift) & (kBuckets - 1)) == 0) continue;
+				if (stop.stop_requested ()) return false;
+
+				ParallelFor (threads, [&] (size_t t) {
+					const auto [begin, end] = SegmentOf (count, threads, t);
+					offsets [t].fill (0);
+					for (size_t i = begin; i < end; ++i) ++offsets [t][(srcKeys [i] >> shift) & (kBuckets - 1)];
+				});
+				// Bucket-major, then thread order, keeps equal digits in their previous order.
+				size_t total = 0;
+				for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+					for (size_t t = 0; t < threads; ++t) {
+						const size_t n = offsets [t][bucket];
+						offsets [t][bucket] = total;
+						total += n;
+					}
+				}
+				ParallelFor (threads, [&] (size_t t) {
+					const auto [begin, end] = SegmentOf (count, threads, t);
+					std::array<size_t, kBuckets>& next = offsets [t];
+					for (size_t i = begin; i < end; ++i) {
+						const size_t at = next [(srcKeys [i] >> shift) & (kBuckets - 1)]++;
+						dstKeys [at] = srcKeys [i];
+						dstRows [at] = srcRows [i];
+					}
+				});
+				std::swap (srcKeys, dstKeys);
+				std::swap (srcRows, dstRows);
+			}
+			if (srcKeys.data () != keys.data ()) {
+				std::ranges::copy (srcKeys, keys.begin ());
+				std::ranges::copy (srcRows, rows.begin ());
+			}
+			return true;
+		}
+
+		struct TextRun {
+			size_t begin;
+			size_t end;
+			size_t depth;  ///< Leading bytes known to be equal across the run.
+		};
+
+		/**
+		 * @brief Orders the rows of tied text runs. Keys and scratch are only touched inside
+		 * each run's [begin, end), so different runs can be refined on different threads.
+		 */
+		class TextRefiner {
+		public:
+			TextRefiner (const ResultSet& results,
+						 size_t column,
+						 bool descending,
+						 std::span<u64> keys,
+						 std::span<u32> rows,
+						 SortBuffers& buffers)
+				: m_results (results), m_column (column), m_descending (descending),
+				  m_flip (descending ? ~u64{0} : 0), m_keys (keys), m_rows (rows), m_buffers (buffers) {}
+
+			/// Appends the runs of equal keys within [begin, end) to @p runs.
+			void
+			Ties (size_t begin, size_t end, size_t depth, std::vector<TextRun>& runs) const {
+				for (size_t i = begin; i < end;) {
+					size_t j = i + 1;
+					while (j < end && m_keys [j] == m_keys [i]) ++j;
+					if (j - i > 1) runs.push_back ({i, j, depth});
+					i = j;
+				}
+			}
+
+			/**
+			 * @brief Sort @p run on its next eight bytes; pushes the runs still tied.
+			 * Once every string ends within those bytes, a stable pass on length followed by
+			 * one on the bytes orders the run exactly and nothing is pushed.
+			 */
+			bool
+			Refine (const TextRun& run, std::vector<TextRun>& runs, size_t threads, const std::stop_token& stop) {
+				const size_t count = run.end - run.begin;
+				const std::span<u64> keys = m_keys.subspan (run.begin, count);
+				const std::span<u32> rows = m_rows.subspan (run.begin, count);
+				const std::span<u64> keyScratch = std::span (m_buffers.byRow).subspan (run.begin, count);
+				const std::span<u32> rowScratch = std::span (m_buffers.rowScratch).subspan (run.begin, count);
+
+				size_t shortest = std::numeric_limits<size_t>::max ();
+				size_t longest = 0;
+				for (size_t i = 0; i < count; ++i) {
+					const size_t size = Text (rows [i]).size ();
+					shortest = std::min (shortest, size);
+					longest = std::max (longest, size);
+					keys [i] = size ^ m_flip;
+				}
+				const bool last = longest <= run.depth + kPrefixBytes;
+				if (last && shortest != longest && !RadixSort (keys, rows, keyScratch, rowScratch, threads, stop)) {
+					return false;
+				}
+				for (size_t i = 0; i < count; ++i) keys [i] = Prefix (Text (rows [i]), run.depth) ^ m_flip;
+				if (!RadixSort (keys, rows, keyScratch, rowScratch, threads, stop)) return false;
+				if (!last) Ties (run.begin, run.end, run.depth + kPrefixBytes, runs);
+				return true;
+			}
+
+			/// Compare a small run in full, reading each string once.
+			void
+			SortSmall (const TextRun& run, std::vector<std::pair<std::string_view, u32>>& cells) const {
+				cells.clear ();
+				bool sameSize = true;
+				for (size_t i = run.begin; i < run.end; ++i) {
+					cells.emplace_back (Text (m_rows [i]), m_rows [i]);
+					sameSize = sameSize && cells.back ().first.size () == cells.front ().first.size ();
+				}
+				// Same size and no bytes past the compared prefix: all equal, already in order.
+				if (sameSize && cells.front ().first.size () <= run.depth) return;
+				std::ranges::stable_sort (cells, [this] (const auto& a, const auto& b) {
+					return m_descending ? b.first < a.first : a.first < b.first;
+				});
+				for (size_t i = run.begin; i < run.end; ++i) m_rows [i] = cells [i - run.begin].second;
+			}
+
+		private:
+			std::string_view
+			Text (u32 row) const {
+				return m_results.Text (row, m_column);
+			}
+
+			const ResultSet& m_results;
+			size_t m_column;
+			bool m_descending;
+			u64 m_flip;
+			std::span<u64> m_keys;
+			std::span<u32> m_rows;
+			SortBuffers& m_buffers;
+		};
+
+		/**
+		 * @brief Order the runs of rows whose first eight text bytes tied.
+		 * @p keys / @p rows hold the non-null rows already sorted on those bytes. Runs too
+		 * large for one core are refined one at a time with every thread; the rest are
+		 * dealt out to the threads, which then refine them to the end on their own.
+		 */
+		bool
+		RefineText (const ResultSet& results,
+					size_t column,
+					bool descending,
+					std::span<u64> keys,
+					std::span<u32> rows,
+					SortBuffers& buffers,
+					size_t threads,
+					const std::stop_token& stop) {
+			TextRefiner refiner (results, column, descending, keys, rows, buffers);
+			std::vector<TextRun> runs;
+			refiner.Ties (0, keys.size (), kPrefixBytes, runs);
+
+			std::vector<TextRun> rest;
+			while (!runs.empty ()) {
+				const TextRun run = runs.back ();
+				runs.pop_back ();
+				if (run.end - run.begin < kParallelRows) {
+					rest.push_back (run);
+				}
+				else if (!refiner.Refine (run, runs, threads, stop)) {
+					return false;
+				}
+			}
+
+			std::atomic<bool> stopped{false};
+			ParallelFor (std::min (threads, rest.size ()), [&] (size_t t) {
+				std::vector<TextRun> stack;
+				std::vector<std::pair<std::string_view, u32>> cells;
+				for (size_t i = t; i < rest.size (); i += threads) {
+					stack.push_back (rest [i]);
+					while (!stack.empty ()) {
+						const TextRun run = stack.back ();
+						stack.pop_back ();
+						if (run.end - run.begin <= kSmallRun) {
+							refiner.SortSmall (run, cells);
+						}
+						else if (!refiner.Refine (run, stack, 1, stop)) {
+							stopped = true;
+							return;
+						}
+					}
+				}
+			});
+			return !stopped;
+		}
+
+		bool
+		SortColumn (const ResultSet& results,
+					const SortKey& key,
+					std::vector<u32>& order,
+					SortBuffers& buffers,
+					size_t threads,
+					const std::stop_token& stop) {
+			const ColumnType type = results.Type (key.column);
+			if (type == ColumnType::Null) return true;
+
+			const u64 flip = key.descending ? ~u64{0} : 0;
+			switch (type) {
+				case ColumnType::Integer: ExtractKeys<ColumnType::Integer> (results, key.column, flip, buffers, threads); break;
+				case ColumnType::Real: ExtractKeys<ColumnType::Real> (results, key.column, flip, buffers, threads); break;
+				case ColumnType::Text: ExtractKeys<ColumnType::Text> (results, key.column, flip, buffers, threads); break;
+				case ColumnType::Blob: ExtractKeys<ColumnType::Blob> (results, key.column, flip, buffers, threads); break;
+				case ColumnType::Null: break;
+			}
+			if (stop.stop_requested ()) return false;
+
+			// Gather keys in the current order, non-null rows in front and NULL rows at the
+			// back, both stable.
+			const size_t count = order.size ();
+			const size_t workers = count < kParallelRows ? 1 : threads;
+			std::vector<size_t> nullsBefore (workers + 1, 0);
+			ParallelFor (workers, [&] (size_t t) {
+				const auto [begin, end] = SegmentOf (count, workers, t);
+				size_t n = 0;
+				for (size_t i = begin; i < end; ++i) n += buffers.nulls [order [i]];
+				nullsBefore [t + 1] = n;
+			});
+			std::partial_sum (nullsBefore.begin (), nullsBefore.end (), nullsBefore.begin ());
+			const size_t values = count - nullsBefore.back ();
+			ParallelFor (workers, [&] (size_t t) {
+				const auto [begin, end] = SegmentOf (count, workers, t);
+				size_t nullAt = values + nullsBefore [t];
+				size_t valueAt = begin - nullsBefore [t];
+				for (size_t i = begin; i < end; ++i) {
+					const u32 row = order [i];
+					if (buffers.nulls [row]) {
+						buffers.rows [nullAt++] = row;
+					}
+					else {
+						buffers.keys [valueAt] = buffers.byRow [row];
+						buffers.rows [valueAt++] = row;
+					}
+				}
+			});
+
+			const std::span<u64> keys = std::span (buffers.keys).first (values);
+			const std::span<u32> rows = std::span (buffers.rows).first (values);
+			if (!RadixSort (keys, rows, buffers.byRow, buffers.rowScratch, threads, stop)) return false;
+			if ((type == ColumnType::Text || type == ColumnType::Blob) &&
+				!RefineText (results, key.column, key.descending, keys, rows, buffers, threads, stop)) {
+				return false;
+			}
+
+			// SQLite orders NULL below every value.
+			const auto nulls = std::span (buffers.rows).subspan (values, count - values);
+			if (key.descending) {
+				std::ranges::copy (rows, order.begin ());
+				std::ranges::copy (nulls, order.begin () + static_cast<std::ptrdiff_t> (values));
+			}
+			else {
+				std::ranges::copy (nulls, order.begin ());
+				std::ranges::copy (rows, order.begin () + static_cast<std::ptrdiff_t> (count - values));
+			}
+			return true;
+		}
+
+	}  // namespace
+
+	std::optional<std::vector<u32>>
+	SortRows (const ResultSet& results, std::span<const SortKey> keys, std::stop_token stop, size_t threads) {
+		const size_t count = results.RowCount ();
+		if (count > RowTask::kMaxRows) return std::nullopt;
+		threads = ThreadCount (threads);
+
+		std::vector<u32> order (count);
+		std::iota (order.begin (), order.end (), u32{0});
+		if (keys.empty () || count < 2) return order;
+
+		SortBuffers buffers;
+		buffers.byRow.resize (count);
+		buffers.nulls.resize (count);
+		buffers.keys.resize (count);
+		buffers.rows.resize (count);
+		buffers.rowScratch.resize (count);
+		for (auto key = keys.rbegin (); key != keys.rend (); ++key) {
+			if (key->column >= results.ColumnCount ()) continue;
+			if (!SortColumn (results, *key, order, buffers, threads, stop)) return std::nullopt;
+		}
+		return order;
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "result_set.h"
+
+#include <macro.h>
+
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+namespace ambidb::db {
+
+	struct SortKey {
+		size_t column{0};
+		bool descending{false};
+	};
+
+	/**
+	 * @brief Row order of @p results under @p keys: row order [i] is shown at position i.
+	 *
+	 * Keys are applied least significant first, each with a stable sort, so earlier keys win
+	 * and full ties keep result order. Integer and Real columns are LSD radix sorted on
+	 * order-preserving u64 keys. Text and Blob columns are radix sorted on their first eight
+	 * bytes (bytewise, like SQLite's BINARY collation); runs that tie on that prefix are
+	 * sorted again on the next eight bytes, and small runs are compared in full. NULLs come
+	 * first ascending and last descending, as in SQLite. Histograms, scatters and key
+	 * extraction are split across @p threads (0 = one per core).
+	 *
+	 * @return std::nullopt if @p stop is requested first, or if the result has more than
+	 * RowTask::kMaxRows rows. Run it through a RowTask to keep it off the UI thread.
+	 */
+	std::optional<std::vector<u32>>
+	SortRows (const ResultSet& results, std::span<const SortKey> keys, std::stop_token stop, size_t threads = 0);
+
+}  // namespace ambidb::db
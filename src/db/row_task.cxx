@@ -0,0 +1,44 @@
+#include "row_task.h"
+
+namespace ambidb::db {
+
+	RowTask::~RowTask () {
+		Cancel ();
+	}
+
+	void
+	RowTask::Start (Job job, std::function<void ()> notify) {
+		Cancel ();
+		m_running.store (true, std::memory_order_release);
+		m_thread = std::jthread ([this, job = std::move (job), notify = std::move (notify)] (std::stop_token stop) {
+			std::optional<std::vector<u32>> rows = job (stop);
+			if (rows) {
+				std::lock_guard lock (m_mutex);
+				m_result = std::move (rows);
+			}
+			m_running.store (false, std::memory_order_release);
+			if (notify) notify ();
+		});
+	}
+
+	void
+	RowTask::Cancel () {
+		if (m_thread.joinable ()) {
+			m_thread.request_stop ();
+			m_thread.join ();
+		}
+		m_running.store (false, std::memory_order_release);
+		std::lock_guard lock (m_mutex);
+		m_result.reset ();
+	}
+
+	bool
+	RowTask::TakeResult (std::vector<u32>& rows) {
+		std::lock_guard lock (m_mutex);
+		if (!m_result) return false;
+		rows = std::move (*m_result);
+		m_result.reset ();
+		return true;
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <macro.h>
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace ambidb::db {
+
+	/**
+	 * @brief Computes a list of row indices (a sort order, a filter selection) on a
+	 * background thread, one job at a time. Starting a job cancels the previous one.
+	 *
+	 * Whatever the job reads must not change until it finishes or Cancel () returns.
+	 */
+	class RowTask {
+	public:
+		/// Row lists are u32, which covers any result a grid holds in memory.
+		static constexpr size_t kMaxRows = std::numeric_limits<u32>::max ();
+
+		using Job = std::function<std::optional<std::vector<u32>> (std::stop_token)>;
+
+		MAKE_NONCOPYABLE (RowTask);
+		MAKE_NONMOVABLE (RowTask);
+		RowTask () = default;
+		~RowTask ();
+
+		/**
+		 * @brief Cancel any running job and start @p job. @p notify is called from the job's
+		 * thread when it ends; a job returning std::nullopt (cancelled) leaves no result.
+		 */
+		void
+		Start (Job job, std::function<void ()> notify);
+
+		/**
+		 * @brief Stop the running job, if any, wait for it, and drop any unclaimed result.
+		 */
+		void
+		Cancel ();
+
+		bool
+		Running () const {
+			return m_running.load (std::memory_order_acquire);
+		}
+
+		/**
+		 * @brief Hand over the rows of the last finished job. True once per job.
+		 */
+		bool
+		TakeResult (std::vector<u32>& rows);
+
+	private:
+		std::mutex m_mutex;
+		std::optional<std::vector<u32>> m_result;
+		std::atomic<bool> m_running{false};
+		std::jthread m_thread;	///< Last member: joined before the rest is destroyed.
+	};
+
+}  // namespace ambidb::db
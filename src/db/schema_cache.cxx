@@ -0,0 +1,526 @@
+#include "schema_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ambidb::db {
+
+	namespace {
+
+		constexpr std::string_view kSnapshotMagic = "AMBISCH1";
+
+		enum : u8 {
+			kExpanded = 1,
+			kLoaded = 2,
+		};
+
+		void
+		PutVarint (std::string& out, u64 value) {
+			while (value >= 0x80) {
+				out += static_cast<char> (value | 0x80);
+				value >>= 7;
+			}
+			out += static_cast<char> (value);
+		}
+
+		void
+		PutString (std::string& out, std::string_view text) {
+			PutVarint (out, text.size ());
+			out += text;
+		}
+
+		/// Reads what PutVarint () and PutString () wrote; once past the end, ok turns false.
+		struct SnapshotReader {
+			std::string_view data;
+			size_t position{0};
+			bool ok{true};
+
+			u64
+			Varint () {
+				u64 value = 0;
+				for (u32 shift = 0; shift < 64; shift += 7) {
+					if (position >= data.size ()) break;
+					const u8 byte = static_cast<u8> (data [position++]);
+					value |= static_cast<u64> (byte & 0x7f) << shift;
+					if (!(byte & 0x80)) return value;
+				}
+				ok = false;
+				return 0;
+			}
+
+			/// A count of items at least @p itemBytes each, checked against what is left.
+			size_t
+			Count (size_t itemBytes) {
+				const u64 count = Varint ();
+				if (count > (data.size () - position) / itemBytes) ok = false;
+				return ok ? static_cast<size_t> (count) : 0;
+			}
+
+			u8
+			Byte () {
+				if (position >= data.size ()) {
+					ok = false;
+					return 0;
+				}
+				return static_cast<u8> (data [position++]);
+			}
+
+			std::string
+			String () {
+				const size_t size = Count (1);
+				if (!ok) return {};
+				std::string text (data.substr (position, size));
+				position += size;
+				return text;
+			}
+		};
+
+		/// Merge @p entries into @p old by name: same-named nodes keep their state and children.
+		template <typename Node>
+		std::vector<Node>
+		MergeByName (std::vector<Node>& old, std::vector<CatalogEntry>& entries) {
+			std::unordered_map<std::string_view, size_t> byName;
+			byName.reserve (old.size ());
+			for (size_t i = 0; i < old.size (); ++i) byName.emplace (old [i].entry.name, i);
+			std::vector<Node> merged;
+			merged.reserve (entries.size ());
+			for (CatalogEntry& entry : entries) {
+				Node& node = merged.emplace_back ();
+				if (const auto it = byName.find (entry.name); it != byName.end ()) node = std::move (old [it->second]);
+				node.entry = std::move (entry);
+			}
+			return merged;
+		}
+
+		template <typename Node>
+		Node*
+		FindByName (std::vector<Node>& nodes, std::string_view name) {
+			const auto it = std::ranges::find (nodes, name, [] (const Node& node) -> std::string_view { return node.entry.name; });
+			return it != nodes.end () ? &*it : nullptr;
+		}
+
+		/// Children loaded for an older state than the node's current marker.
+		template <typename Node>
+		bool
+		Stale (const Node& node) {
+			return node.loaded && (node.entry.marker == 0 || node.entry.marker != node.loadedMarker);
+		}
+
+	}  // namespace
+
+	std::shared_ptr<SchemaCache>
+	SchemaCache::Open (std::filesystem::path snapshot, std::function<void ()> notify) {
+		std::shared_ptr<SchemaCache> cache (new SchemaCache (std::move (snapshot), std::move (notify)));
+		if (!cache->m_snapshot.empty ()) {
+			std::ifstream in (cache->m_snapshot, std::ios::binary);
+			const std::string data ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+			// A missing or damaged snapshot only means starting from the database.
+			if (!data.empty () && !cache->Deserialize (data)) cache->m_schemas.clear ();
+		}
+		return cache;
+	}
+
+	std::string
+	SchemaCache::SnapshotName (const ConnectionParams& params) {
+		u64 hash = 14695981039346656037ull;
+		for (const char c : params.target) hash = (hash ^ static_cast<u8> (c)) * 1099511628211ull;
+		char name [64];
+		std::snprintf (name, sizeof (name), "%.16s-%016llx.schema", params.driver.c_str (), static_cast<unsigned long long> (hash));
+		return name;
+	}
+
+	SchemaCache::SchemaCache (std::filesystem::path snapshot, std::function<void ()> notify)
+		: m_snapshot (std::move (snapshot)), m_notify (std::move (notify)) {
+		if (!m_snapshot.empty ()) {
+			m_writer = std::jthread ([this] (std::stop_token stop) { WriteLoop (stop); });
+		}
+	}
+
+	bool
+	SchemaCache::Loaded () const {
+		std::lock_guard lock (m_mutex);
+		return m_loaded;
+	}
+
+	bool
+	SchemaCache::Busy () const {
+		std::lock_guard lock (m_mutex);
+		return m_jobs > 0;
+	}
+
+	std::string
+	SchemaCache::Error () const {
+		std::lock_guard lock (m_mutex);
+		return m_error;
+	}
+
+	void
+	SchemaCache::Rows (std::vector<Row>& rows) const {
+		rows.clear ();
+		std::lock_guard lock (m_mutex);
+		for (u32 s = 0; s < m_schemas.size (); ++s) {
+			const Schema& schema = m_schemas [s];
+			rows.push_back ({0, s, kNone, schema.entry.name, schema.entry.detail, true, schema.expanded, schema.expanded && schema.loading});
+			if (!schema.expanded) continue;
+			for (u32 t = 0; t < schema.tables.size (); ++t) {
+				const Table& table = schema.tables [t];
+				rows.push_back ({1, s, t, table.entry.name, table.entry.detail, true, table.expanded, table.expanded && table.loading});
+				if (!table.expanded) continue;
+				for (const CatalogEntry& column : table.columns) rows.push_back ({2, s, t, column.name, column.detail});
+			}
+		}
+	}
+
+	std::optional<CatalogPath>
+	SchemaCache::Toggle (u32 schema, u32 table, bool canLoad) {
+		std::lock_guard lock (m_mutex);
+		if (schema >= m_schemas.size () || (table != kNone && table >= m_schemas [schema].tables.size ())) return std::nullopt;
+		const auto toggle = [&] (auto& node, CatalogPath path) -> std::optional<CatalogPath> {
+			std::optional<CatalogPath> load;
+			const bool expanded = node.expanded;
+			if (node.expanded) {
+				node.expanded = false;
+			}
+			else if (node.loaded || node.loading) {
+				node.expanded = true;
+			}
+			else if (canLoad) {
+				node.expanded = true;
+				node.loading = true;
+				++m_jobs;
+				load = std::move (path);
+			}
+			m_generation.fetch_add (1, std::memory_order_acq_rel);
+			// The tree as left is what a reopened client shows, so the snapshot keeps it too.
+			if (node.expanded != expanded) ScheduleSnapshot ();
+			return load;
+		};
+		Schema& parent = m_schemas [schema];
+		if (table == kNone) return toggle (parent, {parent.entry.name, {}});
+		return toggle (parent.tables [table], {parent.entry.name, parent.tables [table].entry.name});
+	}
+
+	void
+	SchemaCache::Visit (const std::function<void (u32 depth, const CatalogEntry& entry, bool loaded)>& visit) const {
+		std::lock_guard lock (m_mutex);
+		for (const Schema& schema : m_schemas) {
+			visit (0, schema.entry, schema.loaded);
+			for (const Table& table : schema.tables) {
+				visit (1, table.entry, table.loaded);
+				for (const CatalogEntry& column : table.columns) visit (2, column, true);
+			}
+		}
+	}
+
+	std::optional<CatalogPath>
+	SchemaCache::Require (std::string_view schema, std::string_view table) {
+		std::lock_guard lock (m_mutex);
+		Schema* parent = FindByName (m_schemas, schema);
+		if (!parent) return std::nullopt;
+		const auto require = [&] (auto& node) -> std::optional<CatalogPath> {
+			if (node.loaded || node.loading) return std::nullopt;
+			node.loading = true;
+			++m_jobs;
+			return CatalogPath{std::string (schema), std::string (table)};
+		};
+		if (table.empty ()) return require (*parent);
+		Table* found = FindByName (parent->tables, table);
+		return found ? require (*found) : std::nullopt;
+	}
+
+	void
+	SchemaCache::Reveal (std::string_view schema, std::string_view table) {
+		std::lock_guard lock (m_mutex);
+		Schema* parent = FindByName (m_schemas, schema);
+		if (!parent) return;
+		bool changed = false;
+		const auto expand = [&] (auto& node) {
+			if (node.expanded || !node.loaded) return;
+			node.expanded = true;
+			changed = true;
+		};
+		expand (*parent);
+		if (!table.empty ()) {
+			if (Table* found = FindByName (parent->tables, table)) expand (*found);
+		}
+		if (!changed) return;
+		m_generation.fetch_add (1, std::memory_order_acq_rel);
+		ScheduleSnapshot ();
+	}
+
+	void
+	SchemaCache::Queued () {
+		std::lock_guard lock (m_mutex);
+		++m_jobs;
+	}
+
+	DbResult<void>
+	SchemaCache::Load (Connection& connection, const CatalogPath& path) {
+		DbResult<std::vector<CatalogEntry>> entries = path.schema.empty () ? connection.ListSchemas ()
+													  : path.table.empty ()	 ? connection.ListTables (path.schema)
+																			 : connection.ListColumns (path.schema, path.table);
+		{
+			std::lock_guard lock (m_mutex);
+			if (!entries) {
+				EndJob (entries.error ().message);
+			}
+			else {
+				if (path.schema.empty ()) {
+					SetSchemas (std::move (*entries));
+				}
+				else if (path.table.empty ()) {
+					SetTables (path.schema, std::move (*entries));
+				}
+				else {
+					SetColumns (path.schema, path.table, std::move (*entries));
+				}
+				EndJob ({});
+			}
+		}
+		Changed ();
+		if (!entries) return std::unexpected (entries.error ());
+		return {};
+	}
+
+	DbResult<void>
+	SchemaCache::Refresh (Connection& connection, const std::function<bool ()>& cancelled) {
+		const auto fail = [&] (DbError error) -> DbResult<void> {
+			{
+				std::lock_guard lock (m_mutex);
+				EndJob (error.message);
+			}
+			Changed ();
+			return std::unexpected (std::move (error));
+		};
+
+		DbResult<std::vector<CatalogEntry>> schemas = connection.ListSchemas ();
+		if (!schemas) return fail (std::move (schemas.error ()));
+		// Loaded schemas, and whether their table list is stale.
+		std::vector<std::pair<std::string, bool>> loaded;
+		{
+			std::lock_guard lock (m_mutex);
+			SetSchemas (std::move (*schemas));
+			for (const Schema& schema : m_schemas) {
+				if (schema.loaded) loaded.emplace_back (schema.entry.name, Stale (schema));
+			}
+		}
+		Changed ();
+
+		std::vector<std::string> tables;
+		for (const auto& [schema, stale] : loaded) {
+			if (cancelled && cancelled ()) return fail (DbError{"Cancelled"});
+			if (stale) {
+				DbResult<std::vector<CatalogEntry>> entries = connection.ListTables (schema);
+				if (!entries) return fail (std::move (entries.error ()));
+				std::lock_guard lock (m_mutex);
+				SetTables (schema, std::move (*entries));
+			}
+			// Tables of an unchanged schema may still be stale from an interrupted refresh.
+			tables.clear ();
+			{
+				std::lock_guard lock (m_mutex);
+				if (Schema* found = FindByName (m_schemas, schema)) {
+					for (const Table& table : found->tables) {
+						if (Stale (table)) tables.push_back (table.entry.name);
+					}
+				}
+			}
+			for (const std::string& table : tables) {
+				if (cancelled && cancelled ()) return fail (DbError{"Cancelled"});
+				DbResult<std::vector<CatalogEntry>> entries = connection.ListColumns (schema, table);
+				if (!entries) return fail (std::move (entries.error ()));
+				std::lock_guard lock (m_mutex);
+				SetColumns (schema, table, std::move (*entries));
+			}
+			if (stale || !tables.empty ()) Changed ();
+		}
+
+		{
+			std::lock_guard lock (m_mutex);
+			EndJob ({});
+		}
+		Changed ();
+		return {};
+	}
+
+	void
+	SchemaCache::Fail (std::string error) {
+		{
+			std::lock_guard lock (m_mutex);
+			EndJob (std::move (error));
+		}
+		Changed ();
+	}
+
+	void
+	SchemaCache::SetSchemas (std::vector<CatalogEntry> entries) {
+		m_schemas = MergeByName (m_schemas, entries);
+		m_loaded = true;
+	}
+
+	void
+	SchemaCache::SetTables (const std::string& schema, std::vector<CatalogEntry> entries) {
+		Schema* found = FindByName (m_schemas, schema);
+		if (!found) return;
+		found->tables = MergeByName (found->tables, entries);
+		found->loaded = true;
+		found->loading = false;
+		found->loadedMarker = found->entry.marker;
+	}
+
+	void
+	SchemaCache::SetColumns (const std::string& schema, const std::string& table, std::vector<CatalogEntry> entries) {
+		Schema* parent = FindByName (m_schemas, schema);
+		Table* found = parent ? FindByName (parent->tables, table) : nullptr;
+		if (!found) return;
+		found->columns = std::move (entries);
+		found->loaded = true;
+		found->loading = false;
+		found->loadedMarker = found->entry.marker;
+	}
+
+	void
+	SchemaCache::EndJob (std::string error) {
+		if (m_jobs > 0) --m_jobs;
+		m_error = std::move (error);
+		if (m_jobs > 0) return;
+		// Nothing left to fill in what is still marked loading; it can be asked for again.
+		for (Schema& schema : m_schemas) {
+			if (schema.loading && !schema.loaded) schema.expanded = false;
+			schema.loading = false;
+			for (Table& table : schema.tables) {
+				if (table.loading && !table.loaded) table.expanded = false;
+				table.loading = false;
+			}
+		}
+	}
+
+	void
+	SchemaCache::Changed () {
+		m_content.fetch_add (1, std::memory_order_acq_rel);
+		m_generation.fetch_add (1, std::memory_order_acq_rel);
+		ScheduleSnapshot ();
+		if (m_notify) m_notify ();
+	}
+
+	void
+	SchemaCache::ScheduleSnapshot () {
+		if (m_snapshot.empty ()) return;
+		{
+			std::lock_guard lock (m_snapshotMutex);
+			m_dirty = true;
+		}
+		m_snapshotWake.notify_one ();
+	}
+
+	void
+	SchemaCache::WriteLoop (std::stop_token stop) {
+		while (true) {
+			{
+				std::unique_lock lock (m_snapshotMutex);
+				// On stop, a pending change is still written before the thread ends.
+				if (!m_snapshotWake.wait (lock, stop, [this] { return m_dirty; })) return;
+				// Let the rest of a burst arrive; stopping cuts the wait short.
+				m_snapshotWake.wait_for (lock, stop, kSnapshotDelay, [] { return false; });
+				m_dirty = false;
+			}
+			WriteSnapshot ();
+		}
+	}
+
+	void
+	SchemaCache::WriteSnapshot () {
+		std::string data;
+		{
+			std::lock_guard lock (m_mutex);
+			data = Serialize ();
+		}
+		// Written aside, synced and renamed, so a crash leaves the old snapshot or the new one.
+		const std::filesystem::path temp = m_snapshot.string () + ".tmp";
+		std::error_code ec;
+		std::filesystem::create_directories (m_snapshot.parent_path (), ec);
+		const int fd = open (temp.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) return;
+		bool ok = true;
+		for (size_t written = 0; ok && written < data.size ();) {
+			const ssize_t n = write (fd, data.data () + written, data.size () - written);
+			if (n < 0 && errno == EINTR) continue;
+			ok = n > 0;
+			if (ok) written += static_cast<size_t> (n);
+		}
+		ok = ok && fdatasync (fd) == 0;
+		ok = close (fd) == 0 && ok;
+		if (ok) {
+			std::filesystem::rename (temp, m_snapshot, ec);
+		}
+		else {
+			std::filesystem::remove (temp, ec);
+		}
+	}
+
+	std::string
+	SchemaCache::Serialize () const {
+		std::string out (kSnapshotMagic);
+		const auto putEntry = [&out] (const CatalogEntry& entry) {
+			PutString (out, entry.name);
+			PutString (out, entry.detail);
+			PutVarint (out, entry.marker);
+		};
+		PutVarint (out, m_schemas.size ());
+		for (const Schema& schema : m_schemas) {
+			putEntry (schema.entry);
+			PutVarint (out, schema.loadedMarker);
+			out += static_cast<char> ((schema.expanded ? kExpanded : 0) | (schema.loaded ? kLoaded : 0));
+			PutVarint (out, schema.tables.size ());
+			for (const Table& table : schema.tables) {
+				putEntry (table.entry);
+				PutVarint (out, table.loadedMarker);
+				out += static_cast<char> ((table.expanded ? kExpanded : 0) | (table.loaded ? kLoaded : 0));
+				PutVarint (out, table.columns.size ());
+				for (const CatalogEntry& column : table.columns) putEntry (column);
+			}
+		}
+		return out;
+	}
+
+	bool
+	SchemaCache::Deserialize (std::string_view data) {
+		if (!data.starts_with (kSnapshotMagic)) return false;
+		SnapshotReader in{data, kSnapshotMagic.size ()};
+		const auto readEntry = [&in] (CatalogEntry& entry) {
+			entry.name = in.String ();
+			entry.detail = in.String ();
+			entry.marker = in.Varint ();
+		};
+		// Each entry takes at least its two string sizes and its marker.
+		constexpr size_t kMinEntry = 3;
+		m_schemas.resize (in.Count (kMinEntry + 3));
+		for (Schema& schema : m_schemas) {
+			readEntry (schema.entry);
+			schema.loadedMarker = in.Varint ();
+			const u8 flags = in.Byte ();
+			schema.expanded = flags & kExpanded;
+			schema.loaded = flags & kLoaded;
+			schema.tables.resize (in.Count (kMinEntry + 3));
+			for (Table& table : schema.tables) {
+				readEntry (table.entry);
+				table.loadedMarker = in.Varint ();
+				const u8 tableFlags = in.Byte ();
+				table.expanded = tableFlags & kExpanded;
+				table.loaded = tableFlags & kLoaded;
+				table.columns.resize (in.Count (kMinEntry));
+				for (CatalogEntry& column : table.columns) readEntry (column);
+			}
+		}
+		m_loaded = in.ok;
+		return in.ok;
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "driver.h"
+
+#include <macro.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ambidb::db {
+
+	/// A level of the catalog to load: the schema list, a schema's tables or a table's columns.
+	struct CatalogPath {
+		std::string schema;	 ///< Empty: the schema list.
+		std::string table;	 ///< Empty: the tables of schema.
+	};
+
+	/**
+	 * @brief The catalog of one connection, as far as it has been browsed, kept on disk.
+	 *
+	 * Levels load lazily: the schema list first, then a schema's tables when it is
+	 * expanded, then a table's columns. Changes are written to a compact snapshot, and
+	 * Open () reads it back, so a reopened client shows the tree it had at once, before
+	 * the connection is even up. A writer thread batches the writes: it waits
+	 * kSnapshotDelay after a change for more to arrive, so a burst of level loads on a
+	 * large catalog costs one write, and it writes whatever is pending when the cache goes.
+	 *
+	 * Refresh () brings a loaded tree up to date from the entries' change markers: it lists
+	 * the schemas, and only refetches the tables of a schema whose marker moved, and only
+	 * the columns of a table whose marker moved. Entries of drivers without markers (0)
+	 * are always refetched.
+	 *
+	 * Load () and Refresh () run on a database worker (QueryExecutor::LoadCatalog () and
+	 * RefreshCatalog ()); everything else is called from the UI thread. Fetches happen
+	 * without the lock, which is only taken to swap results in.
+	 */
+	class SchemaCache {
+	public:
+		static constexpr u32 kNone = ~u32{0};
+		static constexpr std::chrono::milliseconds kSnapshotDelay{1000};
+
+		/// A line of the tree as shown: a schema, a table or a column.
+		struct Row {
+			u32 depth{0};
+			u32 schema{0};
+			u32 table{kNone};  ///< kNone on schema rows.
+			std::string name;
+			std::string detail;
+			bool expandable{false};
+			bool expanded{false};
+			bool loading{false};  ///< Expanded, with its children still being fetched.
+		};
+
+		MAKE_NONCOPYABLE (SchemaCache);
+		MAKE_NONMOVABLE (SchemaCache);
+
+		/**
+		 * @brief A cache backed by @p snapshot, loaded from it if it exists. An empty path
+		 * keeps the cache in memory. @p notify is called from the worker after each change.
+		 */
+		static std::shared_ptr<SchemaCache>
+		Open (std::filesystem::path snapshot, std::function<void ()> notify = {});
+
+		/// Snapshot file name for a connection, stable across runs.
+		static std::string
+		SnapshotName (const ConnectionParams& params);
+
+		/// Bumped on every change, expanding and collapsing included.
+		u64
+		Generation () const {
+			return m_generation.load (std::memory_order_acquire);
+		}
+
+		/// Bumped when entries are loaded, refreshed or fail to load; not by Toggle ().
+		u64
+		ContentGeneration () const {
+			return m_content.load (std::memory_order_acquire);
+		}
+
+		/// The schema list is known, from the snapshot or the database.
+		bool
+		Loaded () const;
+
+		/// A load or refresh is queued or running.
+		bool
+		Busy () const;
+
+		/// Why the last load or refresh failed; empty once one succeeds.
+		std::string
+		Error () const;
+
+		/// Replace @p rows with the expanded part of the tree, in order.
+		void
+		Rows (std::vector<Row>& rows) const;
+
+		/**
+		 * @brief Expand or collapse a schema (@p table = kNone) or a table. Expanding a
+		 * level not loaded yet marks it loading and returns it; the caller must hand it to
+		 * LoadCatalog (). With @p canLoad false (not connected) such a level stays collapsed.
+		 */
+		std::optional<CatalogPath>
+		Toggle (u32 schema, u32 table, bool canLoad);
+
+		/**
+		 * @brief Call @p visit for every entry held, depth first: each schema, its tables,
+		 * their columns. @p loaded tells whether a schema's tables or a table's columns are
+		 * known. Holds the lock, so @p visit must not call back into the cache.
+		 */
+		void
+		Visit (const std::function<void (u32 depth, const CatalogEntry& entry, bool loaded)>& visit) const;
+
+		/**
+		 * @brief Toggle () without expanding, by name: start loading a schema's tables (empty
+		 * @p table) or a table's columns unless they are loaded or loading, and return what
+		 * to hand to LoadCatalog ().
+		 */
+		std::optional<CatalogPath>
+		Require (std::string_view schema, std::string_view table);
+
+		/**
+		 * @brief Expand @p schema, and @p table in it unless empty, so the entries under
+		 * them show, e.g. to bring a search hit into view. Levels not loaded stay collapsed.
+		 */
+		void
+		Reveal (std::string_view schema, std::string_view table);
+
+		/// UI: a refresh was queued; Busy () until it ends.
+		void
+		Queued ();
+
+		/// Worker: fetch the level @p path names.
+		DbResult<void>
+		Load (Connection& connection, const CatalogPath& path);
+
+		/// Worker: refetch every loaded level whose marker changed.
+		DbResult<void>
+		Refresh (Connection& connection, const std::function<bool ()>& cancelled = {});
+
+		/// Worker: a queued job could not run, e.g. the connection is closed.
+		void
+		Fail (std::string error);
+
+	private:
+		struct Table {
+			CatalogEntry entry;
+			u64 loadedMarker{0};  ///< entry.marker when columns were fetched.
+			bool expanded{false};
+			bool loaded{false};
+			bool loading{false};
+			std::vector<CatalogEntry> columns;
+		};
+
+		struct Schema {
+			CatalogEntry entry;
+			u64 loadedMarker{0};  ///< entry.marker when tables were fetched.
+			bool expanded{false};
+			bool loaded{false};
+			bool loading{false};
+			std::vector<Table> tables;
+		};
+
+		SchemaCache (std::filesystem::path snapshot, std::function<void ()> notify);
+
+		// Swap fetched entries in; under m_mutex.
+		void
+		SetSchemas (std::vector<CatalogEntry> entries);
+		void
+		SetTables (const std::string& schema, std::vector<CatalogEntry> entries);
+		void
+		SetColumns (const std::string& schema, const std::string& table, std::vector<CatalogEntry> entries);
+		/// A job ended; the last one clears any loading marks left. Under m_mutex.
+		void
+		EndJob (std::string error);
+		/// Bump both generations, schedule a snapshot write and notify.
+		void
+		Changed ();
+		/// Have the writer write the snapshot after kSnapshotDelay.
+		void
+		ScheduleSnapshot ();
+		void
+		WriteLoop (std::stop_token stop);
+		/// Serialize the tree and replace the snapshot file with it.
+		void
+		WriteSnapshot ();
+		std::string
+		Serialize () const;
+		bool
+		Deserialize (std::string_view data);
+
+		std::filesystem::path m_snapshot;
+		std::function<void ()> m_notify;
+
+		mutable std::mutex m_mutex;
+		std::vector<Schema> m_schemas;
+		bool m_loaded{false};
+		u32 m_jobs{0};	///< Queued or running loads and refreshes.
+		std::string m_error;
+
+		std::atomic<u64> m_generation{0};
+		std::atomic<u64> m_content{0};
+
+		std::mutex m_snapshotMutex;
+		std::condition_variable_any m_snapshotWake;
+		bool m_dirty{false};  ///< Under m_snapshotMutex: a change is not written yet.
+		std::jthread m_writer;	///< Last member: stops (writing what is pending) before the rest goes.
+	};
+
+}  // namespace ambidb::db
@@ -0,0 +1,213 @@
+#include "spill_store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <print>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ambidb::db {
+
+	namespace {
+
+		size_t
+		DefaultLimit () {
+			if (const char* env = std::getenv ("AMBIDB_MEMORY_BUDGET"); env && *env) {
+				char* end = nullptr;
+				const unsigned long long mib = std::strtoull (env, &end, 10);
+				if (*end == '\0' && mib > 0) return static_cast<size_t> (mib) * 1024 * 1024;
+				std::println (stderr, "Ignoring AMBIDB_MEMORY_BUDGET='{}' (expected MiB)", env);
+			}
+			const long pages = sysconf (_SC_PHYS_PAGES);
+			const long pageSize = sysconf (_SC_PAGESIZE);
+			if (pages <= 0 || pageSize <= 0) return size_t{1024} * 1024 * 1024;
+			return static_cast<size_t> (pages) * static_cast<size_t> (pageSize) / 4;
+		}
+
+		size_t
+		PageSize () {
+			static const size_t size = static_cast<size_t> (sysconf (_SC_PAGESIZE));
+			return size;
+		}
+
+		size_t
+		AlignUp (size_t value, size_t alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		bool
+		WriteAll (int fd, const std::byte* data, size_t size, size_t offset) {
+			while (size > 0) {
+				const ssize_t written = pwrite (fd, data, size, static_cast<off_t> (offset));
+				if (written < 0 && errno == EINTR) continue;
+				if (written <= 0) return false;
+				data += written;
+				size -= static_cast<size_t> (written);
+				offset += static_cast<size_t> (written);
+			}
+			return true;
+		}
+
+	}  // namespace
+
+	MemoryBudget::MemoryBudget () : m_limit (DefaultLimit ()) {}
+
+	MemoryBudget&
+	MemoryBudget::Process () {
+		static MemoryBudget budget;
+		return budget;
+	}
+
+	MemoryCharge::MemoryCharge (MemoryCharge&& other) noexcept : m_bytes (std::exchange (other.m_bytes, 0)) {}
+
+	MemoryCharge&
+	MemoryCharge::operator= (MemoryCharge&& other) noexcept {
+		if (this != &other) {
+			Set (0);
+			m_bytes = std::exchange (other.m_bytes, 0);
+		}
+		return *this;
+	}
+
+	MemoryCharge::~MemoryCharge () {
+		Set (0);
+	}
+
+	void
+	MemoryCharge::Set (size_t bytes) {
+		std::atomic<size_t>& resident = MemoryBudget::Process ().m_resident;
+		if (bytes > m_bytes) {
+			resident.fetch_add (bytes - m_bytes, std::memory_order_relaxed);
+		}
+		else {
+			resident.fetch_sub (m_bytes - bytes, std::memory_order_relaxed);
+		}
+		m_bytes = bytes;
+	}
+
+	SpillMapping::SpillMapping (SpillMapping&& other) noexcept
+		: m_data (std::exchange (other.m_data, nullptr)), m_size (std::exchange (other.m_size, 0)),
+		  m_offset (std::exchange (other.m_offset, 0)) {}
+
+	SpillMapping&
+	SpillMapping::operator= (SpillMapping&& other) noexcept {
+		if (this != &other) {
+			if (m_data) munmap (const_cast<std::byte*> (m_data), m_size);
+			m_data = std::exchange (other.m_data, nullptr);
+			m_size = std::exchange (other.m_size, 0);
+			m_offset = std::exchange (other.m_offset, 0);
+		}
+		return *this;
+	}
+
+	SpillMapping::~SpillMapping () {
+		if (m_data) munmap (const_cast<std::byte*> (m_data), m_size);
+	}
+
+	SpillFile::SpillFile (SpillFile&& other) noexcept
+		: m_fd (std::exchange (other.m_fd, -1)), m_size (std::exchange (other.m_size, 0)),
+		  m_live (std::exchange (other.m_live, 0)), m_free (std::move (other.m_free)) {}
+
+	SpillFile&
+	SpillFile::operator= (SpillFile&& other) noexcept {
+		if (this != &other) {
+			if (m_fd >= 0) close (m_fd);
+			m_fd = std::exchange (other.m_fd, -1);
+			m_size = std::exchange (other.m_size, 0);
+			m_live = std::exchange (other.m_live, 0);
+			m_free = std::move (other.m_free);
+			other.m_free.clear ();
+		}
+		return *this;
+	}
+
+	SpillFile::~SpillFile () {
+		if (m_fd >= 0) close (m_fd);
+	}
+
+	bool
+	SpillFile::Open () {
+		std::error_code error;
+		const std::filesystem::path dir = std::filesystem::temp_directory_path (error);
+		if (error) return false;
+
+#if defined(O_TMPFILE)
+		m_fd = open (dir.c_str (), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+		if (m_fd >= 0) return true;
+#endif
+		// No O_TMPFILE (or not on this filesystem): create and unlink right away.
+		std::string path = (dir / "ambidb-spill-XXXXXX").string ();
+		m_fd = mkstemp (path.data ());
+		if (m_fd < 0) return false;
+		unlink (path.c_str ());
+		fcntl (m_fd, F_SETFD, FD_CLOEXEC);
+		return true;
+	}
+
+	std::optional<SpillMapping>
+	SpillFile::Write (std::span<const std::span<const std::byte>> parts, std::vector<size_t>& offsets) {
+		if (m_fd < 0 && !Open ()) return std::nullopt;
+
+		offsets.clear ();
+		size_t length = 0;
+		for (const std::span<const std::byte> part : parts) {
+			length = AlignUp (length, kAlignment);
+			offsets.push_back (length);
+			length += part.size ();
+		}
+		if (length == 0) return SpillMapping{};
+
+		// Each write starts on a page boundary so that it can be mapped on its own. The first
+		// released range that is large enough is reused; otherwise the file grows.
+		const size_t extent = AlignUp (length, PageSize ());
+		const auto reuse = std::ranges::find_if (m_free, [extent] (const Extent& free) { return free.length >= extent; });
+		const size_t base = reuse != m_free.end () ? reuse->offset : AlignUp (m_size, PageSize ());
+		for (size_t i = 0; i < parts.size (); ++i) {
+			if (!WriteAll (m_fd, parts [i].data (), parts [i].size (), base + offsets [i])) return std::nullopt;
+		}
+
+		void* data = mmap (nullptr, length, PROT_READ, MAP_SHARED, m_fd, static_cast<off_t> (base));
+		if (data == MAP_FAILED) return std::nullopt;
+		if (reuse != m_free.end ()) {
+			reuse->offset += extent;
+			reuse->length -= extent;
+			if (reuse->length == 0) m_free.erase (reuse);
+		}
+		else {
+			m_size = base + length;
+		}
+		m_live += length;
+		return SpillMapping (static_cast<const std::byte*> (data), length, base);
+	}
+
+	void
+	SpillFile::Release (SpillMapping mapping) {
+		if (!mapping.Data () || m_fd < 0) return;
+		const Extent released{mapping.Offset (), AlignUp (mapping.Size (), PageSize ())};
+		m_live -= mapping.Size ();
+		mapping = SpillMapping{};  // Unmap before the blocks go.
+
+#if defined(FALLOC_FL_PUNCH_HOLE)
+		// Best effort: filesystems without hole punching keep the blocks until the file goes.
+		(void) fallocate (m_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t> (released.offset), static_cast<off_t> (released.length));
+#endif
+
+		auto next = std::ranges::upper_bound (m_free, released.offset, {}, &Extent::offset);
+		next = m_free.insert (next, released);
+		if (next + 1 != m_free.end () && next->offset + next->length == (next + 1)->offset) {
+			next->length += (next + 1)->length;
+			m_free.erase (next + 1);
+		}
+		if (next != m_free.begin () && (next - 1)->offset + (next - 1)->length == next->offset) {
+			(next - 1)->length += next->length;
+			m_free.erase (next);
+		}
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <macro.h>
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace ambidb::db {
+
+	/**
+	 * @brief Process-wide limit on result data kept on the heap.
+	 *
+	 * Result sets charge their resident bytes here through a MemoryCharge. Once the total
+	 * passes the limit they move sealed row groups to a SpillFile, so a result larger than
+	 * RAM is paged in from disk by the kernel instead of growing the heap until the process
+	 * is killed. The limit defaults to a quarter of physical memory; AMBIDB_MEMORY_BUDGET
+	 * overrides it in MiB.
+	 */
+	class MemoryBudget {
+	public:
+		MAKE_NONCOPYABLE (MemoryBudget);
+		MAKE_NONMOVABLE (MemoryBudget);
+		~MemoryBudget () = default;
+
+		static MemoryBudget&
+		Process ();
+
+		size_t
+		Limit () const {
+			return m_limit.load (std::memory_order_relaxed);
+		}
+
+		void
+		SetLimit (size_t bytes) {
+			m_limit.store (bytes, std::memory_order_relaxed);
+		}
+
+		size_t
+		Resident () const {
+			return m_resident.load (std::memory_order_relaxed);
+		}
+
+		bool
+		Exceeded () const {
+			return Resident () > Limit ();
+		}
+
+	private:
+		friend class MemoryCharge;
+
+		MemoryBudget ();
+
+		std::atomic<size_t> m_limit;
+		std::atomic<size_t> m_resident{0};
+	};
+
+	/**
+	 * @brief One owner's share of MemoryBudget::Process (); released on destruction.
+	 */
+	class MemoryCharge {
+	public:
+		MAKE_NONCOPYABLE (MemoryCharge);
+		MemoryCharge () = default;
+		MemoryCharge (MemoryCharge&& other) noexcept;
+		MemoryCharge&
+		operator= (MemoryCharge&& other) noexcept;
+		~MemoryCharge ();
+
+		/// Set the charged amount to @p bytes.
+		void
+		Set (size_t bytes);
+
+		size_t
+		Bytes () const {
+			return m_bytes;
+		}
+
+	private:
+		size_t m_bytes{0};
+	};
+
+	/**
+	 * @brief Read-only mapping of a region of a SpillFile. Stays valid when moved.
+	 */
+	class SpillMapping {
+	public:
+		MAKE_NONCOPYABLE (SpillMapping);
+		SpillMapping () = default;
+		SpillMapping (SpillMapping&& other) noexcept;
+		SpillMapping&
+		operator= (SpillMapping&& other) noexcept;
+		~SpillMapping ();
+
+		const std::byte*
+		Data () const {
+			return m_data;
+		}
+
+		size_t
+		Size () const {
+			return m_size;
+		}
+
+		/// Where the region starts in its SpillFile; always page-aligned.
+		size_t
+		Offset () const {
+			return m_offset;
+		}
+
+	private:
+		friend class SpillFile;
+
+		SpillMapping (const std::byte* data, size_t size, size_t offset) : m_data (data), m_size (size), m_offset (offset) {}
+
+		const std::byte* m_data{nullptr};
+		size_t m_size{0};
+		size_t m_offset{0};
+	};
+
+	/**
+	 * @brief Anonymous temp file that cold result data is written to and mapped back from.
+	 *
+	 * The file is unlinked as soon as it is created, so its disk space goes away with the
+	 * last descriptor and mapping even if the process dies. It lives in the system temp
+	 * directory ($TMPDIR). Regions given back with Release () are punched out of the file
+	 * and reused by later writes, so rewriting data does not grow it without bound.
+	 */
+	class SpillFile {
+	public:
+		static constexpr size_t kAlignment = 8;
+
+		MAKE_NONCOPYABLE (SpillFile);
+		SpillFile () = default;
+		SpillFile (SpillFile&& other) noexcept;
+		SpillFile&
+		operator= (SpillFile&& other) noexcept;
+		~SpillFile ();
+
+		/**
+		 * @brief Append @p parts back to back, each kAlignment-aligned, and map them.
+		 * @p offsets receives the offset of each part within the mapping.
+		 * @return std::nullopt if the file cannot be created, written or mapped.
+		 */
+		std::optional<SpillMapping>
+		Write (std::span<const std::span<const std::byte>> parts, std::vector<size_t>& offsets);
+
+		/**
+		 * @brief Give back the region @p mapping was written to, after unmapping it: its
+		 * blocks are freed and the range is reused by later writes.
+		 */
+		void
+		Release (SpillMapping mapping);
+
+		/// End of the file, including regions that were released.
+		size_t
+		Size () const {
+			return m_size;
+		}
+
+		/// Bytes of regions written and not released.
+		size_t
+		LiveBytes () const {
+			return m_live;
+		}
+
+	private:
+		/// A released, page-aligned range of the file.
+		struct Extent {
+			size_t offset{0};
+			size_t length{0};
+		};
+
+		bool
+		Open ();
+
+		int m_fd{-1};
+		size_t m_size{0};
+		size_t m_live{0};
+		std::vector<Extent> m_free;	 ///< Sorted by offset, adjacent ranges merged.
+	};
+
+}  // namespace ambidb::db
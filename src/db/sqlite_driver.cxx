@@ -0,0 +1,348 @@
+#include "sqlite_driver.h"
+
+#include <algorithm>
+#include <charconv>
+#include <mutex>
+#include <sqlite3.h>
+
+namespace ambidb::db {
+
+	namespace {
+
+		constexpr int kBusyTimeoutMs = 5000;
+
+		/// Rows per bulk INSERT statement, fewer when the columns would pass the variable limit.
+		constexpr size_t kInsertRows = 256;
+
+		DbError
+		LastError (sqlite3* db) {
+			return DbError{sqlite3_errmsg (db)};
+		}
+
+		/// @p name as a quoted identifier.
+		std::string
+		QuoteIdentifier (std::string_view name) {
+			std::string quoted = "\"";
+			for (const char c : name) {
+				if (c == '"') quoted += '"';
+				quoted += c;
+			}
+			quoted += '"';
+			return quoted;
+		}
+
+		/**
+		 * Skip whitespace and SQL comments, so trailing ones do not count as a statement.
+		 */
+		const char*
+		SkipTrivia (const char* p, const char* end) {
+			while (p < end) {
+				if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == ';') {
+					++p;
+				}
+				else if (end - p >= 2 && p [0] == '-' && p [1] == '-') {
+					while (p < end && *p != '\n') ++p;
+				}
+				else if (end - p >= 2 && p [0] == '/' && p [1] == '*') {
+					p += 2;
+					while (end - p >= 2 && !(p [0] == '*' && p [1] == '/')) ++p;
+					p = end - p >= 2 ? p + 2 : end;
+				}
+				else {
+					break;
+				}
+			}
+			return p;
+		}
+
+		class SqliteCursor final : public Cursor {
+		public:
+			MAKE_NONCOPYABLE (SqliteCursor);
+			MAKE_NONMOVABLE (SqliteCursor);
+
+			/// @p stmt may be null for input without any statement (only comments).
+			SqliteCursor (sqlite3* db, sqlite3_stmt* stmt, i64 changesBefore) :
+				m_db (db), m_stmt (stmt), m_changes (changesBefore) {
+				if (!m_stmt) {
+					m_done = true;
+					return;
+				}
+				const int count = sqlite3_column_count (m_stmt);
+				m_columns.reserve (static_cast<size_t> (count));
+				for (int i = 0; i < count; ++i) {
+					const char* name = sqlite3_column_name (m_stmt, i);
+					const char* type = sqlite3_column_decltype (m_stmt, i);
+					m_columns.push_back ({name ? name : "", type ? type : ""});
+				}
+			}
+
+			~SqliteCursor () override {
+				sqlite3_finalize (m_stmt);
+			}
+
+			const std::vector<ColumnInfo>&
+			Columns () const override {
+				return m_columns;
+			}
+
+			DbResult<bool>
+			FetchBatch (RowBatch& batch, size_t maxRows) override {
+				batch.columnCount = m_columns.size ();
+				if (m_done) return false;
+
+				const int columns = static_cast<int> (m_columns.size ());
+				for (size_t rows = 0; rows < maxRows; ++rows) {
+					const int rc = sqlite3_step (m_stmt);
+					if (rc == SQLITE_DONE) {
+						m_done = true;
+						if (columns == 0) m_changes += sqlite3_changes (m_db);
+						return false;
+					}
+					if (rc != SQLITE_ROW) {
+						m_done = true;
+						return std::unexpected (LastError (m_db));
+					}
+					for (int i = 0; i < columns; ++i) {
+						batch.values.push_back (ReadColumn (i));
+					}
+				}
+				return true;
+			}
+
+			bool
+			ReadOnly () const override {
+				// INSERT/UPDATE/DELETE ... RETURNING produce rows but are not read-only.
+				return !m_stmt || sqlite3_stmt_readonly (m_stmt) != 0;
+			}
+
+			i64
+			RowsAffected () const override {
+				return m_changes;
+			}
+
+		private:
+			Value
+			ReadColumn (int i) const {
+				switch (sqlite3_column_type (m_stmt, i)) {
+					case SQLITE_INTEGER: return static_cast<i64> (sqlite3_column_int64 (m_stmt, i));
+					case SQLITE_FLOAT: return sqlite3_column_double (m_stmt, i);
+					case SQLITE_TEXT: {
+						const auto* text = reinterpret_cast<const char*> (sqlite3_column_text (m_stmt, i));
+						return std::string (text, static_cast<size_t> (sqlite3_column_bytes (m_stmt, i)));
+					}
+					case SQLITE_BLOB: {
+						const auto* data = static_cast<const u8*> (sqlite3_column_blob (m_stmt, i));
+						const size_t size = static_cast<size_t> (sqlite3_column_bytes (m_stmt, i));
+						return Blob{std::vector<u8> (data, data + size)};
+					}
+					default: return std::monostate{};
+				}
+			}
+
+			sqlite3* m_db;
+			sqlite3_stmt* m_stmt;
+			std::vector<ColumnInfo> m_columns;
+			i64 m_changes;
+			bool m_done = false;
+		};
+
+		class SqliteConnection final : public Connection {
+		public:
+			MAKE_NONCOPYABLE (SqliteConnection);
+			MAKE_NONMOVABLE (SqliteConnection);
+			explicit SqliteConnection (sqlite3* db) : m_db (db) {}
+
+			~SqliteConnection () override {
+				Close ();
+			}
+
+			DbResult<std::unique_ptr<Cursor>>
+			Execute (std::string_view sql) override {
+				if (!m_db) return std::unexpected (DbError{"connection is closed"});
+
+				const char* tail = SkipTrivia (sql.data (), sql.data () + sql.size ());
+				const char* const end = sql.data () + sql.size ();
+				sqlite3_stmt* stmt = nullptr;
+				i64 changes = 0;
+
+				while (tail < end) {
+					const char* rest = nullptr;
+					if (sqlite3_prepare_v2 (m_db, tail, static_cast<int> (end - tail), &stmt, &rest) != SQLITE_OK) {
+						return std::unexpected (LastError (m_db));
+					}
+					tail = SkipTrivia (rest, end);
+					if (!stmt || tail == end) break;
+
+					// Not the final statement: run it to completion, discarding rows. Later
+					// statements can only be prepared once this one has run (e.g. CREATE TABLE).
+					int rc;
+					while ((rc = sqlite3_step (stmt)) == SQLITE_ROW) {}
+					const bool dataStatement = sqlite3_column_count (stmt) == 0;
+					sqlite3_finalize (stmt);
+					stmt = nullptr;
+					if (rc != SQLITE_DONE) {
+						return std::unexpected (LastError (m_db));
+					}
+					if (dataStatement) changes += sqlite3_changes (m_db);
+				}
+
+				return std::make_unique<SqliteCursor> (m_db, stmt, changes);
+			}
+
+			DbResult<void>
+			InsertRows (std::string_view table, std::span<const std::string> columns, const RowBatch& rows) override {
+				if (!m_db) return std::unexpected (DbError{"connection is closed"});
+				const size_t width = rows.columnCount;
+				const size_t count = rows.RowCount ();
+				if (width == 0 || count == 0) return {};
+
+				const size_t variables = static_cast<size_t> (sqlite3_limit (m_db, SQLITE_LIMIT_VARIABLE_NUMBER, -1));
+				const size_t perStatement = std::clamp<size_t> (variables / width, 1, kInsertRows);
+				std::string key = InsertHead (table, columns);
+				key += std::to_string (width) + 'x' + std::to_string (perStatement);
+				for (size_t first = 0; first < count; first += perStatement) {
+					const size_t n = std::min (perStatement, count - first);
+					// Full statements reuse one prepared INSERT; only the last, short one is prepared anew.
+					sqlite3_stmt* stmt = nullptr;
+					const bool cached = n == perStatement;
+					if (cached) {
+						if (key != m_insertKey) {
+							sqlite3_finalize (m_insert);
+							m_insert = nullptr;
+							m_insertKey.clear ();
+							if (const DbResult<sqlite3_stmt*> prepared = PrepareInsert (table, columns, width, n); !prepared) {
+								return std::unexpected (prepared.error ());
+							}
+							else {
+								m_insert = *prepared;
+								m_insertKey = key;
+							}
+						}
+						stmt = m_insert;
+					}
+					else {
+						const DbResult<sqlite3_stmt*> prepared = PrepareInsert (table, columns, width, n);
+						if (!prepared) return std::unexpected (prepared.error ());
+						stmt = *prepared;
+					}
+
+					int index = 1;
+					for (size_t row = first; row < first + n; ++row) {
+						for (size_t column = 0; column < width; ++column) Bind (stmt, index++, rows.At (row, column));
+					}
+					const int rc = sqlite3_step (stmt);
+					sqlite3_reset (stmt);
+					if (!cached) sqlite3_finalize (stmt);
+					if (rc != SQLITE_DONE) return std::unexpected (LastError (m_db));
+				}
+				return {};
+			}
+
+			DbResult<std::vector<CatalogEntry>>
+			ListSchemas () override {
+				DbResult<std::vector<CatalogEntry>> schemas = ReadCatalog (*this, "SELECT name FROM pragma_database_list ORDER BY seq");
+				if (!schemas) return schemas;
+				for (CatalogEntry& schema : *schemas) {
+					// schema_version is bumped by every DDL statement on that database file.
+					const DbResult<std::vector<CatalogEntry>> version = ReadCatalog (*this, "PRAGMA " + QuoteIdentifier (schema.name) + ".schema_version");
+					if (!version) return std::unexpected (version.error ());
+					u64 value = 0;
+					if (!version->empty () && std::from_chars (version->front ().name.data (), version->front ().name.data () + version->front ().name.size (), value).ec == std::errc{}) {
+						schema.marker = value + 1;
+					}
+				}
+				return schemas;
+			}
+
+			DbResult<std::vector<CatalogEntry>>
+			ListTables (std::string_view schema) override {
+				// A table's marker is its CREATE statement, which ALTER TABLE rewrites.
+				return ReadCatalog (*this,
+									"SELECT name, type, sql FROM " + QuoteIdentifier (schema) +
+										".sqlite_master WHERE type IN ('table', 'view') AND name NOT LIKE 'sqlite\\_%' ESCAPE '\\' ORDER BY name");
+			}
+
+			DbResult<std::vector<CatalogEntry>>
+			ListColumns (std::string_view schema, std::string_view table) override {
+				return ReadCatalog (*this, "SELECT name, type FROM pragma_table_info(" + SqlLiteral (table) + ", " + SqlLiteral (schema) + ") ORDER BY cid");
+			}
+
+			void
+			Interrupt () override {
+				std::lock_guard lock (m_mutex);
+				if (m_db) sqlite3_interrupt (m_db);
+			}
+
+			void
+			Close () override {
+				std::lock_guard lock (m_mutex);
+				if (m_db) {
+					sqlite3_finalize (m_insert);
+					m_insert = nullptr;
+					m_insertKey.clear ();
+					sqlite3_close_v2 (m_db);
+					m_db = nullptr;
+				}
+			}
+
+		private:
+			DbResult<sqlite3_stmt*>
+			PrepareInsert (std::string_view table, std::span<const std::string> columns, size_t width, size_t rows) {
+				std::string sql = InsertHead (table, columns);
+				sql.reserve (sql.size () + rows * (width * 2 + 3));
+				for (size_t row = 0; row < rows; ++row) {
+					sql += row == 0 ? "(" : ",(";
+					for (size_t column = 0; column < width; ++column) sql += column == 0 ? "?" : ",?";
+					sql += ')';
+				}
+				sqlite3_stmt* stmt = nullptr;
+				if (sqlite3_prepare_v2 (m_db, sql.c_str (), static_cast<int> (sql.size ()), &stmt, nullptr) != SQLITE_OK) {
+					return std::unexpected (LastError (m_db));
+				}
+				return stmt;
+			}
+
+			/// The batch outlives the step, so text and blobs are bound without a copy.
+			static void
+			Bind (sqlite3_stmt* stmt, int index, const Value& value) {
+				if (const i64* integer = std::get_if<i64> (&value)) {
+					sqlite3_bind_int64 (stmt, index, *integer);
+				}
+				else if (const f64* real = std::get_if<f64> (&value)) {
+					sqlite3_bind_double (stmt, index, *real);
+				}
+				else if (const std::string* text = std::get_if<std::string> (&value)) {
+					sqlite3_bind_text (stmt, index, text->data (), static_cast<int> (text->size ()), SQLITE_STATIC);
+				}
+				else if (const Blob* blob = std::get_if<Blob> (&value)) {
+					sqlite3_bind_blob (stmt, index, blob->bytes.data (), static_cast<int> (blob->bytes.size ()), SQLITE_STATIC);
+				}
+				else {
+					sqlite3_bind_null (stmt, index);
+				}
+			}
+
+			std::mutex m_mutex;	 ///< Guards m_db against Interrupt() racing Close().
+			sqlite3* m_db;
+			sqlite3_stmt* m_insert = nullptr;  ///< Last full-size InsertRows () statement, for m_insertKey.
+			std::string m_insertKey;
+		};
+
+	}  // namespace
+
+	DbResult<std::unique_ptr<Connection>>
+	SqliteDriver::Connect (const ConnectionParams& params) {
+		sqlite3* db = nullptr;
+		// NOMUTEX: the executor never uses a connection from two threads at once.
+		const int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+		const std::string& path = params.target.empty () ? std::string (":memory:") : params.target;
+		if (sqlite3_open_v2 (path.c_str (), &db, flags, nullptr) != SQLITE_OK) {
+			DbError error{db ? sqlite3_errmsg (db) : "out of memory"};
+			sqlite3_close_v2 (db);
+			return std::unexpected (std::move (error));
+		}
+		sqlite3_busy_timeout (db, kBusyTimeoutMs);
+		return std::make_unique<SqliteConnection> (db);
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "driver.h"
+
+namespace ambidb::db {
+
+	/**
+	 * @brief Embedded SQLite driver. ConnectionParams::target is a database file path
+	 * or ":memory:"; the file is created if it does not exist.
+	 */
+	class SqliteDriver final : public Driver {
+	public:
+		MAKE_NONCOPYABLE (SqliteDriver);
+		MAKE_NONMOVABLE (SqliteDriver);
+		SqliteDriver () = default;
+		~SqliteDriver () override = default;
+
+		const char*
+		Name () const override {
+			return "sqlite";
+		}
+
+		DbResult<std::unique_ptr<Connection>>
+		Connect (const ConnectionParams& params) override;
+	};
+
+}  // namespace ambidb::db
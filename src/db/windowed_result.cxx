@@ -0,0 +1,133 @@
+#include "windowed_result.h"
+
+#include <algorithm>
+
+namespace ambidb::db {
+
+	namespace {
+
+		size_t
+		Distance (size_t a, size_t b) {
+			return a > b ? a - b : b - a;
+		}
+
+	}  // namespace
+
+	void
+	WindowedResult::Reset (std::vector<ColumnInfo> columns) {
+		m_columns = std::move (columns);
+		m_pages.clear ();
+		m_inFlight.clear ();
+		m_memoryBytes = 0;
+		m_knownRows = 0;
+		m_extent = 0;
+		m_complete = false;
+		m_centerPage = 0;
+		m_lastFirstVisible = 0;
+		m_forward = true;
+	}
+
+	void
+	WindowedResult::AddPage (size_t firstRow, const RowBatch& rows, bool endOfData) {
+		const size_t page = firstRow / kPageRows;
+		m_inFlight.erase (page);
+
+		const size_t count = rows.RowCount ();
+		if (endOfData) {
+			m_complete = true;
+			m_knownRows = firstRow + count;
+			// Pages past the end can no longer arrive.
+			std::erase_if (m_inFlight, [&] (size_t p) { return p * kPageRows >= m_knownRows; });
+		}
+		else {
+			m_knownRows = std::max (m_knownRows, firstRow + count);
+		}
+		if (count == 0 || firstRow % kPageRows != 0 || m_pages.contains (page)) return;
+
+		ResultSet& stored = m_pages [page];
+		stored.Reset (m_columns);
+		stored.Append (rows);
+		m_memoryBytes += stored.MemoryBytes ();
+		Evict ();
+	}
+
+	void
+	WindowedResult::PageFailed (size_t firstRow) {
+		m_inFlight.erase (firstRow / kPageRows);
+	}
+
+	void
+	WindowedResult::Extend (size_t row) {
+		m_extent = std::max (m_extent, row + 1);
+	}
+
+	size_t
+	WindowedResult::RowCount () const {
+		if (m_complete) return m_knownRows;
+		return std::max (m_knownRows, m_extent) + kPageRows;
+	}
+
+	void
+	WindowedResult::Plan (size_t firstVisible, size_t visibleCount, std::vector<size_t>& firstRows) {
+		const size_t rows = RowCount ();
+		if (m_columns.empty () || rows == 0) return;
+
+		if (firstVisible != m_lastFirstVisible) {
+			m_forward = firstVisible > m_lastFirstVisible;
+			m_lastFirstVisible = firstVisible;
+		}
+
+		const size_t lastPage = (rows - 1) / kPageRows;
+		const size_t firstShown = std::min (firstVisible / kPageRows, lastPage);
+		const size_t lastShown = std::min ((firstVisible + std::max<size_t> (visibleCount, 1) - 1) / kPageRows, lastPage);
+		m_centerPage = firstShown;
+
+		const size_t behind = m_forward ? 1 : kPrefetchPages;
+		const size_t ahead = m_forward ? kPrefetchPages : 1;
+		const size_t low = firstShown > behind ? firstShown - behind : 0;
+		const size_t high = std::min (lastShown + ahead, lastPage);
+
+		// Visible pages first, then outward; ties go to the scroll direction.
+		std::vector<size_t> wanted;
+		for (size_t page = low; page <= high; ++page) {
+			if (!m_pages.contains (page) && !m_inFlight.contains (page)) wanted.push_back (page);
+		}
+		const auto cost = [&] (size_t page) {
+			if (page >= firstShown && page <= lastShown) return size_t{0};
+			const bool isAhead = (page > lastShown) == m_forward;
+			return 2 * (page < firstShown ? firstShown - page : page - lastShown) + (isAhead ? 0 : 1);
+		};
+		std::ranges::sort (wanted, {}, cost);
+
+		for (size_t page : wanted) {
+			if (m_inFlight.size () >= kMaxInFlight) break;
+			m_inFlight.insert (page);
+			firstRows.push_back (page * kPageRows);
+		}
+	}
+
+	const char*
+	WindowedResult::FormatCell (size_t row, size_t column, char* scratch, size_t scratchSize) const {
+		const auto it = m_pages.find (row / kPageRows);
+		if (it == m_pages.end () || row % kPageRows >= it->second.RowCount ()) return "...";
+		return it->second.FormatCell (row % kPageRows, column, scratch, scratchSize);
+	}
+
+	void
+	WindowedResult::Evict () {
+		while (m_memoryBytes > m_budget) {
+			auto farthest = m_pages.end ();
+			for (auto it = m_pages.begin (); it != m_pages.end (); ++it) {
+				if (farthest == m_pages.end () ||
+					Distance (it->first, m_centerPage) > Distance (farthest->first, m_centerPage)) {
+					farthest = it;
+				}
+			}
+			// Never drop what is on screen or about to be.
+			if (farthest == m_pages.end () || Distance (farthest->first, m_centerPage) <= kPrefetchPages) break;
+			m_memoryBytes -= farthest->second.MemoryBytes ();
+			m_pages.erase (farthest);
+		}
+	}
+
+}  // namespace ambidb::db
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "result_set.h"
+
+#include <macro.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ambidb::db {
+
+	/**
+	 * @brief UI-side cache of a windowed query: the pages around the grid's viewport.
+	 *
+	 * The result is split into pages of kPageRows rows, each held in its own ResultSet.
+	 * Plan() turns the visible row range into page requests, nearest first, reading ahead
+	 * in the scroll direction; the caller sends them with QueryExecutor::FetchRows() and
+	 * feeds the QueryPage events back through AddPage(). Pages far from the viewport are
+	 * evicted once the cache exceeds its memory budget, so memory stays bounded however
+	 * far the user scrolls.
+	 *
+	 * The total row count is only known once a page reaches the end; until then RowCount()
+	 * reports one page beyond the known rows so the grid can scroll on and load it.
+	 */
+	class WindowedResult {
+	public:
+		static constexpr size_t kPageRows = 1024;
+		static constexpr size_t kPrefetchPages = 4;	 ///< Read ahead in the scroll direction.
+		static constexpr size_t kMaxInFlight = 4;
+		static constexpr size_t kDefaultBudget = 64 * 1024 * 1024;
+
+		MAKE_NONCOPYABLE (WindowedResult);
+		WindowedResult () = default;
+		explicit WindowedResult (size_t memoryBudget) : m_budget (memoryBudget) {}
+		WindowedResult (WindowedResult&&) noexcept = default;
+		WindowedResult&
+		operator= (WindowedResult&&) noexcept = default;
+		~WindowedResult () = default;
+
+		void
+		Reset (std::vector<ColumnInfo> columns);
+
+		/**
+		 * @brief Store a QueryPage. @p endOfData means the result has exactly
+		 * firstRow + rows.RowCount () rows.
+		 */
+		void
+		AddPage (size_t firstRow, const RowBatch& rows, bool endOfData);
+
+		/**
+		 * @brief A requested page will not arrive (fetch error); allow asking again.
+		 */
+		void
+		PageFailed (size_t firstRow);
+
+		/**
+		 * @brief Make RowCount () cover @p row, e.g. before jumping past the known rows.
+		 */
+		void
+		Extend (size_t row);
+
+		/**
+		 * @brief Pick pages to fetch for the rows on screen and mark them in flight.
+		 * Appends the first row of each to @p firstRows.
+		 */
+		void
+		Plan (size_t firstVisible, size_t visibleCount, std::vector<size_t>& firstRows);
+
+		/// Rows to show: exact once Complete (), otherwise one page past the known rows.
+		size_t
+		RowCount () const;
+
+		size_t
+		KnownRows () const {
+			return m_knownRows;
+		}
+
+		bool
+		Complete () const {
+			return m_complete;
+		}
+
+		size_t
+		ColumnCount () const {
+			return m_columns.size ();
+		}
+
+		const ColumnInfo&
+		Column (size_t column) const {
+			return m_columns [column];
+		}
+
+		/**
+		 * @brief Like ResultSet::FormatCell (); rows whose page is not loaded show "...".
+		 */
+		const char*
+		FormatCell (size_t row, size_t column, char* scratch, size_t scratchSize) const;
+
+		size_t
+		CachedPages () const {
+			return m_pages.size ();
+		}
+
+		size_t
+		MemoryBytes () const {
+			return m_memoryBytes;
+		}
+
+	private:
+		void
+		Evict ();
+
+		std::vector<ColumnInfo> m_columns;
+		std::unordered_map<size_t, ResultSet> m_pages;	 ///< Keyed by page index.
+		std::unordered_set<size_t> m_inFlight;
+		size_t m_budget{kDefaultBudget};
+		size_t m_memoryBytes{0};
+		size_t m_knownRows{0};
+		size_t m_extent{0};	 ///< Rows the user asked to see, from Extend ().
+		bool m_complete{false};
+		size_t m_centerPage{0};
+		size_t m_lastFirstVisible{0};
+		bool m_forward{true};
+	};
+
+}  // namespace ambidb::db
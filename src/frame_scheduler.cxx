@@ -0,0 +1,103 @@
+#include "frame_scheduler.h"
+
+#include <algorithm>
+
+namespace ambidb {
+
+	void
+	FrameScheduler::RequestRedraw () {
+		// Only the first request after the loop drained the flag needs to wake it.
+		if (!m_redrawPending.exchange (true, std::memory_order_acq_rel)) {
+			Wake ();
+		}
+	}
+
+	void
+	FrameScheduler::ScheduleFrameAt (Clock::time_point when) {
+		const Clock::rep ticks = when.time_since_epoch ().count ();
+		Clock::rep current = m_deadline.load (std::memory_order_acquire);
+		while (ticks < current) {
+			if (m_deadline.compare_exchange_weak (current, ticks, std::memory_order_acq_rel)) {
+				// The loop may be sleeping on a later deadline; make it recompute its timeout.
+				Wake ();
+				return;
+			}
+		}
+	}
+
+	void
+	FrameScheduler::BeginAnimation () {
+		if (m_animations.fetch_add (1, std::memory_order_acq_rel) == 0) {
+			Wake ();
+		}
+	}
+
+	void
+	FrameScheduler::EndAnimation () {
+		// One last frame so the final (non-animated) state gets drawn.
+		if (m_animations.fetch_sub (1, std::memory_order_acq_rel) == 1) {
+			RequestRedraw ();
+		}
+	}
+
+	void
+	FrameScheduler::SetWakeHook (std::function<void ()> hook) {
+		std::lock_guard lock (m_hookMutex);
+		m_wakeHook = std::move (hook);
+	}
+
+	bool
+	FrameScheduler::ConsumeRedraw () {
+		return m_redrawPending.exchange (false, std::memory_order_acq_rel);
+	}
+
+	std::optional<FrameScheduler::Clock::time_point>
+	FrameScheduler::NextDeadline () const {
+		const Clock::rep ticks = m_deadline.load (std::memory_order_acquire);
+		if (ticks == kNoDeadline) return std::nullopt;
+		return Clock::time_point (Clock::duration (ticks));
+	}
+
+	bool
+	FrameScheduler::ConsumeDeadline (Clock::time_point now) {
+		const Clock::rep nowTicks = now.time_since_epoch ().count ();
+		Clock::rep current = m_deadline.load (std::memory_order_acquire);
+		while (current <= nowTicks) {
+			if (m_deadline.compare_exchange_weak (current, kNoDeadline, std::memory_order_acq_rel)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	WaitPlan
+	FrameScheduler::PlanWait (Clock::time_point now, Clock::time_point lastFrameStart) {
+		if (m_redrawPending.load (std::memory_order_acquire)) {
+			return {WaitMode::Continuous, Clock::duration::zero ()};
+		}
+
+		const bool animationFrame = m_animationFrameRequested.exchange (false, std::memory_order_relaxed);
+		std::optional<Clock::time_point> wakeAt = NextDeadline ();
+		WaitMode mode = wakeAt ? WaitMode::Deadline : WaitMode::Idle;
+
+		if (animationFrame || IsAnimating ()) {
+			const Clock::time_point nextTick = lastFrameStart + m_animationInterval;
+			if (!wakeAt || nextTick < *wakeAt) {
+				wakeAt = nextTick;
+			}
+			mode = WaitMode::Continuous;
+		}
+
+		if (!wakeAt) return {WaitMode::Idle, Clock::duration::zero ()};
+		return {mode, std::max (*wakeAt - now, Clock::duration::zero ())};
+	}
+
+	void
+	FrameScheduler::Wake () {
+		std::lock_guard lock (m_hookMutex);
+		if (m_wakeHook) {
+			m_wakeHook ();
+		}
+	}
+
+}  // namespace ambidb
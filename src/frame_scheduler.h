@@ -0,0 +1,146 @@
+#pragma once
+
+#include <macro.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+
+namespace ambidb {
+
+	/**
+	 * @brief How the event loop should wait before building the next frame.
+	 */
+	enum class WaitMode {
+		Idle,		 ///< Nothing pending: block until input or a wakeup.
+		Deadline,	 ///< Block until input, a wakeup or the timeout expires.
+		Continuous,	 ///< Something is animating: wait at most one animation interval.
+	};
+
+	struct WaitPlan {
+		WaitMode mode{WaitMode::Idle};
+		std::chrono::steady_clock::duration timeout{};
+	};
+
+	/**
+	 * @brief Thread-safe frame requests shared by App and the active backend.
+	 *
+	 * Any thread may call RequestRedraw() when it has produced something the UI
+	 * should show (query rows, progress), or ScheduleFrameAt() to get a frame at a
+	 * later point in time (timers, blinking cursors). The backend event loop owns the
+	 * wake hook that interrupts its blocking wait and drains the requests once per
+	 * iteration, so an idle client sleeps in the kernel instead of spinning.
+	 */
+	class FrameScheduler {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		MAKE_NONCOPYABLE (FrameScheduler);
+		MAKE_NONMOVABLE (FrameScheduler);
+		FrameScheduler () = default;
+		~FrameScheduler () = default;
+
+		/**
+		 * @brief Ask for one more frame as soon as possible.
+		 * Repeated calls before the event loop wakes are coalesced into one wakeup.
+		 */
+		void
+		RequestRedraw ();
+
+		/**
+		 * @brief Ask for a frame no later than @p when.
+		 * Only the earliest pending deadline is kept.
+		 */
+		void
+		ScheduleFrameAt (Clock::time_point when);
+
+		void
+		ScheduleFrameIn (Clock::duration delay) {
+			ScheduleFrameAt (Clock::now () + delay);
+		}
+
+		/**
+		 * @brief Keep frames flowing at the animation interval until EndAnimation().
+		 * Calls nest; e.g. one Begin/End pair per running query spinner.
+		 */
+		void
+		BeginAnimation ();
+
+		void
+		EndAnimation ();
+
+		/**
+		 * @brief UI thread: ask for the next frame at the animation interval.
+		 * For one-off animations decided while building a frame.
+		 */
+		void
+		RequestAnimationFrame () {
+			m_animationFrameRequested.store (true, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Minimum time between continuous frames (defaults to 60 Hz).
+		 */
+		void
+		SetAnimationInterval (Clock::duration interval) {
+			m_animationInterval = interval;
+		}
+
+		/**
+		 * @brief Install the callback that interrupts the backend's blocking wait.
+		 * Called by the backend before Run(); pass an empty function to detach.
+		 */
+		void
+		SetWakeHook (std::function<void ()> hook);
+
+		/**
+		 * @brief Event loop side: returns true (and clears the flag) if a redraw was requested.
+		 */
+		bool
+		ConsumeRedraw ();
+
+		/**
+		 * @brief Event loop side: the earliest scheduled frame, if any.
+		 */
+		std::optional<Clock::time_point>
+		NextDeadline () const;
+
+		/**
+		 * @brief Event loop side: clears the deadline if it is due at @p now.
+		 * @return true if a deadline was due.
+		 */
+		bool
+		ConsumeDeadline (Clock::time_point now);
+
+		/**
+		 * @brief Event loop side: decide how to wait, given the time the previous frame began.
+		 * Consumes the one-shot RequestAnimationFrame() flag.
+		 */
+		WaitPlan
+		PlanWait (Clock::time_point now, Clock::time_point lastFrameStart);
+
+		bool
+		IsAnimating () const {
+			return m_animations.load (std::memory_order_acquire) > 0;
+		}
+
+	private:
+		static constexpr Clock::rep kNoDeadline = std::numeric_limits<Clock::rep>::max ();
+
+		void
+		Wake ();
+
+		std::atomic<bool> m_redrawPending{false};
+		std::atomic<Clock::rep> m_deadline{kNoDeadline};
+		std::atomic<int> m_animations{0};
+		std::atomic<bool> m_animationFrameRequested{false};
+		Clock::duration m_animationInterval{std::chrono::microseconds (16667)};
+
+		std::mutex m_hookMutex;
+		std::function<void ()> m_wakeHook;
+	};
+
+}  // namespace ambidb
@@ -0,0 +1,83 @@
+#include "frame_timing.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ambidb {
+
+	namespace {
+
+		PhaseStats
+		Percentiles (std::vector<uint32_t>& ns) {
+			PhaseStats stats;
+			if (ns.empty ()) return stats;
+			std::sort (ns.begin (), ns.end ());
+			const auto at = [&] (double p) {
+				const size_t index = static_cast<size_t> (p * static_cast<double> (ns.size () - 1) + 0.5);
+				return static_cast<double> (ns [index]) / 1e6;
+			};
+			stats.p50Ms = at (0.50);
+			stats.p99Ms = at (0.99);
+			stats.maxMs = static_cast<double> (ns.back ()) / 1e6;
+			return stats;
+		}
+
+	}  // namespace
+
+	const char*
+	FramePhaseName (FramePhase phase) {
+		switch (phase) {
+			case FramePhase::NewFrame: return "NewFrame";
+			case FramePhase::Update: return "Update";
+			case FramePhase::Render: return "Render";
+			case FramePhase::Present: return "Present";
+		}
+		UNREACHABLE ();
+	}
+
+	void
+	FrameTimings::EndFrame () {
+		if (!m_recording) return;
+		const uint64_t head = m_head.load (std::memory_order_relaxed);
+		Slot& slot = m_ring [head & (kCapacity - 1)];
+		for (size_t i = 0; i < kFramePhaseCount; ++i) {
+			slot.phaseNs [i].store (m_current [i], std::memory_order_relaxed);
+		}
+		slot.totalNs.store (ToNs (m_phaseStart - m_frameStart), std::memory_order_relaxed);
+		slot.outputBytes.store (m_currentOutputBytes, std::memory_order_relaxed);
+		m_head.store (head + 1, std::memory_order_release);
+		m_current.fill (0);
+		m_currentOutputBytes = 0;
+	}
+
+	FrameTimingStats
+	FrameTimings::Summarize (size_t window) const {
+		FrameTimingStats stats;
+		const uint64_t head = m_head.load (std::memory_order_acquire);
+		const size_t count = static_cast<size_t> (std::min<uint64_t> ({head, window, kCapacity}));
+		stats.samples = count;
+		if (count == 0) return stats;
+
+		std::vector<uint32_t> values (count);
+		for (size_t phase = 0; phase < kFramePhaseCount; ++phase) {
+			for (size_t i = 0; i < count; ++i) {
+				values [i] = m_ring [(head - 1 - i) & (kCapacity - 1)].phaseNs [phase].load (std::memory_order_relaxed);
+			}
+			stats.phases [phase] = Percentiles (values);
+		}
+		for (size_t i = 0; i < count; ++i) {
+			values [i] = m_ring [(head - 1 - i) & (kCapacity - 1)].totalNs.load (std::memory_order_relaxed);
+		}
+		stats.total = Percentiles (values);
+
+		for (size_t i = 0; i < count; ++i) {
+			values [i] = m_ring [(head - 1 - i) & (kCapacity - 1)].outputBytes.load (std::memory_order_relaxed);
+		}
+		std::sort (values.begin (), values.end ());
+		stats.output.p50Bytes = values [static_cast<size_t> (0.50 * static_cast<double> (count - 1) + 0.5)];
+		stats.output.p99Bytes = values [static_cast<size_t> (0.99 * static_cast<double> (count - 1) + 0.5)];
+		stats.output.maxBytes = values.back ();
+		return stats;
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <macro.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ambidb {
+
+	/**
+	 * @brief Phases of one backend frame, in the order the Run() loops execute them.
+	 */
+	enum class FramePhase : uint8_t {
+		NewFrame,  ///< Backend + ImGui NewFrame (input processing).
+		Update,	   ///< RunFrame(): App::Update or the frame callback.
+		Render,	   ///< ImGui::Render (draw list finalization).
+		Present,   ///< GL upload + swap, or ImTui rasterization + terminal write.
+	};
+
+	inline constexpr size_t kFramePhaseCount = 4;
+
+	const char*
+	FramePhaseName (FramePhase phase);
+
+	struct PhaseStats {
+		double p50Ms{0.0};
+		double p99Ms{0.0};
+		double maxMs{0.0};
+	};
+
+	struct OutputStats {
+		uint32_t p50Bytes{0};
+		uint32_t p99Bytes{0};
+		uint32_t maxBytes{0};
+	};
+
+	struct FrameTimingStats {
+		size_t samples{0};
+		std::array<PhaseStats, kFramePhaseCount> phases{};
+		PhaseStats total{};
+		OutputStats output{};  ///< Bytes written to the terminal; zero for GPU backends.
+	};
+
+	/**
+	 * @brief Per-phase frame timer backed by a fixed-size lock-free ring buffer.
+	 *
+	 * The backend's UI thread is the only writer: BeginFrame(), one Mark() per phase,
+	 * EndFrame(). Each slot stores nanoseconds in relaxed atomics and the head index is
+	 * published with release semantics, so Summarize() may run on any thread without
+	 * locks. When disabled every call is a single predictable branch.
+	 */
+	class FrameTimings {
+	public:
+		using Clock = std::chrono::steady_clock;
+		static constexpr size_t kCapacity = 256;
+
+		MAKE_NONCOPYABLE (FrameTimings);
+		MAKE_NONMOVABLE (FrameTimings);
+		FrameTimings () = default;
+		~FrameTimings () = default;
+
+		void
+		SetEnabled (bool enabled) {
+			m_enabled.store (enabled, std::memory_order_relaxed);
+		}
+
+		bool
+		Enabled () const {
+			return m_enabled.load (std::memory_order_relaxed);
+		}
+
+		void
+		BeginFrame () {
+			m_recording = Enabled ();
+			if (!m_recording) return;
+			m_frameStart = Clock::now ();
+			m_phaseStart = m_frameStart;
+		}
+
+		void
+		Mark (FramePhase phase) {
+			if (!m_recording) return;
+			const Clock::time_point now = Clock::now ();
+			m_current [static_cast<size_t> (phase)] = ToNs (now - m_phaseStart);
+			m_phaseStart = now;
+		}
+
+		/**
+		 * @brief Bytes the present phase sent to its output (terminal backends).
+		 */
+		void
+		RecordOutputBytes (size_t bytes) {
+			if (!m_recording) return;
+			m_currentOutputBytes = bytes > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t> (bytes);
+		}
+
+		void
+		EndFrame ();
+
+		/**
+		 * @brief p50/p99/max per phase over the most recent @p window frames.
+		 */
+		FrameTimingStats
+		Summarize (size_t window = kCapacity) const;
+
+	private:
+		static_assert ((kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of two");
+
+		struct Slot {
+			std::array<std::atomic<uint32_t>, kFramePhaseCount> phaseNs{};
+			std::atomic<uint32_t> totalNs{0};
+			std::atomic<uint32_t> outputBytes{0};
+		};
+
+		static uint32_t
+		ToNs (Clock::duration d) {
+			const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds> (d).count ();
+			return ns > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t> (ns < 0 ? 0 : ns);
+		}
+
+		std::atomic<bool> m_enabled{false};
+		std::atomic<uint64_t> m_head{0};
+		std::array<Slot, kCapacity> m_ring{};
+
+		// Writer-only state.
+		bool m_recording{false};
+		Clock::time_point m_frameStart{};
+		Clock::time_point m_phaseStart{};
+		std::array<uint32_t, kFramePhaseCount> m_current{};
+		uint32_t m_currentOutputBytes{0};
+	};
+
+}  // namespace ambidb
@@ -0,0 +1,794 @@
+#include "history_store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <print>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ambidb {
+
+	namespace {
+
+		// Address space reserved per mapping, so files grow without remapping.
+		constexpr size_t kLogReserve = size_t{1} << 38;
+		constexpr size_t kIndexReserve = size_t{1} << 36;
+		constexpr size_t kEntriesReserve = size_t{1} << 32;
+
+		/// Longer words are indexed by their first kMaxWord bytes.
+		constexpr size_t kMaxWord = 64;
+		/// Shorter words are not indexed; query words of any length match as prefixes.
+		constexpr size_t kMinIndexedWord = 2;
+
+		constexpr std::string_view kSegmentMagic = "AMBIFTS1";
+
+		/// One per entry in history.idx; the index record, not the log, commits an entry.
+		struct IndexRecord {
+			u64 offset{0};	///< Of the SQL in the log, past its u32 size.
+			i64 time{0};
+			f64 elapsedMs{0.0};
+			i64 rows{0};
+			u32 size{0};
+			u32 connection{0};
+			u8 status{0};
+			u8 reserved [7]{};
+		};
+		static_assert (sizeof (IndexRecord) == 48);
+
+		struct SegmentHeader {
+			char magic [8]{};
+			u32 first{0};
+			u32 end{0};
+			u64 termCount{0};
+			u64 tableOffset{0};
+		};
+		static_assert (sizeof (SegmentHeader) == 32);
+
+		/// Segment term table entry; the table is sorted by term bytes.
+		struct TermRecord {
+			u64 postings{0};  ///< Offset of the delta-encoded entries.
+			u64 term{0};	  ///< Offset of the term bytes.
+			u32 postingsBytes{0};
+			u32 count{0};
+			u32 termSize{0};
+			u32 reserved{0};
+		};
+		static_assert (sizeof (TermRecord) == 32);
+
+		bool
+		WordByte (u8 c) {
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c >= 0x80;
+		}
+
+		/// Calls word (lower-cased) for each word of @p text of at least @p minLength bytes.
+		template <typename F>
+		void
+		ForEachWord (std::string_view text, size_t minLength, F&& word) {
+			std::string lower;
+			size_t i = 0;
+			while (i < text.size ()) {
+				while (i < text.size () && !WordByte (static_cast<u8> (text [i]))) ++i;
+				const size_t start = i;
+				while (i < text.size () && WordByte (static_cast<u8> (text [i]))) ++i;
+				if (i - start < minLength) continue;
+				lower.assign (text.substr (start, std::min (i - start, kMaxWord)));
+				for (char& c : lower) {
+					if (c >= 'A' && c <= 'Z') c = static_cast<char> (c | 0x20);
+				}
+				word (std::string_view (lower));
+			}
+		}
+
+		void
+		AppendVarint (std::string& out, u32 value) {
+			while (value >= 0x80) {
+				out += static_cast<char> (value | 0x80);
+				value >>= 7;
+			}
+			out += static_cast<char> (value);
+		}
+
+		bool
+		WriteAll (int fd, const void* data, size_t size, size_t offset) {
+			const auto* bytes = static_cast<const char*> (data);
+			while (size > 0) {
+				const ssize_t written = pwrite (fd, bytes, size, static_cast<off_t> (offset));
+				if (written < 0 && errno == EINTR) continue;
+				if (written <= 0) return false;
+				bytes += written;
+				size -= static_cast<size_t> (written);
+				offset += static_cast<size_t> (written);
+			}
+			return true;
+		}
+
+		i64
+		NowMs () {
+			return std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::system_clock::now ().time_since_epoch ()).count ();
+		}
+
+		std::string
+		SegmentName (u32 first, u32 end) {
+			return "fts-" + std::to_string (first) + "-" + std::to_string (end) + ".seg";
+		}
+
+		/**
+		 * Writes a segment: header, postings as they are added, then the term table and the
+		 * term bytes. Terms must come in ascending byte order.
+		 */
+		class SegmentBuilder {
+		public:
+			MAKE_NONCOPYABLE (SegmentBuilder);
+			MAKE_NONMOVABLE (SegmentBuilder);
+			SegmentBuilder () = default;
+
+			~SegmentBuilder () {
+				if (m_fd >= 0) close (m_fd);
+			}
+
+			bool
+			Begin (const std::filesystem::path& path) {
+				m_fd = open (path.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+				m_offset = sizeof (SegmentHeader);
+				return m_fd >= 0;
+			}
+
+			bool
+			Add (std::string_view term, std::span<const u32> entries) {
+				TermRecord record;
+				record.postings = m_offset + m_buffer.size ();
+				record.count = static_cast<u32> (entries.size ());
+				record.termSize = static_cast<u32> (term.size ());
+				record.term = m_terms.size ();	// Rebased in Finish ().
+				const size_t before = m_buffer.size ();
+				u32 previous = 0;
+				for (const u32 entry : entries) {
+					AppendVarint (m_buffer, entry - previous);
+					previous = entry;
+				}
+				record.postingsBytes = static_cast<u32> (m_buffer.size () - before);
+				m_table.push_back (record);
+				m_terms += term;
+				return m_buffer.size () < (size_t{1} << 20) || FlushBuffer ();
+			}
+
+			bool
+			Finish (u32 first, u32 end) {
+				if (!FlushBuffer ()) return false;
+				SegmentHeader header;
+				std::memcpy (header.magic, kSegmentMagic.data (), sizeof (header.magic));
+				header.first = first;
+				header.end = end;
+				header.termCount = m_table.size ();
+				header.tableOffset = m_offset;
+				const u64 termsOffset = m_offset + m_table.size () * sizeof (TermRecord);
+				for (TermRecord& record : m_table) record.term += termsOffset;
+				if (!WriteAll (m_fd, m_table.data (), m_table.size () * sizeof (TermRecord), m_offset) ||
+					!WriteAll (m_fd, m_terms.data (), m_terms.size (), termsOffset) || !WriteAll (m_fd, &header, sizeof (header), 0)) {
+					return false;
+				}
+				const bool synced = fdatasync (m_fd) == 0;
+				close (m_fd);
+				m_fd = -1;
+				return synced;
+			}
+
+		private:
+			bool
+			FlushBuffer () {
+				if (!WriteAll (m_fd, m_buffer.data (), m_buffer.size (), m_offset)) return false;
+				m_offset += m_buffer.size ();
+				m_buffer.clear ();
+				return true;
+			}
+
+			int m_fd{-1};
+			u64 m_offset{0};  ///< File offset m_buffer starts at.
+			std::string m_buffer;
+			std::vector<TermRecord> m_table;
+			std::string m_terms;
+		};
+
+	}  // namespace
+
+	/// An immutable, mapped full-text segment covering entries [First (), End ()).
+	class HistoryStore::Segment {
+	public:
+		MAKE_NONCOPYABLE (Segment);
+		MAKE_NONMOVABLE (Segment);
+
+		~Segment () {
+			if (m_data) munmap (const_cast<std::byte*> (m_data), m_size);
+		}
+
+		/// nullptr if @p path is not a complete segment.
+		static std::unique_ptr<Segment>
+		Open (const std::filesystem::path& path) {
+			const int fd = open (path.c_str (), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) return nullptr;
+			struct stat info{};
+			const bool sized = fstat (fd, &info) == 0 && static_cast<size_t> (info.st_size) >= sizeof (SegmentHeader);
+			void* mapped = sized ? mmap (nullptr, static_cast<size_t> (info.st_size), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+			close (fd);
+			if (mapped == MAP_FAILED) return nullptr;
+
+			std::unique_ptr<Segment> segment (new Segment (static_cast<const std::byte*> (mapped), static_cast<size_t> (info.st_size)));
+			const SegmentHeader& header = segment->m_header;
+			std::memcpy (&segment->m_header, mapped, sizeof (header));
+			const bool valid = std::string_view (header.magic, sizeof (header.magic)) == kSegmentMagic && header.first < header.end &&
+							   header.tableOffset + header.termCount * sizeof (TermRecord) <= segment->m_size;
+			if (!valid) return nullptr;
+			segment->m_path = path;
+			return segment;
+		}
+
+		u32
+		First () const {
+			return m_header.first;
+		}
+
+		u32
+		End () const {
+			return m_header.end;
+		}
+
+		const std::filesystem::path&
+		Path () const {
+			return m_path;
+		}
+
+		size_t
+		TermCount () const {
+			return m_header.termCount;
+		}
+
+		TermRecord
+		Term (size_t index) const {
+			TermRecord record;
+			std::memcpy (&record, m_data + m_header.tableOffset + index * sizeof (TermRecord), sizeof (record));
+			return record;
+		}
+
+		std::string_view
+		TermText (const TermRecord& record) const {
+			return {reinterpret_cast<const char*> (m_data + record.term), record.termSize};
+		}
+
+		/// Appends the entries of @p record, ascending.
+		void
+		Decode (const TermRecord& record, std::vector<u32>& out) const {
+			const auto* p = reinterpret_cast<const u8*> (m_data + record.postings);
+			u32 entry = 0;
+			for (u32 i = 0; i < record.count; ++i) {
+				u32 delta = 0;
+				for (u32 shift = 0;; shift += 7) {
+					const u8 byte = *p++;
+					delta |= static_cast<u32> (byte & 0x7f) << shift;
+					if (!(byte & 0x80)) break;
+				}
+				entry += delta;
+				out.push_back (entry);
+			}
+		}
+
+		/// Replaces @p out with the entries of every term starting with @p prefix, ascending.
+		void
+		Postings (std::string_view prefix, std::vector<u32>& out) const {
+			out.clear ();
+			size_t low = 0;
+			size_t high = TermCount ();
+			while (low < high) {
+				const size_t mid = (low + high) / 2;
+				if (TermText (Term (mid)) < prefix) {
+					low = mid + 1;
+				}
+				else {
+					high = mid;
+				}
+			}
+			size_t terms = 0;
+			for (size_t i = low; i < TermCount (); ++i, ++terms) {
+				const TermRecord record = Term (i);
+				if (!TermText (record).starts_with (prefix)) break;
+				Decode (record, out);
+			}
+			if (terms > 1) {
+				std::ranges::sort (out);
+				out.erase (std::unique (out.begin (), out.end ()), out.end ());
+			}
+		}
+
+	private:
+		Segment (const std::byte* data, size_t size) : m_data (data), m_size (size) {}
+
+		const std::byte* m_data;
+		size_t m_size;
+		SegmentHeader m_header;
+		std::filesystem::path m_path;
+	};
+
+	result<std::unique_ptr<HistoryStore>, std::string>
+	HistoryStore::Open (const std::filesystem::path& directory, std::function<void ()> notify) {
+		std::error_code ec;
+		std::filesystem::create_directories (directory, ec);
+		if (ec) return std::unexpected ("Cannot create " + directory.string () + ": " + ec.message ());
+
+		std::unique_ptr<HistoryStore> store (new HistoryStore (directory, std::move (notify)));
+		std::string error;
+		if (!store->Recover (error)) return std::unexpected (std::move (error));
+		store->m_writer = std::jthread ([raw = store.get ()] (std::stop_token stop) { raw->WriteLoop (stop); });
+		return store;
+	}
+
+	std::optional<std::filesystem::path>
+	HistoryStore::DefaultDirectory () {
+		if (const char* dir = std::getenv ("AMBIDB_DATA_DIR"); dir && *dir) return std::filesystem::path (dir);
+		if (const char* dir = std::getenv ("XDG_DATA_HOME"); dir && *dir) return std::filesystem::path (dir) / "ambidb";
+		if (const char* home = std::getenv ("HOME"); home && *home) return std::filesystem::path (home) / ".local" / "share" / "ambidb";
+		return std::nullopt;
+	}
+
+	HistoryStore::HistoryStore (std::filesystem::path directory, std::function<void ()> notify)
+		: m_directory (std::move (directory)), m_notify (std::move (notify)) {}
+
+	HistoryStore::~HistoryStore () {
+		m_writer = {};	// Commits what is queued, then joins.
+		const auto release = [] (Mapping& mapping) {
+			if (mapping.data) munmap (const_cast<std::byte*> (mapping.data), mapping.reserved);
+			if (mapping.fd >= 0) close (mapping.fd);
+		};
+		release (m_log);
+		release (m_index);
+		for (const std::unique_ptr<Connection>& connection : m_connections) release (connection->entries);
+		if (m_namesFd >= 0) close (m_namesFd);
+	}
+
+	bool
+	HistoryStore::MapFile (const std::filesystem::path& path, size_t reserve, Mapping& mapping, std::string& error) {
+		mapping.fd = open (path.c_str (), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		struct stat info{};
+		if (mapping.fd < 0 || fstat (mapping.fd, &info) != 0) {
+			error = "Cannot open " + path.string () + ": " + std::strerror (errno);
+			return false;
+		}
+		// Pages past the end of the file are never touched: readers stop at what is committed.
+		void* mapped = mmap (nullptr, reserve, PROT_READ, MAP_SHARED, mapping.fd, 0);
+		if (mapped == MAP_FAILED) {
+			error = "Cannot map " + path.string () + ": " + std::strerror (errno);
+			return false;
+		}
+		mapping.data = static_cast<const std::byte*> (mapped);
+		mapping.reserved = reserve;
+		mapping.size = static_cast<size_t> (info.st_size);
+		return true;
+	}
+
+	bool
+	HistoryStore::AppendTo (Mapping& mapping, const void* data, size_t size) {
+		if (mapping.size + size > mapping.reserved || !WriteAll (mapping.fd, data, size, mapping.size)) return false;
+		mapping.size += size;
+		return true;
+	}
+
+	bool
+	HistoryStore::Truncate (Mapping& mapping, size_t size) {
+		if (ftruncate (mapping.fd, static_cast<off_t> (size)) != 0) return false;
+		mapping.size = size;
+		return true;
+	}
+
+	bool
+	HistoryStore::Recover (std::string& error) {
+		if (!MapFile (m_directory / "history.log", kLogReserve, m_log, error) ||
+			!MapFile (m_directory / "history.idx", kIndexReserve, m_index, error)) {
+			return false;
+		}
+
+		// Drop a torn index record, then entries whose SQL did not reach the log, then any
+		// log bytes no record covers.
+		u32 count = static_cast<u32> (m_index.size / sizeof (IndexRecord));
+		const auto record = [this] (u32 entry) {
+			IndexRecord value;
+			std::memcpy (&value, m_index.data + size_t{entry} * sizeof (IndexRecord), sizeof (value));
+			return value;
+		};
+		while (count > 0 && record (count - 1).offset + record (count - 1).size > m_log.size) --count;
+		const size_t logEnd = count > 0 ? record (count - 1).offset + record (count - 1).size : 0;
+		if ((m_index.size != size_t{count} * sizeof (IndexRecord) && !Truncate (m_index, size_t{count} * sizeof (IndexRecord))) ||
+			(m_log.size != logEnd && !Truncate (m_log, logEnd))) {
+			error = "Cannot repair the history in " + m_directory.string () + ": " + std::strerror (errno);
+			return false;
+		}
+		m_count.store (count, std::memory_order_release);
+		m_nextEntry = count;
+		m_lastTime = count > 0 ? record (count - 1).time : 0;
+
+		// Connection names, one per line, numbered in order; each has a file of its entries.
+		const std::filesystem::path names = m_directory / "connections";
+		m_namesFd = open (names.c_str (), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		if (m_namesFd < 0) {
+			error = "Cannot open " + names.string () + ": " + std::strerror (errno);
+			return false;
+		}
+		std::string text;
+		char buffer [4096];
+		for (ssize_t got; (got = pread (m_namesFd, buffer, sizeof (buffer), static_cast<off_t> (text.size ()))) > 0;) text.append (buffer, static_cast<size_t> (got));
+		for (size_t start = 0, end; (end = text.find ('\n', start)) != std::string::npos; start = end + 1) {
+			auto connection = std::make_unique<Connection> ();
+			connection->name = text.substr (start, end - start);
+			const u32 id = static_cast<u32> (m_connections.size ());
+			if (!MapFile (m_directory / ("conn-" + std::to_string (id) + ".idx"), kEntriesReserve, connection->entries, error)) return false;
+			// Written before the index, so it may list entries of a lost group.
+			const auto* entries = reinterpret_cast<const u32*> (connection->entries.data);
+			const size_t listed = connection->entries.size / sizeof (u32);
+			connection->committed = static_cast<u32> (std::lower_bound (entries, entries + listed, count) - entries);
+			if (connection->entries.size != connection->committed * sizeof (u32)) Truncate (connection->entries, connection->committed * sizeof (u32));
+			m_connectionIds.emplace (connection->name, id);
+			m_connections.push_back (std::move (connection));
+		}
+
+		// Segments chain from entry 0; anything else is left over from an interrupted merge.
+		std::vector<std::unique_ptr<Segment>> found;
+		for (const std::filesystem::directory_entry& file : std::filesystem::directory_iterator (m_directory)) {
+			const std::filesystem::path& path = file.path ();
+			if (path.extension () == ".tmp") {
+				std::filesystem::remove (path);
+				continue;
+			}
+			if (path.extension () != ".seg") continue;
+			std::unique_ptr<Segment> segment = Segment::Open (path);
+			if (segment && segment->End () <= count) {
+				found.push_back (std::move (segment));
+			}
+			else {
+				std::filesystem::remove (path);
+			}
+		}
+		std::ranges::sort (found, [] (const std::unique_ptr<Segment>& a, const std::unique_ptr<Segment>& b) {
+			return a->First () != b->First () ? a->First () < b->First () : a->End () > b->End ();
+		});
+		for (std::unique_ptr<Segment>& segment : found) {
+			if (segment->First () == m_tailStart) {
+				m_tailStart = segment->End ();
+				m_segments.push_back (std::move (segment));
+			}
+			else {
+				std::filesystem::remove (segment->Path ());
+			}
+		}
+
+		// Only the entries after the last segment are read.
+		for (u32 entry = m_tailStart; entry < count; ++entry) IndexTail (entry, At (entry).sql);
+		return true;
+	}
+
+	void
+	HistoryStore::Append (HistoryRecord record) {
+		if (m_failed.load (std::memory_order_relaxed)) return;
+		std::ranges::replace (record.connection, '\n', ' ');
+		u32 connection;
+		bool added = false;
+		{
+			std::lock_guard lock (m_tableMutex);
+			const auto [it, inserted] = m_connectionIds.try_emplace (record.connection, static_cast<u32> (m_connections.size ()));
+			connection = it->second;
+			if (inserted) {
+				auto created = std::make_unique<Connection> ();
+				created->name = record.connection;
+				m_connections.push_back (std::move (created));
+				added = true;
+			}
+		}
+		std::lock_guard lock (m_queueMutex);
+		m_lastTime = std::max (NowMs (), m_lastTime);
+		m_queue.push_back ({m_nextEntry++, connection, added, m_lastTime, std::move (record)});
+		m_wake.notify_one ();
+	}
+
+	void
+	HistoryStore::Flush () {
+		std::unique_lock lock (m_queueMutex);
+		m_idle.wait (lock, [this] { return m_queue.empty () && !m_committing; });
+	}
+
+	HistoryEntry
+	HistoryStore::At (u32 entry) const {
+		IndexRecord record;
+		std::memcpy (&record, m_index.data + size_t{entry} * sizeof (IndexRecord), sizeof (record));
+		return {record.time,
+				record.connection,
+				static_cast<db::QueryStatus> (record.status),
+				record.elapsedMs,
+				record.rows,
+				{reinterpret_cast<const char*> (m_log.data + record.offset), record.size}};
+	}
+
+	u32
+	HistoryStore::FirstAtOrAfter (i64 time) const {
+		u32 low = 0;
+		u32 high = Size ();
+		while (low < high) {
+			const u32 mid = low + (high - low) / 2;
+			i64 at;
+			std::memcpy (&at, m_index.data + size_t{mid} * sizeof (IndexRecord) + offsetof (IndexRecord, time), sizeof (at));
+			if (at < time) {
+				low = mid + 1;
+			}
+			else {
+				high = mid;
+			}
+		}
+		return low;
+	}
+
+	u32
+	HistoryStore::ConnectionCount () const {
+		std::lock_guard lock (m_tableMutex);
+		return static_cast<u32> (m_connections.size ());
+	}
+
+	std::string_view
+	HistoryStore::ConnectionName (u32 connection) const {
+		std::lock_guard lock (m_tableMutex);
+		return connection < m_connections.size () ? std::string_view (m_connections [connection]->name) : std::string_view ();
+	}
+
+	std::span<const u32>
+	HistoryStore::EntriesOf (u32 connection) const {
+		std::lock_guard lock (m_tableMutex);
+		if (connection >= m_connections.size () || !m_connections [connection]->entries.data) return {};
+		const Connection& found = *m_connections [connection];
+		return {reinterpret_cast<const u32*> (found.entries.data), found.committed};
+	}
+
+	void
+	HistoryStore::Search (std::string_view query, size_t limit, std::vector<u32>& hits, const HistoryFilter& filter) const {
+		hits.clear ();
+		std::vector<std::string> words;
+		ForEachWord (query, 1, [&] (std::string_view word) {
+			if (std::ranges::find (words, word) == words.end ()) words.emplace_back (word);
+		});
+		if (words.empty () || limit == 0) return;
+
+		// Entries are in time order, so the window is everything from one entry on.
+		const u32 first = FirstAtOrAfter (filter.since);
+
+		std::shared_lock lock (m_textMutex);
+		std::vector<u32> matched;
+		std::vector<u32> more;
+		std::vector<u32> both;
+		// Entries of one source matching every word and the filter, appended newest first.
+		const auto collect = [&] (auto&& postings) {
+			postings (words.front (), matched);
+			for (size_t i = 1; i < words.size () && !matched.empty (); ++i) {
+				postings (words [i], more);
+				both.clear ();
+				std::ranges::set_intersection (matched, more, std::back_inserter (both));
+				matched.swap (both);
+			}
+			for (auto it = matched.rbegin (); it != matched.rend () && hits.size () < limit; ++it) {
+				if (*it < first) break;
+				if (filter.connection && At (*it).connection != *filter.connection) continue;
+				hits.push_back (*it);
+			}
+		};
+
+		collect ([this] (std::string_view prefix, std::vector<u32>& out) {
+			out.clear ();
+			size_t terms = 0;
+			for (auto it = m_tail.lower_bound (prefix); it != m_tail.end () && it->first.starts_with (prefix); ++it, ++terms) {
+				out.insert (out.end (), it->second.begin (), it->second.end ());
+			}
+			if (terms > 1) {
+				std::ranges::sort (out);
+				out.erase (std::unique (out.begin (), out.end ()), out.end ());
+			}
+		});
+		// Newer segments first; older ones are not touched once the limit or the start of the
+		// time window is reached.
+		for (auto segment = m_segments.rbegin (); segment != m_segments.rend () && hits.size () < limit && (*segment)->End () > first; ++segment) {
+			collect ([&] (std::string_view prefix, std::vector<u32>& out) { (*segment)->Postings (prefix, out); });
+		}
+	}
+
+	void
+	HistoryStore::IndexTail (u32 entry, std::string_view sql) {
+		ForEachWord (sql, kMinIndexedWord, [&] (std::string_view word) {
+			auto it = m_tail.find (word);
+			if (it == m_tail.end ()) it = m_tail.emplace (std::string (word), std::vector<u32>{}).first;
+			if (it->second.empty () || it->second.back () != entry) it->second.push_back (entry);
+		});
+	}
+
+	void
+	HistoryStore::WriteLoop (std::stop_token stop) {
+		while (true) {
+			std::vector<Pending> group;
+			{
+				std::unique_lock lock (m_queueMutex);
+				// On stop, whatever is still queued is committed before the thread ends.
+				if (!m_wake.wait (lock, stop, [this] { return !m_queue.empty (); })) return;
+				group.swap (m_queue);
+				m_committing = true;
+			}
+			if (!m_failed.load (std::memory_order_relaxed) && !Commit (group)) {
+				std::println (stderr, "Query history disabled, writing {} failed: {}", m_directory.string (), std::strerror (errno));
+				m_failed.store (true, std::memory_order_relaxed);
+			}
+			{
+				std::lock_guard lock (m_queueMutex);
+				m_committing = false;
+				m_idle.notify_all ();
+			}
+			if (m_notify) m_notify ();
+		}
+	}
+
+	bool
+	HistoryStore::Commit (std::vector<Pending>& group) {
+		std::string names;
+		std::string log;
+		std::vector<IndexRecord> records;
+		std::map<u32, std::vector<u32>> perConnection;
+		records.reserve (group.size ());
+		for (const Pending& pending : group) {
+			if (pending.newConnection) names += pending.record.connection + '\n';
+			const u32 size = static_cast<u32> (pending.record.sql.size ());
+			log.append (reinterpret_cast<const char*> (&size), sizeof (size));
+			IndexRecord& record = records.emplace_back ();
+			record.offset = m_log.size + log.size ();
+			record.time = pending.time;
+			record.elapsedMs = pending.record.elapsedMs;
+			record.rows = pending.record.rows;
+			record.size = size;
+			record.connection = pending.connection;
+			record.status = static_cast<u8> (pending.record.status);
+			log += pending.record.sql;
+			perConnection [pending.connection].push_back (pending.entry);
+		}
+
+		// Everything an index record points at is durable before the record is written.
+		if (!names.empty () && (write (m_namesFd, names.data (), names.size ()) != static_cast<ssize_t> (names.size ()) || fdatasync (m_namesFd) != 0)) {
+			return false;
+		}
+		if (!AppendTo (m_log, log.data (), log.size ()) || fdatasync (m_log.fd) != 0) return false;
+		for (const auto& [id, entries] : perConnection) {
+			Connection* connection;
+			{
+				std::lock_guard lock (m_tableMutex);
+				connection = m_connections [id].get ();
+			}
+			if (!connection->entries.data) {
+				std::string error;
+				Mapping mapping;
+				if (!MapFile (m_directory / ("conn-" + std::to_string (id) + ".idx"), kEntriesReserve, mapping, error)) return false;
+				std::lock_guard lock (m_tableMutex);
+				connection->entries = mapping;
+			}
+			if (!AppendTo (connection->entries, entries.data (), entries.size () * sizeof (u32)) || fdatasync (connection->entries.fd) != 0) return false;
+		}
+		if (!AppendTo (m_index, records.data (), records.size () * sizeof (IndexRecord)) || fdatasync (m_index.fd) != 0) return false;
+
+		{
+			std::lock_guard lock (m_tableMutex);
+			for (const auto& [id, entries] : perConnection) m_connections [id]->committed += static_cast<u32> (entries.size ());
+		}
+		m_count.store (group.back ().entry + 1, std::memory_order_release);
+		{
+			std::unique_lock lock (m_textMutex);
+			for (const Pending& pending : group) IndexTail (pending.entry, pending.record.sql);
+		}
+		if (Size () - m_tailStart >= kSegmentEntries) SealTail ();
+		m_generation.fetch_add (1, std::memory_order_acq_rel);
+		return true;
+	}
+
+	void
+	HistoryStore::SealTail () {
+		// Only this thread changes m_tail, so reading it needs no lock.
+		const u32 first = m_tailStart;
+		const u32 end = Size ();
+		const std::filesystem::path path = m_directory / SegmentName (first, end);
+		const std::filesystem::path temp = path.string () + ".tmp";
+		SegmentBuilder builder;
+		bool written = builder.Begin (temp);
+		for (auto it = m_tail.begin (); written && it != m_tail.end (); ++it) written = builder.Add (it->first, it->second);
+		std::error_code ec;
+		if (!written || !builder.Finish (first, end) || (std::filesystem::rename (temp, path, ec), ec)) {
+			// The tail keeps growing in memory; the next commit tries again.
+			std::filesystem::remove (temp, ec);
+			return;
+		}
+		std::unique_ptr<Segment> segment = Segment::Open (path);
+		if (!segment) return;
+		{
+			std::unique_lock lock (m_textMutex);
+			m_segments.push_back (std::move (segment));
+			m_tail.clear ();
+			m_tailStart = end;
+		}
+		MergeSegments ();
+	}
+
+	void
+	HistoryStore::MergeSegments () {
+		// A segment's level is how many merges its span is past kSegmentEntries.
+		const auto level = [] (const Segment& segment) {
+			size_t span = (segment.End () - segment.First ()) / kSegmentEntries;
+			u32 value = 0;
+			while (span >= kMergeFanIn) {
+				span /= kMergeFanIn;
+				++value;
+			}
+			return value;
+		};
+
+		while (m_segments.size () >= kMergeFanIn) {
+			const size_t from = m_segments.size () - kMergeFanIn;
+			const u32 target = level (*m_segments [from]);
+			if (!std::all_of (m_segments.begin () + static_cast<std::ptrdiff_t> (from), m_segments.end (), [&] (const auto& s) {
+					return level (*s) == target;
+				})) {
+				return;
+			}
+			// Readers only take the lock shared, and segments only change on this thread.
+			std::vector<const Segment*> inputs;
+			for (size_t i = from; i < m_segments.size (); ++i) inputs.push_back (m_segments [i].get ());
+			const u32 first = inputs.front ()->First ();
+			const u32 end = inputs.back ()->End ();
+			const std::filesystem::path path = m_directory / SegmentName (first, end);
+			const std::filesystem::path temp = path.string () + ".tmp";
+
+			// k-way merge of the sorted term tables; inputs cover ascending, disjoint ranges,
+			// so one term's postings are their concatenation in input order.
+			SegmentBuilder builder;
+			bool written = builder.Begin (temp);
+			std::vector<size_t> next (inputs.size (), 0);
+			std::vector<u32> postings;
+			while (written) {
+				std::string_view term;
+				bool any = false;
+				for (size_t i = 0; i < inputs.size (); ++i) {
+					if (next [i] == inputs [i]->TermCount ()) continue;
+					const std::string_view candidate = inputs [i]->TermText (inputs [i]->Term (next [i]));
+					if (!any || candidate < term) term = candidate;
+					any = true;
+				}
+				if (!any) break;
+				postings.clear ();
+				for (size_t i = 0; i < inputs.size (); ++i) {
+					if (next [i] == inputs [i]->TermCount ()) continue;
+					const TermRecord record = inputs [i]->Term (next [i]);
+					if (inputs [i]->TermText (record) != term) continue;
+					inputs [i]->Decode (record, postings);
+					++next [i];
+				}
+				written = builder.Add (term, postings);
+			}
+			std::error_code ec;
+			if (!written || !builder.Finish (first, end) || (std::filesystem::rename (temp, path, ec), ec)) {
+				std::filesystem::remove (temp, ec);
+				return;
+			}
+			std::unique_ptr<Segment> merged = Segment::Open (path);
+			if (!merged) return;
+
+			std::vector<std::unique_ptr<Segment>> replaced;
+			{
+				std::unique_lock lock (m_textMutex);
+				replaced.assign (std::make_move_iterator (m_segments.begin () + static_cast<std::ptrdiff_t> (from)), std::make_move_iterator (m_segments.end ()));
+				m_segments.resize (from);
+				m_segments.push_back (std::move (merged));
+			}
+			for (const std::unique_ptr<Segment>& old : replaced) std::filesystem::remove (old->Path (), ec);
+		}
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <macro.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "db/query_executor.h"
+
+namespace ambidb {
+
+	/// A query to remember, as passed to HistoryStore::Append ().
+	struct HistoryRecord {
+		std::string connection;	 ///< Connection name; entries are grouped by it.
+		std::string sql;
+		db::QueryStatus status{db::QueryStatus::Ok};
+		f64 elapsedMs{0.0};
+		i64 rows{0};  ///< Rows returned, or changed for statements without a result.
+	};
+
+	/// A stored entry. sql points into the mapped log and lives as long as the store.
+	struct HistoryEntry {
+		i64 time{0};  ///< Milliseconds since the Unix epoch; never decreases along the log.
+		u32 connection{0};
+		db::QueryStatus status{db::QueryStatus::Ok};
+		f64 elapsedMs{0.0};
+		i64 rows{0};
+		std::string_view sql;
+	};
+
+	/// Restricts HistoryStore::Search () to part of the history.
+	struct HistoryFilter {
+		std::optional<u32> connection;	///< Only entries of this connection.
+		i64 since{0};					///< Only entries at or after this time.
+	};
+
+	/**
+	 * @brief Query history kept on disk, opened by mapping its files instead of reading them.
+	 *
+	 * The SQL goes into an append-only log; a fixed-size record per entry in a second file
+	 * holds its offset and metadata, so entry i is found by address and the list of every
+	 * query ever run pages in only what is shown. Entries are appended in time order, which
+	 * makes that same file the time index (FirstAtOrAfter () is a binary search), and each
+	 * connection has a file listing its entries. All files are mapped with room to grow, so
+	 * appends become visible without remapping.
+	 *
+	 * Append () only queues. A writer thread commits everything queued at once (group
+	 * commit): the log and connection files are written and synced, then the index
+	 * records, which are the commit point. A crash mid-group loses that group only; Open ()
+	 * trims whatever the index does not cover.
+	 *
+	 * Full-text search uses an inverted index on disk. New entries go into an in-memory
+	 * tail; every kSegmentEntries entries the tail is written out as an immutable segment
+	 * (sorted terms plus delta-encoded postings), and kMergeFanIn segments of one size are
+	 * merged into one of the next size, so a year of history is a few dozen files. Open ()
+	 * maps the segments and re-reads only the tail's entries from the log.
+	 *
+	 * Append (), Search () and the readers are called from one thread (the UI's).
+	 */
+	class HistoryStore {
+	public:
+		static constexpr size_t kSegmentEntries = 4096;
+		static constexpr size_t kMergeFanIn = 8;
+
+		MAKE_NONCOPYABLE (HistoryStore);
+		MAKE_NONMOVABLE (HistoryStore);
+		/// Commits what is queued, then closes the files.
+		~HistoryStore ();
+
+		/**
+		 * @brief Open or create the history in @p directory. @p notify is called from the
+		 * writer thread after each commit.
+		 */
+		static result<std::unique_ptr<HistoryStore>, std::string>
+		Open (const std::filesystem::path& directory, std::function<void ()> notify = {});
+
+		/// $AMBIDB_DATA_DIR, else $XDG_DATA_HOME/ambidb, else ~/.local/share/ambidb.
+		static std::optional<std::filesystem::path>
+		DefaultDirectory ();
+
+		/// Queue @p record, stamped with the current time.
+		void
+		Append (HistoryRecord record);
+
+		/// Block until everything queued is committed.
+		void
+		Flush ();
+
+		/// Committed entries.
+		u32
+		Size () const {
+			return m_count.load (std::memory_order_acquire);
+		}
+
+		/// Bumped after every commit.
+		u64
+		Generation () const {
+			return m_generation.load (std::memory_order_acquire);
+		}
+
+		/// @p entry < Size ().
+		HistoryEntry
+		At (u32 entry) const;
+
+		/// First entry at or after @p time, or Size ().
+		u32
+		FirstAtOrAfter (i64 time) const;
+
+		u32
+		ConnectionCount () const;
+
+		std::string_view
+		ConnectionName (u32 connection) const;
+
+		/// Committed entries of @p connection, ascending.
+		std::span<const u32>
+		EntriesOf (u32 connection) const;
+
+		/**
+		 * @brief Replace @p hits with the newest @p limit entries that pass @p filter and
+		 * contain every word of @p query, each as a word prefix, newest first. Words are runs
+		 * of letters, digits, '_' and non-ASCII bytes, compared ignoring ASCII case.
+		 */
+		void
+		Search (std::string_view query, size_t limit, std::vector<u32>& hits, const HistoryFilter& filter = {}) const;
+
+	private:
+		struct Mapping {
+			int fd{-1};
+			const std::byte* data{nullptr};
+			size_t reserved{0};
+			size_t size{0};	 ///< File size; written by the writer thread only.
+		};
+
+		struct Connection {
+			std::string name;
+			Mapping entries;
+			u32 committed{0};  ///< Guarded by m_tableMutex.
+		};
+
+		class Segment;
+
+		struct Pending {
+			u32 entry{0};
+			u32 connection{0};
+			bool newConnection{false};
+			i64 time{0};
+			HistoryRecord record;
+		};
+
+		HistoryStore (std::filesystem::path directory, std::function<void ()> notify);
+
+		static bool
+		MapFile (const std::filesystem::path& path, size_t reserve, Mapping& mapping, std::string& error);
+		/// Write at the end of the file; the bytes are readable through the mapping after.
+		static bool
+		AppendTo (Mapping& mapping, const void* data, size_t size);
+		static bool
+		Truncate (Mapping& mapping, size_t size);
+
+		bool
+		Recover (std::string& error);
+		void
+		WriteLoop (std::stop_token stop);
+		bool
+		Commit (std::vector<Pending>& group);
+		void
+		IndexTail (u32 entry, std::string_view sql);
+		void
+		SealTail ();
+		void
+		MergeSegments ();
+
+		std::filesystem::path m_directory;
+		std::function<void ()> m_notify;
+		Mapping m_log;
+		Mapping m_index;
+
+		// Connection names are assigned by Append () and their files opened by the writer.
+		mutable std::mutex m_tableMutex;
+		std::vector<std::unique_ptr<Connection>> m_connections;
+		std::unordered_map<std::string, u32> m_connectionIds;
+		int m_namesFd{-1};
+
+		std::mutex m_queueMutex;
+		std::condition_variable_any m_wake;
+		std::condition_variable_any m_idle;
+		std::vector<Pending> m_queue;
+		u32 m_nextEntry{0};
+		i64 m_lastTime{0};
+		bool m_committing{false};
+
+		mutable std::shared_mutex m_textMutex;	///< Guards the full-text index below.
+		std::vector<std::unique_ptr<Segment>> m_segments;  ///< Ascending, covering [0, m_tailStart).
+		u32 m_tailStart{0};
+		std::map<std::string, std::vector<u32>, std::less<>> m_tail;  ///< Term -> entries from m_tailStart.
+
+		std::atomic<u32> m_count{0};
+		std::atomic<u64> m_generation{0};
+		std::atomic<bool> m_failed{false};	///< A commit failed; later entries are dropped.
+
+		std::jthread m_writer;	///< Last member: stops before the rest is destroyed.
+	};
+
+}  // namespace ambidb
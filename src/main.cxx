@@ -8,8 +8,32 @@ using Backend = ambidb::TuiBackend;
 #  error "No backend defined! Set AMBIDB_GUI or AMBIDB_TUI"
 #endif
 
+#ifdef AMBIDB_GUI_MODULE
+// Single binary: Backend is the linked-in TUI; the GUI is a dlopen()ed module.
+#  include "backends/backend_select.h"
+#  include <print>
+#  include <unistd.h>
+#endif
+
 int
-main () {
+main ([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
+#ifdef AMBIDB_GUI_MODULE
+	const std::optional<ambidb::BackendKind> kind = ambidb::SelectBackend (argc, argv);
+	if (!kind) {
+		return 2;
+	}
+	if (*kind == ambidb::BackendKind::Gui) {
+		const int result = ambidb::RunGuiModule ();
+		if (result != ambidb::kGuiUnavailable) {
+			return result;
+		}
+		if (!isatty (STDIN_FILENO) || !isatty (STDOUT_FILENO)) {
+			return 1;
+		}
+		std::println (stderr, "GUI unavailable, falling back to the terminal UI.");
+	}
+#endif
+
 	Backend backend;
 
 	if (!backend.Initialize ()) {
@@ -0,0 +1,113 @@
+#include "present_gate.h"
+
+#include "imgui.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace ambidb {
+
+	namespace {
+
+		constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+
+		constexpr uint64_t
+		Mix (uint64_t hash, uint64_t value) {
+			hash ^= value;
+			hash *= kMultiplier;
+			return hash ^ (hash >> 29);
+		}
+
+		uint64_t
+		LoadWord (const unsigned char* bytes) {
+			uint64_t word;
+			std::memcpy (&word, bytes, sizeof (word));
+			return word;
+		}
+
+		/**
+		 * Four independent lanes so the multiplies overlap; vertex buffers are the
+		 * bulk of the input and this runs every frame.
+		 */
+		uint64_t
+		HashBytes (uint64_t hash, const void* data, size_t size) {
+			const auto* bytes = static_cast<const unsigned char*> (data);
+			uint64_t lanes [4] = {hash, hash ^ 1, hash ^ 2, hash ^ 3};
+			while (size >= 32) {
+				lanes [0] = Mix (lanes [0], LoadWord (bytes));
+				lanes [1] = Mix (lanes [1], LoadWord (bytes + 8));
+				lanes [2] = Mix (lanes [2], LoadWord (bytes + 16));
+				lanes [3] = Mix (lanes [3], LoadWord (bytes + 24));
+				bytes += 32;
+				size -= 32;
+			}
+			hash = Mix (Mix (Mix (lanes [0], lanes [1]), lanes [2]), lanes [3]);
+			while (size >= 8) {
+				hash = Mix (hash, LoadWord (bytes));
+				bytes += 8;
+				size -= 8;
+			}
+			uint64_t tail = 0;
+			std::memcpy (&tail, bytes, size);
+			return Mix (hash, tail ^ (static_cast<uint64_t> (size) << 56));
+		}
+
+		template <typename T>
+		uint64_t
+		HashValue (uint64_t hash, const T& value) {
+			return HashBytes (hash, &value, sizeof (value));
+		}
+
+	}  // namespace
+
+	uint64_t
+	FingerprintDrawData (const ImDrawData& drawData) {
+		uint64_t hash = Mix (0, static_cast<uint64_t> (drawData.CmdListsCount));
+		hash = HashValue (hash, drawData.DisplayPos);
+		hash = HashValue (hash, drawData.DisplaySize);
+		hash = HashValue (hash, drawData.FramebufferScale);
+
+		for (int i = 0; i < drawData.CmdListsCount; ++i) {
+			const ImDrawList* list = drawData.CmdLists [i];
+			hash = Mix (hash, (static_cast<uint64_t> (list->VtxBuffer.Size) << 32) | static_cast<uint32_t> (list->IdxBuffer.Size));
+			hash = HashBytes (hash, list->VtxBuffer.Data, sizeof (ImDrawVert) * static_cast<size_t> (list->VtxBuffer.Size));
+			hash = HashBytes (hash, list->IdxBuffer.Data, sizeof (ImDrawIdx) * static_cast<size_t> (list->IdxBuffer.Size));
+
+			// Field by field: ImDrawCmd has padding whose contents are unspecified.
+			for (const ImDrawCmd& cmd : list->CmdBuffer) {
+				hash = HashValue (hash, cmd.ClipRect);
+				hash = HashValue (hash, cmd.TextureId);
+				hash = Mix (hash, (static_cast<uint64_t> (cmd.VtxOffset) << 32) | cmd.IdxOffset);
+				hash = Mix (hash, cmd.ElemCount);
+			}
+		}
+		return hash;
+	}
+
+	bool
+	PresentGate::ShouldPresent (const ImDrawData* drawData) {
+		bool hasCallback = false;
+		if (drawData) {
+			for (int i = 0; i < drawData->CmdListsCount && !hasCallback; ++i) {
+				for (const ImDrawCmd& cmd : drawData->CmdLists [i]->CmdBuffer) {
+					if (cmd.UserCallback) {
+						hasCallback = true;
+						break;
+					}
+				}
+			}
+		}
+
+		const uint64_t fingerprint = drawData ? FingerprintDrawData (*drawData) : 0;
+		if (m_hasLast && !hasCallback && fingerprint == m_last) {
+			++m_elided;
+			return false;
+		}
+
+		m_last = fingerprint;
+		m_hasLast = !hasCallback;
+		++m_presented;
+		return true;
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <macro.h>
+
+#include <cstdint>
+
+struct ImDrawData;
+
+namespace ambidb {
+
+	/**
+	 * @brief 64-bit fingerprint of everything a renderer reads from @p drawData:
+	 * display rect, framebuffer scale, vertex and index buffers and every command's
+	 * clip rect, texture, offsets and element count.
+	 *
+	 * Vertex data is part of the hash because hover and active states usually only
+	 * change vertex colors, leaving counts and commands identical.
+	 */
+	uint64_t
+	FingerprintDrawData (const ImDrawData& drawData);
+
+	/**
+	 * @brief Decides whether a rendered frame needs to reach the screen.
+	 *
+	 * Backends call ShouldPresent() after ImGui::Render(); when the draw data is
+	 * identical to the last presented frame, the GPU upload and swap (GUI) or the
+	 * rasterization and terminal write (TUI) are skipped. Frames containing user
+	 * draw callbacks are always presented since their output cannot be hashed.
+	 */
+	class PresentGate {
+	public:
+		MAKE_NONCOPYABLE (PresentGate);
+		MAKE_NONMOVABLE (PresentGate);
+		PresentGate () = default;
+		~PresentGate () = default;
+
+		/**
+		 * @return true if the frame differs from the last presented one.
+		 * Counts the frame as presented or elided accordingly.
+		 */
+		bool
+		ShouldPresent (const ImDrawData* drawData);
+
+		/**
+		 * @brief The screen contents are lost (expose, resize, failed write); present the next frame.
+		 */
+		void
+		Invalidate () {
+			m_hasLast = false;
+		}
+
+		uint64_t
+		PresentedFrames () const {
+			return m_presented;
+		}
+
+		uint64_t
+		ElidedFrames () const {
+			return m_elided;
+		}
+
+	private:
+		uint64_t m_last = 0;
+		bool m_hasLast = false;
+		uint64_t m_presented = 0;
+		uint64_t m_elided = 0;
+	};
+
+}  // namespace ambidb
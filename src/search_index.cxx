@@ -0,0 +1,331 @@
+#include "search_index.h"
+
+#include "db/parallel.h"
+#include "db/result_filter.h"
+
+#include <algorithm>
+
+namespace ambidb {
+
+	namespace {
+
+		/// Longer queries are cut here; their first trigrams are plenty to rank by.
+		constexpr size_t kMaxQuery = 256;
+
+		/// Removed entries are purged from the postings once there are this many and more than live ones.
+		constexpr size_t kCompactDead = 4096;
+
+		/// Short queries scan the arena on one more thread per this many bytes, up to one per core.
+		constexpr size_t kScanBytesPerThread = size_t{1} << 20;
+
+		char
+		Lower (char c) {
+			return (c >= 'A' && c <= 'Z') ? static_cast<char> (c | 0x20) : c;
+		}
+
+		std::string
+		ToLower (std::string_view text) {
+			std::string lower (text);
+			std::ranges::transform (lower, lower.begin (), Lower);
+			return lower;
+		}
+
+		/// Distinct trigrams of @p lower, each packed as three bytes of a u32, ascending.
+		void
+		Trigrams (std::string_view lower, std::vector<u32>& out) {
+			out.clear ();
+			for (size_t i = 0; i + 3 <= lower.size (); ++i) {
+				const auto byte = [&] (size_t at) { return static_cast<u32> (static_cast<unsigned char> (lower [at])); };
+				out.push_back ((byte (i) << 16) | (byte (i + 1) << 8) | byte (i + 2));
+			}
+			std::ranges::sort (out);
+			out.erase (std::unique (out.begin (), out.end ()), out.end ());
+		}
+
+		/**
+		 * @brief Rank of @p lower for @p query given the share of query trigrams it holds.
+		 * An exact substring beats any fuzzy match, a prefix beats a substring, and among
+		 * equals the shorter name wins. Without @p whole (some trigram is missing) the name
+		 * cannot contain the query, so the substring check is skipped.
+		 */
+		float
+		Score (std::string_view lower, std::string_view query, float overlap, bool whole) {
+			float score = overlap;
+			const size_t at = whole ? lower.find (query) : std::string_view::npos;
+			if (at != std::string_view::npos) score += at == 0 ? 1.5f : 1.0f;
+			return score - static_cast<float> (std::min<size_t> (lower.size (), 1000)) * 1e-4f;
+		}
+
+		struct Candidate {
+			u32 entry;
+			float score;
+		};
+
+		/// Keeps the best @p limit candidates offered, as a heap whose front is the worst of them.
+		class TopCandidates {
+		public:
+			explicit TopCandidates (size_t limit) : m_limit (limit) {
+				m_heap.reserve (limit);
+			}
+
+			void
+			Offer (u32 entry, float score) {
+				const Candidate candidate{entry, score};
+				if (m_heap.size () == m_limit) {
+					if (!Better (candidate, m_heap.front ())) return;
+					std::ranges::pop_heap (m_heap, Better);
+					m_heap.back () = candidate;
+				}
+				else {
+					m_heap.push_back (candidate);
+				}
+				std::ranges::push_heap (m_heap, Better);
+			}
+
+			void
+			Merge (const TopCandidates& other) {
+				for (const Candidate& candidate : other.m_heap) Offer (candidate.entry, candidate.score);
+			}
+
+			/// Best first; empties the heap.
+			std::vector<Candidate>
+			Take () {
+				std::ranges::sort_heap (m_heap, Better);
+				return std::move (m_heap);
+			}
+
+		private:
+			static bool
+			Better (const Candidate& a, const Candidate& b) {
+				return a.score != b.score ? a.score > b.score : a.entry < b.entry;
+			}
+
+			size_t m_limit;
+			std::vector<Candidate> m_heap;
+		};
+
+	}  // namespace
+
+	const char*
+	SearchKindName (SearchKind kind) {
+		switch (kind) {
+			case SearchKind::Page: return "page";
+			case SearchKind::Connection: return "connection";
+			case SearchKind::History: return "history";
+			case SearchKind::Schema: return "schema";
+			case SearchKind::Table: return "table";
+			case SearchKind::Column: return "column";
+		}
+		UNREACHABLE ();
+	}
+
+	SearchIndex::SearchIndex (std::function<void ()> notify)
+		: m_notify (std::move (notify)), m_thread ([this] (std::stop_token stop) { Run (stop); }) {}
+
+	SearchIndex::~SearchIndex () = default;
+
+	u32
+	SearchIndex::Add (SearchKind kind, std::string text, u64 target) {
+		std::lock_guard lock (m_queueMutex);
+		const u32 entry = m_nextEntry++;
+		m_queue.push_back ({entry, false, kind, target, std::move (text)});
+		m_wake.notify_one ();
+		return entry;
+	}
+
+	void
+	SearchIndex::Remove (u32 entry) {
+		std::lock_guard lock (m_queueMutex);
+		m_queue.push_back ({entry, true, SearchKind::Page, 0, {}});
+		m_wake.notify_one ();
+	}
+
+	void
+	SearchIndex::Flush () {
+		std::unique_lock lock (m_queueMutex);
+		m_idle.wait (lock, [this] { return m_queue.empty () && !m_applying; });
+	}
+
+	size_t
+	SearchIndex::Size () const {
+		std::shared_lock lock (m_indexMutex);
+		return m_live;
+	}
+
+	void
+	SearchIndex::Run (std::stop_token stop) {
+		std::vector<Change> batch;
+		while (true) {
+			{
+				std::unique_lock lock (m_queueMutex);
+				m_applying = false;
+				m_idle.notify_all ();
+				if (!m_wake.wait (lock, stop, [this] { return !m_queue.empty (); })) return;
+				const size_t count = std::min (m_queue.size (), kBatchEntries);
+				batch.assign (std::make_move_iterator (m_queue.begin ()), std::make_move_iterator (m_queue.begin () + count));
+				m_queue.erase (m_queue.begin (), m_queue.begin () + count);
+				m_applying = true;
+			}
+			Apply (batch);
+			m_generation.fetch_add (1, std::memory_order_release);
+			if (m_notify) m_notify ();
+		}
+	}
+
+	void
+	SearchIndex::Apply (std::vector<Change>& changes) {
+		std::vector<u32> trigrams;
+		std::unique_lock lock (m_indexMutex);
+		for (Change& change : changes) {
+			if (change.remove) {
+				if (change.entry >= m_entries.size () || !m_entries [change.entry].live) continue;
+				Entry& entry = m_entries [change.entry];
+				entry.live = false;
+				entry.text = {};
+				--m_live;
+				++m_dead;
+				continue;
+			}
+
+			// Changes arrive in id order, so every posting list stays sorted.
+			if (change.entry >= m_entries.size ()) {
+				m_entries.resize (change.entry + 1);
+				m_starts.resize (change.entry + 1, m_lower.size ());
+			}
+			Entry& entry = m_entries [change.entry];
+			m_starts [change.entry] = m_lower.size ();
+			entry.size = static_cast<u32> (change.text.size ());
+			entry.kind = change.kind;
+			entry.target = change.target;
+			entry.live = true;
+			// Names hold no NUL, so an arena hit never spans two of them.
+			m_lower += ToLower (change.text);
+			m_lower += '\0';
+			entry.text = std::move (change.text);
+			++m_live;
+			Trigrams (Lower (change.entry), trigrams);
+			for (const u32 trigram : trigrams) m_postings [trigram].push_back (change.entry);
+		}
+		if (m_dead >= kCompactDead && m_dead > m_live) Compact ();
+	}
+
+	void
+	SearchIndex::Compact () {
+		for (auto it = m_postings.begin (); it != m_postings.end ();) {
+			std::erase_if (it->second, [this] (u32 entry) { return !m_entries [entry].live; });
+			it = it->second.empty () ? m_postings.erase (it) : std::next (it);
+		}
+		// Removed entries keep their slot as an empty name where the next one starts.
+		std::string lower;
+		lower.reserve (m_lower.size ());
+		for (u32 id = 0; id < m_entries.size (); ++id) {
+			Entry& entry = m_entries [id];
+			const std::string_view text = Lower (id);
+			m_starts [id] = lower.size ();
+			if (!entry.live) {
+				entry.size = 0;
+				continue;
+			}
+			lower += text;
+			lower += '\0';
+		}
+		m_lower = std::move (lower);
+		m_dead = 0;
+	}
+
+	u32
+	SearchIndex::EntryAt (size_t at, u32 first) const {
+		// Hits come in order and often close together, so gallop from the previous one; the
+		// answer is the last entry starting at or before @p at (empty ones sharing its offset
+		// come first).
+		const size_t count = m_starts.size ();
+		size_t low = first, step = 1;
+		while (low + step < count && m_starts [low + step] <= at) {
+			low += step;
+			step *= 2;
+		}
+		const auto it = std::upper_bound (m_starts.begin () + low, m_starts.begin () + std::min (low + step, count), at);
+		return static_cast<u32> (it - m_starts.begin ()) - 1;
+	}
+
+	void
+	SearchIndex::Search (std::string_view query, size_t limit, std::vector<SearchHit>& hits) {
+		hits.clear ();
+		if (query.empty () || limit == 0) return;
+		const std::string lower = ToLower (query.substr (0, kMaxQuery));
+
+		TopCandidates best (limit);
+		std::shared_lock index (m_indexMutex);
+		std::lock_guard scratch (m_searchMutex);
+		if (lower.size () < 3) {
+			// Each thread scans the texts of a run of entries.
+			const std::string_view arena (m_lower);
+			const size_t threads = std::min (db::ThreadCount (0), arena.size () / kScanBytesPerThread + 1);
+			std::vector<TopCandidates> parts (threads, TopCandidates (limit));
+			db::ParallelFor (threads, [&] (size_t t) {
+				const db::Segment part = db::SegmentOf (m_entries.size (), threads, t);
+				if (part.begin == part.end) return;
+				const size_t end = part.end < m_starts.size () ? m_starts [part.end] : arena.size ();
+				size_t pos = m_starts [part.begin];
+				u32 entry = static_cast<u32> (part.begin);
+				while (pos < end) {
+					const size_t hit = db::FindCaseless (arena.substr (pos, end - pos), lower);
+					if (hit == std::string_view::npos) break;
+					entry = EntryAt (pos + hit, entry);
+					if (m_entries [entry].live) parts [t].Offer (entry, Score (Lower (entry), lower, 1.0f, true));
+					pos = m_starts [entry] + m_entries [entry].size + 1;
+				}
+			});
+			for (const TopCandidates& part : parts) best.Merge (part);
+		}
+		else {
+			std::vector<u32> trigrams;
+			Trigrams (lower, trigrams);
+			std::vector<const std::vector<u32>*> lists;
+			for (const u32 trigram : trigrams) {
+				const auto it = m_postings.find (trigram);
+				lists.push_back (it != m_postings.end () ? &it->second : nullptr);
+			}
+			std::ranges::sort (lists, {}, [] (const std::vector<u32>* list) { return list ? list->size () : 0; });
+
+			// At least half the trigrams must match, which tolerates a typo or two. An entry
+			// missing from all of the first (rarest) `seeds` lists cannot reach that.
+			const size_t need = (trigrams.size () + 1) / 2;
+			const size_t seeds = trigrams.size () - need + 1;
+			m_counts.resize (m_entries.size ());
+			for (size_t i = 0; i < lists.size (); ++i) {
+				if (!lists [i]) continue;
+				const std::vector<u32>& list = *lists [i];
+				if (i < seeds) {
+					for (const u32 entry : list) {
+						if (m_counts [entry]++ == 0) m_touched.push_back (entry);
+					}
+				}
+				else if (m_touched.size () * 16 < list.size ()) {
+					for (const u32 entry : m_touched) m_counts [entry] += std::ranges::binary_search (list, entry);
+				}
+				else {
+					for (const u32 entry : list) m_counts [entry] += m_counts [entry] > 0;
+				}
+			}
+			for (const u32 entry : m_touched) {
+				const Entry& e = m_entries [entry];
+				const size_t shared = m_counts [entry];
+				m_counts [entry] = 0;
+				if (e.live && shared >= need) {
+					const float overlap = static_cast<float> (shared) / static_cast<float> (trigrams.size ());
+					best.Offer (entry, Score (Lower (entry), lower, overlap, shared == trigrams.size ()));
+				}
+			}
+			m_touched.clear ();
+		}
+
+		const std::vector<Candidate> ranked = best.Take ();
+		hits.reserve (ranked.size ());
+		for (const Candidate& candidate : ranked) {
+			const Entry& e = m_entries [candidate.entry];
+			hits.push_back ({candidate.entry, e.kind, e.target, candidate.score, e.text});
+		}
+	}
+
+}  // namespace ambidb
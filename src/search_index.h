@@ -0,0 +1,150 @@
+#pragma once
+
+#include <macro.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ambidb {
+
+	/// What a search entry stands for; the App decides what opening it does.
+	enum class SearchKind : u8 {
+		Page,
+		Connection,
+		History,  ///< A query kept in the HistoryStore.
+		Schema,
+		Table,
+		Column,
+	};
+
+	const char*
+	SearchKindName (SearchKind kind);
+
+	struct SearchHit {
+		u32 entry{0};
+		SearchKind kind{SearchKind::Page};
+		u64 target{0};	///< Whatever the caller passed to Add ().
+		float score{0.0f};
+		std::string text;
+	};
+
+	/**
+	 * @brief Fuzzy name lookup for the search palette, backed by a trigram index.
+	 *
+	 * Each name is lower-cased and split into overlapping three-byte trigrams; every trigram
+	 * keeps a posting list of the entries containing it. A query ranks the entries sharing
+	 * at least half of its trigrams, so typos and transpositions still find the name. Only
+	 * the rarest trigrams' postings propose candidates (any entry sharing half the trigrams
+	 * must hold one of them); the common ones are only checked against those candidates.
+	 * Queries shorter than a trigram scan the lower-cased names, which are packed into one
+	 * NUL-separated arena so the scan is a single vectorized substring search.
+	 *
+	 * Add () and Remove () only queue the change and return; a background thread folds
+	 * queued changes into the index in batches, taking the index lock for one batch at a
+	 * time, and calls notify after each so an open palette can search again. Removed
+	 * entries are skipped at once and dropped from the postings once they pile up.
+	 */
+	class SearchIndex {
+	public:
+		/// Entries applied per exclusive lock, so a bulk load never stalls a search for long.
+		static constexpr size_t kBatchEntries = 4096;
+
+		MAKE_NONCOPYABLE (SearchIndex);
+		MAKE_NONMOVABLE (SearchIndex);
+		explicit SearchIndex (std::function<void ()> notify = {});
+		~SearchIndex ();
+
+		/// Queue @p text for indexing. The id stays valid for Remove () until then.
+		u32
+		Add (SearchKind kind, std::string text, u64 target);
+
+		void
+		Remove (u32 entry);
+
+		/// Block until every queued change is searchable.
+		void
+		Flush ();
+
+		/// Bumped after every applied batch; search again when it changes.
+		u64
+		Generation () const {
+			return m_generation.load (std::memory_order_acquire);
+		}
+
+		/// Live entries that are searchable now.
+		size_t
+		Size () const;
+
+		/**
+		 * @brief Replace @p hits with the @p limit best matches for @p query, best first.
+		 * An empty query matches nothing. Safe to call while the index is being updated.
+		 */
+		void
+		Search (std::string_view query, size_t limit, std::vector<SearchHit>& hits);
+
+	private:
+		struct Entry {
+			u32 size{0};  ///< Of the lower-cased text at m_lower [m_starts [id]].
+			SearchKind kind{SearchKind::Page};
+			bool live{false};
+			u64 target{0};
+			std::string text;
+		};
+
+		struct Change {
+			u32 entry{0};
+			bool remove{false};
+			SearchKind kind{SearchKind::Page};
+			u64 target{0};
+			std::string text;
+		};
+
+		void
+		Run (std::stop_token stop);
+		void
+		Apply (std::vector<Change>& changes);
+		void
+		Compact ();
+		std::string_view
+		Lower (u32 entry) const {
+			return {m_lower.data () + m_starts [entry], m_entries [entry].size};
+		}
+		/// Entry whose text in m_lower spans byte @p at, looking from entry @p first on.
+		u32
+		EntryAt (size_t at, u32 first) const;
+
+		std::function<void ()> m_notify;
+
+		std::mutex m_queueMutex;
+		std::condition_variable_any m_wake;
+		std::condition_variable_any m_idle;
+		std::deque<Change> m_queue;
+		u32 m_nextEntry{0};
+		bool m_applying{false};
+
+		mutable std::shared_mutex m_indexMutex;
+		std::vector<Entry> m_entries;  ///< Indexed by id.
+		std::vector<size_t> m_starts;  ///< Offset of each entry's text in m_lower; ascending.
+		std::string m_lower;		   ///< Lower-cased texts in id order, each followed by a NUL.
+		std::unordered_map<u32, std::vector<u32>> m_postings;  ///< Trigram -> ascending entries.
+		size_t m_live{0};
+		size_t m_dead{0};  ///< Removed entries still in m_postings.
+		std::atomic<u64> m_generation{0};
+
+		std::mutex m_searchMutex;  ///< Guards the scratch below.
+		std::vector<u16> m_counts;
+		std::vector<u32> m_touched;
+
+		std::jthread m_thread;	///< Last member: stops before the rest is destroyed.
+	};
+
+}  // namespace ambidb
@@ -0,0 +1,588 @@
+#include "sql_completion.h"
+
+#include <algorithm>
+#include <array>
+
+namespace ambidb {
+
+	namespace {
+
+		/// Prefix matches ranked per call; the range is in name order, so these are the first.
+		constexpr size_t kPrefixScan = 4096;
+		/// Names sharing the first letter checked for a fuzzy match when prefixes run short.
+		constexpr size_t kFuzzyScan = 16384;
+
+		// Sorted, so KeywordIndex () can search them.
+		constexpr std::array<std::string_view, 70> kKeywords = {
+			"ADD", "ALL", "ALTER", "AND", "AS", "ASC", "BEGIN", "BETWEEN", "BY", "CASE",
+			"CAST", "COLUMN", "COMMIT", "CREATE", "CROSS", "DEFAULT", "DELETE", "DESC", "DISTINCT", "DROP",
+			"ELSE", "END", "EXCEPT", "EXISTS", "FROM", "FULL", "GROUP", "HAVING", "IN", "INDEX",
+			"INNER", "INSERT", "INTERSECT", "INTO", "IS", "JOIN", "KEY", "LEFT", "LIKE", "LIMIT",
+			"NATURAL", "NOT", "NULL", "OFFSET", "ON", "OR", "ORDER", "OUTER", "PRIMARY", "REFERENCES",
+			"RETURNING", "RIGHT", "ROLLBACK", "SELECT", "SET", "TABLE", "THEN", "TRUNCATE", "UNION", "UNIQUE",
+			"UPDATE", "USING", "VALUES", "VIEW", "WHEN", "WHERE", "WINDOW", "WITH", "WITHOUT", "XOR",
+		};
+		static_assert (std::ranges::is_sorted (kKeywords));
+
+		/// Keywords that commonly follow a table name, ranked first there; sorted.
+		constexpr std::array<std::string_view, 16> kAfterTable = {
+			"AS", "CROSS", "FULL", "GROUP", "INNER", "JOIN", "LEFT", "LIMIT", "NATURAL", "ON", "ORDER", "RIGHT", "SET", "USING", "VALUES", "WHERE",
+		};
+		static_assert (std::ranges::is_sorted (kAfterTable));
+
+		bool
+		IdentByte (char c) {
+			const auto u = static_cast<unsigned char> (c);
+			return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '_' || u == '$' || u >= 0x80;
+		}
+
+		char
+		LowerByte (char c) {
+			return (c >= 'A' && c <= 'Z') ? static_cast<char> (c | 0x20) : c;
+		}
+
+		char
+		UpperByte (char c) {
+			return (c >= 'a' && c <= 'z') ? static_cast<char> (c & ~0x20) : c;
+		}
+
+		std::string
+		ToLower (std::string_view text) {
+			std::string lower (text);
+			std::ranges::transform (lower, lower.begin (), LowerByte);
+			return lower;
+		}
+
+		/// Index into kKeywords of @p word in any case, or kKeywords.size ().
+		size_t
+		KeywordIndex (std::string_view word) {
+			if (word.size () > 16) return kKeywords.size ();
+			char upper [16];
+			std::ranges::transform (word, upper, UpperByte);
+			const std::string_view key (upper, word.size ());
+			const auto it = std::ranges::lower_bound (kKeywords, key);
+			return it != kKeywords.end () && *it == key ? static_cast<size_t> (it - kKeywords.begin ()) : kKeywords.size ();
+		}
+
+		struct Token {
+			enum class Kind : u8 {
+				Word,
+				Keyword,
+				Quoted,	 ///< "name", `name` or [name].
+				Number,
+				String,
+				Symbol,
+			};
+
+			Kind kind{Kind::Symbol};
+			size_t begin{0};
+			size_t end{0};
+			size_t keyword{0};	///< Keyword: index into kKeywords.
+
+			bool
+			Name () const {
+				return kind == Kind::Word || kind == Kind::Quoted;
+			}
+		};
+
+		/// Tokens of @p text [begin, end), with offsets into @p text. Comments are skipped.
+		void
+		Lex (std::string_view text, size_t begin, size_t end, std::vector<Token>& out) {
+			out.clear ();
+			size_t i = begin;
+			const auto closeAt = [&] (char close) {
+				while (++i < end) {
+					if (text [i] != close) continue;
+					if (i + 1 < end && text [i + 1] == close && close != ']') {
+						++i;  // Doubled quote.
+						continue;
+					}
+					++i;
+					return;
+				}
+			};
+			while (i < end) {
+				const char c = text [i];
+				const size_t start = i;
+				if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+					++i;
+					continue;
+				}
+				if (c == '-' && i + 1 < end && text [i + 1] == '-') {
+					while (i < end && text [i] != '\n') ++i;
+					continue;
+				}
+				if (c == '/' && i + 1 < end && text [i + 1] == '*') {
+					const size_t close = text.substr (0, end).find ("*/", i + 2);
+					i = close == std::string_view::npos ? end : close + 2;
+					continue;
+				}
+				Token token;
+				if (c == '\'') {
+					closeAt ('\'');
+					token.kind = Token::Kind::String;
+				}
+				else if (c == '"' || c == '`' || c == '[') {
+					closeAt (c == '[' ? ']' : c);
+					token.kind = Token::Kind::Quoted;
+				}
+				else if (c >= '0' && c <= '9') {
+					while (i < end && (IdentByte (text [i]) || text [i] == '.')) ++i;
+					token.kind = Token::Kind::Number;
+				}
+				else if (IdentByte (c)) {
+					while (i < end && IdentByte (text [i])) ++i;
+					token.keyword = KeywordIndex (text.substr (start, i - start));
+					token.kind = token.keyword < kKeywords.size () ? Token::Kind::Keyword : Token::Kind::Word;
+				}
+				else {
+					++i;
+					token.kind = Token::Kind::Symbol;
+				}
+				token.begin = start;
+				token.end = std::min (i, end);
+				out.push_back (token);
+			}
+		}
+
+		/// The name a Word or Quoted token stands for.
+		std::string
+		Unquote (std::string_view raw) {
+			if (raw.empty () || (raw.front () != '"' && raw.front () != '`' && raw.front () != '[')) return std::string (raw);
+			const char close = raw.front () == '[' ? ']' : raw.front ();
+			std::string name;
+			for (size_t i = 1; i < raw.size (); ++i) {
+				if (raw [i] == close) {
+					if (close != ']' && i + 1 < raw.size () && raw [i + 1] == close) {
+						name += close;
+						++i;
+						continue;
+					}
+					break;
+				}
+				name += raw [i];
+			}
+			return name;
+		}
+
+		/// @p name as it can be typed: quoted unless a plain identifier that is no keyword.
+		std::string
+		Quoted (std::string_view name) {
+			const bool plain = !name.empty () && !(name [0] >= '0' && name [0] <= '9') && std::ranges::all_of (name, IdentByte) &&
+							   KeywordIndex (name) == kKeywords.size ();
+			if (plain) return std::string (name);
+			std::string quoted = "\"";
+			for (const char c : name) {
+				if (c == '"') quoted += '"';
+				quoted += c;
+			}
+			quoted += '"';
+			return quoted;
+		}
+
+		/**
+		 * @brief How well @p typed matches @p name, both lower-cased; negative if @p typed is
+		 * not a subsequence of @p name. A prefix scores 3 or more; otherwise 1 plus up to 1
+		 * for characters landing on word starts or right after the previous one. Shorter
+		 * names win ties.
+		 */
+		float
+		MatchScore (std::string_view name, std::string_view typed) {
+			const float length = static_cast<float> (std::min<size_t> (name.size (), 1000)) * 1e-3f;
+			if (name.starts_with (typed)) return (name.size () == typed.size () ? 3.5f : 3.0f) - length;
+			float bonus = 0.0f;
+			size_t at = 0;
+			size_t previous = std::string_view::npos;
+			for (const char c : typed) {
+				at = name.find (c, at);
+				if (at == std::string_view::npos) return -1.0f;
+				if (at == 0 || name [at - 1] == '_' || name [at - 1] == ' ') {
+					bonus += 1.0f;
+				}
+				else if (previous != std::string_view::npos && at == previous + 1) {
+					bonus += 0.5f;
+				}
+				previous = at++;
+			}
+			return 1.0f + bonus / static_cast<float> (typed.size ()) - length;
+		}
+
+		enum : size_t {
+			kFrom = 24,
+			kInto = 33,
+			kJoin = 35,
+			kTable = 55,
+			kUpdate = 60,
+			kAs = 4,
+		};
+		static_assert (kKeywords [kFrom] == "FROM" && kKeywords [kInto] == "INTO" && kKeywords [kJoin] == "JOIN" &&
+					   kKeywords [kTable] == "TABLE" && kKeywords [kUpdate] == "UPDATE" && kKeywords [kAs] == "AS");
+
+		bool
+		TableKeyword (size_t keyword) {
+			return keyword == kFrom || keyword == kJoin || keyword == kUpdate || keyword == kInto || keyword == kTable;
+		}
+
+		/// A table named in FROM, JOIN, UPDATE or INTO, with its alias if it has one.
+		struct TableRef {
+			std::string schema;
+			std::string table;
+			std::string alias;
+		};
+
+		void
+		ParseRefs (std::string_view text, const std::vector<Token>& tokens, std::vector<TableRef>& refs) {
+			const auto symbol = [&] (size_t at, char c) {
+				return at < tokens.size () && tokens [at].kind == Token::Kind::Symbol && text [tokens [at].begin] == c;
+			};
+			const auto name = [&] (size_t at) { return Unquote (text.substr (tokens [at].begin, tokens [at].end - tokens [at].begin)); };
+			for (size_t i = 0; i < tokens.size (); ++i) {
+				if (tokens [i].kind != Token::Kind::Keyword || !TableKeyword (tokens [i].keyword) || tokens [i].keyword == kTable) continue;
+				size_t j = i + 1;
+				while (j < tokens.size ()) {
+					TableRef ref;
+					if (symbol (j, '(')) {
+						// A subquery: its alias names no table we know.
+						for (int depth = 0; j < tokens.size (); ++j) {
+							if (symbol (j, '(')) ++depth;
+							if (symbol (j, ')') && --depth == 0) break;
+						}
+						++j;
+					}
+					else if (tokens [j].Name ()) {
+						ref.table = name (j++);
+						if (symbol (j, '.') && j + 1 < tokens.size () && tokens [j + 1].Name ()) {
+							ref.schema = std::move (ref.table);
+							ref.table = name (j + 1);
+							j += 2;
+						}
+					}
+					else {
+						break;
+					}
+					if (j < tokens.size () && tokens [j].kind == Token::Kind::Keyword && tokens [j].keyword == kAs) ++j;
+					if (j < tokens.size () && tokens [j].Name ()) ref.alias = name (j++);
+					if (!ref.table.empty ()) refs.push_back (std::move (ref));
+					if (tokens [i].keyword != kFrom || !symbol (j, ',')) break;
+					++j;
+				}
+			}
+		}
+
+		struct Candidate {
+			float score{0.0f};
+			CompletionKind kind{CompletionKind::Keyword};
+			u32 index{0};  ///< Into kKeywords, the names, or the table refs for aliases.
+		};
+
+	}  // namespace
+
+	const char*
+	CompletionKindName (CompletionKind kind) {
+		switch (kind) {
+			case CompletionKind::Keyword: return "keyword";
+			case CompletionKind::Schema: return "schema";
+			case CompletionKind::Table: return "table";
+			case CompletionKind::Column: return "column";
+			case CompletionKind::Alias: return "alias";
+		}
+		UNREACHABLE ();
+	}
+
+	void
+	SqlCompleter::Update (std::shared_ptr<const db::SchemaCache> cache, std::function<void ()> notify) {
+		if (cache.get () != m_cache) {
+			// Names of another connection's catalog must not be offered meanwhile.
+			if (m_builder.joinable ()) {
+				m_builder.request_stop ();
+				m_builder.join ();
+			}
+			m_built.reset ();
+			m_text.clear ();
+			m_lower.clear ();
+			m_names.clear ();
+			m_schemas.clear ();
+			m_tables.clear ();
+			m_columns.clear ();
+			++m_generation;
+		}
+		else {
+			Take ();
+		}
+		const u64 content = cache->ContentGeneration ();
+		if (cache.get () == m_cache && content == m_content) return;
+		// One build at a time; a later call starts the next one once this one is done.
+		if (m_building.load (std::memory_order_acquire)) return;
+		m_cache = cache.get ();
+		m_content = content;
+		m_building.store (true, std::memory_order_release);
+		m_builder = std::jthread ([this, cache = std::move (cache), notify = std::move (notify)] (std::stop_token stop) {
+			auto index = std::make_unique<Index> ();
+			Build (*cache, *index, stop);
+			if (!stop.stop_requested ()) {
+				std::lock_guard lock (m_builtMutex);
+				m_built = std::move (index);
+			}
+			m_building.store (false, std::memory_order_release);
+			if (notify && !stop.stop_requested ()) notify ();
+		});
+	}
+
+	void
+	SqlCompleter::Flush () {
+		if (m_builder.joinable ()) m_builder.join ();
+		Take ();
+	}
+
+	void
+	SqlCompleter::Take () {
+		std::unique_ptr<Index> built;
+		{
+			std::lock_guard lock (m_builtMutex);
+			built = std::move (m_built);
+		}
+		if (!built) return;
+		m_text = std::move (built->text);
+		m_lower = std::move (built->lower);
+		m_names = std::move (built->names);
+		m_tables = std::move (built->tables);
+		m_columns = std::move (built->columns);
+		m_schemas = std::move (built->schemas);
+		++m_generation;
+	}
+
+	void
+	SqlCompleter::Build (const db::SchemaCache& cache, Index& index, std::stop_token stop) {
+		u32 schema = 0;
+		u32 table = 0;
+		cache.Visit ([&] (u32 depth, const db::CatalogEntry& entry, bool loaded) {
+			if (stop.stop_requested ()) return;
+			const u32 id = static_cast<u32> (index.names.size ());
+			Name& name = index.names.emplace_back ();
+			name.offset = static_cast<u32> (index.text.size ());
+			name.size = static_cast<u32> (entry.name.size ());
+			index.text += entry.name;
+			name.detail = static_cast<u32> (index.text.size ());
+			name.detailSize = static_cast<u32> (entry.detail.size ());
+			index.text += entry.detail;
+			name.loaded = loaded;
+			name.first = name.end = id + 1;
+			if (depth == 0) {
+				name.kind = CompletionKind::Schema;
+				schema = id;
+				index.schemas.push_back (id);
+			}
+			else if (depth == 1) {
+				name.kind = CompletionKind::Table;
+				name.parent = schema;
+				table = id;
+				index.tables.push_back (id);
+			}
+			else {
+				name.kind = CompletionKind::Column;
+				name.parent = table;
+				index.names [table].end = id + 1;
+				index.columns.push_back (id);
+			}
+		});
+		if (stop.stop_requested ()) return;
+		index.lower = ToLower (index.text);
+
+		const auto lower = [&index] (u32 id) {
+			const Name& name = index.names [id];
+			return std::string_view (index.lower.data () + name.offset, name.size);
+		};
+		const auto byLower = [&lower] (u32 a, u32 b) { return lower (a) < lower (b); };
+		std::ranges::sort (index.tables, byLower);
+		std::ranges::sort (index.columns, byLower);
+		const auto same = [&lower] (u32 a, u32 b) { return lower (a) == lower (b); };
+		index.columns.erase (std::unique (index.columns.begin (), index.columns.end (), same), index.columns.end ());
+	}
+
+	const SqlCompleter::Name*
+	SqlCompleter::FindTable (std::string_view schema, std::string_view table) const {
+		const std::string lower = ToLower (table);
+		const auto from = std::ranges::partition_point (m_tables, [&] (u32 id) { return Lower (m_names [id]) < lower; });
+		const Name* found = nullptr;
+		for (auto it = from; it != m_tables.end () && Lower (m_names [*it]) == lower; ++it) {
+			const Name& name = m_names [*it];
+			if (schema.empty () || Lower (m_names [name.parent]) == ToLower (schema)) return &name;
+			if (!found) found = &name;
+		}
+		return schema.empty () ? found : nullptr;
+	}
+
+	void
+	SqlCompleter::Complete (std::string_view text, size_t cursor, std::vector<Completion>& out, CompletionContext& context) const {
+		out.clear ();
+		context = {};
+		cursor = std::min (cursor, text.size ());
+
+		// Only the statement around the cursor is read, however long the script.
+		const size_t semicolon = cursor > 0 ? text.rfind (';', cursor - 1) : std::string_view::npos;
+		const size_t begin = semicolon == std::string_view::npos ? 0 : semicolon + 1;
+		const size_t end = std::min (text.find (';', cursor), text.size ());
+		size_t wordStart = cursor;
+		while (wordStart > begin && IdentByte (text [wordStart - 1])) --wordStart;
+		context.wordStart = wordStart;
+		const std::string typed = ToLower (text.substr (wordStart, cursor - wordStart));
+
+		std::vector<Token> tokens;
+		Lex (text, begin, end, tokens);
+		std::vector<TableRef> refs;
+		ParseRefs (text, tokens, refs);
+		const size_t before = static_cast<size_t> (std::ranges::partition_point (tokens, [&] (const Token& t) { return t.end <= wordStart; }) - tokens.begin ());
+		size_t previous = before;  // Last token ahead of the word and its qualifier; before = none.
+		if (before >= 2 && wordStart > begin && text [wordStart - 1] == '.' && tokens [before - 2].Name () && tokens [before - 1].end == wordStart) {
+			const Token& qualifier = tokens [before - 2];
+			context.qualifier = Unquote (text.substr (qualifier.begin, qualifier.end - qualifier.begin));
+			previous = before >= 3 ? before - 3 : before;
+		}
+		else if (before >= 1) {
+			previous = before - 1;
+		}
+		size_t clause = kKeywords.size ();
+		for (size_t i = before; i-- > 0;) {
+			if (tokens [i].kind == Token::Kind::Keyword && tokens [i].keyword != kAs) {
+				clause = tokens [i].keyword;
+				break;
+			}
+		}
+		const bool afterClauseWord = previous < before && tokens [previous].kind == Token::Kind::Keyword && TableKeyword (tokens [previous].keyword);
+		const bool afterComma = previous < before && tokens [previous].kind == Token::Kind::Symbol && text [tokens [previous].begin] == ',';
+		context.tables = context.qualifier.empty () && TableKeyword (clause) && (afterClauseWord || (clause == kFrom && afterComma));
+		// Right after a table name in FROM or JOIN: an alias or the next keyword is due.
+		const bool afterTable = context.qualifier.empty () && TableKeyword (clause) && !context.tables;
+
+		std::vector<Candidate> candidates;
+		m_scored = 0;
+		const auto offer = [&] (CompletionKind kind, u32 index, std::string_view lower, float bonus) {
+			++m_scored;
+			// Nothing typed yet: everything fits, in catalog order.
+			const float score = typed.empty () ? 1.0f : MatchScore (lower, typed);
+			if (score >= 0.0f) candidates.push_back ({score + bonus, kind, index});
+		};
+		const auto offerName = [&] (u32 id, float bonus) { offer (m_names [id].kind, id, Lower (m_names [id]), bonus); };
+		// A sorted name array: its prefix range, then fuzzy matches sharing the first letter.
+		const auto offerSorted = [&] (const std::vector<u32>& sorted, float bonus) {
+			const auto prefixOf = [&] (std::string_view prefix) {
+				const auto from = std::ranges::partition_point (sorted, [&] (u32 id) { return Lower (m_names [id]) < prefix; });
+				const auto to = std::partition_point (from, sorted.end (), [&] (u32 id) { return Lower (m_names [id]).starts_with (prefix); });
+				return std::pair (from, to);
+			};
+			const auto [from, to] = prefixOf (typed);
+			for (auto it = from; it != to && it - from < static_cast<std::ptrdiff_t> (kPrefixScan); ++it) offerName (*it, bonus);
+			if (typed.size () < 2 || to - from >= static_cast<std::ptrdiff_t> (kMaxResults)) return;
+			const auto [letterFrom, letterTo] = prefixOf (std::string_view (typed).substr (0, 1));
+			size_t scanned = 0;
+			for (auto it = letterFrom; it != letterTo && scanned < kFuzzyScan; ++it, ++scanned) {
+				if (it == from) it = to;
+				if (it == letterTo) break;
+				offerName (*it, bonus);
+			}
+		};
+		const auto offerKeywords = [&] (bool afterTable) {
+			for (size_t i = 0; i < kKeywords.size (); ++i) {
+				const bool follows = afterTable && std::ranges::binary_search (kAfterTable, kKeywords [i]);
+				offer (CompletionKind::Keyword, static_cast<u32> (i), ToLower (kKeywords [i]), follows ? 0.1f : 0.0f);
+			}
+		};
+		const auto require = [&] (const Name& table) {
+			if (!table.loaded) context.missing.push_back ({std::string (Text (m_names [table.parent])), std::string (Text (table))});
+		};
+		const auto requireSchemas = [&] {
+			for (const u32 id : m_schemas) {
+				if (!m_names [id].loaded) context.missing.push_back ({std::string (Text (m_names [id])), {}});
+			}
+		};
+
+		// Tables in scope, by what the statement calls them.
+		std::vector<const Name*> scope (refs.size (), nullptr);
+		for (size_t i = 0; i < refs.size (); ++i) scope [i] = FindTable (refs [i].schema, refs [i].table);
+		if (std::ranges::find (scope, nullptr) != scope.end ()) requireSchemas ();
+
+		if (!context.qualifier.empty ()) {
+			const std::string qualifier = ToLower (context.qualifier);
+			const Name* table = nullptr;
+			for (size_t i = 0; i < refs.size () && !table; ++i) {
+				if (ToLower (refs [i].alias) == qualifier) table = scope [i];
+			}
+			for (size_t i = 0; i < refs.size () && !table; ++i) {
+				if (refs [i].alias.empty () && ToLower (refs [i].table) == qualifier) table = scope [i];
+			}
+			if (!table) table = FindTable ({}, context.qualifier);
+			if (table) {
+				require (*table);
+				for (u32 id = table->first; id < table->end; ++id) offerName (id, 0.0f);
+			}
+			else if (const auto schema = std::ranges::find_if (m_schemas, [&] (u32 id) { return Lower (m_names [id]) == qualifier; });
+					 schema != m_schemas.end ()) {
+				if (!m_names [*schema].loaded) context.missing.push_back ({std::string (Text (m_names [*schema])), {}});
+				for (const u32 id : m_tables) {
+					if (m_names [id].parent == *schema) offerName (id, 0.0f);
+				}
+			}
+		}
+		else if (context.tables) {
+			requireSchemas ();
+			offerSorted (m_tables, 0.3f);
+			for (const u32 id : m_schemas) offerName (id, 0.2f);
+		}
+		else if (afterTable) {
+			if (!typed.empty ()) offerKeywords (true);
+		}
+		else {
+			bool any = false;
+			for (size_t i = 0; i < refs.size (); ++i) {
+				if (!scope [i]) continue;
+				any = true;
+				require (*scope [i]);
+				for (u32 id = scope [i]->first; id < scope [i]->end; ++id) offerName (id, 0.6f);
+				const std::string& shown = refs [i].alias.empty () ? refs [i].table : refs [i].alias;
+				offer (CompletionKind::Alias, static_cast<u32> (i), ToLower (shown), 0.7f);
+			}
+			if (!typed.empty ()) offerKeywords (false);
+			if (!any && !typed.empty ()) {
+				offerSorted (m_columns, 0.4f);
+				offerSorted (m_tables, 0.3f);
+			}
+		}
+
+		const size_t count = std::min (candidates.size (), kMaxResults);
+		std::partial_sort (candidates.begin (), candidates.begin () + static_cast<std::ptrdiff_t> (count), candidates.end (), [] (const Candidate& a, const Candidate& b) {
+			return a.score != b.score ? a.score > b.score : a.index < b.index;
+		});
+		// Keywords follow the case of what was typed.
+		const bool lowerCase = !typed.empty () && text.substr (wordStart, cursor - wordStart) == typed;
+		out.reserve (count);
+		for (size_t i = 0; i < count; ++i) {
+			const Candidate& candidate = candidates [i];
+			Completion& completion = out.emplace_back ();
+			completion.kind = candidate.kind;
+			completion.score = candidate.score;
+			switch (candidate.kind) {
+				case CompletionKind::Keyword:
+					completion.text = lowerCase ? ToLower (kKeywords [candidate.index]) : std::string (kKeywords [candidate.index]);
+					break;
+				case CompletionKind::Alias: {
+					const TableRef& ref = refs [candidate.index];
+					completion.text = Quoted (ref.alias.empty () ? ref.table : ref.alias);
+					completion.detail = ref.table;
+					break;
+				}
+				default: {
+					const Name& name = m_names [candidate.index];
+					completion.text = Quoted (Text (name));
+					completion.detail = Detail (name);
+					if (name.kind == CompletionKind::Column && !context.qualifier.empty ()) break;
+					if (name.kind == CompletionKind::Column) {
+						if (!completion.detail.empty ()) completion.detail += "  ";
+						completion.detail += Text (m_names [name.parent]);
+					}
+					break;
+				}
+			}
+		}
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <macro.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "db/schema_cache.h"
+
+namespace ambidb {
+
+	enum class CompletionKind : u8 {
+		Keyword,
+		Schema,
+		Table,
+		Column,
+		Alias,	///< A table alias or table name in scope of the statement.
+	};
+
+	const char*
+	CompletionKindName (CompletionKind kind);
+
+	struct Completion {
+		CompletionKind kind{CompletionKind::Keyword};
+		std::string text;	 ///< What replaces the word, quoted if the name needs it.
+		std::string detail;	 ///< Columns: type and table; tables: "table" or "view".
+		float score{0.0f};
+	};
+
+	/// Where the cursor is, as Complete () resolved it.
+	struct CompletionContext {
+		size_t wordStart{0};  ///< The partial word [wordStart, cursor) a completion replaces.
+		std::string qualifier;	///< Name before a '.' right ahead of the word, unquoted.
+		bool tables{false};		///< After FROM, JOIN, UPDATE, INTO or TABLE: a table is due.
+		/// Catalog levels the statement needs that the cache has not loaded; hand to Require ().
+		std::vector<db::CatalogPath> missing;
+	};
+
+	/**
+	 * @brief SQL completion for the Query Editor, from the names in a SchemaCache.
+	 *
+	 * The cache's names are copied into one arena and sorted: tables and the distinct
+	 * column names each get a sorted array, so every prefix is a contiguous range found by
+	 * binary search (a flattened prefix trie), and each table keeps the range of its own
+	 * columns. That index is built on a background thread whenever the cache's content
+	 * generation moves (expanding and collapsing the tree does not), and Update () takes
+	 * it in once it is done; until then Complete () answers from the previous one.
+	 * Complete () costs the statement around the cursor plus the candidates it ranks,
+	 * never the catalog size:
+	 *
+	 * - only the statement holding the cursor (between semicolons) is lexed, to find the
+	 *   partial word, a "qualifier." before it, the clause it is in and the tables of
+	 *   FROM, JOIN, UPDATE and INTO with their aliases, wherever they appear, so the column
+	 *   list after SELECT already knows them;
+	 * - "alias." ranks only that table's columns, and a word in a column position ranks
+	 *   the columns of the tables in scope, their aliases and the keywords;
+	 * - anywhere else, and for columns when no table is in scope, candidates come from the
+	 *   prefix range, topped up with fuzzy matches from the names sharing the first letter.
+	 *
+	 * A candidate's score favours a prefix match, then matches at word starts and runs,
+	 * then shorter names, plus a bonus by kind for the clause. Called from the UI thread.
+	 */
+	class SqlCompleter {
+	public:
+		static constexpr size_t kMaxResults = 50;
+
+		MAKE_NONCOPYABLE (SqlCompleter);
+		MAKE_NONMOVABLE (SqlCompleter);
+		SqlCompleter () = default;
+
+		/**
+		 * @brief Take in a finished index, and start indexing @p cache if it is another
+		 * cache or its entries changed since the last build. @p notify is called from the
+		 * build thread when the index is ready for the next Update ().
+		 */
+		void
+		Update (std::shared_ptr<const db::SchemaCache> cache, std::function<void ()> notify = {});
+
+		/// Block until a running build ends and take its index in.
+		void
+		Flush ();
+
+		/// Bumped whenever a new index is taken in; complete again when it changes.
+		u64
+		Generation () const {
+			return m_generation;
+		}
+
+		/**
+		 * @brief Replace @p out with the best completions for the word ending at @p cursor
+		 * in @p text, best first, and describe the position in @p context.
+		 */
+		void
+		Complete (std::string_view text, size_t cursor, std::vector<Completion>& out, CompletionContext& context) const;
+
+		/// Names held: schemas, tables and columns.
+		size_t
+		Size () const {
+			return m_names.size ();
+		}
+
+		/// Candidates the last Complete () scored; for tests and tracing.
+		size_t
+		Scored () const {
+			return m_scored;
+		}
+
+	private:
+		struct Name {
+			u32 offset{0};	///< Of the name in m_text and its lower-cased copy in m_lower.
+			u32 size{0};
+			u32 detail{0};	///< Offset of the detail in m_text; detailSize bytes.
+			u32 detailSize{0};
+			u32 parent{0};	///< Tables: their schema; columns: their table.
+			u32 first{0};	///< Schemas: their tables; tables: their columns, [first, end).
+			u32 end{0};
+			CompletionKind kind{CompletionKind::Schema};
+			bool loaded{false};
+		};
+
+		std::string_view
+		Text (const Name& name) const {
+			return {m_text.data () + name.offset, name.size};
+		}
+
+		std::string_view
+		Lower (const Name& name) const {
+			return {m_lower.data () + name.offset, name.size};
+		}
+
+		std::string_view
+		Detail (const Name& name) const {
+			return {m_text.data () + name.detail, name.detailSize};
+		}
+
+		/// An index as the build thread hands it over; the fields below, by the same names.
+		struct Index {
+			std::string text;
+			std::string lower;
+			std::vector<Name> names;
+			std::vector<u32> tables;
+			std::vector<u32> columns;
+			std::vector<u32> schemas;
+		};
+
+		/// Index into m_names of the table called @p table (in @p schema, if not empty).
+		const Name*
+		FindTable (std::string_view schema, std::string_view table) const;
+
+		/// Build thread: copy the names of @p cache into @p index and sort them.
+		static void
+		Build (const db::SchemaCache& cache, Index& index, std::stop_token stop);
+		/// Move a finished index in, if there is one.
+		void
+		Take ();
+
+		const db::SchemaCache* m_cache{nullptr};
+		u64 m_content{0};	  ///< Cache content generation of the last build started.
+		u64 m_generation{0};  ///< Indexes taken in.
+		std::string m_text;
+		std::string m_lower;
+		std::vector<Name> m_names;	 ///< Depth first, as the cache holds them.
+		std::vector<u32> m_tables;	 ///< Table names, sorted by lower-cased name.
+		std::vector<u32> m_columns;	 ///< One column per distinct lower-cased name, sorted.
+		std::vector<u32> m_schemas;
+		mutable size_t m_scored{0};
+
+		std::mutex m_builtMutex;
+		std::unique_ptr<Index> m_built;	 ///< Under m_builtMutex: finished, not taken in yet.
+		std::atomic<bool> m_building{false};
+		std::jthread m_builder;	 ///< Last member: stops before the rest is destroyed.
+	};
+
+}  // namespace ambidb
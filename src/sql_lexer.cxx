@@ -0,0 +1,503 @@
+#include "sql_lexer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <span>
+
+namespace ambidb {
+
+	namespace {
+
+		/// Lines lexed past the one asked for while an edit has not converged yet.
+		constexpr u32 kLookahead = 256;
+
+		// Words of each table are upper-case and sorted, so IsWord () can search them.
+
+		constexpr std::string_view kKeywords [] = {
+			"ADD", "ALL", "ALTER", "ALWAYS", "AND", "ANY", "AS", "ASC", "BEGIN", "BETWEEN",
+			"BY", "CASCADE", "CASE", "CAST", "CHECK", "COLLATE", "COLUMN", "COMMIT", "CONSTRAINT", "CREATE",
+			"CROSS", "CURRENT", "DATABASE", "DEFAULT", "DEFERRABLE", "DELETE", "DESC", "DISTINCT", "DROP", "EACH",
+			"ELSE", "END", "ESCAPE", "EXCEPT", "EXISTS", "EXPLAIN", "FALSE", "FETCH", "FILTER", "FIRST",
+			"FOLLOWING", "FOR", "FOREIGN", "FROM", "FULL", "GENERATED", "GROUP", "GROUPS", "HAVING", "IF",
+			"IN", "INDEX", "INNER", "INSERT", "INTERSECT", "INTO", "IS", "JOIN", "KEY", "LAST",
+			"LEFT", "LIKE", "LIMIT", "NATURAL", "NEXT", "NO", "NOT", "NULL", "NULLS", "OF",
+			"OFFSET", "ON", "ONLY", "OR", "ORDER", "OTHERS", "OUTER", "OVER", "PARTITION", "PRECEDING",
+			"PRIMARY", "RANGE", "RECURSIVE", "REFERENCES", "RELEASE", "RENAME", "RESTRICT", "RETURNING", "RIGHT", "ROLLBACK",
+			"ROW", "ROWS", "SAVEPOINT", "SELECT", "SET", "TABLE", "THEN", "TIES", "TO", "TRANSACTION",
+			"TRIGGER", "TRUE", "UNBOUNDED", "UNION", "UNIQUE", "UPDATE", "USING", "VALUES", "VIEW", "WHEN",
+			"WHERE", "WINDOW", "WITH", "WITHOUT",
+		};
+
+		constexpr std::string_view kPostgreSqlKeywords [] = {
+			"ANALYZE", "ARRAY", "CONCURRENTLY", "CONFLICT", "COPY", "DO", "EXTENSION", "FUNCTION", "GRANT", "ILIKE",
+			"IMMUTABLE", "LANGUAGE", "LATERAL", "LISTEN", "MATERIALIZED", "NOTHING", "NOTIFY", "OWNER", "REFRESH", "RETURNS",
+			"REVOKE", "SCHEMA", "SEQUENCE", "SIMILAR", "STABLE", "TEMP", "TEMPORARY", "TRUNCATE", "VACUUM", "VOLATILE",
+		};
+
+		constexpr std::string_view kMySqlKeywords [] = {
+			"AUTO_INCREMENT", "CHANGE", "CHARSET", "DATABASES", "DELIMITER", "DESCRIBE", "DUAL", "DUPLICATE", "ENGINE", "FORCE",
+			"IGNORE", "LOCK", "MODIFY", "PROCEDURE", "REGEXP", "REPLACE", "RLIKE", "SHOW", "STRAIGHT_JOIN", "TABLES",
+			"TEMPORARY", "TRUNCATE", "UNLOCK", "UNSIGNED", "USE", "ZEROFILL",
+		};
+
+		constexpr std::string_view kSqliteKeywords [] = {
+			"ABORT", "ATTACH", "AUTOINCREMENT", "CONFLICT", "DETACH", "FAIL", "GLOB", "IGNORE", "INDEXED", "INSTEAD",
+			"MATCH", "PLAN", "PRAGMA", "QUERY", "REGEXP", "REINDEX", "REPLACE", "ROWID", "STRICT", "TEMP",
+			"TEMPORARY", "VACUUM", "VIRTUAL",
+		};
+
+		constexpr std::string_view kTypes [] = {
+			"BIGINT", "BINARY", "BIT", "BLOB", "BOOLEAN", "CHAR", "CHARACTER", "DATE", "DECIMAL", "DOUBLE",
+			"FLOAT", "INT", "INTEGER", "INTERVAL", "NUMERIC", "PRECISION", "REAL", "SMALLINT", "TEXT", "TIME",
+			"TIMESTAMP", "VARCHAR", "VARYING", "ZONE",
+		};
+
+		constexpr std::string_view kPostgreSqlTypes [] = {
+			"BIGSERIAL", "BOOL", "BYTEA", "CIDR", "INET", "INT2", "INT4", "INT8", "JSON", "JSONB",
+			"MONEY", "SERIAL", "SMALLSERIAL", "TIMESTAMPTZ", "TIMETZ", "TSQUERY", "TSVECTOR", "UUID", "XML",
+		};
+
+		constexpr std::string_view kMySqlTypes [] = {
+			"DATETIME", "ENUM", "JSON", "LONGBLOB", "LONGTEXT", "MEDIUMBLOB", "MEDIUMINT", "MEDIUMTEXT", "TINYBLOB", "TINYINT",
+			"TINYTEXT", "VARBINARY", "YEAR",
+		};
+
+		constexpr std::string_view kSqliteTypes [] = {"ANY", "DATETIME"};
+
+		constexpr bool
+		Sorted (std::span<const std::string_view> words) {
+			return std::ranges::is_sorted (words);
+		}
+		static_assert (Sorted (kKeywords) && Sorted (kPostgreSqlKeywords) && Sorted (kMySqlKeywords) && Sorted (kSqliteKeywords));
+		static_assert (Sorted (kTypes) && Sorted (kPostgreSqlTypes) && Sorted (kMySqlTypes) && Sorted (kSqliteTypes));
+
+		/// How a dialect's lexing differs.
+		struct DialectRules {
+			std::span<const std::string_view> keywords;
+			std::span<const std::string_view> types;
+			bool hashComments;		  ///< # starts a line comment (MySQL).
+			bool nestedComments;	  ///< /* */ nest (PostgreSQL).
+			bool backslashEscapes;	  ///< \ escapes in '...' and "..." (MySQL).
+			bool doubleQuotedStrings;  ///< "..." is a string, not a name (MySQL).
+			bool dollarQuotes;		  ///< $tag$...$tag$ strings and $1 parameters (PostgreSQL).
+			bool backtickNames;		  ///< `name` (MySQL, SQLite).
+			bool bracketNames;		  ///< [name] (SQLite).
+		};
+
+		const DialectRules&
+		RulesFor (SqlDialect dialect) {
+			static constexpr DialectRules kSqlite{kSqliteKeywords, kSqliteTypes, false, false, false, false, false, true, true};
+			static constexpr DialectRules kPostgreSql{kPostgreSqlKeywords, kPostgreSqlTypes, false, true, false, false, true, false, false};
+			static constexpr DialectRules kMySql{kMySqlKeywords, kMySqlTypes, true, false, true, true, false, true, false};
+			switch (dialect) {
+				case SqlDialect::Sqlite: return kSqlite;
+				case SqlDialect::PostgreSql: return kPostgreSql;
+				case SqlDialect::MySql: return kMySql;
+			}
+			UNREACHABLE ();
+		}
+
+		// A line state: what is open in the low byte, a nesting depth or tag hash above it.
+		enum : u32 {
+			kPlain = 0,
+			kComment = 1,
+			kString = 2,		  ///< '...'
+			kEscapedString = 3,	  ///< '...' with \ escapes: MySQL, PostgreSQL E'...'.
+			kQuotedName = 4,	  ///< "..."
+			kDoubleString = 5,	  ///< "..." as a string, with \ escapes: MySQL.
+			kBacktickName = 6,	  ///< `...`
+			kDollarString = 7,	  ///< $tag$...$tag$
+		};
+
+		constexpr u32
+		StateOf (u32 kind, u32 extra) {
+			return kind | (extra << 8);
+		}
+
+		bool
+		IdentStart (char c) {
+			const auto u = static_cast<unsigned char> (c);
+			return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || u == '_' || u >= 0x80;
+		}
+
+		bool
+		IdentByte (char c) {
+			return IdentStart (c) || (c >= '0' && c <= '9') || c == '$';
+		}
+
+		bool
+		Digit (char c) {
+			return c >= '0' && c <= '9';
+		}
+
+		bool
+		IsWord (std::span<const std::string_view> words, std::string_view upper) {
+			return std::ranges::binary_search (words, upper);
+		}
+
+		/// 24-bit hash of a dollar-quote tag, kept in the line state to find the closing tag.
+		u32
+		TagHash (std::string_view tag) {
+			u32 hash = 2166136261u;
+			for (const char c : tag) hash = (hash ^ static_cast<unsigned char> (c)) * 16777619u;
+			return hash & 0xFFFFFF;
+		}
+
+		/// If a dollar-quote tag ($$ or $name$) starts at @p at, its length.
+		size_t
+		DollarTag (std::string_view line, size_t at) {
+			if (line [at] != '$') return 0;
+			size_t end = at + 1;
+			if (end < line.size () && Digit (line [end])) return 0;	 // $1 is a parameter.
+			while (end < line.size () && IdentByte (line [end]) && line [end] != '$') ++end;
+			return end < line.size () && line [end] == '$' ? end + 1 - at : 0;
+		}
+
+		class LineLexer {
+		public:
+			LineLexer (const DialectRules& rules, std::string_view line, std::vector<SqlSpan>* spans)
+				: m_rules (rules), m_line (line), m_spans (spans) {}
+
+			SqlLineState
+			Run (SqlLineState state) {
+				size_t at = 0;
+				// Finish what the previous line left open.
+				if (state != kPlain) {
+					const size_t end = Continue (0, state);
+					if (end == std::string_view::npos) {
+						Emit (0, m_line.size (), (state & 0xFF) == kComment ? SqlToken::Comment : TokenOf (state & 0xFF));
+						return m_state;
+					}
+					Emit (0, end, (state & 0xFF) == kComment ? SqlToken::Comment : TokenOf (state & 0xFF));
+					at = end;
+				}
+				while (at < m_line.size ()) {
+					const char c = m_line [at];
+					const size_t start = at;
+					if (c == ' ' || c == '\t' || c == '\r' || c == '\f') {
+						++at;
+						continue;
+					}
+					const char next = at + 1 < m_line.size () ? m_line [at + 1] : '\0';
+					if ((c == '-' && next == '-') || (c == '#' && m_rules.hashComments)) {
+						Emit (start, m_line.size (), SqlToken::Comment);
+						return kPlain;
+					}
+					u32 open = kPlain;
+					if (c == '/' && next == '*') {
+						open = kComment;
+					}
+					else if (c == '\'') {
+						open = m_rules.backslashEscapes ? kEscapedString : kString;
+					}
+					else if (c == '"') {
+						open = m_rules.doubleQuotedStrings ? kDoubleString : kQuotedName;
+					}
+					else if (c == '`' && m_rules.backtickNames) {
+						open = kBacktickName;
+					}
+					else if (c == '$' && m_rules.dollarQuotes && DollarTag (m_line, at) > 0) {
+						open = kDollarString;
+					}
+					if (open != kPlain) {
+						// A string, name or comment: it may run on past this line.
+						SqlLineState inside = StateOf (open, 0);
+						size_t body = at + 1;
+						if (open == kComment) {
+							inside = StateOf (kComment, 1);
+							body = at + 2;
+						}
+						else if (open == kDollarString) {
+							const size_t tag = DollarTag (m_line, at);
+							inside = StateOf (kDollarString, TagHash (m_line.substr (at + 1, tag - 2)));
+							body = at + tag;
+						}
+						const size_t end = Continue (body, inside);
+						const SqlToken token = open == kComment ? SqlToken::Comment : TokenOf (open);
+						if (end == std::string_view::npos) {
+							Emit (start, m_line.size (), token);
+							return m_state;
+						}
+						Emit (start, end, token);
+						at = end;
+						continue;
+					}
+					if (c == '[' && m_rules.bracketNames) {
+						const size_t close = m_line.find (']', at + 1);
+						at = close == std::string_view::npos ? m_line.size () : close + 1;
+						Emit (start, at, SqlToken::Name);
+						continue;
+					}
+					if (Digit (c) || (c == '.' && Digit (next))) {
+						at = Number (at);
+						Emit (start, at, SqlToken::Number);
+						continue;
+					}
+					if ((c == '?' || (c == '$' && m_rules.dollarQuotes)) && (c == '?' || Digit (next))) {
+						++at;
+						while (at < m_line.size () && Digit (m_line [at])) ++at;
+						Emit (start, at, SqlToken::Parameter);
+						continue;
+					}
+					if ((c == ':' || c == '@') && IdentStart (next) && !(at > 0 && m_line [at - 1] == ':')) {
+						at += 2;
+						while (at < m_line.size () && IdentByte (m_line [at])) ++at;
+						Emit (start, at, SqlToken::Parameter);
+						continue;
+					}
+					if (IdentStart (c)) {
+						at = Word (at);
+						continue;
+					}
+					// Operators and punctuation, one run per span.
+					++at;
+					while (at < m_line.size () && OperatorByte (m_line [at]) && !(m_line [at] == '-' && at + 1 < m_line.size () && m_line [at + 1] == '-') &&
+						   !(m_line [at] == '/' && at + 1 < m_line.size () && m_line [at + 1] == '*')) {
+						++at;
+					}
+					Emit (start, at, SqlToken::Operator);
+				}
+				return m_state;
+			}
+
+		private:
+			static SqlToken
+			TokenOf (u32 kind) {
+				return kind == kQuotedName || kind == kBacktickName ? SqlToken::Name : SqlToken::String;
+			}
+
+			static bool
+			OperatorByte (char c) {
+				return std::string_view ("+-*/<>=~!%^&|,;().").find (c) != std::string_view::npos;
+			}
+
+			void
+			Emit (size_t begin, size_t end, SqlToken token) {
+				if (m_spans && end > begin) m_spans->push_back ({static_cast<u32> (begin), static_cast<u32> (end - begin), token});
+			}
+
+			/**
+			 * @brief Scan the body of what @p state has open from @p at; return the offset
+			 * just past its end, or npos if the line ends first (m_state then says what is
+			 * still open).
+			 */
+			size_t
+			Continue (size_t at, SqlLineState state) {
+				const u32 kind = state & 0xFF;
+				const u32 extra = state >> 8;
+				if (kind == kComment) {
+					u32 depth = extra;
+					while (at < m_line.size ()) {
+						if (m_line [at] == '*' && at + 1 < m_line.size () && m_line [at + 1] == '/') {
+							at += 2;
+							if (--depth == 0) return at;
+						}
+						else if (m_rules.nestedComments && m_line [at] == '/' && at + 1 < m_line.size () && m_line [at + 1] == '*') {
+							at += 2;
+							++depth;
+						}
+						else {
+							++at;
+						}
+					}
+					m_state = StateOf (kComment, depth);
+					return std::string_view::npos;
+				}
+				if (kind == kDollarString) {
+					for (at = m_line.find ('$', at); at != std::string_view::npos; at = m_line.find ('$', at + 1)) {
+						const size_t tag = DollarTag (m_line, at);
+						if (tag > 0 && TagHash (m_line.substr (at + 1, tag - 2)) == extra) return at + tag;
+					}
+					m_state = state;
+					return std::string_view::npos;
+				}
+				const char close = kind == kQuotedName || kind == kDoubleString ? '"' : kind == kBacktickName ? '`' : '\'';
+				const bool escapes = kind == kEscapedString || kind == kDoubleString;
+				while (at < m_line.size ()) {
+					const char c = m_line [at];
+					if (escapes && c == '\\') {
+						at += 2;
+						continue;
+					}
+					++at;
+					if (c != close) continue;
+					// A doubled quote stands for itself.
+					if (at < m_line.size () && m_line [at] == close) {
+						++at;
+						continue;
+					}
+					return at;
+				}
+				m_state = state;
+				return std::string_view::npos;
+			}
+
+			size_t
+			Number (size_t at) const {
+				if (m_line [at] == '0' && at + 1 < m_line.size () && (m_line [at + 1] == 'x' || m_line [at + 1] == 'X')) {
+					at += 2;
+					while (at < m_line.size () && std::isxdigit (static_cast<unsigned char> (m_line [at]))) ++at;
+					return at;
+				}
+				while (at < m_line.size () && (Digit (m_line [at]) || m_line [at] == '.' || m_line [at] == '_')) ++at;
+				if (at < m_line.size () && (m_line [at] == 'e' || m_line [at] == 'E')) {
+					size_t exponent = at + 1;
+					if (exponent < m_line.size () && (m_line [exponent] == '+' || m_line [exponent] == '-')) ++exponent;
+					if (exponent < m_line.size () && Digit (m_line [exponent])) {
+						at = exponent;
+						while (at < m_line.size () && Digit (m_line [at])) ++at;
+					}
+				}
+				return at;
+			}
+
+			/// A word from @p at: a keyword, type, function name, identifier or prefixed string.
+			size_t
+			Word (size_t at) {
+				const size_t start = at;
+				while (at < m_line.size () && IdentByte (m_line [at]) && !(m_line [at] == '$' && m_rules.dollarQuotes)) ++at;
+				const std::string_view word = m_line.substr (start, at - start);
+
+				// X'..' blobs, N'..' national and B'..' bit strings; E'..' escapes in PostgreSQL.
+				if (word.size () == 1 && at < m_line.size () && m_line [at] == '\'' && std::string_view ("xXnNbBeE").find (word [0]) != std::string_view::npos) {
+					const bool escapes = m_rules.backslashEscapes || word [0] == 'e' || word [0] == 'E';
+					const SqlLineState inside = StateOf (escapes ? kEscapedString : kString, 0);
+					const size_t end = Continue (at + 1, inside);
+					if (end == std::string_view::npos) {
+						Emit (start, m_line.size (), SqlToken::String);
+						return m_line.size ();
+					}
+					Emit (start, end, SqlToken::String);
+					return end;
+				}
+
+				SqlToken token = SqlToken::Plain;
+				char upper [32];
+				if (word.size () <= sizeof (upper)) {
+					std::ranges::transform (word, upper, [] (char c) { return (c >= 'a' && c <= 'z') ? static_cast<char> (c & ~0x20) : c; });
+					const std::string_view key (upper, word.size ());
+					if (IsWord (kKeywords, key) || IsWord (m_rules.keywords, key)) {
+						token = SqlToken::Keyword;
+					}
+					else if (IsWord (kTypes, key) || IsWord (m_rules.types, key)) {
+						token = SqlToken::Type;
+					}
+				}
+				if (token == SqlToken::Plain) {
+					size_t next = at;
+					while (next < m_line.size () && (m_line [next] == ' ' || m_line [next] == '\t')) ++next;
+					if (next < m_line.size () && m_line [next] == '(') token = SqlToken::Function;
+				}
+				Emit (start, at, token);
+				return at;
+			}
+
+			const DialectRules& m_rules;
+			std::string_view m_line;
+			std::vector<SqlSpan>* m_spans;
+			SqlLineState m_state{kPlain};  ///< What the line leaves open.
+		};
+
+	}  // namespace
+
+	SqlDialect
+	SqlDialectFor (std::string_view driver) {
+		if (driver == "postgresql") return SqlDialect::PostgreSql;
+		if (driver == "mysql") return SqlDialect::MySql;
+		return SqlDialect::Sqlite;
+	}
+
+	SqlLineState
+	LexSqlLine (SqlDialect dialect, std::string_view line, SqlLineState state, std::vector<SqlSpan>* spans) {
+		return LineLexer (RulesFor (dialect), line, spans).Run (state);
+	}
+
+	SqlHighlighter::SqlHighlighter (SqlDialect dialect) : m_dialect (dialect) {}
+
+	void
+	SqlHighlighter::SetDialect (SqlDialect dialect) {
+		if (dialect == m_dialect) return;
+		m_dialect = dialect;
+		Reset ();
+	}
+
+	void
+	SqlHighlighter::Reset () {
+		m_states.clear ();
+		m_dirtyFrom = kNone;
+		m_dirtyTo = 0;
+		for (CachedLine& cached : m_cache) cached.line = kNone;
+	}
+
+	void
+	SqlHighlighter::Edited (u32 line, u32 removed, u32 inserted) {
+		// The edited lines and every line below may read differently or have moved.
+		for (CachedLine& cached : m_cache) {
+			if (cached.line != kNone && cached.line >= line) cached.line = kNone;
+		}
+		if (line >= m_states.size ()) return;
+
+		// Lines below keep their old starting states, to tell when a new pass converges.
+		const size_t first = line + 1;
+		const size_t erased = std::min (m_states.size (), first + removed);
+		m_states.erase (m_states.begin () + static_cast<std::ptrdiff_t> (std::min (first, m_states.size ())), m_states.begin () + static_cast<std::ptrdiff_t> (erased));
+		if (first <= m_states.size ()) m_states.insert (m_states.begin () + static_cast<std::ptrdiff_t> (first), inserted, kPlain);
+
+		if (m_dirtyFrom == kNone) {
+			m_dirtyFrom = line;
+			m_dirtyTo = line + inserted;
+			return;
+		}
+		// An earlier edit not lexed yet: move its range with the lines.
+		u32 to = m_dirtyTo;
+		if (to > line + removed) {
+			to = to - removed + inserted;
+		}
+		else if (to >= line) {
+			to = line + inserted;
+		}
+		m_dirtyTo = std::max (to, line + inserted);
+		m_dirtyFrom = std::min (m_dirtyFrom, line);
+	}
+
+	void
+	SqlHighlighter::Reach (u32 line, const LineSource& source) {
+		if (m_states.empty ()) m_states.push_back (kPlain);
+		if (m_dirtyFrom != kNone) {
+			u32 at = m_dirtyFrom;
+			m_dirtyFrom = kNone;
+			while (at + 1 < m_states.size ()) {
+				const SqlLineState end = LexSqlLine (m_dialect, source (at), m_states [at], nullptr);
+				++m_linesLexed;
+				++at;
+				// Past the edit, a line starting as it did before: the rest stands.
+				if (at > m_dirtyTo && m_states [at] == end) break;
+				m_states [at] = end;
+				if (at > line + kLookahead) {
+					// Everything below may have changed; lex it when it is needed.
+					m_states.resize (at + 1);
+					break;
+				}
+			}
+		}
+		while (m_states.size () <= line) {
+			const auto at = static_cast<u32> (m_states.size () - 1);
+			m_states.push_back (LexSqlLine (m_dialect, source (at), m_states.back (), nullptr));
+			++m_linesLexed;
+		}
+	}
+
+	const std::vector<SqlSpan>&
+	SqlHighlighter::Spans (u32 line, const LineSource& source) {
+		Reach (line, source);
+		CachedLine& cached = m_cache [line % kCacheSize];
+		if (cached.line != line) {
+			cached.spans.clear ();
+			LexSqlLine (m_dialect, source (line), m_states [line], &cached.spans);
+			++m_linesLexed;
+			cached.line = line;
+		}
+		return cached.spans;
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <macro.h>
+
+#include <array>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace ambidb {
+
+	enum class SqlDialect : u8 {
+		Sqlite,
+		PostgreSql,
+		MySql,
+	};
+
+	/// Dialect for a connection's driver name ("postgresql", "mysql", "sqlite"); SQLite otherwise.
+	SqlDialect
+	SqlDialectFor (std::string_view driver);
+
+	enum class SqlToken : u8 {
+		Plain,	///< Identifiers and anything unclassified.
+		Keyword,
+		Type,
+		Function,  ///< A name followed by '('.
+		String,
+		Number,
+		Comment,
+		Name,  ///< A quoted identifier.
+		Operator,
+		Parameter,	///< ?, ?1, $1, :name, @name.
+	};
+
+	constexpr size_t kSqlTokenCount = 10;
+
+	/// A token of one line: [begin, begin + length) in the line's bytes.
+	struct SqlSpan {
+		u32 begin{0};
+		u32 length{0};
+		SqlToken token{SqlToken::Plain};
+
+		bool
+		operator== (const SqlSpan&) const = default;
+	};
+
+	/**
+	 * @brief What the lexer carries from the end of one line into the next: inside a block
+	 * comment (and how deeply nested), a string, a quoted name or a dollar-quoted body (and
+	 * a hash of its tag). 0 is plain SQL.
+	 */
+	using SqlLineState = u32;
+
+	/**
+	 * @brief Lex one line (without its newline) that starts in @p state and return the state
+	 * it ends in. Spans for every token are appended to @p spans when it is not null;
+	 * whitespace is left out.
+	 */
+	SqlLineState
+	LexSqlLine (SqlDialect dialect, std::string_view line, SqlLineState state, std::vector<SqlSpan>* spans);
+
+	/**
+	 * @brief Syntax highlighting for a document of many lines that changes by edits.
+	 *
+	 * Keeps the lexer state at the start of every line lexed so far. An edit re-lexes from
+	 * its first line onward only until a line ends in the state it ended in before and the
+	 * edited lines are behind, so typing costs the same in a five-line query as in a script
+	 * of a hundred thousand lines. Lines are lexed lazily, no further than the last line
+	 * asked for; when an edit changes the state of everything below (an unclosed quote),
+	 * the states past the requested line are dropped and lexed again when scrolled to.
+	 *
+	 * Spans of the lines drawn are kept in a small cache, so frames without edits lex
+	 * nothing. Not thread-safe; used from the UI thread.
+	 */
+	class SqlHighlighter {
+	public:
+		/// Text of line @p line, without its newline.
+		using LineSource = std::function<std::string_view (u32 line)>;
+
+		MAKE_NONCOPYABLE (SqlHighlighter);
+		MAKE_NONMOVABLE (SqlHighlighter);
+		explicit SqlHighlighter (SqlDialect dialect = SqlDialect::Sqlite);
+
+		SqlDialect
+		Dialect () const {
+			return m_dialect;
+		}
+
+		/// Switch dialect; everything is lexed again.
+		void
+		SetDialect (SqlDialect dialect);
+
+		/// The whole text was replaced.
+		void
+		Reset ();
+
+		/**
+		 * @brief Lines [@p line, @p line + @p removed] were replaced by lines [@p line,
+		 * @p line + @p inserted]: an edit within one line is (line, 0, 0), typing a newline
+		 * in it (line, 0, 1).
+		 */
+		void
+		Edited (u32 line, u32 removed, u32 inserted);
+
+		/**
+		 * @brief Spans of line @p line, lexing what it takes to know the state the line
+		 * starts in. The reference is valid until the next call.
+		 */
+		const std::vector<SqlSpan>&
+		Spans (u32 line, const LineSource& source);
+
+		/// Lines whose starting state is known.
+		size_t
+		KnownLines () const {
+			return m_states.size ();
+		}
+
+		/// Lines lexed since construction, counting each pass; for tests and tracing.
+		u64
+		LinesLexed () const {
+			return m_linesLexed;
+		}
+
+	private:
+		static constexpr u32 kNone = ~u32{0};
+		static constexpr size_t kCacheSize = 256;  ///< Direct-mapped by line; a screenful or two.
+
+		struct CachedLine {
+			u32 line{kNone};
+			std::vector<SqlSpan> spans;
+		};
+
+		/// Make the starting state of line @p line known.
+		void
+		Reach (u32 line, const LineSource& source);
+
+		SqlDialect m_dialect;
+		std::vector<SqlLineState> m_states;	 ///< State at the start of each line known.
+		u32 m_dirtyFrom{kNone};	 ///< First line to lex again after edits; kNone if none.
+		u32 m_dirtyTo{0};		 ///< Lines up to here were edited; convergence counts after.
+		std::array<CachedLine, kCacheSize> m_cache;
+		u64 m_linesLexed{0};
+	};
+
+}  // namespace ambidb
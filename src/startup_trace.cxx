@@ -0,0 +1,148 @@
+#include "startup_trace.h"
+
+#include <backends/backend_config.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <print>
+#include <unistd.h>
+
+namespace ambidb {
+
+	namespace {
+
+		// Initialized with the image's static constructors, i.e. before main().
+		const StartupTrace::Clock::time_point g_loadTime = StartupTrace::Clock::now ();
+
+		std::chrono::nanoseconds
+		ProcessCpuTime () {
+			timespec ts{};
+			clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+			return std::chrono::seconds (ts.tv_sec) + std::chrono::nanoseconds (ts.tv_nsec);
+		}
+
+		double
+		Micros (StartupTrace::Clock::duration d) {
+			return std::chrono::duration<double, std::micro> (d).count ();
+		}
+
+		double
+		Millis (std::chrono::nanoseconds d) {
+			return std::chrono::duration<double, std::milli> (d).count ();
+		}
+
+		void
+		WriteJsonString (std::ofstream& out, const char* text) {
+			out << '"';
+			for (const char* c = text; *c; ++c) {
+				if (*c == '"' || *c == '\\') out << '\\';
+				out << *c;
+			}
+			out << '"';
+		}
+
+	}  // namespace
+
+	StartupTrace::Scope::Scope (const char* name) : m_name (name) {
+		if (!Instance ().Recording ()) {
+			m_name = nullptr;
+			return;
+		}
+		m_start = Clock::now ();
+		m_cpuStart = ProcessCpuTime ();
+	}
+
+	StartupTrace::Scope::~Scope () {
+		if (!m_name) return;
+		const std::chrono::nanoseconds cpu = ProcessCpuTime () - m_cpuStart;
+		Instance ().Record (m_name, m_start, Clock::now (), cpu);
+	}
+
+	StartupTrace::StartupTrace () : m_origin (g_loadTime) {
+		if (const char* path = std::getenv ("AMBIDB_STARTUP_TRACE"); path && *path) {
+			m_outputPath = path;
+		}
+		m_events.reserve (32);
+	}
+
+	StartupTrace&
+	StartupTrace::Instance () {
+		static StartupTrace trace;
+		return trace;
+	}
+
+	void
+	StartupTrace::Absorb (const StartupTrace& host) {
+		m_origin = host.m_origin;
+		m_events.insert (m_events.begin (), host.m_events.begin (), host.m_events.end ());
+	}
+
+	void
+	StartupTrace::Record (const char* name, Clock::time_point start, Clock::time_point end, std::chrono::nanoseconds cpu) {
+		if (!Recording ()) return;
+		m_events.push_back ({name, start, end - start, cpu});
+	}
+
+	void
+	StartupTrace::MarkFirstFrame () {
+		if (m_firstFrame) return;
+		m_firstFrameAt = Clock::now ();
+		m_firstFrame = true;
+
+		if (!m_outputPath.empty () && !WriteChromeTrace (m_outputPath)) {
+			// stderr is the terminal in TUI mode; report at shutdown instead.
+			m_outputPath += " (write failed)";
+		}
+	}
+
+	bool
+	StartupTrace::WriteChromeTrace (const std::string& path) const {
+		std::ofstream out (path);
+		if (!out) return false;
+
+		const int pid = static_cast<int> (getpid ());
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		for (const StartupTraceEvent& event : m_events) {
+			if (!first) out << ",\n";
+			first = false;
+			out << "{\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":1,\"name\":";
+			WriteJsonString (out, event.name);
+			out << ",\"ts\":" << Micros (event.start - m_origin) << ",\"dur\":" << Micros (event.wall)
+				<< ",\"args\":{\"cpu_ms\":" << Millis (event.cpu) << "}}";
+		}
+		if (m_firstFrame) {
+			if (!first) out << ",\n";
+			out << "{\"ph\":\"i\",\"s\":\"g\",\"pid\":" << pid << ",\"tid\":1,\"name\":\"first frame\",\"ts\":"
+				<< Micros (m_firstFrameAt - m_origin) << "}";
+		}
+		out << "\n]}\n";
+		return static_cast<bool> (out);
+	}
+
+	void
+	StartupTrace::PrintSummary () const {
+		if (m_outputPath.empty ()) return;
+
+		std::println ("[Startup] {:<28} {:>9} {:>9} {:>9}", "step", "start ms", "wall ms", "cpu ms");
+		for (const StartupTraceEvent& event : m_events) {
+			std::println ("[Startup] {:<28} {:>9.2f} {:>9.2f} {:>9.2f}",
+						  event.name,
+						  Millis (event.start - m_origin),
+						  Millis (event.wall),
+						  Millis (event.cpu));
+		}
+		if (!m_firstFrame) {
+			std::println ("[Startup] no frame was presented");
+			return;
+		}
+		const double firstFrameMs = Millis (TimeToFirstFrame ());
+		std::println ("[Startup] first frame after {:.2f} ms (budget {} ms){}",
+					  firstFrameMs,
+					  config::STARTUP_BUDGET_MS,
+					  firstFrameMs > config::STARTUP_BUDGET_MS ? " OVER BUDGET" : "");
+		std::println ("[Startup] trace: {}", m_outputPath);
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <macro.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace ambidb {
+
+	struct StartupTraceEvent {
+		const char* name{nullptr};	///< Static string; lives as long as the image that recorded it.
+		std::chrono::steady_clock::time_point start{};
+		std::chrono::steady_clock::duration wall{};
+		std::chrono::nanoseconds cpu{};	 ///< Process CPU time, so driver threads count too.
+	};
+
+	/**
+	 * @brief Records wall and CPU time of each startup step until the first frame is presented.
+	 *
+	 * Steps are recorded with Scope; once MarkFirstFrame() is called, further scopes are
+	 * a single branch, so they can stay in code that runs every frame (e.g. ApplyTheme).
+	 * If AMBIDB_STARTUP_TRACE=<file.json> is set, the trace is written as Chrome trace
+	 * JSON (chrome://tracing, Perfetto) on the first frame and a summary is printed
+	 * after shutdown, flagged if the first frame missed config::STARTUP_BUDGET_MS.
+	 *
+	 * UI thread only.
+	 */
+	class StartupTrace {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		class Scope {
+		public:
+			MAKE_NONCOPYABLE (Scope);
+			MAKE_NONMOVABLE (Scope);
+			explicit Scope (const char* name);
+			~Scope ();
+
+		private:
+			const char* m_name;
+			Clock::time_point m_start;
+			std::chrono::nanoseconds m_cpuStart;
+		};
+
+		MAKE_NONCOPYABLE (StartupTrace);
+		MAKE_NONMOVABLE (StartupTrace);
+
+		static StartupTrace&
+		Instance ();
+
+		/**
+		 * @brief Take over the origin and events of the host executable's trace.
+		 * Used by the GUI module, which has its own copy of this class.
+		 */
+		void
+		Absorb (const StartupTrace& host);
+
+		void
+		Record (const char* name, Clock::time_point start, Clock::time_point end, std::chrono::nanoseconds cpu);
+
+		/**
+		 * @brief Call after the first frame reached the screen; ends recording.
+		 */
+		void
+		MarkFirstFrame ();
+
+		bool
+		Recording () const {
+			return !m_firstFrame;
+		}
+
+		/**
+		 * @brief Time from process start to the first presented frame (zero until then).
+		 */
+		Clock::duration
+		TimeToFirstFrame () const {
+			return m_firstFrame ? m_firstFrameAt - m_origin : Clock::duration::zero ();
+		}
+
+		const std::vector<StartupTraceEvent>&
+		Events () const {
+			return m_events;
+		}
+
+		bool
+		WriteChromeTrace (const std::string& path) const;
+
+		/**
+		 * @brief Print per-step times and the budget verdict if tracing was requested.
+		 */
+		void
+		PrintSummary () const;
+
+	private:
+		StartupTrace ();
+		~StartupTrace () = default;
+
+		Clock::time_point m_origin;
+		Clock::time_point m_firstFrameAt{};
+		bool m_firstFrame = false;
+		std::string m_outputPath;
+		std::vector<StartupTraceEvent> m_events;
+	};
+
+}  // namespace ambidb
@@ -0,0 +1,321 @@
+#include "text_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ambidb {
+
+	/// Bytes that are only ever appended to: pieces keep pointing at what is already there.
+	struct TextBuffer::Block {
+		std::string text;			  ///< Reserved up front when appended to, so it never moves.
+		std::vector<size_t> breaks;	  ///< Offsets of the '\n's in text, ascending.
+
+		void
+		Add (std::string_view bytes) {
+			const size_t base = text.size ();
+			text.append (bytes);
+			for (const char* at = bytes.data (); (at = static_cast<const char*> (std::memchr (at, '\n', static_cast<size_t> (bytes.data () + bytes.size () - at))));
+				 ++at) {
+				breaks.push_back (base + static_cast<size_t> (at - bytes.data ()));
+			}
+		}
+
+		/// Newlines in text [from, to).
+		size_t
+		Newlines (size_t from, size_t to) const {
+			return static_cast<size_t> (std::ranges::lower_bound (breaks, to) - std::ranges::lower_bound (breaks, from));
+		}
+
+		/// Offset of the @p nth (from 0) newline at or after @p from.
+		size_t
+		Break (size_t from, size_t nth) const {
+			return *(std::ranges::lower_bound (breaks, from) + static_cast<std::ptrdiff_t> (nth));
+		}
+	};
+
+	/// A piece, and the sums over the subtree it roots. Immutable once shared.
+	struct TextBuffer::Node {
+		NodePtr left;
+		NodePtr right;
+		std::shared_ptr<Block> block;
+		size_t offset{0};  ///< The piece is block->text [offset, offset + length).
+		size_t length{0};
+		size_t newlines{0};	 ///< In the piece.
+		size_t bytes{0};	 ///< In the subtree.
+		size_t lines{0};	 ///< Newlines in the subtree.
+		u32 priority{0};	 ///< Greater than its children's.
+	};
+
+	struct TextBuffer::Tree {
+		static size_t
+		Bytes (const NodePtr& node) {
+			return node ? node->bytes : 0;
+		}
+
+		static size_t
+		Lines (const NodePtr& node) {
+			return node ? node->lines : 0;
+		}
+
+		/// @p piece's bytes [offset, offset + length) under new children.
+		static NodePtr
+		With (const Node& piece, NodePtr left, NodePtr right, size_t offset, size_t length) {
+			auto node = std::make_shared<Node> ();
+			node->block = piece.block;
+			node->offset = offset;
+			node->length = length;
+			node->newlines = offset == piece.offset && length == piece.length ? piece.newlines : piece.block->Newlines (offset, offset + length);
+			node->priority = piece.priority;
+			node->bytes = Bytes (left) + length + Bytes (right);
+			node->lines = Lines (left) + node->newlines + Lines (right);
+			node->left = std::move (left);
+			node->right = std::move (right);
+			return node;
+		}
+
+		static NodePtr
+		With (const Node& piece, NodePtr left, NodePtr right) {
+			return With (piece, std::move (left), std::move (right), piece.offset, piece.length);
+		}
+
+		/// The first @p at bytes, and the rest; a piece straddling @p at is cut in two.
+		static std::pair<NodePtr, NodePtr>
+		Split (const NodePtr& node, size_t at) {
+			if (!node) return {};
+			const size_t before = Bytes (node->left);
+			if (at <= before) {
+				auto [left, right] = Split (node->left, at);
+				return {std::move (left), With (*node, std::move (right), node->right)};
+			}
+			if (at >= before + node->length) {
+				auto [left, right] = Split (node->right, at - before - node->length);
+				return {With (*node, node->left, std::move (left)), std::move (right)};
+			}
+			const size_t cut = at - before;
+			return {With (*node, node->left, nullptr, node->offset, cut), With (*node, nullptr, node->right, node->offset + cut, node->length - cut)};
+		}
+
+		/// @p left followed by @p right.
+		static NodePtr
+		Merge (const NodePtr& left, const NodePtr& right) {
+			if (!left) return right;
+			if (!right) return left;
+			if (left->priority > right->priority) return With (*left, left->left, Merge (left->right, right));
+			return With (*right, Merge (left, right->left), right->right);
+		}
+
+		/// @p node with its last piece grown by @p length, if that piece ends at @p start of
+		/// @p block; null otherwise.
+		static NodePtr
+		Extend (const NodePtr& node, const Block* block, size_t start, size_t length) {
+			if (!node) return nullptr;
+			if (node->right) {
+				NodePtr right = Extend (node->right, block, start, length);
+				return right ? With (*node, node->left, std::move (right)) : nullptr;
+			}
+			if (node->block.get () != block || node->offset + node->length != start) return nullptr;
+			return With (*node, node->left, nullptr, node->offset, node->length + length);
+		}
+
+		static void
+		Visit (const NodePtr& node, size_t base, size_t from, size_t to, const std::function<void (std::string_view)>& chunk) {
+			if (!node) return;
+			const size_t start = base + Bytes (node->left);
+			const size_t end = start + node->length;
+			if (from < start) Visit (node->left, base, from, to, chunk);
+			if (from < end && to > start) {
+				const size_t first = std::max (from, start);
+				chunk (std::string_view (node->block->text).substr (node->offset + first - start, std::min (to, end) - first));
+			}
+			if (to > end) Visit (node->right, end, from, to, chunk);
+		}
+
+		static size_t
+		Count (const NodePtr& node) {
+			return node ? Count (node->left) + 1 + Count (node->right) : 0;
+		}
+	};
+
+	TextBuffer::TextBuffer (std::string text) {
+		Assign (std::move (text));
+	}
+
+	TextBuffer::~TextBuffer () = default;
+
+	size_t
+	TextBuffer::Size () const {
+		return Tree::Bytes (m_root);
+	}
+
+	u32
+	TextBuffer::LineCount () const {
+		return static_cast<u32> (Tree::Lines (m_root) + 1);
+	}
+
+	size_t
+	TextBuffer::LineStart (u32 line) const {
+		if (line == 0) return 0;
+		// Just past the line-th newline.
+		size_t nth = line;
+		size_t base = 0;
+		for (const Node* node = m_root.get (); node;) {
+			const size_t before = Tree::Lines (node->left);
+			if (nth <= before) {
+				node = node->left.get ();
+				continue;
+			}
+			nth -= before;
+			base += Tree::Bytes (node->left);
+			if (nth <= node->newlines) return base + node->block->Break (node->offset, nth - 1) - node->offset + 1;
+			nth -= node->newlines;
+			base += node->length;
+			node = node->right.get ();
+		}
+		return Size ();
+	}
+
+	size_t
+	TextBuffer::LineEnd (u32 line) const {
+		return line + 1 < LineCount () ? LineStart (line + 1) - 1 : Size ();
+	}
+
+	u32
+	TextBuffer::LineOf (size_t offset) const {
+		// Newlines before offset.
+		size_t lines = 0;
+		for (const Node* node = m_root.get (); node;) {
+			const size_t before = Tree::Bytes (node->left);
+			if (offset <= before) {
+				node = node->left.get ();
+				continue;
+			}
+			offset -= before;
+			lines += Tree::Lines (node->left);
+			if (offset <= node->length) return static_cast<u32> (lines + node->block->Newlines (node->offset, node->offset + offset));
+			offset -= node->length;
+			lines += node->newlines;
+			node = node->right.get ();
+		}
+		return static_cast<u32> (lines);
+	}
+
+	char
+	TextBuffer::At (size_t offset) const {
+		for (const Node* node = m_root.get (); node;) {
+			const size_t before = Tree::Bytes (node->left);
+			if (offset < before) {
+				node = node->left.get ();
+				continue;
+			}
+			offset -= before;
+			if (offset < node->length) return node->block->text [node->offset + offset];
+			offset -= node->length;
+			node = node->right.get ();
+		}
+		return '\0';
+	}
+
+	std::string_view
+	TextBuffer::Text (size_t from, size_t to, std::string& scratch) const {
+		std::string_view first;
+		size_t chunks = 0;
+		ForEachChunk (from, to, [&] (std::string_view chunk) {
+			if (chunks++ == 0) {
+				first = chunk;
+				return;
+			}
+			if (chunks == 2) scratch.assign (first);
+			scratch.append (chunk);
+		});
+		return chunks <= 1 ? first : std::string_view (scratch);
+	}
+
+	std::string_view
+	TextBuffer::Line (u32 line, std::string& scratch) const {
+		return Text (LineStart (line), LineEnd (line), scratch);
+	}
+
+	std::string
+	TextBuffer::Text () const {
+		std::string text;
+		text.reserve (Size ());
+		ForEachChunk (0, Size (), [&] (std::string_view chunk) { text.append (chunk); });
+		return text;
+	}
+
+	void
+	TextBuffer::ForEachChunk (size_t from, size_t to, const std::function<void (std::string_view)>& chunk) const {
+		to = std::min (to, Size ());
+		if (from < to) Tree::Visit (m_root, 0, from, to, chunk);
+	}
+
+	void
+	TextBuffer::Insert (size_t offset, std::string_view text) {
+		if (text.empty ()) return;
+		auto [left, right] = Tree::Split (m_root, std::min (offset, Size ()));
+		auto [block, start] = Append (text);
+		// Typing on where the last insert ended grows its piece.
+		NodePtr grown = Tree::Extend (left, block.get (), start, text.size ());
+		if (!grown) grown = Tree::Merge (left, MakeNode (std::move (block), start, text.size ()));
+		m_root = Tree::Merge (grown, right);
+	}
+
+	void
+	TextBuffer::Erase (size_t from, size_t to) {
+		to = std::min (to, Size ());
+		if (from >= to) return;
+		auto [left, rest] = Tree::Split (m_root, from);
+		m_root = Tree::Merge (left, Tree::Split (rest, to - from).second);
+	}
+
+	void
+	TextBuffer::Assign (std::string text) {
+		if (text.empty ()) {
+			m_root = nullptr;
+			return;
+		}
+		auto block = std::make_shared<Block> ();
+		block->text = std::move (text);
+		for (size_t at = block->text.find ('\n'); at != std::string::npos; at = block->text.find ('\n', at + 1)) block->breaks.push_back (at);
+		const size_t size = block->text.size ();
+		m_root = MakeNode (std::move (block), 0, size);
+	}
+
+	size_t
+	TextBuffer::PieceCount () const {
+		return Tree::Count (m_root);
+	}
+
+	TextBuffer::NodePtr
+	TextBuffer::MakeNode (std::shared_ptr<Block> block, size_t offset, size_t length) {
+		// xorshift32; only needs to look random to keep the treap balanced.
+		m_seed ^= m_seed << 13;
+		m_seed ^= m_seed >> 17;
+		m_seed ^= m_seed << 5;
+		Node piece;
+		piece.block = std::move (block);
+		piece.offset = offset;
+		piece.length = length;
+		piece.newlines = piece.block->Newlines (offset, offset + length);
+		piece.priority = m_seed;
+		return Tree::With (piece, nullptr, nullptr);
+	}
+
+	std::pair<std::shared_ptr<TextBuffer::Block>, size_t>
+	TextBuffer::Append (std::string_view text) {
+		if (text.size () >= kBlockSize) {
+			auto block = std::make_shared<Block> ();
+			block->text.reserve (text.size ());
+			block->Add (text);
+			return {std::move (block), 0};
+		}
+		if (!m_append || m_append->text.capacity () - m_append->text.size () < text.size ()) {
+			m_append = std::make_shared<Block> ();
+			m_append->text.reserve (kBlockSize);
+		}
+		const size_t start = m_append->text.size ();
+		m_append->Add (text);
+		return {m_append, start};
+	}
+
+}  // namespace ambidb
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <macro.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ambidb {
+
+	/**
+	 * @brief Editable text as a piece table: the text is a sequence of pieces, each a range
+	 * of an immutable block of bytes.
+	 *
+	 * Inserted text is appended once to an append-only block and referenced by a new piece;
+	 * nothing already in the buffer is copied or moved, so pasting a 50 MB dump costs one
+	 * copy of the paste, and typing into it costs O(log n). Typing at the end of the last
+	 * insert extends that piece instead of adding one.
+	 *
+	 * The pieces live in a persistent balanced tree (a treap keyed by position) whose
+	 * nodes sum their subtree's bytes and newlines. Position and line lookups descend it in
+	 * O(log n); each block keeps the offsets of its newlines, so splitting a piece counts
+	 * its newlines with two binary searches instead of a scan. Edits copy only the nodes on
+	 * their path and share the rest, so a Snapshot is a pointer to a root: taking one is
+	 * O(1), and an undo history costs O(log n) per edit.
+	 *
+	 * Offsets are in bytes; lines are separated by '\n'. Not thread-safe.
+	 */
+	class TextBuffer {
+	private:
+		struct Block;
+		struct Node;
+		struct Tree;  ///< Operations on the piece tree, in the .cxx.
+		using NodePtr = std::shared_ptr<const Node>;
+
+	public:
+		/// The text at one point in time; restoring it is O(1).
+		class Snapshot {
+		public:
+			Snapshot () = default;
+
+		private:
+			friend class TextBuffer;
+			explicit Snapshot (NodePtr root) : m_root (std::move (root)) {}
+
+			NodePtr m_root;
+		};
+
+		MAKE_NONCOPYABLE (TextBuffer);
+		MAKE_NONMOVABLE (TextBuffer);
+		explicit TextBuffer (std::string text = {});
+		~TextBuffer ();
+
+		size_t
+		Size () const;
+
+		/// Newlines + 1; an empty buffer has one empty line.
+		u32
+		LineCount () const;
+
+		/// Offset of the first byte of @p line; Size () past the last line.
+		size_t
+		LineStart (u32 line) const;
+
+		/// Offset of the '\n' ending @p line, or Size () for the last line.
+		size_t
+		LineEnd (u32 line) const;
+
+		/// Line holding the byte at @p offset.
+		u32
+		LineOf (size_t offset) const;
+
+		/// Byte at @p offset; '\0' at or past the end.
+		char
+		At (size_t offset) const;
+
+		/**
+		 * @brief Bytes [@p from, @p to). Points into the buffer when they lie in one piece and
+		 * are assembled in @p scratch otherwise; valid until the next edit or use of scratch.
+		 */
+		std::string_view
+		Text (size_t from, size_t to, std::string& scratch) const;
+
+		/// @p line without its '\n', as Text ().
+		std::string_view
+		Line (u32 line, std::string& scratch) const;
+
+		/// The whole text, copied.
+		std::string
+		Text () const;
+
+		/// Call @p chunk with the bytes [@p from, @p to) piece by piece, in order.
+		void
+		ForEachChunk (size_t from, size_t to, const std::function<void (std::string_view)>& chunk) const;
+
+		void
+		Insert (size_t offset, std::string_view text);
+
+		/// Remove bytes [@p from, @p to).
+		void
+		Erase (size_t from, size_t to);
+
+		/// Replace everything; the text becomes one block of its own, without a copy.
+		void
+		Assign (std::string text);
+
+		Snapshot
+		Save () const {
+			return Snapshot (m_root);
+		}
+
+		void
+		Restore (const Snapshot& snapshot) {
+			m_root = snapshot.m_root;
+		}
+
+		/// Pieces the text is made of; for tests and tracing.
+		size_t
+		PieceCount () const;
+
+	private:
+		/// Appended text goes into blocks of this size; larger inserts get a block of their own.
+		static constexpr size_t kBlockSize = 64 * 1024;
+
+		NodePtr
+		MakeNode (std::shared_ptr<Block> block, size_t offset, size_t length);
+
+		/// Append @p text to the append-only block; returns the block and where the text starts.
+		std::pair<std::shared_ptr<Block>, size_t>
+		Append (std::string_view text);
+
+		NodePtr m_root;
+		std::shared_ptr<Block> m_append;  ///< Current append-only block; its bytes never move.
+		u32 m_seed{0x9E3779B9u};		  ///< Treap priorities.
+	};
+
+}  // namespace ambidb
@@ -0,0 +1,326 @@
+#include "data_grid.h"
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+
+namespace ambidb::ui {
+
+	namespace {
+
+		// Slide by a quarter window when the scroll position enters the outer quarters; the
+		// new position lands mid-window, so the window does not bounce back and forth.
+		constexpr size_t kShiftRows = DataGrid::kWindowRows / 4;
+
+#if defined(IMGUI_HAS_TABLE)
+	#if IMGUI_VERSION_NUM >= 19000
+		constexpr size_t kMaxTableColumns = 512;
+	#else
+		constexpr size_t kMaxTableColumns = 64;
+	#endif
+		constexpr ImGuiTableFlags kGridFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+											   ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY |
+											   ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingFixedFit;
+#else
+		constexpr size_t kMinColumnChars = 4;
+		constexpr size_t kMaxColumnChars = 32;
+		constexpr size_t kMeasureRows = 64;
+#endif
+
+		void
+		HeaderTooltip (const DataGridSource& source, size_t column) {
+			if (!source.HasColumnTooltip (column)) return;
+			ImGui::BeginTooltip ();
+			source.ColumnTooltip (column);
+			ImGui::EndTooltip ();
+		}
+
+	}  // namespace
+
+	bool
+	DataGrid::Draw (const char* id, const DataGridSource& source, const ImVec2& size) {
+		const size_t rows = source.RowCount ();
+		const size_t columns = source.ColumnCount ();
+		if (columns == 0) return false;
+
+		ImGui::PushID (id);
+		ImGui::PushID (m_generation);
+
+		// Rows only ever get appended, so the window start stays put while a result streams in.
+		m_windowBase = std::min (m_windowBase, rows > kWindowRows ? rows - kWindowRows : 0);
+		if (rows > kWindowRows) {
+			PositionSlider (rows);
+		}
+		const size_t windowRows = std::min (rows - m_windowBase, kWindowRows);
+		bool settle = false;
+
+#if defined(IMGUI_HAS_TABLE)
+		if (columns > kMaxTableColumns) {
+			int first = static_cast<int> (std::min (m_columnBase, columns - kMaxTableColumns));
+			ImGui::SliderInt ("##columns", &first, 0, static_cast<int> (columns - kMaxTableColumns), "columns from %d");
+			m_columnBase = static_cast<size_t> (first);
+		}
+		else {
+			m_columnBase = 0;
+		}
+		const size_t shown = std::min (columns - m_columnBase, kMaxTableColumns);
+
+		const ImGuiTableFlags flags = kGridFlags | (source.Sortable () ? kSortableTableFlags : 0);
+		if (ImGui::BeginTable ("##grid", static_cast<int> (shown), flags, size)) {
+			ImGui::TableSetupScrollFreeze (0, 1);
+			for (size_t column = 0; column < shown; ++column) {
+				ImGui::TableSetupColumn (source.ColumnName (m_columnBase + column));
+			}
+			if (ui::TakeSortSpecs (m_sortSpecs)) {
+				for (SortSpec& spec : m_sortSpecs) spec.column += m_columnBase;
+				m_sortChanged = true;
+			}
+			// TableHeadersRow () by hand, so each header can show its tooltip.
+			ImGui::TableNextRow (ImGuiTableRowFlags_Headers);
+			for (size_t column = 0; column < shown; ++column) {
+				if (!ImGui::TableSetColumnIndex (static_cast<int> (column))) continue;
+				ImGui::PushID (static_cast<int> (column));
+				ImGui::TableHeader (source.ColumnName (m_columnBase + column));
+				ImGui::PopID ();
+				if (ImGui::IsItemHovered ()) HeaderTooltip (source, m_columnBase + column);
+			}
+			DrawRows (source, windowRows, shown);
+			settle = FinishScroll (rows, windowRows);
+			ImGui::EndTable ();
+		}
+#else
+		if (m_columnX.size () != columns + 1 || (!m_measuredRows && rows > 0)) {
+			MeasureColumns (source);
+		}
+		DrawHeader (source);
+		ImGui::Separator ();
+
+		ImGui::SetNextWindowContentSize (ImVec2 (m_columnX.back (), 0.0f));
+		if (ImGui::BeginChild ("##grid", size, false, ImGuiWindowFlags_HorizontalScrollbar)) {
+			DrawRows (source, windowRows, columns);
+			settle = FinishScroll (rows, windowRows);
+			// The header is drawn before the child, so it follows horizontal scrolling a frame late.
+			const float scrollX = ImGui::GetScrollX ();
+			if (scrollX != m_scrollX) {
+				m_scrollX = scrollX;
+				settle = true;
+			}
+		}
+		ImGui::EndChild ();
+#endif
+
+		ImGui::PopID ();
+		ImGui::PopID ();
+		return settle;
+	}
+
+	void
+	DataGrid::JumpToRow (size_t row) {
+		m_jumpTarget = row;
+		m_jumpPending = true;
+	}
+
+	bool
+	DataGrid::TakeSortSpecs (std::vector<SortSpec>& specs) {
+		if (!m_sortChanged) return false;
+		m_sortChanged = false;
+		specs = m_sortSpecs;
+		return true;
+	}
+
+	void
+	DataGrid::Reset () {
+		m_windowBase = 0;
+		m_jumpTarget = 0;
+		m_jumpPending = false;
+		m_rowHeight = 0.0f;
+		m_firstVisible = 0;
+		m_visibleCount = 0;
+		++m_generation;
+		m_sortSpecs.clear ();
+		m_sortChanged = false;
+#if defined(IMGUI_HAS_TABLE)
+		m_columnBase = 0;
+#else
+		m_columnX.clear ();
+		m_measuredRows = false;
+		m_scrollX = 0.0f;
+		m_firstColumn = 0;
+		m_lastColumn = 0;
+#endif
+	}
+
+	void
+	DataGrid::PositionSlider (size_t rows) {
+		ImU64 top = m_firstVisible;
+		const ImU64 first = 0;
+		const ImU64 last = rows - 1;
+		ImGui::PushItemWidth (-1.0f);
+		if (ImGui::SliderScalar ("##position", ImGuiDataType_U64, &top, &first, &last, "row %llu")) {
+			JumpToRow (static_cast<size_t> (top));
+		}
+		ImGui::PopItemWidth ();
+	}
+
+	void
+	DataGrid::DrawRows (const DataGridSource& source, size_t windowRows, size_t columns) {
+#if !defined(IMGUI_HAS_TABLE)
+		// Only the columns overlapping the viewport get laid out.
+		VisibleColumns (ImGui::GetScrollX (), ImGui::GetScrollX () + ImGui::GetWindowWidth (), columns);
+		const ImVec2 origin = ImGui::GetCursorScreenPos ();
+		const float spacing = ImGui::GetStyle ().ItemSpacing.x;
+#endif
+
+		char scratch [64];
+		ImGuiListClipper clipper;
+		clipper.Begin (static_cast<int> (windowRows));
+		while (clipper.Step ()) {
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+				const size_t row = m_windowBase + static_cast<size_t> (i);
+#if defined(IMGUI_HAS_TABLE)
+				ImGui::TableNextRow ();
+				for (size_t column = 0; column < columns; ++column) {
+					// False for columns scrolled out of view: skip formatting them.
+					if (!ImGui::TableSetColumnIndex (static_cast<int> (column))) continue;
+					ImGui::TextUnformatted (source.CellText (row, m_columnBase + column, scratch, sizeof (scratch)));
+				}
+#else
+				const float y = ImGui::GetCursorScreenPos ().y;
+				const float lineHeight = ImGui::GetTextLineHeight ();
+				for (size_t column = m_firstColumn; column < m_lastColumn; ++column) {
+					const ImVec2 cell (origin.x + m_columnX [column], y);
+					const float width = m_columnX [column + 1] - m_columnX [column] - spacing;
+					ImGui::PushClipRect (cell, ImVec2 (cell.x + width, y + lineHeight), true);
+					ImGui::SetCursorScreenPos (cell);
+					ImGui::TextUnformatted (source.CellText (row, column, scratch, sizeof (scratch)));
+					ImGui::PopClipRect ();
+				}
+				ImGui::SetCursorScreenPos (ImVec2 (origin.x, y));
+				ImGui::Dummy (ImVec2 (m_columnX.back (), lineHeight));
+#endif
+			}
+		}
+		if (clipper.ItemsHeight > 0.0f) {
+			m_rowHeight = clipper.ItemsHeight;
+		}
+		clipper.End ();
+
+		if (m_rowHeight > 0.0f) {
+			m_firstVisible = m_windowBase + static_cast<size_t> (ImGui::GetScrollY () / m_rowHeight);
+			m_visibleCount = static_cast<size_t> (ImGui::GetWindowHeight () / m_rowHeight);
+		}
+	}
+
+	bool
+	DataGrid::FinishScroll (size_t rows, size_t windowRows) {
+		// Runs inside the scrolling window after its rows are drawn. SetScrollY() lands on the
+		// next frame, so m_windowBase changes only here to take effect on that same frame.
+		if (m_rowHeight <= 0.0f || rows == 0) return false;
+
+		if (m_jumpPending) {
+			m_jumpPending = false;
+			const size_t target = std::min (m_jumpTarget, rows - 1);
+			const size_t maxBase = rows > kWindowRows ? rows - kWindowRows : 0;
+			m_windowBase = std::min (target > kWindowRows / 2 ? target - kWindowRows / 2 : 0, maxBase);
+			ImGui::SetScrollY (static_cast<float> (target - m_windowBase) * m_rowHeight);
+			return true;
+		}
+
+		const float scroll = ImGui::GetScrollY ();
+		const float maxScroll = ImGui::GetScrollMaxY ();
+		if (scroll > maxScroll * 0.75f && m_windowBase + windowRows < rows) {
+			const size_t shift = std::min (kShiftRows, rows - (m_windowBase + windowRows));
+			m_windowBase += shift;
+			ImGui::SetScrollY (scroll - static_cast<float> (shift) * m_rowHeight);
+			return true;
+		}
+		if (scroll < maxScroll * 0.25f && m_windowBase > 0) {
+			const size_t shift = std::min (kShiftRows, m_windowBase);
+			m_windowBase -= shift;
+			ImGui::SetScrollY (scroll + static_cast<float> (shift) * m_rowHeight);
+			return true;
+		}
+		return false;
+	}
+
+#if !defined(IMGUI_HAS_TABLE)
+	void
+	DataGrid::MeasureColumns (const DataGridSource& source) {
+		const size_t columns = source.ColumnCount ();
+		const size_t rows = std::min (source.RowCount (), kMeasureRows);
+		const float charWidth = ImGui::CalcTextSize ("M").x;
+		const float spacing = ImGui::GetStyle ().ItemSpacing.x;
+
+		char scratch [64];
+		m_columnX.assign (columns + 1, 0.0f);
+		for (size_t column = 0; column < columns; ++column) {
+			size_t chars = std::strlen (source.ColumnName (column));
+			for (size_t row = 0; row < rows; ++row) {
+				chars = std::max (chars, std::strlen (source.CellText (row, column, scratch, sizeof (scratch))));
+			}
+			chars = std::clamp (chars, kMinColumnChars, kMaxColumnChars);
+			m_columnX [column + 1] = m_columnX [column] + static_cast<float> (chars) * charWidth + spacing;
+		}
+		m_measuredRows = rows > 0;
+	}
+
+	void
+	DataGrid::DrawHeader (const DataGridSource& source) {
+		const ImVec2 origin = ImGui::GetCursorScreenPos ();
+		const float width = ImGui::GetContentRegionAvail ().x;
+		const float lineHeight = ImGui::GetTextLineHeight ();
+		const float spacing = ImGui::GetStyle ().ItemSpacing.x;
+		VisibleColumns (m_scrollX, m_scrollX + width, source.ColumnCount ());
+		for (size_t column = m_firstColumn; column < m_lastColumn; ++column) {
+			const float x = origin.x + m_columnX [column] - m_scrollX;
+			const float clipLeft = std::max (x, origin.x);
+			const float clipRight = std::min (x + m_columnX [column + 1] - m_columnX [column] - spacing, origin.x + width);
+			if (clipRight <= clipLeft) continue;
+			if (source.Sortable ()) {
+				ImGui::SetCursorScreenPos (ImVec2 (clipLeft, origin.y));
+				ImGui::PushID (static_cast<int> (column));
+				if (ImGui::InvisibleButton ("##sort", ImVec2 (clipRight - clipLeft, lineHeight))) {
+					CycleSort (column);
+				}
+				ImGui::PopID ();
+			}
+			ImGui::PushClipRect (ImVec2 (clipLeft, origin.y), ImVec2 (clipRight, origin.y + lineHeight), true);
+			ImGui::SetCursorScreenPos (ImVec2 (x, origin.y));
+			if (!m_sortSpecs.empty () && m_sortSpecs.front ().column == column) {
+				ImGui::Text ("%s %s", source.ColumnName (column), m_sortSpecs.front ().descending ? "v" : "^");
+			}
+			else {
+				ImGui::TextUnformatted (source.ColumnName (column));
+			}
+			const bool hovered = ImGui::IsWindowHovered () && ImGui::IsMouseHoveringRect (ImVec2 (clipLeft, origin.y), ImVec2 (clipRight, origin.y + lineHeight));
+			ImGui::PopClipRect ();
+			if (hovered) HeaderTooltip (source, column);
+		}
+		ImGui::SetCursorScreenPos (origin);
+		ImGui::Dummy (ImVec2 (width, lineHeight));
+	}
+
+	void
+	DataGrid::CycleSort (size_t column) {
+		if (m_sortSpecs.empty () || m_sortSpecs.front ().column != column) {
+			m_sortSpecs.assign (1, {column, false});
+		}
+		else if (!m_sortSpecs.front ().descending) {
+			m_sortSpecs.front ().descending = true;
+		}
+		else {
+			m_sortSpecs.clear ();
+		}
+		m_sortChanged = true;
+	}
+
+	void
+	DataGrid::VisibleColumns (float left, float right, size_t columns) {
+		const std::span<const float> edges = std::span (m_columnX).first (columns);
+		const auto first = std::ranges::upper_bound (edges, left) - edges.begin ();
+		m_firstColumn = first > 0 ? static_cast<size_t> (first - 1) : 0;
+		m_lastColumn = static_cast<size_t> (std::ranges::lower_bound (edges, right) - edges.begin ());
+	}
+#endif
+
+}  // namespace ambidb::ui
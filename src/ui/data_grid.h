@@ -0,0 +1,160 @@
+#pragma once
+
+#include "imgui.h"
+#include "tables.h"
+
+#include <macro.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace ambidb::ui {
+
+	/**
+	 * @brief Cell provider for DataGrid. Only called for cells that are on screen.
+	 */
+	class DataGridSource {
+	public:
+		MAKE_NONCOPYABLE (DataGridSource);
+		MAKE_NONMOVABLE (DataGridSource);
+		DataGridSource () = default;
+		virtual ~DataGridSource () = default;
+
+		virtual size_t
+		RowCount () const = 0;
+
+		virtual size_t
+		ColumnCount () const = 0;
+
+		virtual const char*
+		ColumnName (size_t column) const = 0;
+
+		/**
+		 * @brief Text for one cell; may point into @p scratch or into the source's own storage.
+		 */
+		virtual const char*
+		CellText (size_t row, size_t column, char* scratch, size_t scratchSize) const = 0;
+
+		/// Whether header clicks may ask for a new order (see DataGrid::TakeSortSpecs ()).
+		virtual bool
+		Sortable () const {
+			return false;
+		}
+
+		/// Whether hovering the header of @p column shows a tooltip.
+		virtual bool
+		HasColumnTooltip (size_t /*column*/) const {
+			return false;
+		}
+
+		/// Body of that tooltip; the grid opens and closes it.
+		virtual void
+		ColumnTooltip (size_t /*column*/) const {}
+	};
+
+	/**
+	 * @brief Scrollable result grid whose cost per frame depends on the viewport, not the
+	 * row count.
+	 *
+	 * Rows go through ImGuiListClipper; columns scrolled out horizontally are skipped
+	 * without formatting their cells. ImGui positions are floats, which stop resolving
+	 * single rows somewhere past a million rows, so the clipper only ever sees a window of
+	 * kWindowRows starting at a base row. The window slides as the scroll position nears
+	 * either end, and a position slider covers the whole result. Appended rows never move
+	 * the view.
+	 *
+	 * With IMGUI_HAS_TABLE the grid is an ImGui table with a frozen header; otherwise it
+	 * lays out fixed-width columns itself in a child window.
+	 *
+	 * The grid does not reorder rows. For a Sortable () source, header clicks update the
+	 * sort order, which the caller collects with TakeSortSpecs () and applies in its source.
+	 * The fallback header sorts by one column: each click cycles ascending, descending, off.
+	 * Hovering a header shows the source's ColumnTooltip (), if it has one.
+	 */
+	class DataGrid {
+	public:
+		static constexpr size_t kWindowRows = 64 * 1024;
+
+		MAKE_NONCOPYABLE (DataGrid);
+		MAKE_NONMOVABLE (DataGrid);
+		DataGrid () = default;
+		~DataGrid () = default;
+
+		/**
+		 * @brief Draw the grid filling @p size (0 = remaining space, negative = leave room).
+		 * @return true if the grid moved its scroll window and needs one more frame to settle.
+		 */
+		bool
+		Draw (const char* id, const DataGridSource& source, const ImVec2& size = ImVec2 (0.0f, 0.0f));
+
+		/**
+		 * @brief Scroll so that @p row is at the top on the next frame. O(1) in the row count.
+		 */
+		void
+		JumpToRow (size_t row);
+
+		/**
+		 * @brief Forget scroll position and column layout, e.g. for a new result.
+		 */
+		void
+		Reset ();
+
+		/**
+		 * @brief If a header click changed the sort order, store it in @p specs (result
+		 * columns, most significant first; empty = unsorted) and return true.
+		 */
+		bool
+		TakeSortSpecs (std::vector<SortSpec>& specs);
+
+		/// First row on screen as of the last Draw().
+		size_t
+		FirstVisibleRow () const {
+			return m_firstVisible;
+		}
+
+		/// Number of rows that fit on screen as of the last Draw().
+		size_t
+		VisibleRowCount () const {
+			return m_visibleCount;
+		}
+
+	private:
+		void
+		PositionSlider (size_t rows);
+		void
+		DrawRows (const DataGridSource& source, size_t windowRows, size_t columns);
+		bool
+		FinishScroll (size_t rows, size_t windowRows);
+#if !defined(IMGUI_HAS_TABLE)
+		void
+		MeasureColumns (const DataGridSource& source);
+		void
+		DrawHeader (const DataGridSource& source);
+		void
+		CycleSort (size_t column);
+		void
+		VisibleColumns (float left, float right, size_t columns);
+#endif
+
+		size_t m_windowBase{0};	 ///< Result row of clipper item 0.
+		size_t m_jumpTarget{0};
+		bool m_jumpPending{false};
+		float m_rowHeight{0.0f};
+		size_t m_firstVisible{0};
+		size_t m_visibleCount{0};
+		int m_generation{0};  ///< Bumped by Reset() so ImGui forgets per-table state.
+		std::vector<SortSpec> m_sortSpecs;
+		bool m_sortChanged{false};
+
+#if defined(IMGUI_HAS_TABLE)
+		size_t m_columnBase{0};	 ///< First column shown when there are more than a table holds.
+#else
+		std::vector<float> m_columnX;  ///< Left edge of each column, plus the total width.
+		bool m_measuredRows{false};
+		float m_scrollX{0.0f};
+		size_t m_firstColumn{0};  ///< Visible column range [first, last) as of the last layout.
+		size_t m_lastColumn{0};
+#endif
+	};
+
+}  // namespace ambidb::ui
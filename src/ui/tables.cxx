@@ -1,5 +1,6 @@
 #include "tables.h"
 
+#include <span>
 #include <vector>
 
 namespace ambidb::ui {
@@ -79,4 +80,22 @@ namespace ambidb::ui {
 		ImGui::TextUnformatted (text);
 	}
 
+	bool
+	TakeSortSpecs (std::vector<SortSpec>& specs) {
+#if defined(IMGUI_HAS_TABLE)
+		ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs ();
+		if (!sortSpecs || !sortSpecs->SpecsDirty) return false;
+		specs.assign (static_cast<size_t> (sortSpecs->SpecsCount), {});
+		for (const ImGuiTableColumnSortSpecs& spec : std::span (sortSpecs->Specs, specs.size ())) {
+			specs [static_cast<size_t> (spec.SortOrder)] = {static_cast<size_t> (spec.ColumnIndex),
+															spec.SortDirection == ImGuiSortDirection_Descending};
+		}
+		sortSpecs->SpecsDirty = false;
+		return true;
+#else
+		(void) specs;
+		return false;
+#endif
+	}
+
 }  // namespace ambidb::ui
@@ -2,6 +2,8 @@
 
 #include "imgui.h"
 
+#include <vector>
+
 namespace ambidb::ui {
 
 #if defined(IMGUI_HAS_TABLE)
@@ -9,13 +11,23 @@ namespace ambidb::ui {
 	using TableColumnFlags = ImGuiTableColumnFlags;
 	inline constexpr TableFlags kDefaultTableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
 	inline constexpr TableColumnFlags kNoTableColumnFlags = ImGuiTableColumnFlags_None;
+	/// Header clicks sort, Shift+click adds a column, a third click returns to unsorted.
+	inline constexpr TableFlags kSortableTableFlags = ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti |
+													  ImGuiTableFlags_SortTristate;
 #else
 	using TableFlags = int;
 	using TableColumnFlags = int;
 	inline constexpr TableFlags kDefaultTableFlags = 0;
 	inline constexpr TableColumnFlags kNoTableColumnFlags = 0;
+	inline constexpr TableFlags kSortableTableFlags = 0;
 #endif
 
+	/// One column of a table's sort order.
+	struct SortSpec {
+		size_t column{0};
+		bool descending{false};
+	};
+
 	struct TableConfig {
 		TableFlags flags{kDefaultTableFlags};
 		ImVec2 outerSize{0.0f, 0.0f};
@@ -46,4 +58,12 @@ namespace ambidb::ui {
 	void
 	CellText (const char* text);
 
+	/**
+	 * @brief If the user changed the current table's sort order since the last call, store
+	 * it in @p specs, most significant column first, and return true. Call after the columns
+	 * are set up. Always false without IMGUI_HAS_TABLE.
+	 */
+	bool
+	TakeSortSpecs (std::vector<SortSpec>& specs);
+
 }  // namespace ambidb::ui
@@ -0,0 +1,485 @@
+#include "text_editor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <ranges>
+
+namespace ambidb::ui {
+
+	namespace {
+
+		bool
+		IsContinuation (char c) {
+			return (static_cast<unsigned char> (c) & 0xC0) == 0x80;
+		}
+
+		bool
+		IsWordChar (char c) {
+			return std::isalnum (static_cast<unsigned char> (c)) || c == '_' || (static_cast<unsigned char> (c) & 0x80);
+		}
+
+		void
+		AppendUtf8 (std::string& out, unsigned code) {
+			if (code < 0x80) {
+				out += static_cast<char> (code);
+			}
+			else if (code < 0x800) {
+				out += static_cast<char> (0xC0 | (code >> 6));
+				out += static_cast<char> (0x80 | (code & 0x3F));
+			}
+			else if (code < 0x10000) {
+				out += static_cast<char> (0xE0 | (code >> 12));
+				out += static_cast<char> (0x80 | ((code >> 6) & 0x3F));
+				out += static_cast<char> (0x80 | (code & 0x3F));
+			}
+			else {
+				out += static_cast<char> (0xF0 | (code >> 18));
+				out += static_cast<char> (0x80 | ((code >> 12) & 0x3F));
+				out += static_cast<char> (0x80 | ((code >> 6) & 0x3F));
+				out += static_cast<char> (0x80 | (code & 0x3F));
+			}
+		}
+
+		/// CalcTextSize ().x of @p text; empty text may have no data, which CalcTextSize reads as a C string.
+		float
+		Width (std::string_view text) {
+			return text.empty () ? 0.0f : ImGui::CalcTextSize (text.data (), text.data () + text.size ()).x;
+		}
+
+		/// Bytes of the UTF-8 sequence starting with @p lead; 1 for a stray continuation byte.
+		size_t
+		Utf8Length (char lead) {
+			const auto byte = static_cast<unsigned char> (lead);
+			if (byte < 0xC0) return 1;
+			if (byte < 0xE0) return 2;
+			return byte < 0xF0 ? 3 : 4;
+		}
+
+	}  // namespace
+
+	void
+	AppendTyped (std::string& out, const ImVector<ImWchar>& queue) {
+		for (const ImWchar c : queue) {
+			if (c >= 0x20 && c != 0x7F) AppendUtf8 (out, c);
+		}
+	}
+
+	void
+	TextEditor::SetColors (TextEditorColors* colors) {
+		m_colors = colors;
+		if (m_colors) m_colors->Edited (0, 0, m_text.LineCount () - 1);
+	}
+
+	bool
+	TextEditor::Draw (const char* id, const ImVec2& size) {
+		m_changed = false;
+		m_typed = '\0';
+		const ImGuiStyle& style = ImGui::GetStyle ();
+
+		if (m_focusRequested) {
+			m_focusRequested = false;
+			ImGui::SetNextWindowFocus ();
+		}
+		// Navigation keeps off the arrows and Tab, which edit here.
+		ImGui::PushStyleColor (ImGuiCol_ChildBg, style.Colors [ImGuiCol_FrameBg]);
+		ImGui::PushStyleVar (ImGuiStyleVar_WindowPadding, style.FramePadding);
+		const bool open = ImGui::BeginChild (id, size, false, ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_NoNavInputs);
+		ImGui::PopStyleVar ();
+		ImGui::PopStyleColor ();
+		if (open) {
+			m_lineHeight = ImGui::GetTextLineHeight ();
+			if (ImGui::GetFont () != m_measuredFont || ImGui::GetFontSize () != m_measuredSize) {
+				m_measuredFont = ImGui::GetFont ();
+				m_measuredSize = ImGui::GetFontSize ();
+				for (size_t c = 0; c < m_asciiWidths.size (); ++c) {
+					const char byte = static_cast<char> (c);
+					m_asciiWidths [c] = Width (std::string_view (&byte, 1));
+				}
+				for (LineAdvances& advances : m_advances) advances.line = ~u32{0};
+			}
+			const ImVec2 view = ImGui::GetContentRegionAvail ();
+			const ImVec2 origin = ImGui::GetCursorScreenPos ();
+			m_focused = ImGui::IsWindowFocused ();
+			if (m_focused) HandleKeys ();
+
+			// One item the size of the text takes the mouse and sets the scroll range.
+			const float height = static_cast<float> (m_text.LineCount ()) * m_lineHeight;
+			const ImVec2 content (std::max (view.x, m_width + ImGui::CalcTextSize ("M").x), std::max (view.y, height));
+			ImGui::InvisibleButton ("##text", ImVec2 (std::max (content.x, 1.0f), std::max (content.y, 1.0f)));
+			HandleMouse (origin);
+
+			DrawLines (origin, view);
+			if (m_follow) FollowCursor (view);
+		}
+		else {
+			m_focused = false;
+		}
+		ImGui::EndChild ();
+		return m_changed;
+	}
+
+	void
+	TextEditor::Load (std::string text) {
+		const u32 lines = m_text.LineCount ();
+		m_text.Assign (std::move (text));
+		if (m_colors) m_colors->Edited (0, lines - 1, m_text.LineCount () - 1);
+		Remeasure (0, lines - 1, m_text.LineCount () - 1);
+		m_undo.clear ();
+		m_redo.clear ();
+		m_merge = false;
+		SetCursor (0);
+	}
+
+	void
+	TextEditor::Replace (size_t from, size_t to, std::string_view text) {
+		Edit (from, to, text, false);
+	}
+
+	void
+	TextEditor::SetCursor (size_t offset) {
+		m_cursor = m_anchor = std::min (offset, m_text.Size ());
+		m_wantX = -1.0f;
+		m_merge = false;
+		m_follow = true;
+	}
+
+	void
+	TextEditor::Edit (size_t from, size_t to, std::string_view text, bool typing) {
+		to = std::min (to, m_text.Size ());
+		from = std::min (from, to);
+		if (from == to && text.empty ()) return;
+
+		const u32 first = m_text.LineOf (from);
+		const u32 removed = m_text.LineOf (to) - first;
+		const u32 below = m_text.LineCount () - 1 - first - removed;
+		if (!typing || !m_merge || m_undo.empty ()) {
+			if (m_undo.size () == kUndoSteps) m_undo.pop_front ();
+			m_undo.push_back ({m_text.Save (), m_cursor, m_anchor, first, below});
+		}
+		else {
+			m_undo.back ().first = std::min (m_undo.back ().first, first);
+			m_undo.back ().below = std::min (m_undo.back ().below, below);
+		}
+		m_redo.clear ();
+
+		m_text.Erase (from, to);
+		m_text.Insert (from, text);
+		const u32 inserted = static_cast<u32> (std::ranges::count (text, '\n'));
+		if (m_colors) m_colors->Edited (first, removed, inserted);
+		Remeasure (first, removed, inserted);
+
+		m_cursor = m_anchor = from + text.size ();
+		m_wantX = -1.0f;
+		m_merge = typing;
+		m_changed = true;
+		m_follow = true;
+		m_typed = typing && !text.empty () ? text.back () : '\0';
+	}
+
+	void
+	TextEditor::Step (std::deque<UndoStep>& from, std::deque<UndoStep>& to) {
+		if (from.empty ()) return;
+		UndoStep step = std::move (from.back ());
+		from.pop_back ();
+		to.push_back ({m_text.Save (), m_cursor, m_anchor, step.first, step.below});
+
+		const u32 lines = m_text.LineCount ();
+		m_text.Restore (step.text);
+		const u32 removed = lines - 1 - step.below - step.first;
+		const u32 inserted = m_text.LineCount () - 1 - step.below - step.first;
+		if (m_colors) m_colors->Edited (step.first, removed, inserted);
+		Remeasure (step.first, removed, inserted);
+
+		m_cursor = std::min (step.cursor, m_text.Size ());
+		m_anchor = std::min (step.anchor, m_text.Size ());
+		m_wantX = -1.0f;
+		m_merge = false;
+		m_changed = true;
+		m_follow = true;
+	}
+
+	void
+	TextEditor::HandleKeys () {
+		const ImGuiIO& io = ImGui::GetIO ();
+		const bool shift = io.KeyShift;
+		const bool ctrl = io.ConfigMacOSXBehaviors ? io.KeySuper : io.KeyCtrl;
+		const auto [selFrom, selTo] = Selection ();
+		const bool selected = selFrom != selTo;
+
+		if (ImGui::IsKeyPressed (ImGuiKey_LeftArrow)) {
+			Move (ctrl ? WordStart (m_cursor) : (selected && !shift ? selFrom : PrevChar (m_cursor)), shift);
+		}
+		if (ImGui::IsKeyPressed (ImGuiKey_RightArrow)) {
+			Move (ctrl ? WordEnd (m_cursor) : (selected && !shift ? selTo : NextChar (m_cursor)), shift);
+		}
+		const int page = std::max (1, static_cast<int> (ImGui::GetWindowHeight () / m_lineHeight) - 1);
+		if (ImGui::IsKeyPressed (ImGuiKey_UpArrow)) MoveLines (-1, shift);
+		if (ImGui::IsKeyPressed (ImGuiKey_DownArrow)) MoveLines (1, shift);
+		if (ImGui::IsKeyPressed (ImGuiKey_PageUp)) MoveLines (-page, shift);
+		if (ImGui::IsKeyPressed (ImGuiKey_PageDown)) MoveLines (page, shift);
+		if (ImGui::IsKeyPressed (ImGuiKey_Home)) Move (ctrl ? 0 : m_text.LineStart (m_text.LineOf (m_cursor)), shift);
+		if (ImGui::IsKeyPressed (ImGuiKey_End)) Move (ctrl ? m_text.Size () : m_text.LineEnd (m_text.LineOf (m_cursor)), shift);
+
+		if (ctrl && ImGui::IsKeyPressed (ImGuiKey_A, false)) {
+			m_anchor = 0;
+			m_cursor = m_text.Size ();
+			m_merge = false;
+		}
+		if (ctrl && (ImGui::IsKeyPressed (ImGuiKey_C, false) || ImGui::IsKeyPressed (ImGuiKey_X, false)) && selected) {
+			ImGui::SetClipboardText (std::string (m_text.Text (selFrom, selTo, m_scratch)).c_str ());
+			if (ImGui::IsKeyPressed (ImGuiKey_X, false)) Edit (selFrom, selTo, {}, false);
+		}
+		if (ctrl && ImGui::IsKeyPressed (ImGuiKey_V)) {
+			if (const char* clipboard = ImGui::GetClipboardText ()) Edit (selFrom, selTo, clipboard, false);
+		}
+		if (ctrl && ImGui::IsKeyPressed (ImGuiKey_Z)) {
+			if (shift) {
+				Step (m_redo, m_undo);
+			}
+			else {
+				Step (m_undo, m_redo);
+			}
+		}
+		if (ctrl && ImGui::IsKeyPressed (ImGuiKey_Y)) Step (m_redo, m_undo);
+
+		if (ImGui::IsKeyPressed (ImGuiKey_Backspace)) {
+			const auto [from, to] = Selection ();
+			Edit (from != to ? from : (ctrl ? WordStart (m_cursor) : PrevChar (m_cursor)), to, {}, false);
+		}
+		if (ImGui::IsKeyPressed (ImGuiKey_Delete)) {
+			const auto [from, to] = Selection ();
+			Edit (from, from != to ? to : (ctrl ? WordEnd (m_cursor) : NextChar (m_cursor)), {}, false);
+		}
+
+		// Characters typed with Ctrl are shortcuts; Ctrl+Alt is AltGr on some layouts.
+		std::string typed;
+		if (!ctrl || io.KeyAlt) AppendTyped (typed, io.InputQueueCharacters);
+		if (ImGui::IsKeyPressed (ImGuiKey_Enter) || ImGui::IsKeyPressed (ImGuiKey_KeypadEnter)) typed += '\n';
+		if (ImGui::IsKeyPressed (ImGuiKey_Tab) && !ctrl) typed += '\t';
+		if (!typed.empty ()) {
+			const auto [from, to] = Selection ();
+			// A new line or replaced selection starts its own undo step.
+			Edit (from, to, typed, from == to && typed.find ('\n') == std::string::npos);
+		}
+	}
+
+	void
+	TextEditor::HandleMouse (const ImVec2& origin) {
+		if (ImGui::IsItemHovered ()) ImGui::SetMouseCursor (ImGuiMouseCursor_TextInput);
+		const bool doubleClicked = ImGui::IsItemHovered () && ImGui::IsMouseDoubleClicked (ImGuiMouseButton_Left);
+		const bool pressed = ImGui::IsItemActivated ();
+		const bool dragged = ImGui::IsItemActive () && ImGui::IsMouseDragging (ImGuiMouseButton_Left);
+		if (!doubleClicked && !pressed && !dragged) return;
+
+		const ImVec2 mouse = ImGui::GetMousePos ();
+		const float row = std::max (0.0f, (mouse.y - origin.y) / m_lineHeight);
+		const u32 line = std::min (static_cast<u32> (row), m_text.LineCount () - 1);
+		const size_t offset = OffsetAt (line, mouse.x - origin.x);
+		if (doubleClicked) {
+			m_anchor = WordStart (NextChar (offset));
+			m_cursor = WordEnd (m_anchor);
+			m_merge = false;
+			return;
+		}
+		Move (offset, dragged || ImGui::GetIO ().KeyShift);
+	}
+
+	void
+	TextEditor::DrawLines (const ImVec2& origin, const ImVec2& view) {
+		ImDrawList* drawList = ImGui::GetWindowDrawList ();
+		const float left = drawList->GetClipRectMin ().x;
+		const float right = drawList->GetClipRectMax ().x;
+		const ImU32 textColor = ImGui::GetColorU32 (ImGuiCol_Text);
+		const ImU32 selectionColor = ImGui::GetColorU32 (ImGuiCol_TextSelectedBg);
+		const float space = ImGui::CalcTextSize (" ").x;
+		const auto [selFrom, selTo] = Selection ();
+
+		const float top = ImGui::GetScrollY ();
+		const u32 lines = m_text.LineCount ();
+		const u32 first = std::min (static_cast<u32> (top / m_lineHeight), lines - 1);
+		const u32 last = std::min (lines, static_cast<u32> ((top + view.y + ImGui::GetStyle ().FramePadding.y * 2.0f) / m_lineHeight) + 1);
+		for (u32 line = first; line < last; ++line) {
+			const LineAdvances& advances = Advances (line);
+			const size_t start = m_text.LineStart (line);
+			const size_t size = advances.offsets.back ();
+			const float y = origin.y + static_cast<float> (line) * m_lineHeight;
+			const auto xOf = [&] (size_t offset) { return origin.x + advances.x [advances.Index (offset)]; };
+
+			// Only the characters between the clip edges are fetched, colored and drawn.
+			const size_t chars = advances.offsets.size () - 1;
+			const size_t firstChar = std::max<size_t> (std::ranges::lower_bound (advances.x, left - origin.x) - advances.x.begin (), 1) - 1;
+			const size_t endChar = std::min<size_t> (std::ranges::upper_bound (advances.x, right - origin.x) - advances.x.begin (), chars);
+			const size_t begin = advances.offsets [firstChar];
+			const size_t end = advances.offsets [std::max (firstChar, endChar)];
+			const std::string_view text = m_text.Text (start + begin, start + end, m_scratch);
+
+			// The selection, with a space's width for a selected newline.
+			if (selFrom <= start + size && selTo > start) {
+				const float x0 = xOf (std::max (selFrom, start) - start);
+				const float x1 = xOf (std::min (selTo, start + size) - start) + (selTo > start + size ? space : 0.0f);
+				drawList->AddRectFilled (ImVec2 (x0, y), ImVec2 (x1, y + m_lineHeight), selectionColor);
+			}
+
+			// Runs in their colors, the gaps in the text color.
+			m_runs.clear ();
+			if (m_colors && begin < end) m_colors->Colors (m_text, line, static_cast<u32> (begin), static_cast<u32> (end), m_runs);
+			size_t at = begin;
+			const auto draw = [&] (size_t from, size_t to, ImU32 color) {
+				from = std::max (from, begin);
+				to = std::min (to, end);
+				if (from < to) drawList->AddText (ImVec2 (xOf (from), y), color, text.data () + (from - begin), text.data () + (to - begin));
+			};
+			for (const TextColor& run : m_runs) {
+				const size_t runBegin = std::min<size_t> (run.begin, size);
+				draw (at, runBegin, textColor);
+				at = std::min<size_t> (runBegin + run.length, size);
+				draw (runBegin, at, run.color);
+			}
+			draw (at, end, textColor);
+			m_width = std::max (m_width, advances.x.back ());
+		}
+
+		const u32 line = m_text.LineOf (m_cursor);
+		const ImVec2 caret (origin.x + Column (line, m_cursor), origin.y + static_cast<float> (line) * m_lineHeight);
+		m_cursorScreenPos = ImVec2 (caret.x, caret.y + m_lineHeight);
+		if (m_focused) drawList->AddRectFilled (caret, ImVec2 (caret.x + 1.0f, caret.y + m_lineHeight), textColor);
+	}
+
+	void
+	TextEditor::FollowCursor (const ImVec2& view) {
+		m_follow = false;
+		const u32 line = m_text.LineOf (m_cursor);
+		const float x = Column (line, m_cursor);
+		const float y = static_cast<float> (line) * m_lineHeight;
+		const float margin = ImGui::CalcTextSize ("MMMM").x;
+		if (y < ImGui::GetScrollY ()) {
+			ImGui::SetScrollY (y);
+		}
+		else if (y + m_lineHeight > ImGui::GetScrollY () + view.y) {
+			ImGui::SetScrollY (y + m_lineHeight - view.y);
+		}
+		if (x < ImGui::GetScrollX ()) {
+			ImGui::SetScrollX (std::max (0.0f, x - margin));
+		}
+		else if (x > ImGui::GetScrollX () + view.x) {
+			// The content may not be this wide yet.
+			m_width = std::max (m_width, x + margin);
+			ImGui::SetScrollX (x + margin - view.x);
+		}
+	}
+
+	void
+	TextEditor::Move (size_t offset, bool select) {
+		m_cursor = std::min (offset, m_text.Size ());
+		if (!select) m_anchor = m_cursor;
+		m_wantX = -1.0f;
+		m_merge = false;
+		m_follow = true;
+	}
+
+	void
+	TextEditor::MoveLines (int delta, bool select) {
+		const u32 line = m_text.LineOf (m_cursor);
+		const float wantX = m_wantX >= 0.0f ? m_wantX : Column (line, m_cursor);
+		const i64 target = static_cast<i64> (line) + delta;
+		if (target < 0) {
+			Move (0, select);
+		}
+		else if (target >= static_cast<i64> (m_text.LineCount ())) {
+			Move (m_text.Size (), select);
+		}
+		else {
+			Move (OffsetAt (static_cast<u32> (target), wantX), select);
+		}
+		m_wantX = wantX;
+	}
+
+	std::pair<size_t, size_t>
+	TextEditor::Selection () const {
+		return {std::min (m_cursor, m_anchor), std::max (m_cursor, m_anchor)};
+	}
+
+	float
+	TextEditor::Column (u32 line, size_t offset) {
+		const LineAdvances& advances = Advances (line);
+		return advances.x [advances.Index (offset - m_text.LineStart (line))];
+	}
+
+	size_t
+	TextEditor::OffsetAt (u32 line, float x) {
+		const LineAdvances& advances = Advances (line);
+		// The first character whose middle is right of x.
+		const auto chars = std::views::iota (size_t{0}, advances.offsets.size () - 1);
+		const auto it = std::ranges::partition_point (chars, [&] (size_t i) { return (advances.x [i] + advances.x [i + 1]) * 0.5f <= x; });
+		return m_text.LineStart (line) + (it == chars.end () ? advances.offsets.back () : advances.offsets [*it]);
+	}
+
+	size_t
+	TextEditor::LineAdvances::Index (size_t offset) const {
+		const size_t index = static_cast<size_t> (std::ranges::lower_bound (offsets, offset) - offsets.begin ());
+		return std::min (index, offsets.size () - 1);
+	}
+
+	const TextEditor::LineAdvances&
+	TextEditor::Advances (u32 line) {
+		LineAdvances& advances = m_advances [line % kAdvanceLines];
+		if (advances.line == line) return advances;
+		advances.line = line;
+		advances.offsets.clear ();
+		advances.x.clear ();
+		const std::string_view text = m_text.Line (line, m_measureScratch);
+		float x = 0.0f;
+		for (size_t at = 0; at < text.size ();) {
+			const size_t next = std::min (text.size (), at + Utf8Length (text [at]));
+			advances.offsets.push_back (static_cast<u32> (at));
+			advances.x.push_back (x);
+			const auto byte = static_cast<unsigned char> (text [at]);
+			x += byte < m_asciiWidths.size () ? m_asciiWidths [byte] : Width (text.substr (at, next - at));
+			at = next;
+		}
+		advances.offsets.push_back (static_cast<u32> (text.size ()));
+		advances.x.push_back (x);
+		return advances;
+	}
+
+	void
+	TextEditor::Remeasure (u32 line, u32 removed, u32 inserted) {
+		// Lines below keep their numbers only if the edit kept the line count.
+		const u32 last = removed == inserted ? line + removed : ~u32{0};
+		for (LineAdvances& advances : m_advances) {
+			if (advances.line >= line && advances.line <= last) advances.line = ~u32{0};
+		}
+	}
+
+	size_t
+	TextEditor::PrevChar (size_t offset) const {
+		if (offset == 0) return 0;
+		--offset;
+		while (offset > 0 && IsContinuation (m_text.At (offset))) --offset;
+		return offset;
+	}
+
+	size_t
+	TextEditor::NextChar (size_t offset) const {
+		if (offset >= m_text.Size ()) return m_text.Size ();
+		++offset;
+		while (offset < m_text.Size () && IsContinuation (m_text.At (offset))) ++offset;
+		return offset;
+	}
+
+	size_t
+	TextEditor::WordStart (size_t offset) const {
+		while (offset > 0 && !IsWordChar (m_text.At (offset - 1))) --offset;
+		while (offset > 0 && IsWordChar (m_text.At (offset - 1))) --offset;
+		return offset;
+	}
+
+	size_t
+	TextEditor::WordEnd (size_t offset) const {
+		const size_t size = m_text.Size ();
+		while (offset < size && !IsWordChar (m_text.At (offset))) ++offset;
+		while (offset < size && IsWordChar (m_text.At (offset))) ++offset;
+		return offset;
+	}
+
+}  // namespace ambidb::ui
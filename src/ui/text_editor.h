@@ -0,0 +1,236 @@
+#pragma once
+
+#include "imgui.h"
+#include "text_buffer.h"
+
+#include <macro.h>
+
+#include <array>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ambidb::ui {
+
+	/// Bytes [begin, begin + length) of a line, drawn in color.
+	struct TextColor {
+		u32 begin{0};
+		u32 length{0};
+		ImU32 color{0};
+	};
+
+	/// Append the characters of @p queue (ImGuiIO::InputQueueCharacters) that type text to
+	/// @p out as UTF-8; control characters and DEL are dropped.
+	void
+	AppendTyped (std::string& out, const ImVector<ImWchar>& queue);
+
+	/**
+	 * @brief Coloring for TextEditor. Told about every edit, so it can keep per-line state
+	 * and redo only what an edit touched.
+	 */
+	class TextEditorColors {
+	public:
+		MAKE_NONCOPYABLE (TextEditorColors);
+		MAKE_NONMOVABLE (TextEditorColors);
+		TextEditorColors () = default;
+		virtual ~TextEditorColors () = default;
+
+		/// Lines [@p line, @p line + @p removed] became lines [@p line, @p line + @p inserted].
+		virtual void
+		Edited (u32 line, u32 removed, u32 inserted) = 0;
+
+		/// Colored runs of @p line that overlap its bytes [@p from, @p to), in order; bytes
+		/// outside them use the text color. Only called for lines on screen.
+		virtual void
+		Colors (const TextBuffer& text, u32 line, u32 from, u32 to, std::vector<TextColor>& out) = 0;
+	};
+
+	/**
+	 * @brief Multi-line text editor over a TextBuffer whose cost per frame depends on the
+	 * viewport, not the text size.
+	 *
+	 * The editor is a child window whose content is as tall as all lines; only the lines
+	 * in view are fetched from the buffer, colored and drawn, and of those only the bytes
+	 * between the left and right edges. The content width grows to the widest line drawn
+	 * so far.
+	 *
+	 * Where each character of a line starts is measured once and kept for the lines on
+	 * screen and the cursor's, until an edit reaches the line. Placing the caret, hit
+	 * testing the mouse and clipping a line are then binary searches, so a frame costs the
+	 * same on a megabyte-long INSERT as on a short line.
+	 *
+	 * Edits go straight to the buffer as inserts and erases, so a keystroke never copies
+	 * the text, and each undo step is a TextBuffer::Snapshot. Typing without moving the
+	 * cursor collects into one step. Undo and redo tell the colors only the lines between
+	 * the step's first edit and the lines below it that no edit reached.
+	 *
+	 * Keys: arrows (Ctrl: by word), Home/End (Ctrl: text), Page Up/Down, Shift to select,
+	 * Ctrl+A/C/X/V, Ctrl+Z and Ctrl+Y or Ctrl+Shift+Z. The mouse places the cursor, drags a
+	 * selection and double-clicks a word.
+	 */
+	class TextEditor {
+	public:
+		static constexpr size_t kUndoSteps = 1000;
+
+		MAKE_NONCOPYABLE (TextEditor);
+		MAKE_NONMOVABLE (TextEditor);
+		TextEditor () = default;
+		~TextEditor () = default;
+
+		/// Colors for the text from now on (null: none); must outlive the editor's use of it.
+		void
+		SetColors (TextEditorColors* colors);
+
+		/**
+		 * @brief Draw the editor filling @p size (0 = remaining space, negative = leave room)
+		 * and handle its input.
+		 * @return true if the text changed.
+		 */
+		bool
+		Draw (const char* id, const ImVec2& size = ImVec2 (0.0f, 0.0f));
+
+		const TextBuffer&
+		Text () const {
+			return m_text;
+		}
+
+		/// Replace everything without an undo step, e.g. for the initial text.
+		void
+		Load (std::string text);
+
+		/// Replace bytes [@p from, @p to) with @p text as one undo step; the cursor ends after it.
+		void
+		Replace (size_t from, size_t to, std::string_view text);
+
+		/// Replace everything as one undo step.
+		void
+		SetText (std::string_view text) {
+			Replace (0, m_text.Size (), text);
+		}
+
+		size_t
+		Cursor () const {
+			return m_cursor;
+		}
+
+		/// Move the cursor, dropping the selection.
+		void
+		SetCursor (size_t offset);
+
+		/// Last character typed during the last Draw (); '\0' if it typed none.
+		char
+		Typed () const {
+			return m_typed;
+		}
+
+		/// Whether the editor had the keyboard during the last Draw ().
+		bool
+		Focused () const {
+			return m_focused;
+		}
+
+		/// Take the keyboard on the next Draw ().
+		void
+		Focus () {
+			m_focusRequested = true;
+		}
+
+		/// Screen position just below the cursor as of the last Draw (), e.g. for a popup.
+		ImVec2
+		CursorScreenPos () const {
+			return m_cursorScreenPos;
+		}
+
+	private:
+		struct UndoStep {
+			TextBuffer::Snapshot text;	///< Before the step.
+			size_t cursor{0};
+			size_t anchor{0};
+			u32 first{0};  ///< First line the step's edits touched.
+			u32 below{0};  ///< Lines at the end that no edit of the step reached.
+		};
+
+		/// Where the characters of one line start, in bytes and in pixels.
+		struct LineAdvances {
+			u32 line{~u32{0}};
+			std::vector<u32> offsets;  ///< Byte offset of each character, then the line's size.
+			std::vector<float> x;	   ///< Left edge of each, then the line's width.
+
+			/// Index of the character at byte @p offset, or of the one after it.
+			size_t
+			Index (size_t offset) const;
+		};
+
+		static constexpr size_t kAdvanceLines = 256;  ///< Direct-mapped by line; a screenful or two.
+
+		void
+		Edit (size_t from, size_t to, std::string_view text, bool typing);
+		/// Pop a step from @p from, restoring its text, and push the current text to @p to.
+		void
+		Step (std::deque<UndoStep>& from, std::deque<UndoStep>& to);
+		void
+		HandleKeys ();
+		void
+		HandleMouse (const ImVec2& origin);
+		void
+		DrawLines (const ImVec2& origin, const ImVec2& view);
+		void
+		FollowCursor (const ImVec2& view);
+
+		void
+		Move (size_t offset, bool select);
+		void
+		MoveLines (int delta, bool select);
+		/// Text between the cursor and the anchor, as [first, second).
+		std::pair<size_t, size_t>
+		Selection () const;
+		/// Width of line @p line's bytes up to @p offset.
+		float
+		Column (u32 line, size_t offset);
+		/// Offset in @p line closest to @p x.
+		size_t
+		OffsetAt (u32 line, float x);
+		/// Left edge of every character of @p line, measured on first use.
+		const LineAdvances&
+		Advances (u32 line);
+		/// Lines [@p line, @p line + @p removed] became lines [@p line, @p line + @p inserted];
+		/// forget what was measured of them, and of every line below if lines moved.
+		void
+		Remeasure (u32 line, u32 removed, u32 inserted);
+		size_t
+		PrevChar (size_t offset) const;
+		size_t
+		NextChar (size_t offset) const;
+		size_t
+		WordStart (size_t offset) const;
+		size_t
+		WordEnd (size_t offset) const;
+
+		TextBuffer m_text;
+		TextEditorColors* m_colors{nullptr};
+		size_t m_cursor{0};
+		size_t m_anchor{0};		  ///< Other end of the selection; == m_cursor without one.
+		float m_wantX{-1.0f};	  ///< Column Up and Down keep to; < 0 to take the cursor's.
+		std::deque<UndoStep> m_undo;
+		std::deque<UndoStep> m_redo;
+		bool m_merge{false};  ///< The next typed text joins the last undo step.
+		bool m_changed{false};
+		bool m_follow{false};  ///< Scroll the cursor into view.
+		bool m_focused{false};
+		bool m_focusRequested{false};
+		char m_typed{'\0'};
+		float m_lineHeight{1.0f};
+		float m_width{0.0f};  ///< Widest line drawn.
+		ImVec2 m_cursorScreenPos;
+		std::string m_scratch;
+		std::vector<TextColor> m_runs;
+		std::array<LineAdvances, kAdvanceLines> m_advances;
+		std::array<float, 128> m_asciiWidths{};	 ///< For the font below.
+		const ImFont* m_measuredFont{nullptr};
+		float m_measuredSize{0.0f};
+		std::string m_measureScratch;
+	};
+
+}  // namespace ambidb::ui
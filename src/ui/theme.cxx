@@ -37,7 +37,16 @@ namespace ambidb::ui {
 				   SameColor (lhs.navActivePressed, rhs.navActivePressed) &&
 				   SameColor (lhs.navInactiveHeader, rhs.navInactiveHeader) &&
 				   SameColor (lhs.navInactiveHovered, rhs.navInactiveHovered) &&
-				   SameColor (lhs.navInactivePressed, rhs.navInactivePressed);
+				   SameColor (lhs.navInactivePressed, rhs.navInactivePressed) &&
+				   SameColor (lhs.syntaxKeyword, rhs.syntaxKeyword) &&
+				   SameColor (lhs.syntaxType, rhs.syntaxType) &&
+				   SameColor (lhs.syntaxFunction, rhs.syntaxFunction) &&
+				   SameColor (lhs.syntaxString, rhs.syntaxString) &&
+				   SameColor (lhs.syntaxNumber, rhs.syntaxNumber) &&
+				   SameColor (lhs.syntaxComment, rhs.syntaxComment) &&
+				   SameColor (lhs.syntaxName, rhs.syntaxName) &&
+				   SameColor (lhs.syntaxOperator, rhs.syntaxOperator) &&
+				   SameColor (lhs.syntaxParameter, rhs.syntaxParameter);
 		}
 
 		ImGuiContext*&
@@ -88,6 +97,12 @@ namespace ambidb::ui {
 
 			ImVec4 (0.0f, 0.0f, 0.0f, 0.0f),	ImVec4 (0.18f, 0.18f, 0.22f, 1.0f),
 			ImVec4 (0.24f, 0.24f, 0.30f, 1.0f),
+
+			ImVec4 (0.45f, 0.65f, 1.00f, 1.0f), ImVec4 (0.35f, 0.80f, 0.75f, 1.0f),
+			ImVec4 (0.85f, 0.80f, 0.50f, 1.0f), ImVec4 (0.80f, 0.60f, 0.40f, 1.0f),
+			ImVec4 (0.70f, 0.85f, 0.55f, 1.0f), ImVec4 (0.45f, 0.50f, 0.45f, 1.0f),
+			ImVec4 (0.75f, 0.65f, 0.95f, 1.0f), ImVec4 (0.70f, 0.70f, 0.75f, 1.0f),
+			ImVec4 (0.95f, 0.55f, 0.65f, 1.0f),
 		};
 	}
 
@@ -129,6 +144,15 @@ namespace ambidb::ui {
 		config.navInactiveHeader = Transparent ();
 		config.navInactiveHovered = bg1;
 		config.navInactivePressed = bg2;
+		config.syntaxKeyword = RGBA (251, 73, 52);
+		config.syntaxType = RGBA (250, 189, 47);
+		config.syntaxFunction = RGBA (142, 192, 124);
+		config.syntaxString = RGBA (184, 187, 38);
+		config.syntaxNumber = RGBA (211, 134, 155);
+		config.syntaxComment = RGBA (146, 131, 116);
+		config.syntaxName = blueBr;
+		config.syntaxOperator = fgDim;
+		config.syntaxParameter = RGBA (254, 128, 25);
 		return config;
 	}
 
@@ -171,6 +195,15 @@ namespace ambidb::ui {
 		config.navInactiveHeader = Transparent ();
 		config.navInactiveHovered = bg1;
 		config.navInactivePressed = bg2;
+		config.syntaxKeyword = blue;
+		config.syntaxType = blueBr;
+		config.syntaxFunction = RGBA (224, 175, 104);
+		config.syntaxString = RGBA (158, 206, 106);
+		config.syntaxNumber = RGBA (255, 158, 100);
+		config.syntaxComment = RGBA (86, 95, 137);
+		config.syntaxName = magenta;
+		config.syntaxOperator = RGBA (137, 221, 255);
+		config.syntaxParameter = RGBA (247, 118, 142);
 		return config;
 	}
 
@@ -212,6 +245,15 @@ namespace ambidb::ui {
 		config.navInactiveHeader = Transparent ();
 		config.navInactiveHovered = bg1;
 		config.navInactivePressed = bg2;
+		config.syntaxKeyword = pink;
+		config.syntaxType = RGBA (139, 233, 253);
+		config.syntaxFunction = RGBA (80, 250, 123);
+		config.syntaxString = RGBA (241, 250, 140);
+		config.syntaxNumber = purple;
+		config.syntaxComment = fgDim;
+		config.syntaxName = RGBA (255, 184, 108);
+		config.syntaxOperator = fg;
+		config.syntaxParameter = RGBA (255, 85, 85);
 		return config;
 	}
 
@@ -254,6 +296,15 @@ namespace ambidb::ui {
 		out.navInactiveHeader = SnapOrKeep (src.navInactiveHeader);
 		out.navInactiveHovered = SnapOrKeep (src.navInactiveHovered);
 		out.navInactivePressed = SnapOrKeep (src.navInactivePressed);
+		out.syntaxKeyword = SnapOrKeep (src.syntaxKeyword);
+		out.syntaxType = SnapOrKeep (src.syntaxType);
+		out.syntaxFunction = SnapOrKeep (src.syntaxFunction);
+		out.syntaxString = SnapOrKeep (src.syntaxString);
+		out.syntaxNumber = SnapOrKeep (src.syntaxNumber);
+		out.syntaxComment = SnapOrKeep (src.syntaxComment);
+		out.syntaxName = SnapOrKeep (src.syntaxName);
+		out.syntaxOperator = SnapOrKeep (src.syntaxOperator);
+		out.syntaxParameter = SnapOrKeep (src.syntaxParameter);
 		return out;
 	}
 
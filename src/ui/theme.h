@@ -41,6 +41,17 @@ namespace ambidb::ui {
 		ImVec4 navInactiveHeader;
 		ImVec4 navInactiveHovered;
 		ImVec4 navInactivePressed;
+
+		// SQL syntax highlighting in the Query Editor.
+		ImVec4 syntaxKeyword;
+		ImVec4 syntaxType;
+		ImVec4 syntaxFunction;
+		ImVec4 syntaxString;
+		ImVec4 syntaxNumber;
+		ImVec4 syntaxComment;
+		ImVec4 syntaxName;	///< Quoted identifiers.
+		ImVec4 syntaxOperator;
+		ImVec4 syntaxParameter;
 	};
 
 	enum class ThemePreset {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "color_utils.h"
+#include "data_grid.h"
 #include "dialogs.h"
 #include "filter.h"
 #include "forms.h"
@@ -9,5 +10,6 @@
 #include "metrics.h"
 #include "selection.h"
 #include "tables.h"
+#include "text_editor.h"
 #include "theme.h"
 #include "widgets.h"
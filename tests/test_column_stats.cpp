@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "db/column_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using ambidb::db::ColumnSketch;
+using ambidb::db::ColumnStats;
+using ambidb::db::ColumnType;
+using ambidb::db::HyperLogLog;
+using ambidb::db::QuantileSketch;
+using ambidb::db::ResultSet;
+using ambidb::db::RowBatch;
+using ambidb::db::StatsEngine;
+using ambidb::db::Value;
+
+namespace {
+
+uint64_t Hash(uint64_t x) {
+    x += 0x9E3779B97F4A7C15;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+// Feeds until every group is through, as the App does by calling Feed() each frame.
+void FeedAll(StatsEngine& engine, const ResultSet& rs, bool complete) {
+    for (size_t i = 0; i <= rs.GroupCount(); ++i) {
+        engine.Feed(rs, complete);
+        engine.Flush();
+    }
+}
+
+}  // namespace
+
+TEST(ColumnStatsTest, HyperLogLogEstimatesDistinctCounts) {
+    HyperLogLog small;
+    for (uint64_t i = 0; i < 1000; ++i) small.Add(Hash(i % 100));
+    EXPECT_NEAR(small.Estimate(), 100.0, 5.0);
+
+    HyperLogLog large;
+    for (uint64_t i = 0; i < 500000; ++i) large.Add(Hash(i));
+    EXPECT_NEAR(large.Estimate(), 500000.0, 500000.0 * 0.05);
+
+    EXPECT_EQ(HyperLogLog().Estimate(), 0.0);
+}
+
+TEST(ColumnStatsTest, QuantileSketchStaysWithinRankError) {
+    constexpr int kValues = 1000000;
+    std::vector<double> values(kValues);
+    std::iota(values.begin(), values.end(), 0.0);
+    std::shuffle(values.begin(), values.end(), std::mt19937(11));
+
+    QuantileSketch sketch;
+    for (const double value : values) sketch.Add(value);
+    EXPECT_EQ(sketch.Count(), static_cast<uint64_t>(kValues));
+
+    const std::vector<double> ranks = {0.0, 0.01, 0.5, 0.9, 0.99};
+    std::vector<double> quantiles(ranks.size());
+    sketch.Quantiles(ranks, quantiles);
+    for (size_t i = 0; i < ranks.size(); ++i) {
+        EXPECT_NEAR(quantiles[i], ranks[i] * kValues, kValues * 0.02) << ranks[i];
+    }
+
+    std::vector<float> bins(10);
+    sketch.Histogram(0.0, kValues - 1, bins);
+    for (const float bin : bins) EXPECT_NEAR(bin, 0.1f, 0.02f);
+}
+
+TEST(ColumnStatsTest, SummarizesEveryColumnType) {
+    constexpr size_t kRows = 150000;  // Spans three row groups.
+    ResultSet rs;
+    rs.Reset({{"id", ""}, {"name", ""}, {"score", ""}, {"empty", ""}});
+    RowBatch batch;
+    batch.columnCount = 4;
+    for (size_t row = 0; row < kRows; ++row) {
+        batch.values.push_back(row % 3 == 0 ? Value{} : Value{static_cast<int64_t>(row)});
+        batch.values.push_back(std::string("name") + std::to_string(row % 1000));
+        batch.values.push_back(static_cast<double>(row % 100) - 50.0);
+        batch.values.push_back(Value{});
+    }
+    rs.Append(batch);
+
+    std::vector<ColumnSketch> sketches;
+    for (size_t column = 0; column < rs.ColumnCount(); ++column) sketches.emplace_back(rs.Type(column));
+    for (size_t group = 0; group < rs.GroupCount(); ++group) {
+        for (size_t column = 0; column < rs.ColumnCount(); ++column) sketches[column].Add(rs.Chunk(group, column));
+    }
+
+    const ColumnStats id = sketches[0].Summarize();
+    EXPECT_EQ(id.type, ColumnType::Integer);
+    EXPECT_EQ(id.rows, kRows);
+    EXPECT_EQ(id.nulls, kRows / 3);
+    EXPECT_EQ(id.min, 1.0);
+    EXPECT_EQ(id.max, static_cast<double>(kRows - 1));
+    EXPECT_NEAR(id.distinct, kRows * 2 / 3, kRows * 0.05);
+    EXPECT_NEAR(id.quantiles[2], kRows / 2, kRows * 0.02);
+
+    const ColumnStats name = sketches[1].Summarize();
+    EXPECT_EQ(name.nulls, 0u);
+    EXPECT_EQ(name.minText, "name0");
+    EXPECT_EQ(name.maxText, "name999");
+    EXPECT_NEAR(name.distinct, 1000.0, 30.0);
+
+    const ColumnStats score = sketches[2].Summarize();
+    EXPECT_EQ(score.min, -50.0);
+    EXPECT_EQ(score.max, 49.0);
+    EXPECT_NEAR(score.distinct, 100.0, 5.0);
+    float total = 0.0f;
+    for (const float bin : score.histogram) total += bin;
+    EXPECT_NEAR(total, 1.0f, 1e-4f);
+
+    const ColumnStats empty = sketches[3].Summarize();
+    EXPECT_EQ(empty.nulls, kRows);
+    EXPECT_FALSE(empty.HasValues());
+    EXPECT_EQ(empty.distinct, 0.0);
+}
+
+TEST(ColumnStatsTest, EngineFollowsAStreamingResult) {
+    StatsEngine engine;
+    ResultSet rs;
+    rs.Reset({{"n", ""}});
+    RowBatch batch;
+    batch.columnCount = 1;
+    for (int64_t row = 0; row < 200000; ++row) batch.values.push_back(row);
+    rs.Append(batch);
+
+    // Only full groups go while rows keep coming.
+    FeedAll(engine, rs, false);
+    std::vector<ColumnStats> stats;
+    engine.Snapshot(stats);
+    ASSERT_EQ(stats.size(), 1u);
+    EXPECT_EQ(stats[0].rows, 3 * ResultSet::kGroupRows);
+
+    // A real widens the column, which rewrites the groups already fed.
+    batch.values.assign(1, 0.5);
+    rs.Append(batch);
+    ASSERT_EQ(rs.Type(0), ColumnType::Real);
+    FeedAll(engine, rs, true);
+    engine.Snapshot(stats);
+    ASSERT_EQ(stats.size(), 1u);
+    EXPECT_EQ(stats[0].type, ColumnType::Real);
+    EXPECT_EQ(stats[0].rows, 200001u);
+    EXPECT_EQ(stats[0].min, 0.0);
+    EXPECT_EQ(stats[0].max, 199999.0);
+
+    engine.Reset();
+    engine.Snapshot(stats);
+    EXPECT_TRUE(stats.empty());
+
+    // An empty result still reports its columns.
+    const uint64_t generation = engine.Generation();
+    rs.Reset({{"a", ""}, {"b", ""}});
+    FeedAll(engine, rs, true);
+    engine.Snapshot(stats);
+    EXPECT_EQ(stats.size(), 2u);
+    EXPECT_GT(engine.Generation(), generation);
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include "backends/tui/damage_writer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t Cell(uint32_t ch, uint32_t fg = 7, uint32_t bg = 0) {
+    return ch | (fg << 16) | (bg << 24);
+}
+
+class DamageWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(pipe(fds_), 0);
+        fcntl(fds_[0], F_SETFL, fcntl(fds_[0], F_GETFL) | O_NONBLOCK);
+    }
+
+    void TearDown() override {
+        close(fds_[0]);
+        close(fds_[1]);
+    }
+
+    // Everything the writer has sent so far.
+    std::string Drain() {
+        std::string out;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(fds_[0], buffer, sizeof(buffer))) > 0) {
+            out.append(buffer, static_cast<size_t>(n));
+        }
+        return out;
+    }
+
+    int fds_[2] = {-1, -1};
+};
+
+}  // namespace
+
+TEST_F(DamageWriterTest, FirstFrameRepaintsEveryCell) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    const std::vector<uint32_t> screen(6, Cell('a'));
+    ASSERT_TRUE(writer.Present(screen.data(), 3, 2));
+
+    EXPECT_EQ(Drain(), "\x1b[0m\x1b[H\x1b[38;5;7;48;5;0maaa\x1b[2;1Haaa");
+    EXPECT_TRUE(writer.LastStats().fullRepaint);
+    EXPECT_EQ(writer.LastStats().changedCells, 6u);
+}
+
+TEST_F(DamageWriterTest, UnchangedFrameWritesNothing) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    const std::vector<uint32_t> screen(6, Cell('a'));
+    ASSERT_TRUE(writer.Present(screen.data(), 3, 2));
+    Drain();
+
+    ASSERT_TRUE(writer.Present(screen.data(), 3, 2));
+    EXPECT_EQ(Drain(), "");
+    EXPECT_EQ(writer.LastStats().bytes, 0u);
+    EXPECT_EQ(writer.LastStats().changedCells, 0u);
+    EXPECT_FALSE(writer.LastStats().fullRepaint);
+}
+
+TEST_F(DamageWriterTest, ReprintsShortGapsBetweenChangedCells) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    std::vector<uint32_t> screen(10, Cell('a'));
+    ASSERT_TRUE(writer.Present(screen.data(), 10, 1));
+    Drain();
+
+    screen[1] = Cell('b');
+    screen[3] = Cell('b');
+    ASSERT_TRUE(writer.Present(screen.data(), 10, 1));
+    EXPECT_EQ(Drain(), "\x1b[1;2Hbab");
+    EXPECT_EQ(writer.LastStats().changedCells, 2u);
+}
+
+TEST_F(DamageWriterTest, SkipsLongGapsWithCursorForward) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    std::vector<uint32_t> screen(10, Cell('a'));
+    ASSERT_TRUE(writer.Present(screen.data(), 10, 1));
+    Drain();
+
+    screen[1] = Cell('b');
+    screen[8] = Cell('b');
+    ASSERT_TRUE(writer.Present(screen.data(), 10, 1));
+    EXPECT_EQ(Drain(), "\x1b[1;2Hb\x1b[6Cb");
+}
+
+TEST_F(DamageWriterTest, DoesNotReprintGapsInAnotherColor) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    std::vector<uint32_t> screen(10, Cell('a'));
+    screen[2] = Cell('a', 1);
+    ASSERT_TRUE(writer.Present(screen.data(), 10, 1));
+    Drain();
+
+    screen[1] = Cell('b');
+    screen[3] = Cell('b');
+    ASSERT_TRUE(writer.Present(screen.data(), 10, 1));
+    EXPECT_EQ(Drain(), "\x1b[1;2Hb\x1b[Cb");
+}
+
+TEST_F(DamageWriterTest, MovesToNextLineWithCrLf) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    std::vector<uint32_t> screen(6, Cell('a'));
+    ASSERT_TRUE(writer.Present(screen.data(), 3, 2));
+    Drain();
+
+    screen[1] = Cell('b');
+    screen[3] = Cell('c');
+    ASSERT_TRUE(writer.Present(screen.data(), 3, 2));
+    EXPECT_EQ(Drain(), "\x1b[1;2Hb\r\nc");
+}
+
+TEST_F(DamageWriterTest, EmitsOnlyTheChangedColor) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    std::vector<uint32_t> screen(4, Cell('a'));
+    ASSERT_TRUE(writer.Present(screen.data(), 4, 1));
+    Drain();
+
+    screen[0] = Cell('a', 1);
+    screen[1] = Cell('a', 1, 4);
+    ASSERT_TRUE(writer.Present(screen.data(), 4, 1));
+    EXPECT_EQ(Drain(), "\x1b[1;1H\x1b[38;5;1ma\x1b[48;5;4ma");
+}
+
+TEST_F(DamageWriterTest, EncodesNonAsciiAsUtf8) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    std::vector<uint32_t> screen(2, Cell('a'));
+    ASSERT_TRUE(writer.Present(screen.data(), 2, 1));
+    Drain();
+
+    screen[0] = Cell(0x00E9);  // é
+    screen[1] = Cell(0x2500);  // ─
+    ASSERT_TRUE(writer.Present(screen.data(), 2, 1));
+    EXPECT_EQ(Drain(), "\x1b[1;1H\xc3\xa9\xe2\x94\x80");
+}
+
+TEST_F(DamageWriterTest, ResizeAndInvalidateRepaintEverything) {
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    std::vector<uint32_t> screen(4, Cell('a'));
+    ASSERT_TRUE(writer.Present(screen.data(), 4, 1));
+    Drain();
+
+    ASSERT_TRUE(writer.Present(screen.data(), 2, 2));
+    EXPECT_TRUE(writer.LastStats().fullRepaint);
+    EXPECT_EQ(writer.LastStats().changedCells, 4u);
+    Drain();
+
+    writer.Invalidate();
+    ASSERT_TRUE(writer.Present(screen.data(), 2, 2));
+    EXPECT_TRUE(writer.LastStats().fullRepaint);
+    EXPECT_EQ(Drain(), "\x1b[0m\x1b[H\x1b[38;5;7;48;5;0maa\x1b[2;1Haa");
+}
+
+TEST_F(DamageWriterTest, WaitsForAFullNonBlockingOutput) {
+    fcntl(fds_[1], F_SETFL, fcntl(fds_[1], F_GETFL) | O_NONBLOCK);
+    ambidb::TerminalDamageWriter writer(fds_[1]);
+    // Three UTF-8 bytes per cell: far more than a pipe buffer holds.
+    std::vector<uint32_t> screen(200 * 200);
+    for (size_t i = 0; i < screen.size(); ++i) {
+        screen[i] = Cell(0x4E00 + static_cast<uint32_t>(i % 256));
+    }
+
+    std::string received;
+    std::thread reader([&] {
+        fcntl(fds_[0], F_SETFL, fcntl(fds_[0], F_GETFL) & ~O_NONBLOCK);
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(fds_[0], buffer, sizeof(buffer))) > 0) {
+            received.append(buffer, static_cast<size_t>(n));
+        }
+    });
+
+    const bool ok = writer.Present(screen.data(), 200, 200);
+    close(fds_[1]);
+    fds_[1] = -1;
+    reader.join();
+
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(received.size(), writer.LastStats().bytes);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include "db/exporter.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using ambidb::db::Blob;
+using ambidb::db::ColumnType;
+using ambidb::db::Exporter;
+using ambidb::db::ExportFormat;
+using ambidb::db::ResultSet;
+using ambidb::db::RowBatch;
+using ambidb::db::Value;
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+RowBatch Tricky() {
+    RowBatch batch;
+    batch.columnCount = 4;
+    batch.values = {
+        Value{int64_t{1}}, Value{std::string("plain")}, Value{0.5}, Value{},
+        Value{int64_t{-2}}, Value{std::string("a,\"b\"\n\tc\\")}, Value{1e300}, Value{Blob{{0x00, 0xff}}},
+    };
+    return batch;
+}
+
+std::string Export(ExportFormat format, const RowBatch& batch, const std::string& name) {
+    const std::string path = testing::TempDir() + name;
+    auto exporter = Exporter::Create(format, path, {}, 2);
+    EXPECT_TRUE(exporter.has_value());
+    (*exporter)->Begin({{"id", ""}, {"na\"me", ""}, {"score", ""}, {"data", ""}});
+    RowBatch copy;
+    copy.columnCount = batch.columnCount;
+    copy.values = batch.values;
+    EXPECT_TRUE((*exporter)->Write(std::move(copy)));
+    (*exporter)->Finish();
+    EXPECT_TRUE((*exporter)->Done());
+    EXPECT_EQ((*exporter)->Error(), "");
+    EXPECT_EQ((*exporter)->Rows(), batch.RowCount());
+    return ReadFile(path);
+}
+
+}  // namespace
+
+TEST(ExporterTest, EscapesEachTextFormat) {
+    EXPECT_EQ(Export(ExportFormat::Csv, Tricky(), "export.csv"),
+              "id,\"na\"\"me\",score,data\n"
+              "1,plain,0.5,\n"
+              "-2,\"a,\"\"b\"\"\n\tc\\\",1e+300,\\x00ff\n");
+    EXPECT_EQ(Export(ExportFormat::Tsv, Tricky(), "export.tsv"),
+              "id\tna\"me\tscore\tdata\n"
+              "1\tplain\t0.5\t\\N\n"
+              "-2\ta,\"b\"\\n\\tc\\\\\t1e+300\t\\\\x00ff\n");
+    EXPECT_EQ(Export(ExportFormat::JsonLines, Tricky(), "export.jsonl"),
+              "{\"id\":1,\"na\\\"me\":\"plain\",\"score\":0.5,\"data\":null}\n"
+              "{\"id\":-2,\"na\\\"me\":\"a,\\\"b\\\"\\n\\tc\\\\\",\"score\":1e+300,\"data\":\"\\\\x00ff\"}\n");
+}
+
+TEST(ExporterTest, StoredResultsMatchStreamedBatches) {
+    constexpr size_t kRows = 150000;  // Spans three row groups.
+    ResultSet rs;
+    rs.Reset({{"id", ""}, {"name", ""}, {"score", ""}});
+    RowBatch batch;
+    batch.columnCount = 3;
+    for (size_t row = 0; row < kRows; ++row) {
+        batch.values.push_back(static_cast<int64_t>(row));
+        batch.values.push_back(row % 7 == 0 ? Value{} : Value{"name, " + std::to_string(row)});
+        batch.values.push_back(static_cast<double>(row) / 8.0);
+    }
+    rs.Append(batch);
+
+    const std::string stored = testing::TempDir() + "stored.csv";
+    auto exporter = Exporter::Create(ExportFormat::Csv, stored, {}, 4);
+    ASSERT_TRUE(exporter.has_value());
+    (*exporter)->Begin({{"id", ""}, {"name", ""}, {"score", ""}});
+    for (size_t group = 0; group < rs.GroupCount(); ++group) ASSERT_TRUE((*exporter)->Write(rs, group));
+    (*exporter)->Finish();
+    EXPECT_EQ((*exporter)->Error(), "");
+    EXPECT_EQ((*exporter)->Rows(), kRows);
+
+    // The same rows as small batches, in order, through more blocks than kMaxPending.
+    const std::string streamed = testing::TempDir() + "streamed.csv";
+    exporter = Exporter::Create(ExportFormat::Csv, streamed, {}, 4);
+    ASSERT_TRUE(exporter.has_value());
+    (*exporter)->Begin({{"id", ""}, {"name", ""}, {"score", ""}});
+    for (size_t first = 0; first < kRows; first += 1000) {
+        RowBatch part;
+        part.columnCount = 3;
+        part.values.assign(batch.values.begin() + first * 3, batch.values.begin() + std::min(first + 1000, kRows) * 3);
+        ASSERT_TRUE((*exporter)->Write(std::move(part)));
+    }
+    (*exporter)->Finish();
+    EXPECT_EQ((*exporter)->Bytes(), ReadFile(stored).size());
+    EXPECT_EQ(ReadFile(stored), ReadFile(streamed));
+}
+
+TEST(ExporterTest, ColumnarKeepsChunkLayout) {
+    ResultSet rs;
+    rs.Reset({{"n", ""}, {"s", ""}});
+    RowBatch batch;
+    batch.columnCount = 2;
+    batch.values = {Value{int64_t{7}}, Value{std::string("x")}, Value{}, Value{std::string("yz")}};
+    rs.Append(batch);
+
+    const std::string path = testing::TempDir() + "export.ambicol";
+    auto exporter = Exporter::Create(ExportFormat::Columnar, path);
+    ASSERT_TRUE(exporter.has_value());
+    (*exporter)->Begin({{"n", ""}, {"s", ""}});
+    ASSERT_TRUE((*exporter)->Write(rs, 0));
+    (*exporter)->Finish();
+    ASSERT_EQ((*exporter)->Error(), "");
+
+    const std::string file = ReadFile(path);
+    size_t at = 0;
+    const auto take = [&](size_t size) {
+        EXPECT_LE(at + size, file.size());
+        const std::string part = file.substr(at, size);
+        at += size;
+        return part;
+    };
+    const auto takeU32 = [&] {
+        uint32_t value = 0;
+        std::memcpy(&value, take(4).data(), 4);
+        return value;
+    };
+    const auto takeU64 = [&] {
+        uint64_t value = 0;
+        std::memcpy(&value, take(8).data(), 8);
+        return value;
+    };
+    EXPECT_EQ(take(8), "AMBICOL1");
+    ASSERT_EQ(takeU32(), 2u);
+    ASSERT_EQ(takeU32(), 1u);
+    EXPECT_EQ(take(1), "n");
+    ASSERT_EQ(takeU32(), 1u);
+    EXPECT_EQ(take(1), "s");
+
+    ASSERT_EQ(takeU32(), 2u);  // rows
+    EXPECT_EQ(static_cast<ColumnType>(take(1)[0]), ColumnType::Integer);
+    EXPECT_EQ(takeU64(), 0b10u);  // row 1 is NULL
+    EXPECT_EQ(takeU64(), 7u);
+    takeU64();
+    EXPECT_EQ(static_cast<ColumnType>(take(1)[0]), ColumnType::Text);
+    EXPECT_EQ(takeU64(), 0u);
+    EXPECT_EQ(takeU32(), 0u);
+    EXPECT_EQ(takeU32(), 2u);
+    EXPECT_EQ(takeU32(), 5u);
+    EXPECT_EQ(take(5), std::string("x\0yz\0", 5));
+    EXPECT_EQ(takeU32(), 0u);  // end of file
+    EXPECT_EQ(at, file.size());
+}
+
+TEST(ExporterTest, ReportsOpenFailuresAndCancellation) {
+    EXPECT_FALSE(Exporter::Create(ExportFormat::Csv, testing::TempDir() + "missing/dir/out.csv").has_value());
+
+    auto exporter = Exporter::Create(ExportFormat::Csv, testing::TempDir() + "cancelled.csv");
+    ASSERT_TRUE(exporter.has_value());
+    (*exporter)->Begin({{"a", ""}});
+    (*exporter)->Cancel();
+    RowBatch batch;
+    batch.columnCount = 1;
+    batch.values = {Value{int64_t{1}}};
+    EXPECT_FALSE((*exporter)->Write(std::move(batch)));
+    (*exporter)->Finish();
+    EXPECT_EQ((*exporter)->Error(), "Cancelled");
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "frame_scheduler.h"
+
+#include <chrono>
+
+using ambidb::FrameScheduler;
+
+TEST(FrameSchedulerTest, RedrawRequestsCoalesceIntoOneWakeup) {
+    FrameScheduler scheduler;
+    int wakes = 0;
+    scheduler.SetWakeHook([&] { ++wakes; });
+
+    scheduler.RequestRedraw();
+    scheduler.RequestRedraw();
+    EXPECT_EQ(wakes, 1);
+
+    EXPECT_TRUE(scheduler.ConsumeRedraw());
+    EXPECT_FALSE(scheduler.ConsumeRedraw());
+
+    scheduler.RequestRedraw();
+    EXPECT_EQ(wakes, 2);
+}
+
+TEST(FrameSchedulerTest, KeepsEarliestDeadline) {
+    FrameScheduler scheduler;
+    const auto now = FrameScheduler::Clock::now();
+    EXPECT_FALSE(scheduler.NextDeadline().has_value());
+
+    scheduler.ScheduleFrameAt(now + std::chrono::seconds(2));
+    scheduler.ScheduleFrameAt(now + std::chrono::seconds(1));
+    scheduler.ScheduleFrameAt(now + std::chrono::seconds(3));
+    ASSERT_TRUE(scheduler.NextDeadline().has_value());
+    EXPECT_EQ(*scheduler.NextDeadline(), now + std::chrono::seconds(1));
+
+    EXPECT_FALSE(scheduler.ConsumeDeadline(now));
+    EXPECT_TRUE(scheduler.ConsumeDeadline(now + std::chrono::seconds(1)));
+    EXPECT_FALSE(scheduler.NextDeadline().has_value());
+}
+
+TEST(FrameSchedulerTest, PlansIdleDeadlineAndContinuousWaits) {
+    using namespace std::chrono_literals;
+    FrameScheduler scheduler;
+    scheduler.SetAnimationInterval(10ms);
+    const auto now = FrameScheduler::Clock::now();
+
+    EXPECT_EQ(scheduler.PlanWait(now, now).mode, ambidb::WaitMode::Idle);
+
+    scheduler.ScheduleFrameAt(now + 50ms);
+    auto plan = scheduler.PlanWait(now, now);
+    EXPECT_EQ(plan.mode, ambidb::WaitMode::Deadline);
+    EXPECT_EQ(plan.timeout, 50ms);
+
+    scheduler.BeginAnimation();
+    plan = scheduler.PlanWait(now + 4ms, now);
+    EXPECT_EQ(plan.mode, ambidb::WaitMode::Continuous);
+    EXPECT_EQ(plan.timeout, 6ms);
+
+    scheduler.EndAnimation();
+    plan = scheduler.PlanWait(now, now);
+    EXPECT_EQ(plan.mode, ambidb::WaitMode::Continuous);
+    EXPECT_EQ(plan.timeout, FrameScheduler::Clock::duration::zero());
+    EXPECT_TRUE(scheduler.ConsumeRedraw());
+    EXPECT_EQ(scheduler.PlanWait(now, now).mode, ambidb::WaitMode::Deadline);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "frame_timing.h"
+
+using ambidb::FramePhase;
+using ambidb::FrameTimings;
+
+namespace {
+
+// Output bytes are recorded verbatim, so they make deterministic samples for the
+// ring and percentile logic; phase durations come from the real clock.
+void RecordFrame(FrameTimings& timings, size_t bytes) {
+    timings.BeginFrame();
+    timings.Mark(FramePhase::NewFrame);
+    timings.Mark(FramePhase::Update);
+    timings.Mark(FramePhase::Render);
+    timings.RecordOutputBytes(bytes);
+    timings.Mark(FramePhase::Present);
+    timings.EndFrame();
+}
+
+}  // namespace
+
+TEST(FrameTimingTest, DisabledTimerRecordsNothing) {
+    FrameTimings timings;
+    EXPECT_FALSE(timings.Enabled());
+    for (size_t i = 0; i < 10; ++i) {
+        RecordFrame(timings, 100);
+    }
+    const auto stats = timings.Summarize();
+    EXPECT_EQ(stats.samples, 0u);
+    EXPECT_EQ(stats.output.maxBytes, 0u);
+    EXPECT_EQ(stats.total.maxMs, 0.0);
+}
+
+TEST(FrameTimingTest, DisablingMidFrameKeepsTheFrame) {
+    FrameTimings timings;
+    timings.SetEnabled(true);
+    timings.BeginFrame();
+    timings.SetEnabled(false);
+    timings.RecordOutputBytes(7);
+    timings.EndFrame();
+    RecordFrame(timings, 9);
+
+    const auto stats = timings.Summarize();
+    EXPECT_EQ(stats.samples, 1u);
+    EXPECT_EQ(stats.output.maxBytes, 7u);
+}
+
+TEST(FrameTimingTest, SelectsNearestRankPercentiles) {
+    FrameTimings timings;
+    timings.SetEnabled(true);
+    for (size_t bytes = 1; bytes <= 101; ++bytes) {
+        RecordFrame(timings, bytes);
+    }
+    const auto stats = timings.Summarize();
+    EXPECT_EQ(stats.samples, 101u);
+    EXPECT_EQ(stats.output.p50Bytes, 51u);
+    EXPECT_EQ(stats.output.p99Bytes, 100u);
+    EXPECT_EQ(stats.output.maxBytes, 101u);
+
+    for (size_t phase = 0; phase < ambidb::kFramePhaseCount; ++phase) {
+        EXPECT_LE(stats.phases[phase].p50Ms, stats.phases[phase].p99Ms);
+        EXPECT_LE(stats.phases[phase].p99Ms, stats.phases[phase].maxMs);
+    }
+    EXPECT_LE(stats.total.p50Ms, stats.total.maxMs);
+}
+
+TEST(FrameTimingTest, WindowCoversOnlyTheNewestFrames) {
+    FrameTimings timings;
+    timings.SetEnabled(true);
+    for (size_t bytes = 0; bytes < 20; ++bytes) {
+        RecordFrame(timings, bytes);
+    }
+    const auto stats = timings.Summarize(10);
+    EXPECT_EQ(stats.samples, 10u);
+    EXPECT_EQ(stats.output.p50Bytes, 15u);
+    EXPECT_EQ(stats.output.p99Bytes, 19u);
+    EXPECT_EQ(stats.output.maxBytes, 19u);
+
+    EXPECT_EQ(timings.Summarize(1000).samples, 20u);
+}
+
+TEST(FrameTimingTest, RingWrapsAroundAndDropsOldestFrames) {
+    FrameTimings timings;
+    timings.SetEnabled(true);
+    const size_t frames = FrameTimings::kCapacity + 44;
+    for (size_t bytes = 0; bytes < frames; ++bytes) {
+        RecordFrame(timings, bytes);
+    }
+    // Only frames 44..299 are still in the ring.
+    const auto stats = timings.Summarize();
+    EXPECT_EQ(stats.samples, FrameTimings::kCapacity);
+    EXPECT_EQ(stats.output.p50Bytes, 44u + 128u);
+    EXPECT_EQ(stats.output.p99Bytes, 44u + 252u);
+    EXPECT_EQ(stats.output.maxBytes, frames - 1);
+}
+
+TEST(FrameTimingTest, OutputBytesSaturate) {
+    FrameTimings timings;
+    timings.SetEnabled(true);
+    RecordFrame(timings, size_t{UINT32_MAX} + 10);
+    EXPECT_EQ(timings.Summarize().output.maxBytes, UINT32_MAX);
+}
+
+TEST(FrameTimingTest, NamesEveryPhase) {
+    EXPECT_STREQ(ambidb::FramePhaseName(FramePhase::NewFrame), "NewFrame");
+    EXPECT_STREQ(ambidb::FramePhaseName(FramePhase::Update), "Update");
+    EXPECT_STREQ(ambidb::FramePhaseName(FramePhase::Render), "Render");
+    EXPECT_STREQ(ambidb::FramePhaseName(FramePhase::Present), "Present");
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "history_store.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using ambidb::HistoryRecord;
+using ambidb::HistoryStore;
+using ambidb::db::QueryStatus;
+
+namespace {
+
+std::filesystem::path FreshDirectory(const std::string& name) {
+    const std::filesystem::path directory = std::filesystem::path(testing::TempDir()) / name;
+    std::filesystem::remove_all(directory);
+    return directory;
+}
+
+std::unique_ptr<HistoryStore> OpenStore(const std::filesystem::path& directory) {
+    auto store = HistoryStore::Open(directory);
+    EXPECT_TRUE(store.has_value()) << (store ? "" : store.error());
+    return store ? std::move(*store) : nullptr;
+}
+
+HistoryRecord Record(const std::string& connection, const std::string& sql, int64_t rows = 0) {
+    HistoryRecord record;
+    record.connection = connection;
+    record.sql = sql;
+    record.rows = rows;
+    record.elapsedMs = 1.5;
+    return record;
+}
+
+std::vector<uint32_t> Search(const HistoryStore& store, const std::string& query, size_t limit = 100) {
+    std::vector<uint32_t> hits;
+    store.Search(query, limit, hits);
+    return hits;
+}
+
+}  // namespace
+
+TEST(HistoryStoreTest, PersistsEntriesAndConnections) {
+    const std::filesystem::path directory = FreshDirectory("history_persist");
+    {
+        auto store = OpenStore(directory);
+        ASSERT_NE(store, nullptr);
+        store->Append(Record("local", "SELECT 1", 1));
+        store->Append(Record("prod", "DELETE FROM t", 7));
+        store->Append(Record("local", "SELECT 2", 1));
+        store->Flush();
+        EXPECT_EQ(store->Size(), 3u);
+    }
+
+    auto store = OpenStore(directory);
+    ASSERT_NE(store, nullptr);
+    ASSERT_EQ(store->Size(), 3u);
+    EXPECT_EQ(store->At(1).sql, "DELETE FROM t");
+    EXPECT_EQ(store->At(1).rows, 7);
+    EXPECT_EQ(store->At(1).status, QueryStatus::Ok);
+    EXPECT_LE(store->At(0).time, store->At(2).time);
+    ASSERT_EQ(store->ConnectionCount(), 2u);
+    EXPECT_EQ(store->ConnectionName(0), "local");
+    const auto local = store->EntriesOf(0);
+    EXPECT_EQ(std::vector<uint32_t>(local.begin(), local.end()), (std::vector<uint32_t>{0, 2}));
+    EXPECT_EQ(store->FirstAtOrAfter(store->At(2).time + 1), 3u);
+    EXPECT_EQ(store->FirstAtOrAfter(0), 0u);
+
+    store->Append(Record("prod", "SELECT 3"));
+    store->Flush();
+    const auto prod = store->EntriesOf(1);
+    EXPECT_EQ(std::vector<uint32_t>(prod.begin(), prod.end()), (std::vector<uint32_t>{1, 3}));
+}
+
+TEST(HistoryStoreTest, SearchesSegmentsAndTailNewestFirst) {
+    const std::filesystem::path directory = FreshDirectory("history_search");
+    // Enough to seal kMergeFanIn segments and merge them, plus a tail.
+    const uint32_t count = HistoryStore::kSegmentEntries * (HistoryStore::kMergeFanIn + 1) + 100;
+    {
+        auto store = OpenStore(directory);
+        ASSERT_NE(store, nullptr);
+        for (uint32_t i = 0; i < count; ++i) {
+            store->Append(Record("db", "SELECT amount_" + std::to_string(i % 10) + " FROM Orders_" + std::to_string(i)));
+            // Commit in groups that add up to whole segments.
+            if (i % 512 == 511) store->Flush();
+        }
+        store->Flush();
+        ASSERT_EQ(store->Size(), count);
+        // orders_370 and orders_3700 to orders_3709; there is no orders_37000.
+        EXPECT_EQ(Search(*store, "ORDERS_370"),
+                  (std::vector<uint32_t>{3709, 3708, 3707, 3706, 3705, 3704, 3703, 3702, 3701, 3700, 370}));
+        EXPECT_EQ(Search(*store, "amount_3 orders_12", 3), (std::vector<uint32_t>{12993, 12983, 12973}));
+        EXPECT_EQ(Search(*store, "orders_" + std::to_string(count - 1)), (std::vector<uint32_t>{count - 1}));
+        EXPECT_TRUE(Search(*store, "missing").empty());
+    }
+
+    auto store = OpenStore(directory);
+    ASSERT_NE(store, nullptr);
+    EXPECT_EQ(Search(*store, "orders_370").size(), 11u);
+    EXPECT_EQ(Search(*store, "s a", 2), (std::vector<uint32_t>{count - 1, count - 2}));
+    EXPECT_EQ(Search(*store, "orders_" + std::to_string(count - 1)), (std::vector<uint32_t>{count - 1}));
+}
+
+TEST(HistoryStoreTest, FiltersBeforeTheSearchLimit) {
+    const std::filesystem::path directory = FreshDirectory("history_search_filter");
+    auto store = OpenStore(directory);
+    ASSERT_NE(store, nullptr);
+    // Five old matches of one connection behind a segment's worth of newer ones of another.
+    const uint32_t busy = HistoryStore::kSegmentEntries + 100;
+    for (uint32_t i = 0; i < 5; ++i) store->Append(Record("quiet", "SELECT * FROM orders"));
+    for (uint32_t i = 0; i < busy; ++i) store->Append(Record("busy", "SELECT * FROM orders"));
+    store->Flush();
+
+    std::vector<uint32_t> hits;
+    store->Search("orders", 100, hits, {.connection = 0u});
+    EXPECT_EQ(hits, (std::vector<uint32_t>{4, 3, 2, 1, 0}));
+
+    store->Search("orders", 100, hits, {.connection = 1u});
+    ASSERT_EQ(hits.size(), 100u);
+    EXPECT_EQ(hits.front(), busy + 4);
+
+    // A window that starts after the last entry matches nothing.
+    store->Search("orders", 100, hits, {.connection = std::nullopt, .since = store->At(busy + 4).time + 1});
+    EXPECT_TRUE(hits.empty());
+    store->Search("orders", 3, hits, {.connection = 0u, .since = store->At(0).time});
+    EXPECT_EQ(hits, (std::vector<uint32_t>{4, 3, 2}));
+}
+
+TEST(HistoryStoreTest, TrimsATornTail) {
+    const std::filesystem::path directory = FreshDirectory("history_torn");
+    {
+        auto store = OpenStore(directory);
+        ASSERT_NE(store, nullptr);
+        store->Append(Record("db", "SELECT kept"));
+        store->Flush();
+    }
+    // A group that reached the log but only half of its index record.
+    std::ofstream(directory / "history.log", std::ios::binary | std::ios::app) << std::string(12, 'x');
+    std::ofstream(directory / "history.idx", std::ios::binary | std::ios::app) << std::string(20, '\0');
+
+    auto store = OpenStore(directory);
+    ASSERT_NE(store, nullptr);
+    ASSERT_EQ(store->Size(), 1u);
+    store->Append(Record("db", "SELECT after"));
+    store->Flush();
+    ASSERT_EQ(store->Size(), 2u);
+    EXPECT_EQ(store->At(0).sql, "SELECT kept");
+    EXPECT_EQ(store->At(1).sql, "SELECT after");
+    EXPECT_EQ(Search(*store, "after"), (std::vector<uint32_t>{1}));
+}
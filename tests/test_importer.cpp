@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "db/importer.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+using ambidb::db::Importer;
+using ambidb::db::ImportOptions;
+using ambidb::db::RowBatch;
+using ambidb::db::Value;
+
+namespace {
+
+std::string WriteFile(const std::string& name, const std::string& contents) {
+    const std::string path = testing::TempDir() + name;
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+ImportOptions Options(bool header = true) {
+    ImportOptions options;
+    options.table = "t";
+    options.header = header;
+    return options;
+}
+
+// Every row Next() hands out, in order.
+std::vector<Value> ReadAll(Importer& importer) {
+    std::vector<Value> values;
+    RowBatch batch;
+    while (importer.Next(batch)) values.insert(values.end(), batch.values.begin(), batch.values.end());
+    return values;
+}
+
+}  // namespace
+
+TEST(ImporterTest, ParsesQuotesTypesAndLineEnds) {
+    const std::string path = WriteFile("import.csv",
+                                       "id,\"na\"\"me\",score,code\r\n"
+                                       "1,plain,0.5,007\r\n"
+                                       "\n"
+                                       "-2,\"a,\"\"b\"\"\nc\",1e3,\n"
+                                       "3,\"\",-,x");
+    auto importer = Importer::Create(path, Options(), {}, 2);
+    ASSERT_TRUE(importer.has_value());
+    EXPECT_EQ((*importer)->Columns(), (std::vector<std::string>{"id", "na\"me", "score", "code"}));
+
+    const std::vector<Value> values = ReadAll(**importer);
+    EXPECT_TRUE((*importer)->AtEnd());
+    (*importer)->Finish();
+    EXPECT_EQ((*importer)->Error(), "");
+    EXPECT_EQ((*importer)->Rows(), 3u);
+    EXPECT_EQ((*importer)->Bytes(), (*importer)->TotalBytes());
+
+    const std::vector<Value> expected = {
+        Value{int64_t{1}}, Value{std::string("plain")}, Value{0.5}, Value{std::string("007")},
+        Value{int64_t{-2}}, Value{std::string("a,\"b\"\nc")}, Value{1000.0}, Value{},
+        Value{int64_t{3}}, Value{std::string()}, Value{std::string("-")}, Value{std::string("x")},
+    };
+    EXPECT_EQ(values, expected);
+}
+
+TEST(ImporterTest, SplitsChunksOnRecordBoundaries) {
+    // Quoted fields with line breaks and delimiters straddle many chunk boundaries.
+    constexpr size_t kRows = 100000;
+    std::string csv;
+    for (size_t row = 0; row < kRows; ++row) {
+        csv += std::to_string(row) + ",\"line\n" + std::string(row % 37, ',') + "\"\"" + std::to_string(row) + "\"\"\"\n";
+    }
+    ASSERT_GT(csv.size(), 3 * Importer::kChunkBytes);
+    const std::string path = WriteFile("chunks.csv", csv);
+
+    auto importer = Importer::Create(path, Options(false), {}, 4);
+    ASSERT_TRUE(importer.has_value());
+    EXPECT_EQ((*importer)->ColumnCount(), 2u);
+    const std::vector<Value> values = ReadAll(**importer);
+    (*importer)->Finish();
+    ASSERT_EQ((*importer)->Error(), "");
+    ASSERT_EQ(values.size(), kRows * 2);
+    for (size_t row = 0; row < kRows; ++row) {
+        ASSERT_EQ(values[row * 2], Value{static_cast<int64_t>(row)});
+        ASSERT_EQ(values[row * 2 + 1], Value{"line\n" + std::string(row % 37, ',') + "\"" + std::to_string(row) + "\""});
+    }
+}
+
+TEST(ImporterTest, ReportsMalformedInput) {
+    EXPECT_FALSE(Importer::Create(testing::TempDir() + "missing.csv", Options()).has_value());
+
+    auto importer = Importer::Create(WriteFile("wide.csv", "a,b\n1,2\n3,4,5\n"), Options());
+    ASSERT_TRUE(importer.has_value());
+    ReadAll(**importer);
+    EXPECT_FALSE((*importer)->AtEnd());
+    (*importer)->Finish();
+    EXPECT_EQ((*importer)->Error(), "At byte 8: 3 fields, expected 2");
+
+    importer = Importer::Create(WriteFile("open.csv", "a\n\"never closed\n"), Options());
+    ASSERT_TRUE(importer.has_value());
+    ReadAll(**importer);
+    (*importer)->Finish();
+    EXPECT_EQ((*importer)->Error(), "At byte 2: Unterminated quoted field");
+
+    importer = Importer::Create(WriteFile("cancelled.csv", "a\n1\n"), Options());
+    ASSERT_TRUE(importer.has_value());
+    (*importer)->Cancel();
+    RowBatch batch;
+    EXPECT_FALSE((*importer)->Next(batch));
+    (*importer)->Finish();
+    EXPECT_EQ((*importer)->Error(), "Cancelled");
+}
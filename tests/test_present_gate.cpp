@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "imgui.h"
+#include "present_gate.h"
+
+namespace {
+
+class PresentGateTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        context_ = ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = ImVec2(320.0f, 240.0f);
+        io.DeltaTime = 1.0f / 60.0f;
+        unsigned char* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+
+    void TearDown() override { ImGui::DestroyContext(context_); }
+
+    const ImDrawData* Frame(const ImVec4& color) {
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+        ImGui::Begin("Gate");
+        ImGui::TextColored(color, "rows: 42");
+        ImGui::End();
+        ImGui::Render();
+        return ImGui::GetDrawData();
+    }
+
+    ImGuiContext* context_ = nullptr;
+};
+
+}  // namespace
+
+TEST_F(PresentGateTest, ElidesIdenticalFrames) {
+    ambidb::PresentGate gate;
+    const ImVec4 white(1.0f, 1.0f, 1.0f, 1.0f);
+    Frame(white);  // The first frame settles window size and position.
+
+    EXPECT_TRUE(gate.ShouldPresent(Frame(white)));
+    EXPECT_FALSE(gate.ShouldPresent(Frame(white)));
+    EXPECT_FALSE(gate.ShouldPresent(Frame(white)));
+    EXPECT_EQ(gate.PresentedFrames(), 1u);
+    EXPECT_EQ(gate.ElidedFrames(), 2u);
+}
+
+TEST_F(PresentGateTest, VertexColorChangeIsPresented) {
+    ambidb::PresentGate gate;
+    Frame(ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    EXPECT_TRUE(gate.ShouldPresent(Frame(ImVec4(1.0f, 1.0f, 1.0f, 1.0f))));
+    EXPECT_TRUE(gate.ShouldPresent(Frame(ImVec4(1.0f, 0.0f, 0.0f, 1.0f))));
+}
+
+TEST_F(PresentGateTest, InvalidateForcesPresent) {
+    ambidb::PresentGate gate;
+    const ImVec4 white(1.0f, 1.0f, 1.0f, 1.0f);
+    Frame(white);
+
+    EXPECT_TRUE(gate.ShouldPresent(Frame(white)));
+    gate.Invalidate();
+    EXPECT_TRUE(gate.ShouldPresent(Frame(white)));
+    EXPECT_EQ(gate.ElidedFrames(), 0u);
+}
@@ -0,0 +1,383 @@
+#include <gtest/gtest.h>
+#include "db/query_executor.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using ambidb::db::DbEvent;
+using ambidb::db::QueryExecutor;
+using ambidb::db::QueryStatus;
+
+namespace {
+
+// Collects executor events on the test thread, the way App does once per frame.
+class EventLog {
+public:
+    void Notify() {
+        std::lock_guard lock(mutex_);
+        ++notifications_;
+        cv_.notify_all();
+    }
+
+    // Drains until an event of |kind| for |query| arrives or the timeout expires.
+    bool WaitFor(QueryExecutor& executor, DbEvent::Kind kind, ambidb::db::QueryId query = 0) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (std::chrono::steady_clock::now() < deadline) {
+            const size_t seen = events.size();
+            executor.DrainEvents(events);
+            for (size_t i = seen; i < events.size(); ++i) {
+                if (events[i].kind == kind && (query == 0 || events[i].query == query)) return true;
+            }
+            std::unique_lock lock(mutex_);
+            cv_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    const DbEvent* Last(DbEvent::Kind kind) const {
+        for (auto it = events.rbegin(); it != events.rend(); ++it) {
+            if (it->kind == kind) return &*it;
+        }
+        return nullptr;
+    }
+
+    std::vector<DbEvent> events;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int notifications_ = 0;
+};
+
+}  // namespace
+
+TEST(QueryExecutorTest, StreamsRowsFromSqlite) {
+    EventLog log;
+    QueryExecutor executor(2, [&] { log.Notify(); });
+
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+
+    const auto setup = executor.Execute(conn,
+        "CREATE TABLE t(id INTEGER, name TEXT, score REAL);"
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 1500)"
+        "INSERT INTO t SELECT i, 'row ' || i, i * 0.5 FROM n;");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, setup));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Ok);
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->rowsAffected, 1500);
+
+    log.events.clear();
+    const auto select = executor.Execute(conn, "SELECT id, name, score, NULL FROM t ORDER BY id");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, select));
+
+    size_t rows = 0;
+    size_t batches = 0;
+    for (const DbEvent& event : log.events) {
+        if (event.kind == DbEvent::Kind::QueryColumns) {
+            ASSERT_EQ(event.columns.size(), 4u);
+            EXPECT_EQ(event.columns[1].name, "name");
+        }
+        if (event.kind == DbEvent::Kind::QueryRows) {
+            if (rows == 0) {
+                EXPECT_EQ(std::get<int64_t>(event.rows.At(0, 0)), 1);
+                EXPECT_EQ(std::get<std::string>(event.rows.At(0, 1)), "row 1");
+                EXPECT_DOUBLE_EQ(std::get<double>(event.rows.At(0, 2)), 0.5);
+                EXPECT_TRUE(std::holds_alternative<std::monostate>(event.rows.At(0, 3)));
+            }
+            rows += event.rows.RowCount();
+            ++batches;
+        }
+    }
+    EXPECT_EQ(rows, 1500u);
+    EXPECT_GE(batches, 1500u / QueryExecutor::kBatchRows);
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Ok);
+}
+
+TEST(QueryExecutorTest, ReportsErrorsAndUnknownDrivers) {
+    EventLog log;
+    QueryExecutor executor(1, [&] { log.Notify(); });
+
+    executor.Open({"postgresql", "localhost"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::ConnectFailed));
+
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+    const auto query = executor.Execute(conn, "SELECT * FROM missing_table");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, query));
+    const DbEvent* finished = log.Last(DbEvent::Kind::QueryFinished);
+    EXPECT_EQ(finished->status, QueryStatus::Failed);
+    EXPECT_NE(finished->error.find("missing_table"), std::string::npos);
+}
+
+TEST(QueryExecutorTest, RejectsJobsForUnknownConnectionsWithoutRunningThem) {
+    EventLog log;
+    QueryExecutor executor(1, [&] { log.Notify(); });
+
+    // The failure is pushed before Execute returns; nothing is run on this thread.
+    const auto query = executor.Execute(42, "SELECT 1");
+    std::vector<DbEvent> events;
+    executor.DrainEvents(events);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].kind, DbEvent::Kind::QueryFinished);
+    EXPECT_EQ(events[0].query, query);
+    EXPECT_EQ(events[0].status, QueryStatus::Failed);
+    EXPECT_EQ(events[0].error, "Not connected");
+
+    executor.Close(42);
+    events.clear();
+    executor.DrainEvents(events);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].kind, DbEvent::Kind::Closed);
+}
+
+TEST(QueryExecutorTest, CancelInterruptsRunningQuery) {
+    EventLog log;
+    QueryExecutor executor(1, [&] { log.Notify(); });
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+
+    // Runs for minutes unless interrupted.
+    const auto query = executor.Execute(conn,
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n) SELECT count(*) FROM n");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryColumns, query));
+    executor.Cancel(query);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, query));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Cancelled);
+
+    // The connection stays usable.
+    const auto next = executor.Execute(conn, "SELECT 1");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, next));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Ok);
+}
+
+TEST(QueryExecutorTest, WindowedQueryFetchesPagesOnDemand) {
+    EventLog log;
+    QueryExecutor executor(1, [&] { log.Notify(); });
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+
+    const auto query = executor.ExecuteWindowed(conn,
+        "WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < 9999) SELECT i FROM n", 100);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, query));
+    const DbEvent* first = log.Last(DbEvent::Kind::QueryPage);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->rows.RowCount(), 100u);
+    EXPECT_FALSE(first->endOfData);
+
+    // Forward, then backward (served from the rows already read), then past the end.
+    for (size_t row : {5000u, 200u}) {
+        log.events.clear();
+        executor.FetchRows(query, row, 50);
+        ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryPage, query));
+        const DbEvent* page = log.Last(DbEvent::Kind::QueryPage);
+        ASSERT_EQ(page->rows.RowCount(), 50u);
+        EXPECT_EQ(std::get<int64_t>(page->rows.At(0, 0)), static_cast<int64_t>(row));
+        EXPECT_TRUE(page->error.empty());
+    }
+
+    log.events.clear();
+    executor.FetchRows(query, 20000, 50);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryPage, query));
+    const DbEvent* end = log.Last(DbEvent::Kind::QueryPage);
+    EXPECT_TRUE(end->endOfData);
+    EXPECT_EQ(end->firstRow + end->rows.RowCount(), 10000u);
+
+    executor.Release(query);
+    log.events.clear();
+    executor.FetchRows(query, 0, 10);
+    const auto next = executor.Execute(conn, "SELECT 1");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, next));
+    // The fetch is either dropped or finds the cursor closed; it never returns rows.
+    if (const DbEvent* closed = log.Last(DbEvent::Kind::QueryPage)) {
+        EXPECT_FALSE(closed->error.empty());
+        EXPECT_EQ(closed->rows.RowCount(), 0u);
+    }
+}
+
+TEST(QueryExecutorTest, WindowedPagesAreReadOnce) {
+    EventLog log;
+    QueryExecutor executor(1, [&] { log.Notify(); });
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+
+    // random () differs on every run, so a re-executed statement would show new values.
+    const auto query = executor.ExecuteWindowed(conn,
+        "WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < 4999) SELECT i, random() FROM n", 100);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, query));
+    ASSERT_TRUE(log.Last(DbEvent::Kind::QueryColumns)->windowed);
+    const int64_t firstValue = std::get<int64_t>(log.Last(DbEvent::Kind::QueryPage)->rows.At(10, 1));
+
+    log.events.clear();
+    executor.FetchRows(query, 3000, 50);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryPage, query));
+    log.events.clear();
+    executor.FetchRows(query, 0, 50);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryPage, query));
+    const DbEvent* page = log.Last(DbEvent::Kind::QueryPage);
+    ASSERT_EQ(page->rows.RowCount(), 50u);
+    EXPECT_EQ(std::get<int64_t>(page->rows.At(10, 1)), firstValue);
+    executor.Release(query);
+}
+
+TEST(QueryExecutorTest, WritingStatementsAreNotWindowed) {
+    EventLog log;
+    QueryExecutor executor(1, [&] { log.Notify(); });
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+
+    const auto setup = executor.Execute(conn,
+        "CREATE TABLE t(i INTEGER);"
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 3000) INSERT INTO t SELECT i FROM n");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, setup));
+
+    log.events.clear();
+    const auto remove = executor.ExecuteWindowed(conn, "DELETE FROM t WHERE i > 1000 RETURNING i", 100);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, remove));
+    ASSERT_FALSE(log.Last(DbEvent::Kind::QueryColumns)->windowed);
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryPage), nullptr);
+    size_t rows = 0;
+    for (const DbEvent& event : log.events) {
+        if (event.kind == DbEvent::Kind::QueryRows) rows += event.rows.RowCount();
+    }
+    EXPECT_EQ(rows, 2000u);
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Ok);
+
+    // The statement is finished, so nothing holds the database open.
+    const auto check = executor.Execute(conn, "SELECT count(*) FROM t");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, check));
+    EXPECT_EQ(std::get<int64_t>(log.Last(DbEvent::Kind::QueryRows)->rows.At(0, 0)), 1000);
+}
+
+TEST(QueryExecutorTest, ExportsStraightFromTheCursor) {
+    EventLog log;
+    QueryExecutor executor(2, [&] { log.Notify(); });
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+
+    const std::string path = testing::TempDir() + "executor_export.csv";
+    auto exporter = ambidb::db::Exporter::Create(ambidb::db::ExportFormat::Csv, path);
+    ASSERT_TRUE(exporter.has_value());
+    std::shared_ptr<ambidb::db::Exporter> shared = std::move(*exporter);
+    const auto query = executor.Export(conn,
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 20000) SELECT i, 'row ' || i FROM n",
+        shared);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, query));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Ok);
+    // The rows went to the file, not to the UI.
+    for (const DbEvent& event : log.events) EXPECT_NE(event.kind, DbEvent::Kind::QueryRows);
+    ASSERT_TRUE(shared->Done());
+    EXPECT_EQ(shared->Rows(), 20000u);
+
+    std::ifstream in(path);
+    std::string line, last;
+    size_t lines = 0;
+    while (std::getline(in, line)) {
+        last = line;
+        ++lines;
+    }
+    EXPECT_EQ(lines, 20001u);
+    EXPECT_EQ(last, "20000,row 20000");
+
+    log.events.clear();
+    auto failing = ambidb::db::Exporter::Create(ambidb::db::ExportFormat::Csv, path);
+    ASSERT_TRUE(failing.has_value());
+    shared = std::move(*failing);
+    const auto bad = executor.Export(conn, "SELECT * FROM missing", shared);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, bad));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Failed);
+    EXPECT_NE(shared->Error().find("missing"), std::string::npos);
+}
+
+TEST(QueryExecutorTest, ImportsCsvIntoATable) {
+    EventLog log;
+    QueryExecutor executor(2, [&] { log.Notify(); });
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+    const auto setup = executor.Execute(conn, "CREATE TABLE t(id INTEGER, name TEXT, score REAL)");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, setup));
+
+    // Columns in another order than the table's, matched by the header.
+    const std::string path = testing::TempDir() + "executor_import.csv";
+    {
+        std::ofstream out(path);
+        out << "name,id,score\n";
+        for (int i = 1; i <= 30000; ++i) out << "\"row, " << i << "\"," << i << ',' << i * 0.5 << '\n';
+    }
+    ambidb::db::ImportOptions options;
+    options.table = "t";
+    auto importer = ambidb::db::Importer::Create(path, options);
+    ASSERT_TRUE(importer.has_value());
+    std::shared_ptr<ambidb::db::Importer> shared = std::move(*importer);
+    const auto load = executor.Import(conn, shared);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, load));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Ok);
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->rowsAffected, 30000);
+    EXPECT_TRUE(shared->Done());
+
+    log.events.clear();
+    const auto check = executor.Execute(conn, "SELECT count(*), sum(id), max(score), min(name) FROM t");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, check));
+    const DbEvent* rows = log.Last(DbEvent::Kind::QueryRows);
+    ASSERT_NE(rows, nullptr);
+    EXPECT_EQ(rows->rows.At(0, 0), ambidb::db::Value{int64_t{30000}});
+    EXPECT_EQ(rows->rows.At(0, 1), ambidb::db::Value{int64_t{450015000}});
+    EXPECT_EQ(rows->rows.At(0, 2), ambidb::db::Value{15000.0});
+    EXPECT_EQ(rows->rows.At(0, 3), ambidb::db::Value{std::string("row, 1")});
+
+    // A failing load rolls back its open transaction.
+    log.events.clear();
+    options.table = "missing";
+    importer = ambidb::db::Importer::Create(path, options);
+    ASSERT_TRUE(importer.has_value());
+    shared = std::move(*importer);
+    const auto bad = executor.Import(conn, shared);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, bad));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Failed);
+    EXPECT_NE(shared->Error().find("missing"), std::string::npos);
+}
+
+TEST(QueryExecutorTest, LoadsAndRefreshesTheCatalog) {
+    EventLog log;
+    QueryExecutor executor(2, [&] { log.Notify(); });
+    const auto conn = executor.Open({"sqlite", ":memory:"});
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Connected));
+    const auto setup = executor.Execute(conn, "CREATE TABLE t(id INTEGER, name TEXT)");
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, setup));
+
+    auto cache = ambidb::db::SchemaCache::Open({});
+    const auto refresh = executor.RefreshCatalog(conn, cache);
+    EXPECT_TRUE(cache->Busy());
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, refresh));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Ok);
+    EXPECT_TRUE(cache->Loaded());
+    EXPECT_FALSE(cache->Busy());
+
+    const auto path = cache->Toggle(0, ambidb::db::SchemaCache::kNone, true);
+    ASSERT_TRUE(path.has_value());
+    EXPECT_EQ(path->schema, "main");
+    const auto load = executor.LoadCatalog(conn, cache, *path);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, load));
+    std::vector<ambidb::db::SchemaCache::Row> rows;
+    cache->Rows(rows);
+    ASSERT_EQ(rows.size(), 2u);
+    EXPECT_EQ(rows[1].name, "t");
+    EXPECT_EQ(rows[1].detail, "table");
+
+    // A closed connection fails the job and clears the loading mark.
+    executor.Close(conn);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::Closed));
+    const auto columns = cache->Toggle(0, 0, true);
+    ASSERT_TRUE(columns.has_value());
+    const auto failed = executor.LoadCatalog(conn, cache, *columns);
+    ASSERT_TRUE(log.WaitFor(executor, DbEvent::Kind::QueryFinished, failed));
+    EXPECT_EQ(log.Last(DbEvent::Kind::QueryFinished)->status, QueryStatus::Failed);
+    EXPECT_FALSE(cache->Busy());
+    EXPECT_EQ(cache->Error(), "Not connected");
+    cache->Rows(rows);
+    EXPECT_FALSE(rows[1].expanded);
+}
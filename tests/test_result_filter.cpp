@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "db/result_filter.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using ambidb::db::FilterRows;
+using ambidb::db::FindCaseless;
+using ambidb::db::ResultSet;
+using ambidb::db::RowBatch;
+using ambidb::db::RowFilter;
+using ambidb::db::Value;
+
+TEST(ResultFilterTest, FindCaselessMatchesScalarSearch) {
+    std::mt19937 rng(7);
+    const std::string alphabet = "abAB-\x80\xc3";
+    for (int round = 0; round < 2000; ++round) {
+        std::string haystack(rng() % 100, ' ');
+        for (char& c : haystack) c = alphabet[rng() % alphabet.size()];
+        std::string needle(1 + rng() % 4, ' ');
+        for (char& c : needle) c = "ab-\x80"[rng() % 4];
+
+        std::string lowered = haystack;
+        for (char& c : lowered) c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+        EXPECT_EQ(FindCaseless(haystack, needle), lowered.find(needle)) << haystack << " / " << needle;
+    }
+}
+
+TEST(ResultFilterTest, ParsesIncludeAndExcludeTerms) {
+    const RowFilter filter(" Foo, -bar ,,-, baz");
+    ASSERT_EQ(filter.Terms().size(), 3u);
+    EXPECT_TRUE(filter.Pass("xFOOx"));
+    EXPECT_TRUE(filter.Pass("baz"));
+    EXPECT_FALSE(filter.Pass("foo bar"));
+    EXPECT_FALSE(filter.Pass("qux"));
+    EXPECT_TRUE(RowFilter("-bar").Pass("qux"));
+}
+
+TEST(ResultFilterTest, FiltersEveryColumnTypeInOrder) {
+    constexpr size_t kRows = 150000;  // Spans three row groups.
+    ResultSet rs;
+    rs.Reset({{"id", ""}, {"name", ""}, {"score", ""}});
+    RowBatch batch;
+    batch.columnCount = 3;
+    for (size_t row = 0; row < kRows; ++row) {
+        batch.values.push_back(static_cast<int64_t>(row));
+        batch.values.push_back(row % 5 == 0 ? Value{} : Value{std::string(row % 2 ? "Alpha" : "beta") + std::to_string(row % 10)});
+        batch.values.push_back(static_cast<double>(row) / 4.0);
+    }
+    rs.Append(batch);
+
+    // "alpha" but no row whose text contains "3"; NULL names never match.
+    const RowFilter filter("ALPHA, -3");
+    std::vector<uint32_t> expected;
+    for (uint32_t row = 0; row < kRows; ++row) {
+        const bool alpha = row % 2 == 1 && row % 5 != 0;
+        char score[32];
+        std::snprintf(score, sizeof(score), "%.15g", static_cast<double>(row) / 4.0);
+        const bool three = std::to_string(row).find('3') != std::string::npos ||
+                           std::string(score).find('3') != std::string::npos || (row % 5 != 0 && row % 10 == 3);
+        if (alpha && !three) expected.push_back(row);
+    }
+    const auto rows = FilterRows(rs, filter, {}, {}, 3);
+    ASSERT_TRUE(rows.has_value());
+    EXPECT_EQ(*rows, expected);
+
+    // With a display order the passing rows keep that order.
+    std::vector<uint32_t> order(kRows);
+    for (uint32_t i = 0; i < kRows; ++i) order[i] = static_cast<uint32_t>(kRows - 1 - i);
+    const auto reversed = FilterRows(rs, filter, order, {}, 2);
+    ASSERT_TRUE(reversed.has_value());
+    EXPECT_EQ(std::vector<uint32_t>(reversed->rbegin(), reversed->rend()), expected);
+
+    std::stop_source source;
+    source.request_stop();
+    EXPECT_FALSE(FilterRows(rs, filter, {}, source.get_token()).has_value());
+}
+
+TEST(ResultFilterTest, RefinesOnlyNarrowerFilters) {
+    EXPECT_TRUE(RowFilter("alph").Refines(RowFilter("al")));
+    EXPECT_TRUE(RowFilter("al, -x").Refines(RowFilter("al")));
+    EXPECT_TRUE(RowFilter("al").Refines(RowFilter("")));
+    EXPECT_TRUE(RowFilter("-x").Refines(RowFilter("-xy")));
+    EXPECT_FALSE(RowFilter("-xy").Refines(RowFilter("-x")));
+    EXPECT_FALSE(RowFilter("al, be").Refines(RowFilter("al")));
+    EXPECT_FALSE(RowFilter("-x").Refines(RowFilter("al")));
+    EXPECT_FALSE(RowFilter("al").Refines(RowFilter("al, -x")));
+}
+
+TEST(ResultFilterTest, RefiningASelectionMatchesAFullScan) {
+    constexpr size_t kRows = 140000;
+    ResultSet rs;
+    rs.Reset({{"name", ""}, {"n", ""}});
+    RowBatch batch;
+    batch.columnCount = 2;
+    for (size_t row = 0; row < kRows; ++row) {
+        batch.values.push_back(Value{"item-" + std::to_string(row * 7919 % 100003)});
+        batch.values.push_back(static_cast<int64_t>(row));
+    }
+    rs.Append(batch);
+
+    // Each step narrows the last one, down to a handful of rows per group.
+    std::vector<uint32_t> previous;
+    bool first = true;
+    for (const char* pattern : {"item-1", "item-12", "item-123", "item-123, -4", "item-1235, -4"}) {
+        const RowFilter filter(pattern);
+        const auto full = FilterRows(rs, filter, {}, {}, 2);
+        ASSERT_TRUE(full.has_value());
+        if (!first) {
+            const auto refined = FilterRows(rs, filter, previous, {}, 2);
+            ASSERT_TRUE(refined.has_value());
+            EXPECT_EQ(*refined, *full) << pattern;
+        }
+        previous = *full;
+        first = false;
+    }
+    EXPECT_FALSE(previous.empty());
+}
+
+TEST(ResultFilterTest, FiltersGroupsSealedEarly) {
+    // A small arena limit seals groups every few dozen rows, at rows that are no multiple of 64.
+    constexpr size_t kRows = 5000;
+    ResultSet rs;
+    rs.SetArenaLimit(700);
+    rs.Reset({{"name", ""}, {"n", ""}});
+    RowBatch batch;
+    batch.columnCount = 2;
+    for (size_t row = 0; row < kRows; ++row) {
+        batch.values.push_back(Value{std::string(row % 3 ? "keep-" : "drop-") + std::to_string(row)});
+        batch.values.push_back(static_cast<int64_t>(row));
+    }
+    rs.Append(batch);
+    ASSERT_GT(rs.GroupCount(), 50u);
+    EXPECT_NE(rs.Chunk(1, 0).firstRow % 64, 0u);
+
+    const RowFilter filter("keep, -7");
+    std::vector<uint32_t> expected;
+    for (uint32_t row = 0; row < kRows; ++row) {
+        if (row % 3 && std::to_string(row).find('7') == std::string::npos) expected.push_back(row);
+    }
+    for (size_t threads : {1u, 4u}) {
+        const auto rows = FilterRows(rs, filter, {}, {}, threads);
+        ASSERT_TRUE(rows.has_value());
+        EXPECT_EQ(*rows, expected) << threads;
+    }
+
+    // A selection covering every other row goes through the sparse path.
+    std::vector<uint32_t> order;
+    for (uint32_t row = 0; row < kRows; row += 2) order.push_back(row);
+    std::vector<uint32_t> narrowed;
+    for (const uint32_t row : expected) {
+        if (row % 2 == 0) narrowed.push_back(row);
+    }
+    const auto refined = FilterRows(rs, filter, order, {}, 4);
+    ASSERT_TRUE(refined.has_value());
+    EXPECT_EQ(*refined, narrowed);
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include "db/result_set.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using ambidb::db::Blob;
+using ambidb::db::ColumnType;
+using ambidb::db::MemoryBudget;
+using ambidb::db::ResultSet;
+using ambidb::db::RowBatch;
+using ambidb::db::Value;
+
+namespace {
+
+RowBatch MakeBatch(size_t columns, std::vector<Value> values) {
+    RowBatch batch;
+    batch.columnCount = columns;
+    batch.values = std::move(values);
+    return batch;
+}
+
+}  // namespace
+
+TEST(ResultSetTest, StoresTypedColumnsAndNulls) {
+    ResultSet rs;
+    rs.Reset({{"id", ""}, {"score", ""}, {"name", ""}, {"data", ""}});
+    rs.Append(MakeBatch(4, {int64_t{1}, 0.5, std::string("alpha"), Blob{{1, 2, 3}},
+                            Value{}, 1.25, Value{}, Value{},
+                            int64_t{3}, Value{}, std::string(""), Blob{{}}}));
+
+    ASSERT_EQ(rs.RowCount(), 3u);
+    EXPECT_EQ(rs.Type(0), ColumnType::Integer);
+    EXPECT_EQ(rs.Type(1), ColumnType::Real);
+    EXPECT_EQ(rs.Type(2), ColumnType::Text);
+    EXPECT_EQ(rs.Type(3), ColumnType::Blob);
+
+    EXPECT_EQ(rs.Integer(2, 0), 3);
+    EXPECT_TRUE(rs.IsNull(1, 0));
+    EXPECT_FALSE(rs.IsNull(1, 1));
+    EXPECT_DOUBLE_EQ(rs.Real(1, 1), 1.25);
+    EXPECT_DOUBLE_EQ(rs.Real(0, 0), 1.0);
+    EXPECT_EQ(rs.Text(0, 2), "alpha");
+    EXPECT_EQ(rs.Text(2, 2), "");
+    EXPECT_TRUE(rs.IsNull(1, 2));
+
+    char scratch[64];
+    EXPECT_STREQ(rs.FormatCell(1, 0, scratch, sizeof(scratch)), "NULL");
+    EXPECT_STREQ(rs.FormatCell(2, 0, scratch, sizeof(scratch)), "3");
+    EXPECT_STREQ(rs.FormatCell(0, 3, scratch, sizeof(scratch)), "<blob 3 bytes>");
+    // Text cells come straight from the arena.
+    EXPECT_EQ(rs.FormatCell(0, 2, scratch, sizeof(scratch)), rs.Text(0, 2).data());
+}
+
+TEST(ResultSetTest, WidensColumnsWhenLaterValuesDoNotFit) {
+    ResultSet rs;
+    rs.Reset({{"a", ""}, {"b", ""}, {"c", ""}});
+    rs.Append(MakeBatch(3, {int64_t{1}, int64_t{7}, Value{}}));
+    rs.Append(MakeBatch(3, {2.5, std::string("x"), int64_t{4}}));
+
+    EXPECT_EQ(rs.Type(0), ColumnType::Real);
+    EXPECT_DOUBLE_EQ(rs.Real(0, 0), 1.0);
+    EXPECT_DOUBLE_EQ(rs.Real(1, 0), 2.5);
+
+    EXPECT_EQ(rs.Type(1), ColumnType::Text);
+    EXPECT_EQ(rs.Text(0, 1), "7");
+    EXPECT_EQ(rs.Text(1, 1), "x");
+
+    EXPECT_EQ(rs.Type(2), ColumnType::Integer);
+    EXPECT_TRUE(rs.IsNull(0, 2));
+    EXPECT_EQ(rs.Integer(1, 2), 4);
+}
+
+TEST(ResultSetTest, SpansRowGroupsAndStaysCloseToRawSize) {
+    constexpr size_t kRows = 200000;
+    constexpr size_t kBatch = 512;
+    ResultSet rs;
+    rs.Reset({{"id", ""}, {"code", ""}});
+
+    for (size_t first = 0; first < kRows; first += kBatch) {
+        RowBatch batch;
+        batch.columnCount = 2;
+        for (size_t row = first; row < std::min(kRows, first + kBatch); ++row) {
+            batch.values.emplace_back(static_cast<int64_t>(row));
+            batch.values.emplace_back(std::string("code") + std::to_string(row % 10000 + 10000));
+        }
+        rs.Append(batch);
+    }
+
+    ASSERT_EQ(rs.RowCount(), kRows);
+    EXPECT_EQ(rs.GroupCount(), (kRows + ResultSet::kGroupRows - 1) / ResultSet::kGroupRows);
+    for (size_t row : {size_t{0}, size_t{65535}, size_t{65536}, size_t{123457}, kRows - 1}) {
+        EXPECT_EQ(rs.Integer(row, 0), static_cast<int64_t>(row));
+        EXPECT_EQ(rs.Text(row, 1), "code" + std::to_string(row % 10000 + 10000));
+    }
+
+    const auto chunk = rs.Chunk(1, 0);
+    EXPECT_EQ(chunk.firstRow, ResultSet::kGroupRows);
+    EXPECT_EQ(chunk.integers.size(), ResultSet::kGroupRows);
+    EXPECT_EQ(chunk.integers[0], static_cast<int64_t>(ResultSet::kGroupRows));
+
+    // 8 bytes per id, 9 string bytes + NUL + a 4-byte offset per code, two null bits.
+    const size_t raw = kRows * (8 + 10 + 4) + kRows / 4;
+    EXPECT_LT(rs.MemoryBytes(), raw + raw / 4);
+}
+
+TEST(ResultSetTest, SpillsFullGroupsWhileOverBudget) {
+    constexpr size_t kRows = 3 * ResultSet::kGroupRows + 100;
+    MemoryBudget& budget = MemoryBudget::Process();
+    const size_t limit = budget.Limit();
+    budget.SetLimit(0);
+
+    ResultSet rs;
+    rs.Reset({{"id", ""}, {"name", ""}});
+    for (size_t first = 0; first < kRows; first += 1000) {
+        RowBatch batch;
+        batch.columnCount = 2;
+        for (size_t row = first; row < std::min(kRows, first + 1000); ++row) {
+            batch.values.emplace_back(static_cast<int64_t>(row));
+            batch.values.emplace_back(std::string("n") + std::to_string(row));
+        }
+        rs.Append(batch);
+    }
+
+    // Everything but the open group is on disk.
+    EXPECT_EQ(rs.SpilledGroups(), rs.GroupCount() - 1);
+    EXPECT_GT(rs.SpilledBytes(), 3 * ResultSet::kGroupRows * 8);
+    EXPECT_LT(rs.MemoryBytes(), 100 * 64);
+    EXPECT_EQ(rs.Integer(12345, 0), 12345);
+    EXPECT_EQ(rs.Text(70000, 1), "n70000");
+    EXPECT_EQ(rs.Chunk(1, 0).integers[1], static_cast<int64_t>(ResultSet::kGroupRows + 1));
+
+    // Widening a column rewrites spilled groups too, without counting the old copies.
+    const size_t spilledBefore = rs.SpilledBytes();
+    rs.Append(MakeBatch(2, {std::string("x"), Value{}}));
+    EXPECT_EQ(rs.Type(0), ColumnType::Text);
+    EXPECT_EQ(rs.Text(12345, 0), "12345");
+    EXPECT_EQ(rs.Text(kRows, 0), "x");
+    EXPECT_EQ(rs.SpilledGroups(), rs.GroupCount() - 1);
+    EXPECT_GT(rs.SpilledBytes(), spilledBefore);
+    EXPECT_LT(rs.SpilledBytes(), 2 * spilledBefore);
+
+    rs.Reset({});
+    EXPECT_EQ(rs.SpilledBytes(), 0u);
+    EXPECT_EQ(budget.Resident(), 0u);
+    budget.SetLimit(limit);
+}
+
+TEST(ResultSetTest, SpillFileReusesReleasedRanges) {
+    ambidb::db::SpillFile file;
+    const std::vector<std::byte> data(10000, std::byte{7});
+    const std::span<const std::byte> part(data);
+    std::vector<size_t> offsets;
+
+    auto first = file.Write({&part, 1}, offsets);
+    auto second = file.Write({&part, 1}, offsets);
+    ASSERT_TRUE(first.has_value());
+    ASSERT_TRUE(second.has_value());
+    const size_t size = file.Size();
+    EXPECT_EQ(file.LiveBytes(), 2 * data.size());
+
+    const size_t offset = first->Offset();
+    file.Release(std::move(*first));
+    EXPECT_EQ(file.LiveBytes(), data.size());
+
+    auto third = file.Write({&part, 1}, offsets);
+    ASSERT_TRUE(third.has_value());
+    EXPECT_EQ(third->Offset(), offset);
+    EXPECT_EQ(file.Size(), size);
+    EXPECT_EQ(third->Data()[9999], std::byte{7});
+    EXPECT_EQ(file.LiveBytes(), 2 * data.size());
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "db/result_sort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using ambidb::db::ResultSet;
+using ambidb::db::RowBatch;
+using ambidb::db::SortKey;
+using ambidb::db::SortRows;
+using ambidb::db::Value;
+
+namespace {
+
+// Rows of (integer with NULLs, real, text sharing long prefixes).
+ResultSet MakeResults(size_t rows, std::vector<Value>& cells) {
+    std::mt19937_64 rng(42);
+    ResultSet rs;
+    rs.Reset({{"i", ""}, {"r", ""}, {"t", ""}});
+    RowBatch batch;
+    batch.columnCount = 3;
+    for (size_t row = 0; row < rows; ++row) {
+        const uint64_t x = rng();
+        batch.values.push_back(x % 7 == 0 ? Value{} : Value{static_cast<int64_t>(x % 1000) - 500});
+        batch.values.push_back(static_cast<double>(static_cast<int64_t>(x >> 20) % 2000) / 8.0 - 100.0);
+        batch.values.push_back(std::string("https://example.com/") + std::to_string(x % 500) +
+                               (x % 3 ? "" : std::string(1, '\0')));
+    }
+    cells = batch.values;
+    rs.Append(batch);
+    return rs;
+}
+
+// SQLite-style comparison: NULL lowest, then by value.
+bool Less(const Value& a, const Value& b) {
+    if (a.index() == 0 || b.index() == 0) return a.index() == 0 && b.index() != 0;
+    if (const auto* text = std::get_if<std::string>(&a)) return *text < std::get<std::string>(b);
+    if (const auto* real = std::get_if<double>(&a)) return *real < std::get<double>(b);
+    return std::get<int64_t>(a) < std::get<int64_t>(b);
+}
+
+std::vector<uint32_t> Reference(const std::vector<Value>& cells, size_t rows, const std::vector<SortKey>& keys) {
+    std::vector<uint32_t> order(rows);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        for (const SortKey& key : keys) {
+            const Value& x = cells[a * 3 + key.column];
+            const Value& y = cells[b * 3 + key.column];
+            if (Less(x, y)) return !key.descending;
+            if (Less(y, x)) return key.descending;
+        }
+        return false;
+    });
+    return order;
+}
+
+}  // namespace
+
+TEST(ResultSortTest, MatchesStableSortForEveryColumnType) {
+    constexpr size_t kRows = 100000;
+    std::vector<Value> cells;
+    const ResultSet rs = MakeResults(kRows, cells);
+
+    const std::vector<std::vector<SortKey>> cases = {
+        {{0, false}},
+        {{1, true}},
+        {{2, false}},
+        {{0, true}, {2, true}},
+        {{2, false}, {1, false}, {0, true}},
+    };
+    for (const auto& keys : cases) {
+        const auto order = SortRows(rs, keys, {}, 4);
+        ASSERT_TRUE(order.has_value());
+        EXPECT_EQ(*order, Reference(cells, kRows, keys)) << "first key column " << keys[0].column;
+    }
+}
+
+TEST(ResultSortTest, StopsWhenCancelled) {
+    std::vector<Value> cells;
+    const ResultSet rs = MakeResults(1000, cells);
+    std::stop_source source;
+    source.request_stop();
+    const std::vector<SortKey> keys = {{0, false}};
+    EXPECT_FALSE(SortRows(rs, keys, source.get_token()).has_value());
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include "db/schema_cache.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ambidb::db::CatalogEntry;
+using ambidb::db::CatalogPath;
+using ambidb::db::Connection;
+using ambidb::db::DbResult;
+using ambidb::db::SchemaCache;
+
+namespace {
+
+// Counts the catalog calls made through it.
+class CountingConnection final : public Connection {
+public:
+    explicit CountingConnection(std::unique_ptr<Connection> inner) : inner_(std::move(inner)) {}
+
+    DbResult<std::unique_ptr<ambidb::db::Cursor>> Execute(std::string_view sql) override { return inner_->Execute(sql); }
+    DbResult<std::vector<CatalogEntry>> ListSchemas() override {
+        ++schemas;
+        return inner_->ListSchemas();
+    }
+    DbResult<std::vector<CatalogEntry>> ListTables(std::string_view schema) override {
+        ++tables;
+        return inner_->ListTables(schema);
+    }
+    DbResult<std::vector<CatalogEntry>> ListColumns(std::string_view schema, std::string_view table) override {
+        columns.emplace_back(table);
+        return inner_->ListColumns(schema, table);
+    }
+    void Interrupt() override { inner_->Interrupt(); }
+    void Close() override { inner_->Close(); }
+
+    int schemas = 0;
+    int tables = 0;
+    std::vector<std::string> columns;
+
+private:
+    std::unique_ptr<Connection> inner_;
+};
+
+std::unique_ptr<CountingConnection> OpenDatabase(const std::string& sql) {
+    auto connection = ambidb::db::FindDriver("sqlite")->Connect({"sqlite", ":memory:"});
+    EXPECT_TRUE(connection.has_value());
+    auto counting = std::make_unique<CountingConnection>(std::move(*connection));
+    EXPECT_TRUE(ambidb::db::RunStatement(*counting, sql).has_value());
+    return counting;
+}
+
+// The tree as "depth:name:detail" lines.
+std::vector<std::string> Tree(const SchemaCache& cache) {
+    std::vector<SchemaCache::Row> rows;
+    cache.Rows(rows);
+    std::vector<std::string> lines;
+    for (const auto& row : rows) lines.push_back(std::to_string(row.depth) + ":" + row.name + ":" + row.detail);
+    return lines;
+}
+
+// Expands a node and runs the load it asks for, as the executor would.
+void Expand(SchemaCache& cache, Connection& connection, uint32_t schema, uint32_t table) {
+    const std::optional<CatalogPath> path = cache.Toggle(schema, table, true);
+    ASSERT_TRUE(path.has_value());
+    ASSERT_TRUE(cache.Load(connection, *path).has_value());
+}
+
+}  // namespace
+
+TEST(SchemaCacheTest, LoadsLevelsLazilyAndRestoresTheSnapshot) {
+    const std::filesystem::path snapshot = std::filesystem::path(testing::TempDir()) / "catalog" / "lazy.schema";
+    std::filesystem::remove(snapshot);
+    auto db = OpenDatabase("CREATE TABLE orders(id INTEGER, total REAL); CREATE VIEW big AS SELECT * FROM orders WHERE total > 100");
+    {
+        auto cache = SchemaCache::Open(snapshot);
+        EXPECT_FALSE(cache->Loaded());
+        cache->Queued();
+        ASSERT_TRUE(cache->Refresh(*db).has_value());
+        EXPECT_EQ(Tree(*cache), (std::vector<std::string>{"0:main:"}));
+        EXPECT_EQ(db->tables, 0);
+
+        Expand(*cache, *db, 0, SchemaCache::kNone);
+        EXPECT_EQ(Tree(*cache), (std::vector<std::string>{"0:main:", "1:big:view", "1:orders:table"}));
+        Expand(*cache, *db, 0, 1);
+        EXPECT_EQ(Tree(*cache), (std::vector<std::string>{"0:main:", "1:big:view", "1:orders:table", "2:id:INTEGER", "2:total:REAL"}));
+        EXPECT_EQ(db->columns, (std::vector<std::string>{"orders"}));
+        EXPECT_FALSE(cache->Busy());
+
+        // Loaded levels expand again without a fetch.
+        EXPECT_FALSE(cache->Toggle(0, SchemaCache::kNone, true).has_value());
+        EXPECT_EQ(Tree(*cache), (std::vector<std::string>{"0:main:"}));
+        EXPECT_FALSE(cache->Toggle(0, SchemaCache::kNone, true).has_value());
+        // Not connected: an unloaded level stays collapsed.
+        EXPECT_FALSE(cache->Toggle(0, 0, false).has_value());
+        EXPECT_EQ(Tree(*cache).size(), 5u);
+    }
+
+    // Without a database, the snapshot brings back the tree as it was.
+    auto reopened = SchemaCache::Open(snapshot);
+    EXPECT_TRUE(reopened->Loaded());
+    EXPECT_EQ(Tree(*reopened), (std::vector<std::string>{"0:main:", "1:big:view", "1:orders:table", "2:id:INTEGER", "2:total:REAL"}));
+}
+
+TEST(SchemaCacheTest, SnapshotKeepsExpandAndCollapse) {
+    const std::filesystem::path snapshot = std::filesystem::path(testing::TempDir()) / "catalog" / "toggle.schema";
+    std::filesystem::remove(snapshot);
+    auto db = OpenDatabase("CREATE TABLE orders(id INTEGER, total REAL)");
+    {
+        auto cache = SchemaCache::Open(snapshot);
+        cache->Queued();
+        ASSERT_TRUE(cache->Refresh(*db).has_value());
+        Expand(*cache, *db, 0, SchemaCache::kNone);
+        Expand(*cache, *db, 0, 0);
+    }
+    {
+        // Nothing loads here: collapsing the table alone must reach the snapshot.
+        auto cache = SchemaCache::Open(snapshot);
+        const uint64_t content = cache->ContentGeneration();
+        EXPECT_FALSE(cache->Toggle(0, 0, false).has_value());
+        EXPECT_EQ(cache->ContentGeneration(), content);
+    }
+    auto reopened = SchemaCache::Open(snapshot);
+    EXPECT_EQ(Tree(*reopened), (std::vector<std::string>{"0:main:", "1:orders:table"}));
+}
+
+TEST(SchemaCacheTest, RevealExpandsLoadedLevelsOnly) {
+    auto db = OpenDatabase("CREATE TABLE orders(id INTEGER); CREATE TABLE users(name TEXT)");
+    auto cache = SchemaCache::Open({});
+    cache->Queued();
+    ASSERT_TRUE(cache->Refresh(*db).has_value());
+    Expand(*cache, *db, 0, SchemaCache::kNone);
+    Expand(*cache, *db, 0, 1);
+    // Collapse everything again; the loaded levels stay.
+    EXPECT_FALSE(cache->Toggle(0, 1, true).has_value());
+    EXPECT_FALSE(cache->Toggle(0, SchemaCache::kNone, true).has_value());
+    EXPECT_EQ(Tree(*cache), (std::vector<std::string>{"0:main:"}));
+
+    const uint64_t generation = cache->Generation();
+    const uint64_t content = cache->ContentGeneration();
+    cache->Reveal("main", "users");
+    EXPECT_EQ(Tree(*cache), (std::vector<std::string>{"0:main:", "1:orders:table", "1:users:table", "2:name:TEXT"}));
+    EXPECT_GT(cache->Generation(), generation);
+    EXPECT_EQ(cache->ContentGeneration(), content);
+
+    // The columns of orders were never fetched, so it stays collapsed and nothing loads.
+    cache->Reveal("main", "orders");
+    cache->Reveal("missing", "");
+    EXPECT_EQ(Tree(*cache).size(), 4u);
+    EXPECT_FALSE(cache->Busy());
+    EXPECT_EQ(db->columns, (std::vector<std::string>{"users"}));
+}
+
+TEST(SchemaCacheTest, RefreshFetchesOnlyWhatChanged) {
+    auto db = OpenDatabase("CREATE TABLE a(x); CREATE TABLE b(y)");
+    auto cache = SchemaCache::Open({});
+    cache->Queued();
+    ASSERT_TRUE(cache->Refresh(*db).has_value());
+    Expand(*cache, *db, 0, SchemaCache::kNone);
+    Expand(*cache, *db, 0, 0);
+    Expand(*cache, *db, 0, 1);
+    db->tables = 0;
+    db->columns.clear();
+
+    // Nothing changed: one schema listing and nothing else.
+    cache->Queued();
+    ASSERT_TRUE(cache->Refresh(*db).has_value());
+    EXPECT_EQ(db->tables, 0);
+    EXPECT_TRUE(db->columns.empty());
+
+    // Only the altered table's columns are fetched again.
+    ASSERT_TRUE(ambidb::db::RunStatement(*db, "ALTER TABLE b ADD COLUMN z TEXT; CREATE TABLE c(w)").has_value());
+    cache->Queued();
+    ASSERT_TRUE(cache->Refresh(*db).has_value());
+    EXPECT_EQ(db->tables, 1);
+    EXPECT_EQ(db->columns, (std::vector<std::string>{"b"}));
+    EXPECT_EQ(Tree(*cache), (std::vector<std::string>{"0:main:", "1:a:table", "2:x:", "1:b:table", "2:y:", "2:z:TEXT", "1:c:table"}));
+
+    // Dropped tables go; a failed refresh keeps the tree and reports why.
+    ASSERT_TRUE(ambidb::db::RunStatement(*db, "DROP TABLE a").has_value());
+    cache->Queued();
+    ASSERT_TRUE(cache->Refresh(*db).has_value());
+    EXPECT_EQ(Tree(*cache), (std::vector<std::string>{"0:main:", "1:b:table", "2:y:", "2:z:TEXT", "1:c:table"}));
+    db->Close();
+    cache->Queued();
+    EXPECT_FALSE(cache->Refresh(*db).has_value());
+    EXPECT_FALSE(cache->Busy());
+    EXPECT_FALSE(cache->Error().empty());
+    EXPECT_EQ(Tree(*cache).size(), 5u);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "search_index.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using ambidb::SearchHit;
+using ambidb::SearchIndex;
+using ambidb::SearchKind;
+
+namespace {
+
+std::vector<std::string> Texts(const std::vector<SearchHit>& hits) {
+    std::vector<std::string> texts;
+    for (const SearchHit& hit : hits) texts.push_back(hit.text);
+    return texts;
+}
+
+}  // namespace
+
+TEST(SearchIndexTest, RanksPrefixThenSubstringThenFuzzy) {
+    SearchIndex index;
+    index.Add(SearchKind::Connection, "staging_orders", 1);
+    index.Add(SearchKind::Connection, "Orders", 2);
+    index.Add(SearchKind::Connection, "ordres_archive", 3);
+    index.Add(SearchKind::Page, "Settings", 4);
+    index.Flush();
+    EXPECT_EQ(index.Size(), 4u);
+
+    std::vector<SearchHit> hits;
+    index.Search("ORDERS", 10, hits);
+    EXPECT_EQ(Texts(hits), (std::vector<std::string>{"Orders", "staging_orders"}));
+    EXPECT_EQ(hits[0].target, 2u);
+    EXPECT_EQ(hits[0].kind, SearchKind::Connection);
+
+    // A transposition still shares half the trigrams.
+    index.Search("ordres_arch", 10, hits);
+    ASSERT_FALSE(hits.empty());
+    EXPECT_EQ(hits[0].text, "ordres_archive");
+    index.Search("ordres_archve", 10, hits);
+    ASSERT_FALSE(hits.empty());
+    EXPECT_EQ(hits[0].text, "ordres_archive");
+
+    // Shorter than a trigram: plain substring scan.
+    index.Search("se", 10, hits);
+    EXPECT_EQ(Texts(hits), (std::vector<std::string>{"Settings"}));
+
+    index.Search("", 10, hits);
+    EXPECT_TRUE(hits.empty());
+}
+
+TEST(SearchIndexTest, RemovedEntriesDisappear) {
+    SearchIndex index;
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < 10000; ++i) ids.push_back(index.Add(SearchKind::History, "select * from table_" + std::to_string(i), i));
+    for (int i = 0; i < 9000; ++i) index.Remove(ids[i]);
+    index.Flush();
+    EXPECT_EQ(index.Size(), 1000u);
+
+    std::vector<SearchHit> hits;
+    index.Search("table_942", 5, hits);
+    ASSERT_FALSE(hits.empty());
+    EXPECT_EQ(hits[0].text, "select * from table_9420");
+    for (const SearchHit& hit : hits) EXPECT_GE(hit.target, 9000u);
+}
+
+TEST(SearchIndexTest, NotifiesAfterEachBatch) {
+    std::atomic<int> batches{0};
+    SearchIndex index([&] { ++batches; });
+    const uint64_t before = index.Generation();
+    for (size_t i = 0; i < SearchIndex::kBatchEntries + 1; ++i) index.Add(SearchKind::Page, "page " + std::to_string(i), i);
+    index.Flush();
+    EXPECT_GE(batches.load(), 2);
+    EXPECT_GE(index.Generation(), before + 2);
+}
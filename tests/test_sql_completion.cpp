@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "sql_completion.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using ambidb::Completion;
+using ambidb::CompletionContext;
+using ambidb::CompletionKind;
+using ambidb::SqlCompleter;
+using ambidb::db::CatalogPath;
+using ambidb::db::SchemaCache;
+
+namespace {
+
+class SqlCompletionTest : public testing::Test {
+protected:
+    void SetUp() override {
+        auto connection = ambidb::db::FindDriver("sqlite")->Connect({"sqlite", ":memory:"});
+        ASSERT_TRUE(connection.has_value());
+        db_ = std::move(*connection);
+        ASSERT_TRUE(ambidb::db::RunStatement(*db_,
+                                             "CREATE TABLE orders(id INTEGER, customer_id INTEGER, total REAL, created_at TEXT);"
+                                             "CREATE TABLE customers(id INTEGER, name TEXT, country TEXT);"
+                                             "CREATE TABLE \"order items\"(order_id INTEGER, quantity INTEGER)")
+                        .has_value());
+        cache_ = SchemaCache::Open({});
+        cache_->Queued();
+        ASSERT_TRUE(cache_->Refresh(*db_).has_value());
+    }
+
+    // Completes at the '|' in sql, loading whatever the completer asks for first.
+    std::vector<Completion> Complete(std::string sql) {
+        const size_t cursor = sql.find('|');
+        sql.erase(cursor, 1);
+        std::vector<Completion> out;
+        for (int pass = 0; pass < 3; ++pass) {
+            completer_.Update(cache_);
+            completer_.Flush();
+            completer_.Complete(sql, cursor, out, context_);
+            if (context_.missing.empty()) break;
+            for (const CatalogPath& path : context_.missing) {
+                if (const auto required = cache_->Require(path.schema, path.table)) {
+                    EXPECT_TRUE(cache_->Load(*db_, *required).has_value());
+                }
+            }
+        }
+        return out;
+    }
+
+    static std::vector<std::string> Texts(const std::vector<Completion>& completions, size_t count) {
+        std::vector<std::string> texts;
+        for (size_t i = 0; i < std::min(count, completions.size()); ++i) texts.push_back(completions[i].text);
+        return texts;
+    }
+
+    std::unique_ptr<ambidb::db::Connection> db_;
+    std::shared_ptr<SchemaCache> cache_;
+    SqlCompleter completer_;
+    CompletionContext context_;
+};
+
+}  // namespace
+
+TEST_F(SqlCompletionTest, CompletesTablesAfterFromAndLoadsThemOnDemand) {
+    const auto out = Complete("SELECT * FROM ord|");
+    EXPECT_TRUE(context_.tables);
+    EXPECT_EQ(context_.wordStart, 14u);
+    ASSERT_GE(out.size(), 2u);
+    EXPECT_EQ(out[0].text, "orders");
+    EXPECT_EQ(out[0].kind, CompletionKind::Table);
+    EXPECT_EQ(out[1].text, "\"order items\"");
+
+    // Right after a table, only keywords fit.
+    EXPECT_EQ(Texts(Complete("SELECT * FROM orders WH|"), 1), (std::vector<std::string>{"WHERE"}));
+    EXPECT_EQ(Texts(Complete("select * from orders o jo|"), 1), (std::vector<std::string>{"join"}));
+}
+
+TEST_F(SqlCompletionTest, ResolvesAliasesAnywhereInTheStatement) {
+    // The select list sees the tables named after it; "o." means orders only, in table order.
+    auto out = Complete("SELECT o.| FROM orders AS o JOIN customers c ON c.id = o.customer_id");
+    EXPECT_EQ(context_.qualifier, "o");
+    EXPECT_EQ(Texts(out, 10), (std::vector<std::string>{"id", "customer_id", "total", "created_at"}));
+
+    out = Complete("SELECT * FROM orders o JOIN customers c ON c.na|");
+    ASSERT_FALSE(out.empty());
+    EXPECT_EQ(out[0].text, "name");
+    EXPECT_EQ(out[0].detail, "TEXT");
+
+    // Unqualified: columns in scope outrank keywords and carry their table.
+    out = Complete("SELECT cou| FROM customers; SELECT * FROM orders");
+    ASSERT_FALSE(out.empty());
+    EXPECT_EQ(out[0].text, "country");
+    EXPECT_EQ(out[0].detail, "TEXT  customers");
+    EXPECT_TRUE(context_.missing.empty());
+
+    // Quoted names are matched unquoted and inserted quoted.
+    out = Complete("SELECT i.qu| FROM \"order items\" i");
+    ASSERT_FALSE(out.empty());
+    EXPECT_EQ(out[0].text, "quantity");
+    EXPECT_EQ(Texts(Complete("SELECT * FROM main.\"order items\" AS i WHERE |"), 1), (std::vector<std::string>{"i"}));
+}
+
+TEST_F(SqlCompletionTest, RanksFuzzyMatchesAfterPrefixes) {
+    const auto out = Complete("SELECT cid| FROM orders");
+    ASSERT_FALSE(out.empty());
+    EXPECT_EQ(out[0].text, "customer_id");
+    EXPECT_EQ(Texts(Complete("SELECT * FROM orders WHERE crat|"), 1), (std::vector<std::string>{"created_at"}));
+    EXPECT_TRUE(Complete("SELECT * FROM orders WHERE zzz|").empty());
+}
+
+TEST_F(SqlCompletionTest, ScoresABoundedShareOfLargeCatalogs) {
+    std::string ddl;
+    for (int table = 0; table < 500; ++table) {
+        ddl += "CREATE TABLE t" + std::to_string(table) + "(";
+        for (int column = 0; column < 100; ++column) ddl += (column ? ", c" : "c") + std::to_string(table * 100 + column) + " INTEGER";
+        ddl += ");";
+    }
+    ASSERT_TRUE(ambidb::db::RunStatement(*db_, ddl).has_value());
+    cache_->Queued();
+    ASSERT_TRUE(cache_->Refresh(*db_).has_value());
+    ASSERT_TRUE(cache_->Load(*db_, {"main", ""}).has_value());
+    for (int table = 0; table < 500; ++table) ASSERT_TRUE(cache_->Load(*db_, {"main", "t" + std::to_string(table)}).has_value());
+    completer_.Update(cache_);
+    completer_.Flush();
+    EXPECT_GT(completer_.Size(), 50000u);
+
+    // Prefix ranges and the capped fuzzy scan keep each call well short of the catalog.
+    std::vector<Completion> out;
+    for (const char* sql : {"SELECT c4999", "SELECT c12", "SELECT c4", "SELECT t49", "SELECT 49"}) {
+        completer_.Complete(sql, std::string(sql).size(), out, context_);
+        EXPECT_LT(completer_.Scored(), completer_.Size() / 2) << sql;
+        EXPECT_LE(out.size(), SqlCompleter::kMaxResults);
+    }
+    completer_.Complete("SELECT c4999", 12, out, context_);
+    ASSERT_FALSE(out.empty());
+    EXPECT_EQ(out[0].text, "c4999");
+}
+
+TEST_F(SqlCompletionTest, ReindexesOnlyWhenEntriesChange) {
+    completer_.Update(cache_);
+    completer_.Flush();
+    const uint64_t generation = completer_.Generation();
+    const size_t names = completer_.Size();
+
+    // Expanding and collapsing the tree keeps the index.
+    const uint64_t content = cache_->ContentGeneration();
+    const auto load = cache_->Toggle(0, SchemaCache::kNone, true);
+    ASSERT_TRUE(load.has_value());
+    EXPECT_EQ(cache_->ContentGeneration(), content);
+    completer_.Update(cache_);
+    completer_.Flush();
+    EXPECT_EQ(completer_.Generation(), generation);
+
+    // Loading a level reindexes; the new index is taken in once it is built.
+    ASSERT_TRUE(cache_->Load(*db_, *load).has_value());
+    EXPECT_GT(cache_->ContentGeneration(), content);
+    completer_.Update(cache_);
+    completer_.Flush();
+    EXPECT_GT(completer_.Generation(), generation);
+    EXPECT_GT(completer_.Size(), names);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "sql_lexer.h"
+
+#include <string>
+#include <vector>
+
+using ambidb::LexSqlLine;
+using ambidb::SqlDialect;
+using ambidb::SqlHighlighter;
+using ambidb::SqlLineState;
+using ambidb::SqlSpan;
+using ambidb::SqlToken;
+
+namespace {
+
+// Each span as "text:token" for readable expectations.
+std::vector<std::string> Describe(std::string_view line, const std::vector<SqlSpan>& spans) {
+    static const char* const kNames[] = {"plain", "keyword", "type", "function", "string", "number", "comment", "name", "operator", "parameter"};
+    std::vector<std::string> out;
+    for (const SqlSpan& span : spans) out.push_back(std::string(line.substr(span.begin, span.length)) + ":" + kNames[static_cast<int>(span.token)]);
+    return out;
+}
+
+std::vector<std::string> Lex(SqlDialect dialect, std::string_view line, SqlLineState& state) {
+    std::vector<SqlSpan> spans;
+    state = LexSqlLine(dialect, line, state, &spans);
+    return Describe(line, spans);
+}
+
+std::vector<std::string> Lex(SqlDialect dialect, std::string_view line) {
+    SqlLineState state = 0;
+    return Lex(dialect, line, state);
+}
+
+}  // namespace
+
+TEST(SqlLexerTest, ClassifiesTokensPerDialect) {
+    EXPECT_EQ(Lex(SqlDialect::Sqlite, "select count(*), 'it''s' FROM [my table] WHERE x>=1.5e3 AND y = ?2 -- done"),
+              (std::vector<std::string>{"select:keyword", "count:function", "(*),:operator", "'it''s':string", "FROM:keyword", "[my table]:name", "WHERE:keyword", "x:plain",
+                                        ">=:operator", "1.5e3:number", "AND:keyword", "y:plain", "=:operator", "?2:parameter", "-- done:comment"}));
+    // Double quotes name things except in MySQL, which also has # comments and \ escapes.
+    EXPECT_EQ(Lex(SqlDialect::PostgreSql, "CAST(\"a\" AS jsonb)"),
+              (std::vector<std::string>{"CAST:keyword", "(:operator", "\"a\":name", "AS:keyword", "jsonb:type", "):operator"}));
+    EXPECT_EQ(Lex(SqlDialect::MySql, "SELECT \"a\\\"b\", `c` # note"),
+              (std::vector<std::string>{"SELECT:keyword", "\"a\\\"b\":string", ",:operator", "`c`:name", "# note:comment"}));
+    EXPECT_EQ(Lex(SqlDialect::Sqlite, "x # y"), (std::vector<std::string>{"x:plain", "#:operator", "y:plain"}));
+    EXPECT_EQ(Lex(SqlDialect::PostgreSql, "WHERE id = $1 AND tag = E'a\\'b'"),
+              (std::vector<std::string>{"WHERE:keyword", "id:plain", "=:operator", "$1:parameter", "AND:keyword", "tag:plain", "=:operator", "E'a\\'b':string"}));
+    EXPECT_EQ(Lex(SqlDialect::MySql, "ENGINE=InnoDB AUTO_INCREMENT"), (std::vector<std::string>{"ENGINE:keyword", "=:operator", "InnoDB:plain", "AUTO_INCREMENT:keyword"}));
+    EXPECT_EQ(Lex(SqlDialect::Sqlite, "ENGINE"), (std::vector<std::string>{"ENGINE:plain"}));
+}
+
+TEST(SqlLexerTest, CarriesOpenConstructsAcrossLines) {
+    SqlLineState state = 0;
+    EXPECT_EQ(Lex(SqlDialect::Sqlite, "SELECT 1 /* start", state), (std::vector<std::string>{"SELECT:keyword", "1:number", "/* start:comment"}));
+    EXPECT_NE(state, 0u);
+    EXPECT_EQ(Lex(SqlDialect::Sqlite, "still */ FROM t", state), (std::vector<std::string>{"still */:comment", "FROM:keyword", "t:plain"}));
+    EXPECT_EQ(state, 0u);
+
+    // PostgreSQL comments nest; dollar quotes end only at their own tag.
+    Lex(SqlDialect::PostgreSql, "/* a /* b */", state);
+    EXPECT_NE(state, 0u);
+    EXPECT_EQ(Lex(SqlDialect::PostgreSql, "c */ x", state), (std::vector<std::string>{"c */:comment", "x:plain"}));
+    EXPECT_EQ(Lex(SqlDialect::PostgreSql, "AS $body$ BEGIN", state), (std::vector<std::string>{"AS:keyword", "$body$ BEGIN:string"}));
+    EXPECT_EQ(Lex(SqlDialect::PostgreSql, "  RETURN $$x$$; $other$", state), (std::vector<std::string>{"  RETURN $$x$$; $other$:string"}));
+    EXPECT_EQ(Lex(SqlDialect::PostgreSql, "END $body$ LANGUAGE plpgsql", state),
+              (std::vector<std::string>{"END $body$:string", "LANGUAGE:keyword", "plpgsql:plain"}));
+    EXPECT_EQ(state, 0u);
+
+    Lex(SqlDialect::Sqlite, "INSERT INTO t VALUES ('multi", state);
+    EXPECT_EQ(Lex(SqlDialect::Sqlite, "line')", state), (std::vector<std::string>{"line':string", "):operator"}));
+    EXPECT_EQ(state, 0u);
+}
+
+TEST(SqlLexerTest, HighlighterRelexesOnlyUntilTheStateConverges) {
+    std::vector<std::string> lines;
+    for (int i = 0; i < 100000; ++i) lines.push_back("SELECT col" + std::to_string(i) + " FROM t; -- line");
+    const SqlHighlighter::LineSource source = [&](uint32_t line) { return std::string_view(lines[line]); };
+    SqlHighlighter highlighter;
+
+    // A screen at the top lexes a screen, however long the script.
+    for (uint32_t line = 0; line < 40; ++line) highlighter.Spans(line, source);
+    EXPECT_LT(highlighter.LinesLexed(), 100u);
+    EXPECT_LT(highlighter.KnownLines(), 100u);
+
+    // Drawing again lexes nothing; typing in a line lexes about that line.
+    uint64_t lexed = highlighter.LinesLexed();
+    for (uint32_t line = 0; line < 40; ++line) highlighter.Spans(line, source);
+    EXPECT_EQ(highlighter.LinesLexed(), lexed);
+    lines[10] = "SELECT 'x' FROM t;";
+    highlighter.Edited(10, 0, 0);
+    for (uint32_t line = 0; line < 40; ++line) highlighter.Spans(line, source);
+    EXPECT_LT(highlighter.LinesLexed() - lexed, 40u);
+
+    // Jumping to the end lexes the way there once.
+    highlighter.Spans(99999, source);
+    EXPECT_EQ(highlighter.KnownLines(), 100000u);
+    lexed = highlighter.LinesLexed();
+    lines.insert(lines.begin() + 50000, "SELECT 1;");
+    highlighter.Edited(49999, 0, 1);
+    EXPECT_EQ(Describe(lines[50000], highlighter.Spans(50000, source)), (std::vector<std::string>{"SELECT:keyword", "1:number", ";:operator"}));
+    EXPECT_LT(highlighter.LinesLexed() - lexed, 10u);
+    EXPECT_EQ(highlighter.KnownLines(), 100001u);
+
+    // Opening a comment turns everything below into comment, but only what is shown is lexed.
+    lexed = highlighter.LinesLexed();
+    lines[5] = "/* SELECT";
+    highlighter.Edited(5, 0, 0);
+    for (uint32_t line = 0; line < 40; ++line) highlighter.Spans(line, source);
+    EXPECT_LT(highlighter.LinesLexed() - lexed, 400u);
+    EXPECT_EQ(Describe(lines[20], highlighter.Spans(20, source)), (std::vector<std::string>{lines[20] + ":comment"}));
+    EXPECT_EQ(Describe(lines[90000], highlighter.Spans(90000, source)), (std::vector<std::string>{lines[90000] + ":comment"}));
+
+    // Closing it again brings the old highlighting back.
+    lines[5] = "/* SELECT */";
+    highlighter.Edited(5, 0, 0);
+    EXPECT_EQ(Describe(lines[90000], highlighter.Spans(90000, source))[0], "SELECT:keyword");
+
+    // Joining two lines drops one.
+    lines[7] += lines[8];
+    lines.erase(lines.begin() + 8);
+    highlighter.Edited(7, 1, 0);
+    EXPECT_EQ(Describe(lines[8], highlighter.Spans(8, source))[0], "SELECT:keyword");
+    highlighter.Spans(static_cast<uint32_t>(lines.size() - 1), source);
+    EXPECT_EQ(highlighter.KnownLines(), lines.size());
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "text_buffer.h"
+
+#include <random>
+#include <string>
+
+using ambidb::TextBuffer;
+
+namespace {
+
+// Every query on the buffer against the same query on a plain string.
+void ExpectMatches(const TextBuffer& buffer, const std::string& expected) {
+    ASSERT_EQ(buffer.Size(), expected.size());
+    ASSERT_EQ(buffer.Text(), expected);
+    std::string scratch;
+    uint32_t line = 0;
+    size_t start = 0;
+    for (size_t at = 0; at <= expected.size(); ++at) {
+        if (at < expected.size()) {
+            ASSERT_EQ(buffer.At(at), expected[at]);
+        }
+        ASSERT_EQ(buffer.LineOf(at), line) << "offset " << at;
+        if (at == expected.size() || expected[at] == '\n') {
+            ASSERT_EQ(buffer.LineStart(line), start);
+            ASSERT_EQ(buffer.LineEnd(line), at);
+            ASSERT_EQ(buffer.Line(line, scratch), expected.substr(start, at - start));
+            ++line;
+            start = at + 1;
+        }
+    }
+    ASSERT_EQ(buffer.LineCount(), line);
+}
+
+}  // namespace
+
+TEST(TextBufferTest, EditsMatchAPlainString) {
+    TextBuffer buffer("SELECT *\nFROM t\n");
+    std::string expected = "SELECT *\nFROM t\n";
+    ExpectMatches(buffer, expected);
+
+    std::mt19937 random(7);
+    const std::string alphabet = "ab\n;\xC3\xA9";
+    for (int step = 0; step < 2000; ++step) {
+        const size_t at = std::uniform_int_distribution<size_t>(0, expected.size())(random);
+        if (expected.empty() || random() % 3 != 0) {
+            std::string text;
+            for (size_t i = random() % 8; i > 0; --i) text += alphabet[random() % alphabet.size()];
+            buffer.Insert(at, text);
+            expected.insert(at, text);
+        } else {
+            const size_t to = std::min(expected.size(), at + random() % 12);
+            buffer.Erase(at, to);
+            expected.erase(at, to - at);
+        }
+        if (step % 100 == 0) ExpectMatches(buffer, expected);
+    }
+    ExpectMatches(buffer, expected);
+
+    std::string scratch;
+    const std::string_view middle = buffer.Text(3, expected.size() - 3, scratch);
+    EXPECT_EQ(middle, expected.substr(3, expected.size() - 6));
+}
+
+TEST(TextBufferTest, SnapshotsRestoreEarlierText) {
+    TextBuffer buffer("one\ntwo");
+    const TextBuffer::Snapshot original = buffer.Save();
+    buffer.Insert(3, " and a half");
+    buffer.Erase(0, 4);
+    const TextBuffer::Snapshot edited = buffer.Save();
+    EXPECT_EQ(buffer.Text(), "and a half\ntwo");
+
+    buffer.Restore(original);
+    ExpectMatches(buffer, "one\ntwo");
+    // Typing after an undo does not disturb the text the redo step holds.
+    buffer.Insert(7, "!");
+    buffer.Restore(edited);
+    ExpectMatches(buffer, "and a half\ntwo");
+    buffer.Assign("");
+    ExpectMatches(buffer, "");
+}
+
+TEST(TextBufferTest, TypingIntoAHugePasteStaysCheap) {
+    std::string dump;
+    for (int row = 0; dump.size() < 50u * 1024 * 1024; ++row) dump += "INSERT INTO t VALUES (" + std::to_string(row) + ", 'some text');\n";
+    TextBuffer buffer;
+    buffer.Insert(0, "-- dump\n");
+
+    buffer.Insert(buffer.Size(), dump);
+    EXPECT_EQ(buffer.Size(), dump.size() + 8);
+
+    // Typing in the middle, snapshotting each keystroke as an undo history would.
+    const uint32_t lines = buffer.LineCount();
+    std::vector<TextBuffer::Snapshot> history;
+    size_t at = buffer.LineStart(lines / 2);
+    for (const char c : std::string("SELECT count(*) FROM t;\n")) {
+        history.push_back(buffer.Save());
+        buffer.Insert(at++, std::string_view(&c, 1));
+    }
+
+    // Cheap by construction: the header, the paste's two halves and one piece for
+    // everything typed, whatever the size of the paste.
+    EXPECT_EQ(buffer.PieceCount(), 4u);
+    EXPECT_EQ(buffer.LineCount(), lines + 1);
+    std::string scratch;
+    EXPECT_EQ(buffer.Line(lines / 2, scratch), "SELECT count(*) FROM t;");
+    buffer.Restore(history.front());
+    EXPECT_EQ(buffer.LineCount(), lines);
+    EXPECT_EQ(buffer.Text().substr(8), dump);
+}
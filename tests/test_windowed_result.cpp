@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "db/windowed_result.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using ambidb::db::RowBatch;
+using ambidb::db::WindowedResult;
+
+namespace {
+
+constexpr size_t kPage = WindowedResult::kPageRows;
+
+RowBatch MakePage(size_t firstRow, size_t rows) {
+    RowBatch batch;
+    batch.columnCount = 2;
+    for (size_t row = firstRow; row < firstRow + rows; ++row) {
+        batch.values.emplace_back(static_cast<int64_t>(row));
+        batch.values.emplace_back(std::string(40, 'x'));
+    }
+    return batch;
+}
+
+}  // namespace
+
+TEST(WindowedResultTest, PlansVisiblePagesFirstAndReadsAhead) {
+    WindowedResult window;
+    window.Reset({{"id", ""}, {"pad", ""}});
+    window.AddPage(0, MakePage(0, kPage), false);
+    EXPECT_EQ(window.RowCount(), 2 * kPage);  // One page beyond what is known.
+
+    char scratch[32];
+    EXPECT_STREQ(window.FormatCell(10, 0, scratch, sizeof(scratch)), "10");
+    EXPECT_STREQ(window.FormatCell(kPage + 1, 0, scratch, sizeof(scratch)), "...");
+
+    // Jump far ahead: the visible page comes first, then pages further down.
+    window.Extend(50 * kPage);
+    std::vector<size_t> requests;
+    window.Plan(40 * kPage + 10, 30, requests);
+    ASSERT_EQ(requests.size(), WindowedResult::kMaxInFlight);
+    EXPECT_EQ(requests[0], 40 * kPage);
+    EXPECT_EQ(requests[1], 41 * kPage);
+
+    // In-flight pages are not requested twice.
+    std::vector<size_t> again;
+    window.Plan(40 * kPage + 10, 30, again);
+    EXPECT_TRUE(again.empty());
+
+    window.AddPage(40 * kPage, MakePage(40 * kPage, 100), true);
+    EXPECT_TRUE(window.Complete());
+    EXPECT_EQ(window.RowCount(), 40 * kPage + 100);
+}
+
+TEST(WindowedResultTest, EvictsFarPagesUnderBudget) {
+    WindowedResult window(256 * 1024);
+    window.Reset({{"id", ""}, {"pad", ""}});
+
+    size_t peak = 0;
+    for (size_t page = 0; page < 200; ++page) {
+        std::vector<size_t> requests;
+        window.Plan(page * kPage, 40, requests);
+        for (size_t first : requests) {
+            window.AddPage(first, MakePage(first, kPage), false);
+        }
+        peak = std::max(peak, window.MemoryBytes());
+    }
+    EXPECT_LT(window.CachedPages(), 20u);
+    EXPECT_LE(peak, 256u * 1024 + 2 * 64 * kPage);
+
+    char scratch[32];
+    EXPECT_STREQ(window.FormatCell(199 * kPage + 5, 0, scratch, sizeof(scratch)),
+                 std::to_string(199 * kPage + 5).c_str());
+    EXPECT_STREQ(window.FormatCell(5, 0, scratch, sizeof(scratch)), "...");
+}